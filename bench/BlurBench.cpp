@@ -6,18 +6,22 @@
  */
 #include "bench/Benchmark.h"
 #include "include/core/SkCanvas.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkMaskFilter.h"
 #include "include/core/SkPaint.h"
 #include "include/core/SkShader.h"
 #include "include/core/SkString.h"
 #include "include/utils/SkRandom.h"
 #include "src/core/SkBlurMask.h"
+#include "src/core/SkMaskBlurFilter.h"
 
 #define MINI    0.01f
 #define SMALL   SkIntToScalar(2)
 #define REAL    0.5f
 #define BIG     SkIntToScalar(10)
 #define REALBIG 100.5f
+// The value that produces a sigma of just over 100.
+#define REALHUGE 172.5f
 // The value that produces a sigma of just over 2.
 #define CUTOVER 2.6f
 
@@ -95,9 +99,76 @@ DEF_BENCH(return new BlurBench(REALBIG, kSolid_SkBlurStyle);)
 DEF_BENCH(return new BlurBench(REALBIG, kOuter_SkBlurStyle);)
 DEF_BENCH(return new BlurBench(REALBIG, kInner_SkBlurStyle);)
 
+DEF_BENCH(return new BlurBench(REALHUGE, kNormal_SkBlurStyle);)
+
 DEF_BENCH(return new BlurBench(REAL, kNormal_SkBlurStyle);)
 DEF_BENCH(return new BlurBench(REAL, kSolid_SkBlurStyle);)
 DEF_BENCH(return new BlurBench(REAL, kOuter_SkBlurStyle);)
 DEF_BENCH(return new BlurBench(REAL, kInner_SkBlurStyle);)
 
 DEF_BENCH(return new BlurBench(0, kNormal_SkBlurStyle);)
+
+// Blurs a large A8 mask directly with SkMaskBlurFilter, serially or in bands on a thread pool, so
+// the per-core scaling can be read off the _Nthreads variants.
+class MaskBlurFilterBench : public Benchmark {
+public:
+    MaskBlurFilterBench(double sigma, int threads) : fSigma(sigma), fThreads(threads) {
+        fName.printf("mask_blur_filter_%d_%dthreads", (int)sigma, threads);
+    }
+
+protected:
+    const char* onGetName() override { return fName.c_str(); }
+
+    bool isSuitableFor(Backend backend) override {
+        return backend == kNonRendering_Backend;
+    }
+
+    void onDelayedSetup() override {
+        if (fThreads > 1) {
+            fExecutor = SkExecutor::MakeFIFOThreadPool(fThreads);
+        }
+
+        fSrc.fFormat   = SkMask::kA8_Format;
+        fSrc.fBounds   = SkIRect::MakeWH(kSize, kSize);
+        fSrc.fRowBytes = kSize;
+        fSrc.fImage    = SkMask::AllocImage(fSrc.computeImageSize());
+        fSrcImage.reset(fSrc.fImage);
+        for (int y = 0; y < kSize; y++) {
+            for (int x = 0; x < kSize; x++) {
+                // A filled circle, like a blurred shadow of a round button.
+                int dx = x - kSize/2,
+                    dy = y - kSize/2;
+                fSrc.fImage[y * kSize + x] = dx*dx + dy*dy < kSize*kSize/9 ? 0xFF : 0x00;
+            }
+        }
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        SkMaskBlurFilter filter{fSigma, fSigma};
+        for (int i = 0; i < loops; i++) {
+            SkMask dst;
+            filter.blur(fSrc, &dst, fExecutor.get());
+            SkMask::FreeImage(dst.fImage);
+        }
+    }
+
+private:
+    static constexpr int kSize = 1024;
+
+    const double                fSigma;
+    const int                   fThreads;
+    SkString                    fName;
+    std::unique_ptr<SkExecutor> fExecutor;
+    SkMask                      fSrc;
+    SkAutoMaskFreeImage         fSrcImage;
+};
+
+#define MASK_BLUR_FILTER_BENCHES(sigma)                          \
+    DEF_BENCH(return new MaskBlurFilterBench(sigma, 1);)         \
+    DEF_BENCH(return new MaskBlurFilterBench(sigma, 2);)         \
+    DEF_BENCH(return new MaskBlurFilterBench(sigma, 4);)         \
+    DEF_BENCH(return new MaskBlurFilterBench(sigma, 8);)
+
+MASK_BLUR_FILTER_BENCHES(20)
+MASK_BLUR_FILTER_BENCHES(50)
+MASK_BLUR_FILTER_BENCHES(100)
@@ -7,7 +7,11 @@
 
 #include "bench/Benchmark.h"
 #include "include/core/SkCanvas.h"
+#include "include/core/SkExecutor.h"
+#include "include/core/SkMaskFilter.h"
 #include "include/core/SkPaint.h"
+#include "include/core/SkPath.h"
+#include "include/core/SkRRect.h"
 #include "include/core/SkShader.h"
 #include "include/core/SkString.h"
 #include "include/utils/SkRandom.h"
@@ -182,6 +186,115 @@ private:
     using INHERITED = BlurRectSeparableBench;
 };
 
+// Box blurs a rect big enough for its mask to be split into bands of rows. SkBlurMask::BoxBlur()
+// hands the bands out to the default executor, so this installs a thread pool as the default
+// while it runs; with a single thread the bands all run inline.
+class BlurRectParallelBench: public BlurRectSeparableBench {
+public:
+    BlurRectParallelBench(SkScalar rad, int threads) : INHERITED(rad), fThreads(threads) {
+        SkString name;
+        name.printf("blurrect_boxfilter_parallel_%d_%dthreads", SkScalarRoundToInt(rad), threads);
+        this->setName(name);
+    }
+
+protected:
+    void onDelayedSetup() override {
+        if (fThreads > 1) {
+            fExecutor = SkExecutor::MakeFIFOThreadPool(fThreads);
+        }
+    }
+
+    void onDraw(int loops, SkCanvas* canvas) override {
+        SkExecutor* previous = &SkExecutor::GetDefault();
+        SkExecutor::SetDefault(fExecutor.get());
+        INHERITED::onDraw(loops, canvas);
+        SkExecutor::SetDefault(previous);
+    }
+
+    void preBenchSetup(const SkRect&) override {
+        INHERITED::preBenchSetup(SkRect::MakeWH(kSize, kSize));
+    }
+
+    void makeBlurryRect(const SkRect&) override {
+        SkMask mask;
+        if (!SkBlurMask::BoxBlur(&mask, fSrcMask, SkBlurMask::ConvertRadiusToSigma(this->radius()),
+                                 kNormal_SkBlurStyle)) {
+            return;
+        }
+        SkMask::FreeImage(mask.fImage);
+    }
+
+private:
+    static constexpr int kSize = 1024;
+
+    const int                   fThreads;
+    std::unique_ptr<SkExecutor> fExecutor;
+
+    using INHERITED = BlurRectSeparableBench;
+};
+
+// Draws blurred rects, round rects or ovals on the raster backend, each at a different subpixel
+// offset, as animated shadows do. They are drawn from SkRasterPipeline's closed-form blur
+// coverage stages, except for corners that are big next to the blur, which use a mask. The mask
+// variants draw the same shapes as paths with an extra, empty contour, so they are never
+// recognized and always go through the mask blur.
+class BlurRectDrawBench: public Benchmark {
+public:
+    enum class Shape { kRect, kRRect, kOval };
+
+    BlurRectDrawBench(SkScalar rad, Shape shape, bool analytic)
+            : fRadius(rad), fShape(shape), fAnalytic(analytic) {
+        static const char* kNames[] = {"rect", "rrect", "oval"};
+        fName.printf("blurrect_draw_%s_%s_", analytic ? "analytic" : "mask", kNames[(int)shape]);
+        if (SkScalarFraction(rad) != 0) {
+            fName.appendf("%.2f", SkScalarToFloat(rad));
+        } else {
+            fName.appendf("%d", SkScalarRoundToInt(rad));
+        }
+    }
+
+protected:
+    const char* onGetName() override {
+        return fName.c_str();
+    }
+
+    void onDraw(int loops, SkCanvas* canvas) override {
+        SkPaint paint;
+        paint.setAntiAlias(true);
+        paint.setMaskFilter(SkMaskFilter::MakeBlur(kNormal_SkBlurStyle,
+                                                   SkBlurMask::ConvertRadiusToSigma(fRadius)));
+
+        for (int i = 0; i < loops; i++) {
+            SkRect r = SkRect::MakeXYWH(100 + (i % 8) * 0.125f, 100, 240, 160);
+            if (!fAnalytic) {
+                SkPath path;
+                switch (fShape) {
+                    case Shape::kRect:  path.addRect(r);                              break;
+                    case Shape::kRRect: path.addRRect(SkRRect::MakeRectXY(r, 8, 8)); break;
+                    case Shape::kOval:  path.addOval(r);                              break;
+                }
+                path.moveTo(r.centerX(), r.centerY());
+                path.lineTo(r.centerX() + 1, r.centerY());
+                canvas->drawPath(path, paint);
+                continue;
+            }
+            switch (fShape) {
+                case Shape::kRect:  canvas->drawRect(r, paint);                             break;
+                case Shape::kRRect: canvas->drawRRect(SkRRect::MakeRectXY(r, 8, 8), paint); break;
+                case Shape::kOval:  canvas->drawOval(r, paint);                             break;
+            }
+        }
+    }
+
+private:
+    SkScalar fRadius;
+    Shape    fShape;
+    bool     fAnalytic;
+    SkString fName;
+
+    using INHERITED = Benchmark;
+};
+
 DEF_BENCH(return new BlurRectBoxFilterBench(SMALL);)
 DEF_BENCH(return new BlurRectBoxFilterBench(BIG);)
 DEF_BENCH(return new BlurRectBoxFilterBench(REALBIG);)
@@ -201,6 +314,24 @@ DEF_BENCH(return new BlurRectDirectBench(kMedBig);)
 DEF_BENCH(return new BlurRectBoxFilterBench(kMedium);)
 DEF_BENCH(return new BlurRectBoxFilterBench(kMedBig);)
 
+DEF_BENCH(return new BlurRectParallelBench(BIG, 1);)
+DEF_BENCH(return new BlurRectParallelBench(BIG, 4);)
+DEF_BENCH(return new BlurRectParallelBench(REALBIG, 1);)
+DEF_BENCH(return new BlurRectParallelBench(REALBIG, 4);)
+
+DEF_BENCH(return new BlurRectDrawBench(kMedium, BlurRectDrawBench::Shape::kRect, true);)
+DEF_BENCH(return new BlurRectDrawBench(kMedium, BlurRectDrawBench::Shape::kRect, false);)
+DEF_BENCH(return new BlurRectDrawBench(REALBIG, BlurRectDrawBench::Shape::kRect, true);)
+DEF_BENCH(return new BlurRectDrawBench(REALBIG, BlurRectDrawBench::Shape::kRect, false);)
+DEF_BENCH(return new BlurRectDrawBench(kMedium, BlurRectDrawBench::Shape::kRRect, true);)
+DEF_BENCH(return new BlurRectDrawBench(kMedium, BlurRectDrawBench::Shape::kRRect, false);)
+DEF_BENCH(return new BlurRectDrawBench(REALBIG, BlurRectDrawBench::Shape::kRRect, true);)
+DEF_BENCH(return new BlurRectDrawBench(REALBIG, BlurRectDrawBench::Shape::kRRect, false);)
+DEF_BENCH(return new BlurRectDrawBench(kMedium, BlurRectDrawBench::Shape::kOval, true);)
+DEF_BENCH(return new BlurRectDrawBench(kMedium, BlurRectDrawBench::Shape::kOval, false);)
+DEF_BENCH(return new BlurRectDrawBench(REALBIG, BlurRectDrawBench::Shape::kOval, true);)
+DEF_BENCH(return new BlurRectDrawBench(REALBIG, BlurRectDrawBench::Shape::kOval, false);)
+
 #if 0
 // disable Gaussian benchmarks; the algorithm works well enough
 // and serves as a baseline for ground truth, but it's too slow
@@ -15,10 +15,11 @@
 
 class BlurRectsBench : public Benchmark {
 public:
-    BlurRectsBench(SkRect outer, SkRect inner, SkScalar radius) {
+    BlurRectsBench(SkRect outer, SkRect inner, SkScalar radius, bool analytic) {
         fRadius = radius;
         fOuter = outer;
         fInner = inner;
+        fAnalytic = analytic;
     }
 
     const char* onGetName() override {
@@ -36,6 +37,11 @@ public:
         SkPath path;
         path.addRect(fOuter, SkPathDirection::kCW);
         path.addRect(fInner, SkPathDirection::kCW);
+        if (!fAnalytic) {
+            // An extra, empty contour keeps the nested rects from being recognized.
+            path.moveTo(fInner.centerX(), fInner.centerY());
+            path.lineTo(fInner.centerX() + 1, fInner.centerY());
+        }
 
         for (int i = 0; i < loops; i++) {
             canvas->drawPath(path, paint);
@@ -47,15 +53,16 @@ private:
     SkRect      fOuter;
     SkRect      fInner;
     SkScalar    fRadius;
+    bool        fAnalytic;
 
     using INHERITED =     Benchmark;
 };
 
 class BlurRectsNinePatchBench: public BlurRectsBench {
 public:
-    BlurRectsNinePatchBench(SkRect outer, SkRect inner, SkScalar radius)
-        : INHERITED(outer, inner, radius) {
-        this->setName(SkString("blurrectsninepatch"));
+    BlurRectsNinePatchBench(SkRect outer, SkRect inner, SkScalar radius, bool analytic)
+        : INHERITED(outer, inner, radius, analytic) {
+        this->setName(SkString(analytic ? "blurrectsninepatch_analytic" : "blurrectsninepatch"));
     }
 private:
     using INHERITED = BlurRectsBench;
@@ -63,18 +70,27 @@ private:
 
 class BlurRectsNonNinePatchBench: public BlurRectsBench {
 public:
-    BlurRectsNonNinePatchBench(SkRect outer, SkRect inner, SkScalar radius)
-        : INHERITED(outer, inner, radius) {
+    BlurRectsNonNinePatchBench(SkRect outer, SkRect inner, SkScalar radius, bool analytic)
+        : INHERITED(outer, inner, radius, analytic) {
         SkString name;
-        this->setName(SkString("blurrectsnonninepatch"));
+        this->setName(SkString(analytic ? "blurrectsnonninepatch_analytic"
+                                        : "blurrectsnonninepatch"));
     }
 private:
     using INHERITED = BlurRectsBench;
 };
 
+// The analytic variants draw from SkRasterPipeline's closed-form blur_rect_coverage stage; the
+// others are always blurred as a mask.
+DEF_BENCH(return new BlurRectsNinePatchBench(SkRect::MakeXYWH(10, 10, 100, 100),
+                                             SkRect::MakeXYWH(20, 20, 60, 60),
+                                             2.3f, true);)
 DEF_BENCH(return new BlurRectsNinePatchBench(SkRect::MakeXYWH(10, 10, 100, 100),
                                              SkRect::MakeXYWH(20, 20, 60, 60),
-                                             2.3f);)
+                                             2.3f, false);)
+DEF_BENCH(return new BlurRectsNonNinePatchBench(SkRect::MakeXYWH(10, 10, 100, 100),
+                                                SkRect::MakeXYWH(50, 50, 10, 10),
+                                                4.3f, true);)
 DEF_BENCH(return new BlurRectsNonNinePatchBench(SkRect::MakeXYWH(10, 10, 100, 100),
                                                 SkRect::MakeXYWH(50, 50, 10, 10),
-                                                4.3f);)
+                                                4.3f, false);)
@@ -9,12 +9,19 @@
 #include "bench/CodecBenchPriv.h"
 #include "include/codec/SkCodec.h"
 #include "include/core/SkBitmap.h"
+#include "include/core/SkColorSpace.h"
 #include "src/core/SkOSFile.h"
 #include "tools/flags/CommandLineFlags.h"
 
 // Actually zeroing the memory would throw off timing, so we just lie.
 static DEFINE_bool(zero_init, false,
                    "Pretend our destination is zero-intialized, simulating Android?");
+static DEFINE_bool(codec_srgb, false,
+                   "Decode to sRGB rather than to no color space, so that images tagged with "
+                   "another profile are color transformed.");
+static DEFINE_int(codec_threads, 0,
+                  "If > 0, set SkCodec::Options::fExecutor to a pool of this many threads, "
+                  "overlapping color transforms with decompression.");
 
 CodecBench::CodecBench(SkString baseName, SkData* encoded, SkColorType colorType,
         SkAlphaType alphaType)
@@ -25,6 +32,12 @@ CodecBench::CodecBench(SkString baseName, SkData* encoded, SkColorType colorType
     // Parse filename and the color type to give the benchmark a useful name
     fName.printf("Codec_%s_%s%s", baseName.c_str(), color_type_to_str(colorType),
             alpha_type_to_str(alphaType));
+    if (FLAGS_codec_srgb) {
+        fName.append("_srgb");
+    }
+    if (FLAGS_codec_threads > 0) {
+        fName.appendf("_threads%d", FLAGS_codec_threads);
+    }
     // Ensure that we can create an SkCodec from this data.
     SkASSERT(SkCodec::MakeFromData(fData));
 }
@@ -42,9 +55,13 @@ void CodecBench::onDelayedSetup() {
 
     fInfo = codec->getInfo().makeColorType(fColorType)
                             .makeAlphaType(fAlphaType)
-                            .makeColorSpace(nullptr);
+                            .makeColorSpace(FLAGS_codec_srgb ? SkColorSpace::MakeSRGB()
+                                                             : nullptr);
 
     fPixelStorage.reset(fInfo.computeMinByteSize());
+    if (FLAGS_codec_threads > 0) {
+        fExecutor = SkExecutor::MakeFIFOThreadPool(FLAGS_codec_threads);
+    }
 }
 
 void CodecBench::onDraw(int n, SkCanvas* canvas) {
@@ -53,6 +70,7 @@ void CodecBench::onDraw(int n, SkCanvas* canvas) {
     if (FLAGS_zero_init) {
         options.fZeroInitialized = SkCodec::kYes_ZeroInitialized;
     }
+    options.fExecutor = fExecutor.get();
     for (int i = 0; i < n; i++) {
         codec = SkCodec::MakeFromData(fData);
 #ifdef SK_DEBUG
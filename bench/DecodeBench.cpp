@@ -6,8 +6,14 @@
  */
 
 #include "bench/Benchmark.h"
+#include "include/codec/SkCodec.h"
 #include "include/core/SkBitmap.h"
+#include "include/core/SkCanvas.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkPictureRecorder.h"
+#include "include/core/SkStream.h"
+#include "include/encode/SkJpegEncoder.h"
+#include "include/utils/SkRandom.h"
 #include "modules/skottie/include/Skottie.h"
 #include "tools/Resources.h"
 
@@ -54,6 +60,64 @@ private:
     using INHERITED = DecodeBench;
 };
 
+#if defined(SK_CODEC_DECODES_JPEG) && defined(SK_ENCODE_JPEG)
+// Decodes a camera sized jpeg with a restart marker after every row of MCUs. With |threads|, it
+// is decoded in bands on a pool of that many threads; without, top to bottom on one.
+class JpegRestartIntervalsDecodeBench final : public DecodeBench {
+public:
+    JpegRestartIntervalsDecodeBench(const char* name, int width, int height, int threads)
+        : INHERITED(name, nullptr)
+        , fWidth(width)
+        , fHeight(height)
+        , fThreads(threads)
+    {}
+
+    void onDelayedSetup() override {
+        SkBitmap src;
+        src.allocN32Pixels(fWidth, fHeight);
+        SkCanvas canvas(src);
+        canvas.clear(SK_ColorWHITE);
+        SkRandom random;
+        SkPaint paint;
+        paint.setAntiAlias(true);
+        for (int i = 0; i < 2000; i++) {
+            paint.setColor(random.nextU() | 0xFF000000);
+            canvas.drawCircle(random.nextRangeF(0, fWidth), random.nextRangeF(0, fHeight),
+                              random.nextRangeF(10, 400), paint);
+        }
+
+        SkJpegEncoder::Options options;
+        options.fQuality = 90;
+        options.fRestartInterval = 1;
+        SkDynamicMemoryWStream stream;
+        SkAssertResult(SkJpegEncoder::Encode(&stream, src.pixmap(), options));
+        fData = stream.detachAsData();
+
+        fBitmap.allocPixels(src.info());
+        if (fThreads) {
+            fExecutor = SkExecutor::MakeFIFOThreadPool(fThreads);
+        }
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        SkCodec::Options options;
+        options.fExecutor = fExecutor.get();
+        while (loops-- > 0) {
+            auto codec = SkCodec::MakeFromData(fData);
+            SkAssertResult(SkCodec::kSuccess == codec->getPixels(fBitmap.pixmap(), &options));
+        }
+    }
+
+private:
+    const int                   fWidth,
+                                fHeight,
+                                fThreads;
+    SkBitmap                    fBitmap;
+    std::unique_ptr<SkExecutor> fExecutor;
+
+    using INHERITED = DecodeBench;
+};
+#endif
 
 class SkottieDecodeBench final : public DecodeBench {
 public:
@@ -233,3 +297,10 @@ DEF_BENCH(return new BitmapDecodeBench("png_small"    /*  32x  32*/, "images/man
 DEF_BENCH(return new BitmapDecodeBench("png_phonehub_connecting"   , "images/Connecting.png"));
 DEF_BENCH(return new BitmapDecodeBench("png_phonehub_generic_error", "images/Generic_Error.png"));
 DEF_BENCH(return new BitmapDecodeBench("png_phonehub_onboard"      , "images/Onboard.png"));
+
+#if defined(SK_CODEC_DECODES_JPEG) && defined(SK_ENCODE_JPEG)
+DEF_BENCH(return new JpegRestartIntervalsDecodeBench("jpeg_restart_52mp", 8832, 5888, 0));
+DEF_BENCH(return new JpegRestartIntervalsDecodeBench("jpeg_restart_52mp_2threads", 8832, 5888, 2));
+DEF_BENCH(return new JpegRestartIntervalsDecodeBench("jpeg_restart_52mp_4threads", 8832, 5888, 4));
+DEF_BENCH(return new JpegRestartIntervalsDecodeBench("jpeg_restart_52mp_8threads", 8832, 5888, 8));
+#endif
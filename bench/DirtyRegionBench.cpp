@@ -0,0 +1,117 @@
+/*
+ * Copyright 2022 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "bench/Benchmark.h"
+#include "include/core/SkCanvas.h"
+#include "include/core/SkPaint.h"
+#include "include/core/SkPath.h"
+#include "include/core/SkPicture.h"
+#include "include/core/SkPictureRecorder.h"
+#include "include/core/SkRRect.h"
+#include "include/core/SkRegion.h"
+#include "include/core/SkSurface.h"
+#include "include/utils/SkRandom.h"
+
+/**
+ * Plays a picture back into a raster surface with and without tracking its dirty region, to
+ * measure what tracking costs. |scatter| draws many small rects all over the surface, the worst
+ * case for the region; otherwise the picture is laid out like a UI screen of cards.
+ */
+class DirtyRegionBench : public Benchmark {
+public:
+    DirtyRegionBench(bool scatter, bool track) : fScatter(scatter), fTrack(track) {
+        fName.printf("dirty_region_%s_%s", scatter ? "scatter" : "cards",
+                     track ? "track" : "none");
+    }
+
+    bool isSuitableFor(Backend backend) override { return backend == kNonRendering_Backend; }
+
+protected:
+    const char* onGetName() override { return fName.c_str(); }
+
+    void onDelayedSetup() override {
+        fSurface = SkSurface::MakeRasterN32Premul(kWidth, kHeight);
+        fSurface->setDirtyRegionTracking(fTrack);
+
+        SkPictureRecorder recorder;
+        SkCanvas* canvas = recorder.beginRecording(SkRect::MakeWH(kWidth, kHeight));
+        SkRandom rand;
+        SkPaint paint;
+        paint.setAntiAlias(true);
+
+        if (fScatter) {
+            for (int i = 0; i < 1000; i++) {
+                paint.setColor(rand.nextU() | 0xFF000000);
+                canvas->drawRect(SkRect::MakeXYWH(rand.nextRangeF(0, kWidth),
+                                                  rand.nextRangeF(0, kHeight), 4, 4), paint);
+            }
+            fPicture = recorder.finishRecordingAsPicture();
+            return;
+        }
+
+        sk_sp<SkSurface> surface = SkSurface::MakeRaster(
+                SkImageInfo::MakeN32(96, 96, kOpaque_SkAlphaType));
+        surface->getCanvas()->clear(SK_ColorLTGRAY);
+        surface->getCanvas()->drawCircle(48, 48, 32, SkPaint());
+        sk_sp<SkImage> image = surface->makeImageSnapshot();
+
+        canvas->drawColor(SK_ColorWHITE);
+        for (int y = 8; y < kHeight; y += 128) {
+            const SkRect card = SkRect::MakeXYWH(8, y, kWidth - 16, 120);
+            paint.setColor(0x20000000);
+            canvas->drawRRect(SkRRect::MakeRectXY(card.makeOffset(0, 2), 8, 8), paint);
+            paint.setColor(SK_ColorWHITE);
+            canvas->drawRRect(SkRRect::MakeRectXY(card, 8, 8), paint);
+
+            canvas->save();
+            canvas->clipRect(card.makeInset(8, 8));
+            canvas->drawImageRect(image, SkRect::MakeXYWH(card.left() + 12, y + 12, 96, 96),
+                                  SkSamplingOptions(SkFilterMode::kLinear));
+            for (int line = 0; line < 5; line++) {
+                paint.setColor(rand.nextU() | 0xFF000000);
+                const SkScalar top = y + 20 + 18 * line;
+                SkPath path;
+                path.moveTo(card.left() + 124, top)
+                    .cubicTo(card.left() + 200, top - 4, card.left() + 300, top + 8,
+                             card.right() - rand.nextRangeScalar(24, 200), top)
+                    .lineTo(card.right() - 24, top + 10)
+                    .lineTo(card.left() + 124, top + 10)
+                    .close();
+                canvas->drawPath(path, paint);
+            }
+            canvas->restore();
+        }
+        fPicture = recorder.finishRecordingAsPicture();
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        for (int i = 0; i < loops; i++) {
+            fSurface->getCanvas()->drawPicture(fPicture);
+            if (fTrack) {
+                SkRegion dirty = fSurface->dirtyRegion();
+                fSurface->resetDirtyRegion();
+            }
+        }
+    }
+
+private:
+    inline static constexpr int kWidth  = 512;
+    inline static constexpr int kHeight = 1024;
+
+    const bool       fScatter;
+    const bool       fTrack;
+    SkString         fName;
+    sk_sp<SkSurface> fSurface;
+    sk_sp<SkPicture> fPicture;
+
+    using INHERITED = Benchmark;
+};
+
+DEF_BENCH(return new DirtyRegionBench(false, false);)
+DEF_BENCH(return new DirtyRegionBench(false, true);)
+DEF_BENCH(return new DirtyRegionBench(true,  false);)
+DEF_BENCH(return new DirtyRegionBench(true,  true);)
@@ -7,10 +7,13 @@
 
 #include "bench/Benchmark.h"
 #include "include/core/SkBitmap.h"
+#include "include/core/SkColorPriv.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkStream.h"
 #include "include/encode/SkJpegEncoder.h"
 #include "include/encode/SkPngEncoder.h"
 #include "include/encode/SkWebpEncoder.h"
+#include "include/utils/SkRandom.h"
 #include "tools/Resources.h"
 
 // Like other Benchmark subclasses, Encoder benchmarks are run by:
@@ -75,15 +78,19 @@ static bool encode_webp_lossless(SkWStream* dst, const SkPixmap& src) {
 static bool encode_png(SkWStream* dst,
                        const SkPixmap& src,
                        SkPngEncoder::FilterFlag filters,
-                       int zlibLevel) {
+                       int zlibLevel,
+                       bool selectFiltersWithSkia = false) {
     SkPngEncoder::Options opts;
     opts.fFilterFlags = filters;
     opts.fZLibLevel = zlibLevel;
+    opts.fSelectFiltersWithSkia = selectFiltersWithSkia;
     return SkPngEncoder::Encode(dst, src, opts);
 }
 
 #define PNG(FLAG, ZLIBLEVEL) [](SkWStream* d, const SkPixmap& s) { \
            return encode_png(d, s, SkPngEncoder::FilterFlag::FLAG, ZLIBLEVEL); }
+#define PNG_SKIA_FILTERS(FLAG, ZLIBLEVEL) [](SkWStream* d, const SkPixmap& s) { \
+           return encode_png(d, s, SkPngEncoder::FilterFlag::FLAG, ZLIBLEVEL, true); }
 
 static const char* srcs[2] = {"images/mandrill_512.png", "images/color_wheel.jpg"};
 
@@ -122,4 +129,137 @@ DEF_BENCH(return new EncodeBench(srcs[1], PNG(kNone, 6), "PNG_6n"));
 DEF_BENCH(return new EncodeBench(srcs[1], PNG(kNone, 3), "PNG_3n"));
 DEF_BENCH(return new EncodeBench(srcs[1], PNG(kNone, 1), "PNG_1n"));
 
+DEF_BENCH(return new EncodeBench(srcs[0], PNG_SKIA_FILTERS(kAll, 6), "PNG_6k"));
+DEF_BENCH(return new EncodeBench(srcs[0], PNG_SKIA_FILTERS(kAll, 1), "PNG_1k"));
+DEF_BENCH(return new EncodeBench(srcs[1], PNG_SKIA_FILTERS(kAll, 6), "PNG_6k"));
+DEF_BENCH(return new EncodeBench(srcs[1], PNG_SKIA_FILTERS(kAll, 1), "PNG_1k"));
+
+#undef PNG_SKIA_FILTERS
 #undef PNG
+
+// Smooth gradients with a little noise, roughly as compressible as a photo.
+static void make_synthetic_photo(SkBitmap* bitmap, int width, int height) {
+    bitmap->allocN32Pixels(width, height);
+    SkRandom random;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const uint32_t noise = random.nextU() & 0xF;
+            *bitmap->getAddr32(x, y) = SkPackARGB32(0xFF, x * 0x80 / width + noise,
+                                                    y * 0x80 / height + noise,
+                                                    (x + y) * 0x40 / (width + height) + noise);
+        }
+    }
+}
+
+static SkString threads_name(int threads) {
+    return threads ? SkStringPrintf("%dthreads", threads) : SkString("serial");
+}
+
+// Encodes a large synthetic image with SkPngEncoder::Options::fExecutor, to compare the parallel
+// strips against the serial encoder (threads == 0).
+class PngParallelEncodeBench : public Benchmark {
+public:
+    PngParallelEncodeBench(int threads, int zlibLevel)
+        : fThreads(threads)
+        , fZLibLevel(zlibLevel)
+        , fName(SkStringPrintf("Encode_PNG_4096x4096_%d_%s", zlibLevel,
+                               threads_name(threads).c_str())) {}
+
+    bool isSuitableFor(Backend backend) override { return backend == kNonRendering_Backend; }
+
+    const char* onGetName() override { return fName.c_str(); }
+
+    void onDelayedSetup() override {
+        make_synthetic_photo(&fBitmap, 4096, 4096);
+        if (fThreads > 0) {
+            fExecutor = SkExecutor::MakeFIFOThreadPool(fThreads);
+        }
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        SkPngEncoder::Options opts;
+        opts.fZLibLevel = fZLibLevel;
+        opts.fExecutor = fExecutor.get();
+        while (loops-- > 0) {
+            SkNullWStream dst;
+            SkAssertResult(SkPngEncoder::Encode(&dst, fBitmap.pixmap(), opts));
+            SkASSERT(dst.bytesWritten() > 0);
+        }
+    }
+
+private:
+    const int                   fThreads;
+    const int                   fZLibLevel;
+    SkString                    fName;
+    SkBitmap                    fBitmap;
+    std::unique_ptr<SkExecutor> fExecutor;
+};
+
+#define PNG_PARALLEL(ZLIBLEVEL)                                            \
+    DEF_BENCH(return new PngParallelEncodeBench(0, ZLIBLEVEL));            \
+    DEF_BENCH(return new PngParallelEncodeBench(1, ZLIBLEVEL));            \
+    DEF_BENCH(return new PngParallelEncodeBench(2, ZLIBLEVEL));            \
+    DEF_BENCH(return new PngParallelEncodeBench(4, ZLIBLEVEL));            \
+    DEF_BENCH(return new PngParallelEncodeBench(8, ZLIBLEVEL));
+
+PNG_PARALLEL(1)
+PNG_PARALLEL(6)
+PNG_PARALLEL(9)
+
+#undef PNG_PARALLEL
+
+// Encodes a large synthetic image with SkJpegEncoder::Options::fExecutor, to compare the parallel
+// strips against the serial encoder (threads == 0).
+class JpegParallelEncodeBench : public Benchmark {
+public:
+    JpegParallelEncodeBench(int width, int height, int threads)
+        : fWidth(width)
+        , fHeight(height)
+        , fThreads(threads)
+        , fName(SkStringPrintf("Encode_JPEG_%dx%d_%s", width, height,
+                               threads_name(threads).c_str())) {}
+
+    bool isSuitableFor(Backend backend) override { return backend == kNonRendering_Backend; }
+
+    const char* onGetName() override { return fName.c_str(); }
+
+    void onDelayedSetup() override {
+        make_synthetic_photo(&fBitmap, fWidth, fHeight);
+        if (fThreads > 0) {
+            fExecutor = SkExecutor::MakeFIFOThreadPool(fThreads);
+        }
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        SkJpegEncoder::Options opts;
+        opts.fQuality = 90;
+        opts.fExecutor = fExecutor.get();
+        while (loops-- > 0) {
+            SkNullWStream dst;
+            SkAssertResult(SkJpegEncoder::Encode(&dst, fBitmap.pixmap(), opts));
+            SkASSERT(dst.bytesWritten() > 0);
+        }
+    }
+
+private:
+    const int                   fWidth;
+    const int                   fHeight;
+    const int                   fThreads;
+    SkString                    fName;
+    SkBitmap                    fBitmap;
+    std::unique_ptr<SkExecutor> fExecutor;
+};
+
+// 24, 50 and 100 megapixels.
+#define JPEG_PARALLEL(WIDTH, HEIGHT)                                       \
+    DEF_BENCH(return new JpegParallelEncodeBench(WIDTH, HEIGHT, 0));       \
+    DEF_BENCH(return new JpegParallelEncodeBench(WIDTH, HEIGHT, 1));       \
+    DEF_BENCH(return new JpegParallelEncodeBench(WIDTH, HEIGHT, 2));       \
+    DEF_BENCH(return new JpegParallelEncodeBench(WIDTH, HEIGHT, 4));       \
+    DEF_BENCH(return new JpegParallelEncodeBench(WIDTH, HEIGHT, 8));
+
+JPEG_PARALLEL( 6000, 4000)
+JPEG_PARALLEL( 8660, 5774)
+JPEG_PARALLEL(12240, 8160)
+
+#undef JPEG_PARALLEL
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2022 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "bench/Benchmark.h"
+#include "include/core/SkExecutor.h"
+#include "include/core/SkString.h"
+#include "src/core/SkTaskGroup.h"
+
+#include <memory>
+#include <vector>
+
+// Measures the overhead of running N tiny tasks on each kind of thread pool,
+// either add()ing each task to an SkTaskGroup or handing all N to SkTaskGroup::batch().
+class ExecutorBench : public Benchmark {
+public:
+    enum class Pool  { kFIFO, kLIFO, kWorkStealing };
+    enum class Style { kAdd, kBatch };
+
+    ExecutorBench(Pool pool, Style style, int N) : fPool(pool), fStyle(style), fN(N) {
+        static const char* kPoolNames[] = { "fifo", "lifo", "workstealing" };
+        fName.printf("executor_%s_%s_%d",
+                     kPoolNames[(int)pool], style == Style::kAdd ? "add" : "batch", N);
+    }
+
+protected:
+    const char* onGetName() override { return fName.c_str(); }
+
+    bool isSuitableFor(Backend backend) override {
+        return backend == kNonRendering_Backend;
+    }
+
+    void onDelayedSetup() override {
+        switch (fPool) {
+            case Pool::kFIFO:         fExecutor = SkExecutor::MakeFIFOThreadPool();   break;
+            case Pool::kLIFO:         fExecutor = SkExecutor::MakeLIFOThreadPool();   break;
+            case Pool::kWorkStealing: fExecutor = SkExecutor::MakeWorkStealingPool(); break;
+        }
+        fResults.resize(fN);
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        int* results = fResults.data();
+        for (int loop = 0; loop < loops; loop++) {
+            SkTaskGroup tg(*fExecutor);
+            if (fStyle == Style::kAdd) {
+                for (int i = 0; i < fN; i++) {
+                    tg.add([=] { results[i] += i; });
+                }
+            } else {
+                tg.batch(fN, [=](int i) { results[i] += i; });
+            }
+            tg.wait();
+        }
+    }
+
+private:
+    const Pool                  fPool;
+    const Style                 fStyle;
+    const int                   fN;
+    SkString                    fName;
+    std::unique_ptr<SkExecutor> fExecutor;
+    std::vector<int>            fResults;
+};
+
+#define EXECUTOR_BENCHES(N)                                                                     \
+    DEF_BENCH(return new ExecutorBench(ExecutorBench::Pool::kFIFO,                              \
+                                       ExecutorBench::Style::kAdd,   N);)                       \
+    DEF_BENCH(return new ExecutorBench(ExecutorBench::Pool::kLIFO,                              \
+                                       ExecutorBench::Style::kAdd,   N);)                       \
+    DEF_BENCH(return new ExecutorBench(ExecutorBench::Pool::kWorkStealing,                      \
+                                       ExecutorBench::Style::kAdd,   N);)                       \
+    DEF_BENCH(return new ExecutorBench(ExecutorBench::Pool::kFIFO,                              \
+                                       ExecutorBench::Style::kBatch, N);)                       \
+    DEF_BENCH(return new ExecutorBench(ExecutorBench::Pool::kLIFO,                              \
+                                       ExecutorBench::Style::kBatch, N);)                       \
+    DEF_BENCH(return new ExecutorBench(ExecutorBench::Pool::kWorkStealing,                      \
+                                       ExecutorBench::Style::kBatch, N);)
+
+EXECUTOR_BENCHES(1000)
+EXECUTOR_BENCHES(10000)
+EXECUTOR_BENCHES(100000)
+EXECUTOR_BENCHES(1000000)
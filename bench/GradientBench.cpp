@@ -8,13 +8,21 @@
 #include "include/core/SkBitmap.h"
 #include "include/core/SkCanvas.h"
 #include "include/core/SkColorPriv.h"
+#include "include/core/SkColorSpace.h"
 #include "include/core/SkPaint.h"
 #include "include/core/SkShader.h"
 #include "include/core/SkString.h"
 #include "include/effects/SkGradientShader.h"
+#include "src/core/SkArenaAlloc.h"
+#include "src/core/SkEffectPriv.h"
+#include "src/core/SkMatrixProvider.h"
+#include "src/core/SkRasterPipeline.h"
+#include "src/shaders/SkShaderBase.h"
 
 #include "tools/ToolUtils.h"
 
+#include <vector>
+
 struct GradData {
     int             fCount;
     const SkColor*  fColors;
@@ -308,6 +316,144 @@ DEF_BENCH( return new GradientBench(kConical_GradType, gGradData[3], false); )
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// Runs a gradient's raster pipeline directly, storing to a row of 8888 or F16 pixels.
+// The name ends in _lowp or _highp, whichever SkRasterPipeline picked for it.
+class GradientPipelineBench : public Benchmark {
+public:
+    enum class Dst { kN32, kN32_WideGamut, kF16 };
+
+    GradientPipelineBench(GradType gradType, GradData data, Dst dst)
+        : fPipeline(&fAlloc) {
+        const SkPoint pts[2] = {
+            { 0, 0 },
+            { SkIntToScalar(kSize), SkIntToScalar(kSize) }
+        };
+        fShader = gGrads[gradType].fMaker(pts, data, SkTileMode::kClamp, 1.0f);
+
+        const SkColorType ct = dst == Dst::kF16 ? kRGBA_F16_SkColorType : kN32_SkColorType;
+        sk_sp<SkColorSpace> cs;
+        switch (dst) {
+            case Dst::kN32:           cs = SkColorSpace::MakeSRGB();       break;
+            case Dst::kN32_WideGamut: cs = SkColorSpace::MakeRGB(SkNamedTransferFn::kSRGB,
+                                                                 SkNamedGamut::kRec2020); break;
+            case Dst::kF16:           cs = SkColorSpace::MakeSRGBLinear(); break;
+        }
+
+        fDst.resize(kSize);
+        fDstCtx = { fDst.data(), 0 };
+
+        SkPaint paint;
+        SkMatrixProvider matrixProvider(SkMatrix::I());
+        SkStageRec rec = {&fPipeline, &fAlloc, ct, cs.get(), paint, nullptr, matrixProvider};
+        SkAssertResult(as_SB(fShader)->appendStages(rec));
+        fPipeline.append_store(ct, &fDstCtx);
+
+        static const char* kDstNames[] = { "8888", "8888_wide", "f16" };
+        fName.printf("gradient_pipeline_%s%s_%s_%s", gGrads[gradType].fName, data.fName,
+                     kDstNames[(int)dst], fPipeline.isLowp() ? "lowp" : "highp");
+    }
+
+protected:
+    const char* onGetName() override { return fName.c_str(); }
+
+    bool isSuitableFor(Backend backend) override {
+        return backend == kNonRendering_Backend;
+    }
+
+    void onDelayedSetup() override {
+        fRun = fPipeline.compile();
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        for (int i = 0; i < loops; i++) {
+            // Every row is stored over the same scratch row; its stride is 0.
+            fRun(0, 0, kSize, kSize);
+        }
+    }
+
+private:
+    static const int kSize = 400;
+
+    SkString                   fName;
+    sk_sp<SkShader>            fShader;
+    std::vector<uint64_t>      fDst;  // Wide enough for F16.
+    SkRasterPipeline_MemoryCtx fDstCtx;
+    SkSTArenaAlloc<1024>       fAlloc;
+    SkRasterPipeline           fPipeline;
+
+    std::function<void(size_t, size_t, size_t, size_t)> fRun;
+};
+
+#define GRADIENT_PIPELINE_BENCHES(type, data)                                                  \
+    DEF_BENCH( return new GradientPipelineBench(type, data,                                   \
+                                                GradientPipelineBench::Dst::kN32); )           \
+    DEF_BENCH( return new GradientPipelineBench(type, data,                                   \
+                                                GradientPipelineBench::Dst::kN32_WideGamut); ) \
+    DEF_BENCH( return new GradientPipelineBench(type, data,                                   \
+                                                GradientPipelineBench::Dst::kF16); )
+
+GRADIENT_PIPELINE_BENCHES(kLinear_GradType,         gGradData[0])
+GRADIENT_PIPELINE_BENCHES(kLinear_GradType,         gGradData[2])
+GRADIENT_PIPELINE_BENCHES(kRadial_GradType,         gGradData[0])
+GRADIENT_PIPELINE_BENCHES(kSweep_GradType,          gGradData[2])
+GRADIENT_PIPELINE_BENCHES(kConical_GradType,        gGradData[0])
+GRADIENT_PIPELINE_BENCHES(kConicalOut_GradType,     gGradData[0])
+GRADIENT_PIPELINE_BENCHES(kConicalOutZero_GradType, gGradData[2])
+
+///////////////////////////////////////////////////////////////////////////////
+
+// A data-viz style heatmap ramp with many stops, drawn with and without a cached color table.
+class GradientHeatmapBench : public Benchmark {
+public:
+    GradientHeatmapBench(int stops, bool evenlySpaced, bool lut) {
+        fName.printf("gradient_heatmap_%d%s%s", stops, evenlySpaced ? "" : "_pos",
+                     lut ? "_lut" : "");
+
+        std::vector<SkColor>  colors(stops);
+        std::vector<SkScalar> pos(stops);
+        for (int i = 0; i < stops; i++) {
+            const float t = i / (stops - 1.0f);
+            colors[i] = SkColorSetRGB(SkScalarRoundToInt(255 * t),
+                                      SkScalarRoundToInt(255 * 4 * t * (1 - t)),
+                                      SkScalarRoundToInt(255 * (1 - t)));
+            // Uneven spacing, to defeat the evenly spaced fast path.
+            pos[i] = t * t;
+        }
+
+        const SkPoint pts[2] = {{0, 0}, {SkIntToScalar(kSize), SkIntToScalar(kSize)}};
+        fPaint.setShader(SkGradientShader::MakeLinear(
+                pts, colors.data(), evenlySpaced ? nullptr : pos.data(), stops,
+                SkTileMode::kClamp, lut ? SkGradientShader::kCacheColorLUT_Flag : 0, nullptr));
+    }
+
+protected:
+    const char* onGetName() override { return fName.c_str(); }
+
+    SkIPoint onGetSize() override { return SkIPoint::Make(kSize, kSize); }
+
+    void onDraw(int loops, SkCanvas* canvas) override {
+        const SkRect r = SkRect::MakeIWH(kSize, kSize);
+        for (int i = 0; i < loops; i++) {
+            canvas->drawRect(r, fPaint);
+        }
+    }
+
+private:
+    static const int kSize = 400;
+
+    SkString fName;
+    SkPaint  fPaint;
+};
+
+DEF_BENCH( return new GradientHeatmapBench( 64, false, false); )
+DEF_BENCH( return new GradientHeatmapBench( 64, false, true ); )
+DEF_BENCH( return new GradientHeatmapBench(256, false, false); )
+DEF_BENCH( return new GradientHeatmapBench(256, false, true ); )
+DEF_BENCH( return new GradientHeatmapBench(256, true,  false); )
+DEF_BENCH( return new GradientHeatmapBench(256, true,  true ); )
+
+///////////////////////////////////////////////////////////////////////////////
+
 class Gradient2Bench : public Benchmark {
     SkString fName;
     bool     fHasAlpha;
@@ -6,7 +6,18 @@
  */
 
 #include "bench/Benchmark.h"
+#include "include/core/SkCanvas.h"
+#include "include/core/SkImage.h"
+#include "include/core/SkImageEncoder.h"
+#include "include/core/SkStream.h"
+#include "include/core/SkString.h"
+#include "include/core/SkSurface.h"
+#include "include/utils/SkRandom.h"
 #include "src/core/SkResourceCache.h"
+#include "src/image/SkImage_Base.h"
+
+#include <thread>
+#include <vector>
 
 namespace {
 static void* gGlobalAddress;
@@ -74,4 +85,132 @@ private:
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// Hammers the global cache from several threads at once, the way raster threads share it.
+// Each thread looks up keys spread across the cache, mostly hits with a few misses.
+class ImageCacheMTBench : public Benchmark {
+    enum {
+        CACHE_COUNT = 500,
+        LOOKUPS_PER_LOOP = 64,
+    };
+public:
+    explicit ImageCacheMTBench(int threads) : fThreads(threads) {
+        fName.printf("imagecache_global_%dthreads", threads);
+    }
+
+protected:
+    const char* onGetName() override { return fName.c_str(); }
+
+    bool isSuitableFor(Backend backend) override {
+        return backend == kNonRendering_Backend;
+    }
+
+    void onDelayedSetup() override {
+        for (int i = 0; i < CACHE_COUNT; ++i) {
+            SkResourceCache::Add(new TestRec(TestKey(i), i));
+        }
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        auto lookups = [loops](int thread) {
+            intptr_t k = thread * 7919;
+            for (int i = 0; i < loops; ++i) {
+                for (int j = 0; j < LOOKUPS_PER_LOOP; ++j) {
+                    // About one in ten lookups misses.
+                    k = (k + 53) % (CACHE_COUNT + CACHE_COUNT / 10);
+                    SkResourceCache::Find(TestKey(k), TestRec::Visitor, nullptr);
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (int t = 1; t < fThreads; ++t) {
+            threads.emplace_back(lookups, t);
+        }
+        lookups(0);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+private:
+    const int fThreads;
+    SkString  fName;
+
+    using INHERITED = Benchmark;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Draws a freshly decoded 6000x4000 JPEG as a mipmapped 300x200 thumbnail, either decoding it at a
+// smaller size and building the mipmaps from that or, as it was drawn before that was possible,
+// from a full size decode. The time is mostly the decode.
+class ImageCacheThumbnailBench : public Benchmark {
+public:
+    explicit ImageCacheThumbnailBench(bool scaledDecodes) : fScaledDecodes(scaledDecodes) {
+        fName.printf("imagecache_thumbnail_decode%s", scaledDecodes ? "_scaled" : "");
+    }
+
+protected:
+    const char* onGetName() override { return fName.c_str(); }
+
+    bool isSuitableFor(Backend backend) override {
+        return backend == kNonRendering_Backend;
+    }
+
+    void onDelayedSetup() override {
+        SkBitmap bitmap;
+        bitmap.allocN32Pixels(6000, 4000, true);
+        bitmap.eraseColor(SK_ColorWHITE);
+        SkCanvas canvas(bitmap);
+        SkPaint paint;
+        SkRandom rand;
+        for (int i = 0; i < 500; ++i) {
+            paint.setColor(rand.nextU() | 0xFF000000);
+            canvas.drawCircle(rand.nextRangeF(0, 6000), rand.nextRangeF(0, 4000),
+                              rand.nextRangeF(10, 400), paint);
+        }
+        SkDynamicMemoryWStream stream;
+        SkAssertResult(SkEncodeImage(&stream, bitmap, SkEncodedImageFormat::kJPEG, 90));
+        fEncoded = stream.detachAsData();
+
+        fSurface = SkSurface::MakeRasterN32Premul(300, 200);
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        for (int i = 0; i < loops; ++i) {
+            this->drawThumbnail();
+        }
+    }
+
+private:
+    // Each image is new, so each draw decodes and builds mipmaps.
+    void drawThumbnail() {
+        sk_sp<SkImage> image = SkImage::MakeFromEncoded(fEncoded);
+        if (!fScaledDecodes) {
+            // With the full size pixels cached, the draw scales those down instead.
+            SkBitmap bitmap;
+            as_IB(image)->getROPixels(nullptr, &bitmap);
+        }
+        fSurface->getCanvas()->drawImageRect(image, SkRect::MakeWH(300, 200),
+                                             SkSamplingOptions(SkFilterMode::kLinear,
+                                                               SkMipmapMode::kLinear));
+    }
+
+    const bool       fScaledDecodes;
+    SkString         fName;
+    sk_sp<SkData>    fEncoded;
+    sk_sp<SkSurface> fSurface;
+
+    using INHERITED = Benchmark;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
 DEF_BENCH( return new ImageCacheBench(); )
+DEF_BENCH( return new ImageCacheMTBench(1); )
+DEF_BENCH( return new ImageCacheMTBench(4); )
+DEF_BENCH( return new ImageCacheMTBench(16); )
+DEF_BENCH( return new ImageCacheMTBench(32); )
+
+DEF_BENCH( return new ImageCacheThumbnailBench(false); )
+DEF_BENCH( return new ImageCacheThumbnailBench(true); )
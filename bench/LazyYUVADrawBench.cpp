@@ -0,0 +1,80 @@
+/*
+ * Copyright 2022 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "bench/Benchmark.h"
+#include "include/core/SkCanvas.h"
+#include "include/core/SkGraphics.h"
+#include "include/core/SkImage.h"
+#include "src/core/SkResourceCache.h"
+#include "tools/Resources.h"
+
+/**
+ * Draws a lazy jpeg to a raster canvas, either by sampling its YUV planes in place or by sampling
+ * the RGBA pixels decoded from them. With |decode|, every loop starts from a fresh image, so the
+ * cost of decoding (the planes or the RGBA pixels) is counted as well.
+ */
+class LazyYUVADrawBench : public Benchmark {
+public:
+    LazyYUVADrawBench(bool usePlanes, bool decode, bool linear)
+        : fUsePlanes(usePlanes)
+        , fDecode(decode)
+        , fSampling(linear ? SkSamplingOptions(SkFilterMode::kLinear) : SkSamplingOptions()) {
+        fName.printf("lazy_yuva_draw_%s_%s%s", usePlanes ? "planes" : "rgba",
+                     decode ? "decode" : "cached", linear ? "_linear" : "");
+    }
+
+    bool isSuitableFor(Backend backend) override { return backend == kRaster_Backend; }
+
+protected:
+    const char* onGetName() override { return fName.c_str(); }
+
+    void onDelayedSetup() override {
+        fData = GetResourceAsData("images/mandrill_512_q075.jpg");
+    }
+
+    void onPerCanvasPreDraw(SkCanvas*) override {
+        fImage = SkImage::MakeFromEncoded(fData);
+        fUsedPlanes = SkGraphics::SetRasterDrawsFromYUVAPlanes(fUsePlanes);
+    }
+
+    void onPerCanvasPostDraw(SkCanvas*) override {
+        SkGraphics::SetRasterDrawsFromYUVAPlanes(fUsedPlanes);
+        fImage.reset();
+        SkResourceCache::PurgeAll();
+    }
+
+    void onDraw(int loops, SkCanvas* canvas) override {
+        if (!fImage) {
+            return;
+        }
+        for (int i = 0; i < loops; i++) {
+            if (fDecode) {
+                SkResourceCache::PurgeAll();
+                fImage = SkImage::MakeFromEncoded(fData);
+            }
+            canvas->drawImage(fImage, 0, 0, fSampling);
+        }
+    }
+
+private:
+    const bool              fUsePlanes;
+    const bool              fDecode;
+    const SkSamplingOptions fSampling;
+    SkString                fName;
+    sk_sp<SkData>           fData;
+    sk_sp<SkImage>          fImage;
+    bool                    fUsedPlanes = false;
+
+    using INHERITED = Benchmark;
+};
+
+DEF_BENCH(return new LazyYUVADrawBench(true,  true,  false);)
+DEF_BENCH(return new LazyYUVADrawBench(false, true,  false);)
+DEF_BENCH(return new LazyYUVADrawBench(true,  false, false);)
+DEF_BENCH(return new LazyYUVADrawBench(false, false, false);)
+DEF_BENCH(return new LazyYUVADrawBench(true,  false, true);)
+DEF_BENCH(return new LazyYUVADrawBench(false, false, true);)
@@ -7,6 +7,7 @@
 
 #include "bench/Benchmark.h"
 #include "include/core/SkBitmap.h"
+#include "include/core/SkExecutor.h"
 #include "src/core/SkMipmap.h"
 
 class MipmapBench: public Benchmark {
@@ -14,15 +15,24 @@ class MipmapBench: public Benchmark {
     SkString fName;
     const int fW, fH;
     bool fHalfFoat;
+    bool fFirstLevel;
+    int fThreads;
+    std::unique_ptr<SkExecutor> fExecutor;
 
 public:
-    MipmapBench(int w, int h, bool halfFloat = false)
-        : fW(w), fH(h), fHalfFoat(halfFloat)
+    // If firstLevel is set, this times building a mipmap lazily and asking for its first level
+    // (what a scaled draw waits for), rather than building the full chain. If threads is not 0,
+    // large levels are downsampled in bands on a pool of that many threads.
+    MipmapBench(int w, int h, bool halfFloat = false, bool firstLevel = false, int threads = 0)
+        : fW(w), fH(h), fHalfFoat(halfFloat), fFirstLevel(firstLevel), fThreads(threads)
     {
-        fName.printf("mipmap_build_%dx%d", w, h);
+        fName.printf("mipmap_build_%s%dx%d", firstLevel ? "first_level_" : "", w, h);
         if (halfFloat) {
             fName.append("_f16");
         }
+        if (threads) {
+            fName.appendf("_%dthreads", threads);
+        }
     }
 
 protected:
@@ -38,12 +48,26 @@ protected:
                                              SkColorSpace::MakeSRGB());
         fBitmap.allocPixels(info);
         fBitmap.eraseColor(SK_ColorWHITE);  // so we don't read uninitialized memory
+        if (fThreads) {
+            fExecutor = SkExecutor::MakeFIFOThreadPool(fThreads);
+        }
     }
 
     void onDraw(int loops, SkCanvas*) override {
+        SkExecutor* defaultExecutor = &SkExecutor::GetDefault();
+        if (fExecutor) {
+            SkExecutor::SetDefault(fExecutor.get());
+        }
         for (int i = 0; i < loops * 4; i++) {
-            SkMipmap::Build(fBitmap, nullptr)->unref();
+            if (fFirstLevel) {
+                SkMipmap* mipmap = SkMipmap::BuildLazily(fBitmap.pixmap(), nullptr);
+                SkAssertResult(mipmap->getLevel(0, nullptr));
+                mipmap->unref();
+            } else {
+                SkMipmap::Build(fBitmap, nullptr)->unref();
+            }
         }
+        SkExecutor::SetDefault(defaultExecutor);
     }
 
 private:
@@ -65,3 +89,12 @@ DEF_BENCH( return new MipmapBench(2048, 2048); )
 DEF_BENCH( return new MipmapBench(2047, 2047); )
 DEF_BENCH( return new MipmapBench(2048, 2047); )
 DEF_BENCH( return new MipmapBench(2047, 2048); )
+
+// Time to the first level, against the full chain above, and how both scale with threads.
+DEF_BENCH( return new MipmapBench(2048, 2048, false, true); )
+DEF_BENCH( return new MipmapBench(2047, 2047, false, true); )
+DEF_BENCH( return new MipmapBench(2048, 2048, true,  true); )
+DEF_BENCH( return new MipmapBench(4096, 4096, false, false); )
+DEF_BENCH( return new MipmapBench(4096, 4096, false, true); )
+DEF_BENCH( return new MipmapBench(4096, 4096, false, false, 4); )
+DEF_BENCH( return new MipmapBench(4096, 4096, false, true,  4); )
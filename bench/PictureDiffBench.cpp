@@ -0,0 +1,142 @@
+/*
+ * Copyright 2022 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "bench/Benchmark.h"
+#include "include/core/SkCanvas.h"
+#include "include/core/SkPaint.h"
+#include "include/core/SkPath.h"
+#include "include/core/SkPicture.h"
+#include "include/core/SkPictureRecorder.h"
+#include "include/core/SkRRect.h"
+#include "include/core/SkSurface.h"
+#include "include/utils/SkPictureDiff.h"
+#include "include/utils/SkRandom.h"
+
+#include <vector>
+
+/**
+ * Diffs two consecutive frames of a picture laid out like a UI screen: a toolbar over a list of
+ * cards with images and content, each card recorded as a nested picture as a view hierarchy
+ * would. Between the frames either one card's progress bar animates (|scroll| false), or the
+ * whole list scrolls by a few pixels.
+ */
+class PictureDiffBench : public Benchmark {
+public:
+    PictureDiffBench(bool scroll) : fScroll(scroll) {
+        fName.printf("picture_diff_%s", scroll ? "scroll" : "animate");
+    }
+
+    bool isSuitableFor(Backend backend) override { return backend == kNonRendering_Backend; }
+
+protected:
+    const char* onGetName() override { return fName.c_str(); }
+
+    void onDelayedSetup() override {
+        sk_sp<SkSurface> surface = SkSurface::MakeRaster(
+                SkImageInfo::MakeN32(96, 96, kOpaque_SkAlphaType));
+        surface->getCanvas()->clear(SK_ColorLTGRAY);
+        surface->getCanvas()->drawCircle(48, 48, 32, SkPaint());
+        sk_sp<SkImage> image = surface->makeImageSnapshot();
+
+        std::vector<sk_sp<SkPicture>> cards;
+        SkRandom rand;
+        for (int i = 0; i < kCards; i++) {
+            cards.push_back(recordCard(image, &rand));
+        }
+        fBefore = recordFrame(cards, 0, 0.25f);
+        fAfter  = fScroll ? recordFrame(cards, 6, 0.25f)
+                          : recordFrame(cards, 0, 0.5f);
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        for (int i = 0; i < loops; i++) {
+            SkRegion damage = SkPictureDiff::Damage(fBefore.get(), fAfter.get(),
+                                                    SkIRect::MakeWH(kWidth, kHeight));
+            if (damage.isEmpty()) {
+                SK_ABORT("Frames should differ.");
+            }
+        }
+    }
+
+private:
+    inline static constexpr int kWidth  = 512;
+    inline static constexpr int kHeight = 1024;
+    inline static constexpr int kCards  = 12;
+
+    static sk_sp<SkPicture> recordCard(const sk_sp<SkImage>& image, SkRandom* rand) {
+        const SkRect card = SkRect::MakeWH(kWidth - 16, 120);
+        SkPictureRecorder recorder;
+        SkCanvas* canvas = recorder.beginRecording(card.makeOutset(0, 4));
+        SkPaint paint;
+        paint.setAntiAlias(true);
+
+        paint.setColor(0x20000000);
+        canvas->drawRRect(SkRRect::MakeRectXY(card.makeOffset(0, 2), 8, 8), paint);
+        paint.setColor(SK_ColorWHITE);
+        canvas->drawRRect(SkRRect::MakeRectXY(card, 8, 8), paint);
+
+        canvas->save();
+        canvas->clipRect(card.makeInset(8, 8));
+        canvas->drawImageRect(image, SkRect::MakeXYWH(12, 12, 96, 96),
+                              SkSamplingOptions(SkFilterMode::kLinear));
+        for (int line = 0; line < 5; line++) {
+            paint.setColor(rand->nextU() | 0xFF000000);
+            const SkScalar top = 20 + 18 * line;
+            SkPath path;
+            path.moveTo(124, top)
+                .cubicTo(200, top - 4, 300, top + 8, card.right() - rand->nextRangeScalar(24, 200),
+                         top)
+                .lineTo(card.right() - 24, top + 10)
+                .lineTo(124, top + 10)
+                .close();
+            canvas->drawPath(path, paint);
+        }
+        canvas->restore();
+        return recorder.finishRecordingAsPicture();
+    }
+
+    // Draws the list scrolled up by |scroll|, with the third card's progress bar at |progress|.
+    static sk_sp<SkPicture> recordFrame(const std::vector<sk_sp<SkPicture>>& cards,
+                                        SkScalar scroll, float progress) {
+        SkPictureRecorder recorder;
+        SkCanvas* canvas = recorder.beginRecording(SkRect::MakeWH(kWidth, kHeight));
+        SkPaint paint;
+        paint.setAntiAlias(true);
+
+        canvas->drawColor(SK_ColorWHITE);
+        canvas->save();
+        canvas->clipRect(SkRect::MakeLTRB(0, 64, kWidth, kHeight));
+        for (int i = 0; i < kCards; i++) {
+            const SkScalar y = 72 + 128 * i - scroll;
+            canvas->save();
+            canvas->translate(8, y);
+            canvas->drawPicture(cards[i]);
+            if (i == 2) {
+                paint.setColor(SK_ColorLTGRAY);
+                canvas->drawRect(SkRect::MakeXYWH(124, 104, 240, 6), paint);
+                paint.setColor(0xFF3050A0);
+                canvas->drawRect(SkRect::MakeXYWH(124, 104, 240 * progress, 6), paint);
+            }
+            canvas->restore();
+        }
+        canvas->restore();
+
+        paint.setColor(0xFF3050A0);
+        canvas->drawRect(SkRect::MakeWH(kWidth, 64), paint);
+        return recorder.finishRecordingAsPicture();
+    }
+
+    const bool       fScroll;
+    SkString         fName;
+    sk_sp<SkPicture> fBefore,
+                     fAfter;
+
+    using INHERITED = Benchmark;
+};
+
+DEF_BENCH(return new PictureDiffBench(false);)
+DEF_BENCH(return new PictureDiffBench(true);)
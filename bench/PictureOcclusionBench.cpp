@@ -0,0 +1,108 @@
+/*
+ * Copyright 2022 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "bench/Benchmark.h"
+#include "include/core/SkCanvas.h"
+#include "include/core/SkPaint.h"
+#include "include/core/SkPath.h"
+#include "include/core/SkPicture.h"
+#include "include/core/SkPictureRecorder.h"
+#include "include/core/SkRRect.h"
+#include "include/core/SkSurface.h"
+#include "include/utils/SkRandom.h"
+
+/**
+ * Plays back a picture laid out like a UI screen: a background, a list of cards with images and
+ * content drawn over it, and (with |covered|) an opaque sheet sliding in over most of the list,
+ * as during a screen transition. Compares playback of the picture recorded with and without
+ * SkPictureRecorder::kSkipOccludedDraws_RecordFlag.
+ */
+class PictureOcclusionBench : public Benchmark {
+public:
+    PictureOcclusionBench(bool skip, bool covered) : fSkip(skip), fCovered(covered) {
+        fName.printf("picture_occlusion_%s%s", covered ? "covered_" : "",
+                     skip ? "skip" : "draw");
+    }
+
+    bool isSuitableFor(Backend backend) override { return backend != kNonRendering_Backend; }
+
+protected:
+    const char* onGetName() override { return fName.c_str(); }
+    SkIPoint onGetSize() override { return SkIPoint::Make(kWidth, kHeight); }
+
+    void onDelayedSetup() override {
+        sk_sp<SkSurface> surface = SkSurface::MakeRaster(
+                SkImageInfo::MakeN32(96, 96, kOpaque_SkAlphaType));
+        surface->getCanvas()->clear(SK_ColorLTGRAY);
+        surface->getCanvas()->drawCircle(48, 48, 32, SkPaint());
+        sk_sp<SkImage> image = surface->makeImageSnapshot();
+
+        SkPictureRecorder recorder;
+        SkRTreeFactory factory;
+        SkCanvas* canvas = recorder.beginRecording(
+                SkRect::MakeWH(kWidth, kHeight), &factory,
+                fSkip ? SkPictureRecorder::kSkipOccludedDraws_RecordFlag : 0);
+        SkRandom rand;
+        SkPaint paint;
+        paint.setAntiAlias(true);
+
+        canvas->drawColor(SK_ColorWHITE);
+        for (int y = 8; y < kHeight; y += 128) {
+            const SkRect card = SkRect::MakeXYWH(8, y, kWidth - 16, 120);
+            paint.setColor(0x20000000);
+            canvas->drawRRect(SkRRect::MakeRectXY(card.makeOffset(0, 2), 8, 8), paint);
+            paint.setColor(SK_ColorWHITE);
+            canvas->drawRRect(SkRRect::MakeRectXY(card, 8, 8), paint);
+
+            canvas->save();
+            canvas->clipRect(card.makeInset(8, 8));
+            canvas->drawImageRect(image, SkRect::MakeXYWH(card.left() + 12, y + 12, 96, 96),
+                                  SkSamplingOptions(SkFilterMode::kLinear));
+            for (int line = 0; line < 5; line++) {
+                paint.setColor(rand.nextU() | 0xFF000000);
+                const SkScalar top = y + 20 + 18 * line;
+                SkPath path;
+                path.moveTo(card.left() + 124, top)
+                    .cubicTo(card.left() + 200, top - 4, card.left() + 300, top + 8,
+                             card.right() - rand.nextRangeScalar(24, 200), top)
+                    .lineTo(card.right() - 24, top + 10)
+                    .lineTo(card.left() + 124, top + 10)
+                    .close();
+                canvas->drawPath(path, paint);
+            }
+            canvas->restore();
+        }
+
+        if (fCovered) {
+            paint.setColor(0xFF3050A0);
+            canvas->drawRect(SkRect::MakeLTRB(64, 0, kWidth, kHeight), paint);
+        }
+        fPicture = recorder.finishRecordingAsPicture();
+    }
+
+    void onDraw(int loops, SkCanvas* canvas) override {
+        for (int i = 0; i < loops; i++) {
+            canvas->drawPicture(fPicture);
+        }
+    }
+
+private:
+    inline static constexpr int kWidth  = 512;
+    inline static constexpr int kHeight = 1024;
+
+    const bool       fSkip;
+    const bool       fCovered;
+    SkString         fName;
+    sk_sp<SkPicture> fPicture;
+
+    using INHERITED = Benchmark;
+};
+
+DEF_BENCH(return new PictureOcclusionBench(true,  false);)
+DEF_BENCH(return new PictureOcclusionBench(false, false);)
+DEF_BENCH(return new PictureOcclusionBench(true,  true);)
+DEF_BENCH(return new PictureOcclusionBench(false, true);)
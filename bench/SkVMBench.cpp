@@ -0,0 +1,99 @@
+/*
+ * Copyright 2022 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "bench/Benchmark.h"
+#include "include/core/SkString.h"
+#include "src/core/SkVM.h"
+
+#include <vector>
+
+// Runs a few typical raster blitter programs over a row of pixels with each way SkVM
+// has to run them: the switch-based interpreter, the threaded interpreter, and the JIT.
+// In builds that can't JIT, the jit benches fall back to the threaded interpreter.
+class SkVMBench : public Benchmark {
+public:
+    using Engine = skvm::Engine;
+    enum class Kind { kPremul, kSrcOver, kCoverage };
+
+    SkVMBench(Engine engine, Kind kind) : fEngine(engine), fKind(kind) {
+        static const char* kEngineNames[] = { "switch", "threaded", "jit" };
+        static const char* kKindNames[]   = { "premul", "srcover", "coverage" };
+        fName.printf("skvm_%s_%s", kKindNames[(int)kind], kEngineNames[(int)engine]);
+    }
+
+protected:
+    const char* onGetName() override { return fName.c_str(); }
+
+    bool isSuitableFor(Backend backend) override {
+        return backend == kNonRendering_Backend;
+    }
+
+    void onDelayedSetup() override {
+        const skvm::PixelFormat rgba_8888 =
+                skvm::SkColorType_to_PixelFormat(kRGBA_8888_SkColorType);
+
+        // For kCoverage, src is 8-bit coverage instead of a row of source pixels.
+        skvm::Builder b;
+        skvm::Ptr src = b.varying(fKind == Kind::kCoverage ? 1 : 4),
+                  dst = b.varying<int>();
+        switch (fKind) {
+            case Kind::kPremul:
+                b.store(rgba_8888, dst, b.premul(b.load(rgba_8888, src)));
+                break;
+
+            case Kind::kSrcOver:
+                b.store(rgba_8888, dst, b.blend(SkBlendMode::kSrcOver,
+                                                b.load(rgba_8888, src),
+                                                b.load(rgba_8888, dst)));
+                break;
+
+            case Kind::kCoverage: {
+                skvm::UPtr uniforms = b.uniform();
+                skvm::Color c = {b.uniformF(uniforms,  0), b.uniformF(uniforms,  4),
+                                 b.uniformF(uniforms,  8), b.uniformF(uniforms, 12)},
+                            d = b.load(rgba_8888, dst);
+                b.store(rgba_8888, dst, b.lerp(d, b.blend(SkBlendMode::kSrcOver, c, d),
+                                               b.from_unorm(8, b.load8(src))));
+            } break;
+        }
+
+        fVM = b.done(fName.c_str(), fEngine);
+
+        fSrc.assign(kPixels, 0x80402010);
+        fDst.assign(kPixels, 0xff808080);
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        const float color[] = { 0.125f, 0.25f, 0.375f, 0.75f };
+        for (int i = 0; i < loops; i++) {
+            if (fKind == Kind::kCoverage) {
+                fVM.eval(kPixels, fSrc.data(), fDst.data(), color);
+            } else {
+                fVM.eval(kPixels, fSrc.data(), fDst.data());
+            }
+        }
+    }
+
+private:
+    static constexpr int kPixels = 1024;
+
+    const Engine          fEngine;
+    const Kind            fKind;
+    SkString              fName;
+    skvm::Program         fVM;
+    std::vector<uint32_t> fSrc,
+                          fDst;
+};
+
+#define SKVM_BENCHES(kind)                                                                      \
+    DEF_BENCH(return new SkVMBench(SkVMBench::Engine::kSwitch,   SkVMBench::Kind::kind);)       \
+    DEF_BENCH(return new SkVMBench(SkVMBench::Engine::kThreaded, SkVMBench::Kind::kind);)       \
+    DEF_BENCH(return new SkVMBench(SkVMBench::Engine::kJIT,      SkVMBench::Kind::kind);)
+
+SKVM_BENCHES(kPremul)
+SKVM_BENCHES(kSrcOver)
+SKVM_BENCHES(kCoverage)
@@ -0,0 +1,46 @@
+/*
+ * Copyright 2022 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "bench/TiledRasterBench.h"
+#include "include/core/SkCanvas.h"
+
+namespace {
+
+// Runs all work on the calling thread, so a single-threaded run has no pool to wait on.
+class InlineExecutor final : public SkExecutor {
+    void add(std::function<void(void)> work) override {
+        work();
+    }
+};
+
+}  // namespace
+
+TiledRasterBench::TiledRasterBench(const char* name, const SkPicture* pic, int threads, int tiles)
+    : INHERITED(name, pic)
+    , fThreads(threads)
+    , fTiles(tiles) {
+    fName.appendf("_tiled%d_%dthreads", fTiles, fThreads);
+}
+
+void TiledRasterBench::onDelayedSetup() {
+    // The calling thread helps out while it waits for the tiles, so it counts as one of ours.
+    fExecutor = fThreads > 1 ? SkExecutor::MakeFIFOThreadPool(fThreads - 1)
+                             : std::make_unique<InlineExecutor>();
+
+    SkIPoint size = this->getSize();
+    fSurface = SkSurface::MakeRasterTiled(SkImageInfo::MakeN32Premul(size.fX, size.fY),
+                                          fExecutor.get(), fTiles);
+}
+
+void TiledRasterBench::onDraw(int loops, SkCanvas*) {
+    while (loops --> 0) {
+        // Play the ops back rather than drawing the picture, so the surface records each op
+        // itself and can cull them per tile.
+        fSrc->playback(fSurface->getCanvas());
+        fSurface->flush();
+    }
+}
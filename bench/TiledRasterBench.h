@@ -0,0 +1,38 @@
+/*
+ * Copyright 2022 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef TiledRasterBench_DEFINED
+#define TiledRasterBench_DEFINED
+
+#include "bench/RecordingBench.h"
+#include "include/core/SkExecutor.h"
+#include "include/core/SkSurface.h"
+
+#include <memory>
+
+/**
+ * Plays an SkPicture into a surface from SkSurface::MakeRasterTiled(), rasterizing its tiles on
+ * a fixed number of threads.  Run with several thread counts to see how playback scales.
+ */
+class TiledRasterBench : public PictureCentricBench {
+public:
+    TiledRasterBench(const char* name, const SkPicture*, int threads, int tiles);
+
+protected:
+    void onDelayedSetup() override;
+    void onDraw(int loops, SkCanvas*) override;
+
+private:
+    const int fThreads;
+    const int fTiles;
+    std::unique_ptr<SkExecutor> fExecutor;
+    sk_sp<SkSurface> fSurface;
+
+    using INHERITED = PictureCentricBench;
+};
+
+#endif//TiledRasterBench_DEFINED
@@ -6,12 +6,15 @@
  */
 
 #include "bench/Benchmark.h"
+#include "include/core/SkBlender.h"
 #include "include/core/SkCanvas.h"
+#include "include/core/SkCustomMesh.h"
 #include "include/core/SkPaint.h"
 #include "include/core/SkShader.h"
 #include "include/core/SkString.h"
 #include "include/core/SkVertices.h"
 #include "include/utils/SkRandom.h"
+#include "src/core/SkCanvasPriv.h"
 #include "tools/Resources.h"
 
 // Just want to trigger perspective handling, not dramatically change size
@@ -27,6 +30,8 @@ enum VertFlags {
     kTexture_VertFlag = 1 << 1,
     kPersp_VertFlag   = 1 << 2,
     kBilerp_VertFlag  = 1 << 3,
+    // Draws the same mesh with drawCustomMesh(), through an equivalent SkCustomMeshSpecification.
+    kCustomMesh_VertFlag = 1 << 4,
 };
 
 class VertBench : public Benchmark {
@@ -61,8 +66,73 @@ class VertBench : public Benchmark {
                 fShader = img->makeShader(SkSamplingOptions(fm));
             }
         }
+#ifdef SK_ENABLE_SKSL
+        if (fFlags & kCustomMesh_VertFlag) {
+            this->setupCustomMesh();
+        }
+#endif
+    }
+
+#ifdef SK_ENABLE_SKSL
+    struct MeshVertex {
+        SkPoint  pos;
+        SkPoint  tex;
+        SkColor  color;
+    };
+
+    void setupCustomMesh() {
+        using Attribute = SkCustomMeshSpecification::Attribute;
+        using Varying   = SkCustomMeshSpecification::Varying;
+
+        static const Attribute kAttributes[]{
+                {Attribute::Type::kFloat2,        0, SkString{"pos"}  },
+                {Attribute::Type::kFloat2,        8, SkString{"tex"}  },
+                {Attribute::Type::kUByte4_unorm, 16, SkString{"color"}},
+        };
+        static const Varying kVaryings[]{
+                {Varying::Type::kHalf4,  SkString{"color"}},
+                {Varying::Type::kFloat2, SkString{"tex"}  },
+        };
+        static constexpr char kVS[] = R"(
+                float2 main(in Attributes a, out Varyings v) {
+                    v.color = a.color.bgra;
+                    v.tex   = a.tex;
+                    return a.pos;
+                }
+        )";
+        const bool colors = fFlags & kColors_VertFlag,
+                   texs   = fFlags & kTexture_VertFlag;
+        SkString fs = SkStringPrintf("%s main(in Varyings v%s) {",
+                                     texs   ? "float2" : "void",
+                                     colors ? ", out half4 color" : "");
+        if (colors) {
+            fs.append(" color = v.color;");
+        }
+        if (texs) {
+            fs.append(" return v.tex;");
+        }
+        fs.append(" }");
+
+        auto [spec, error] = SkCustomMeshSpecification::Make(
+                SkMakeSpan(kAttributes, SK_ARRAY_COUNT(kAttributes)),
+                sizeof(MeshVertex),
+                SkMakeSpan(kVaryings, SK_ARRAY_COUNT(kVaryings)),
+                SkString(kVS),
+                fs);
+        if (!spec) {
+            SkDebugf("%s\n", error.c_str());
+        }
+        fSpec = std::move(spec);
+
+        for (int i = 0; i < PTS; ++i) {
+            fMeshVertices[i] = {fPts[i], fTex[i], fColors[i]};
+        }
     }
 
+    sk_sp<SkCustomMeshSpecification> fSpec;
+    MeshVertex                       fMeshVertices[PTS];
+#endif
+
 public:
     VertBench(unsigned flags) : fFlags(flags) {
         const SkScalar dx = SkIntToScalar(W) / COL;
@@ -102,7 +172,7 @@ public:
             fColors[i] = rand.nextU() | (0xFF << 24);
         }
 
-        fName.set("verts");
+        fName.set((fFlags & kCustomMesh_VertFlag) ? "custommesh" : "verts");
         if (fFlags & kTexture_VertFlag) {
             fName.append("_textures");
         }
@@ -128,6 +198,27 @@ protected:
             tiny_persp_effect(canvas);
         }
 
+#ifdef SK_ENABLE_SKSL
+        if (fFlags & kCustomMesh_VertFlag) {
+            if (!fSpec) {
+                return;
+            }
+            for (int i = 0; i < loops; i++) {
+                SkCustomMesh cm;
+                cm.spec    = fSpec;
+                cm.mode    = SkCustomMesh::Mode::kTriangles;
+                cm.bounds  = SkRect::MakeWH(W, H);
+                cm.vb      = fMeshVertices;
+                cm.vcount  = PTS;
+                cm.indices = fIdx;
+                cm.icount  = IDX;
+                SkCanvasPriv::DrawCustomMesh(canvas, std::move(cm),
+                                             SkBlender::Mode(SkBlendMode::kModulate), paint);
+            }
+            return;
+        }
+#endif
+
         const SkPoint* texs = (fFlags & kTexture_VertFlag) ? fTex    : nullptr;
         const SkColor* cols = (fFlags & kColors_VertFlag)  ? fColors : nullptr;
         auto verts = SkVertices::MakeCopy(SkVertices::kTriangles_VertexMode, PTS,
@@ -148,6 +239,14 @@ DEF_BENCH(return new VertBench(kColors_VertFlag);)
 DEF_BENCH(return new VertBench(kColors_VertFlag | kTexture_VertFlag);)
 DEF_BENCH(return new VertBench(kColors_VertFlag | kTexture_VertFlag | kBilerp_VertFlag);)
 
+#ifdef SK_ENABLE_SKSL
+DEF_BENCH(return new VertBench(kCustomMesh_VertFlag | kTexture_VertFlag | kPersp_VertFlag);)
+DEF_BENCH(return new VertBench(kCustomMesh_VertFlag | kColors_VertFlag  | kPersp_VertFlag);)
+DEF_BENCH(return new VertBench(kCustomMesh_VertFlag | kTexture_VertFlag);)
+DEF_BENCH(return new VertBench(kCustomMesh_VertFlag | kColors_VertFlag);)
+DEF_BENCH(return new VertBench(kCustomMesh_VertFlag | kColors_VertFlag | kTexture_VertFlag);)
+#endif
+
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "include/core/SkRSXform.h"
@@ -21,6 +21,7 @@
 #include "bench/SKPBench.h"
 #include "bench/SkGlyphCacheBench.h"
 #include "bench/SkSLBench.h"
+#include "bench/TiledRasterBench.h"
 #include "include/codec/SkAndroidCodec.h"
 #include "include/codec/SkCodec.h"
 #include "include/core/SkCanvas.h"
@@ -33,9 +34,11 @@
 #include "src/core/SkAutoMalloc.h"
 #include "src/core/SkColorSpacePriv.h"
 #include "src/core/SkLeanWindows.h"
+#include "src/core/SkMappedPicture.h"
 #include "src/core/SkOSFile.h"
 #include "src/core/SkTaskGroup.h"
 #include "src/core/SkTraceEvent.h"
+#include "src/core/SkVMBlitter.h"
 #include "src/utils/SkJSONWriter.h"
 #include "src/utils/SkOSPath.h"
 #include "src/utils/SkShaderUtils.h"
@@ -127,6 +130,13 @@ static DEFINE_string(zoom, "1.0,0",
                      "function that ping-pongs between 1.0 and zoomMax.");
 static DEFINE_bool(bbh, true, "Build a BBH for SKPs?");
 static DEFINE_bool(loopSKP, true, "Loop SKPs like we do for micro benches?");
+static DEFINE_bool(mappedSKPs, false,
+                   "Convert SKPs to the mapped picture format, to bench deserializing and playing "
+                   "them back that way too.");
+static DEFINE_string(tiledRasterThreads, "",
+                     "Space-separated thread counts to play SKPs back with on a tiled raster "
+                     "surface, e.g. \"1 2 4 8\".");
+static DEFINE_int(tiledRasterTiles, 16, "Tiles per tiled raster surface.");
 static DEFINE_int(flushEvery, 10, "Flush --outResultsFile every Nth run.");
 static DEFINE_bool(gpuStats, false, "Print GPU stats after each gpu benchmark?");
 static DEFINE_bool(gpuStatsDump, false, "Dump GPU stats after each benchmark to json");
@@ -144,6 +154,8 @@ static DEFINE_bool(forceRasterPipelineHP, false, "sets gSkForceRasterPipelineBli
 static DEFINE_bool(skvm, false, "sets gUseSkVMBlitter");
 static DEFINE_bool(jit, true, "JIT SkVM?");
 static DEFINE_bool(dylib, false, "JIT via dylib (much slower compile but easier to debug/profile)");
+static DEFINE_string(skvmProgramCacheDir, "",
+                     "If set, save SkVM blitter programs here and load them from here.");
 
 static DEFINE_bool2(pre_log, p, false,
                     "Log before running each test. May be incomprehensible when threading");
@@ -801,6 +813,47 @@ public:
             return new DeserializePictureBench(name.c_str(), std::move(data));
         }
 
+        // And again converted to the mapped format, if asked.
+        while (FLAGS_mappedSKPs && fCurrentMappedDeserialPicture < fSKPs.count()) {
+            const SkString& path = fSKPs[fCurrentMappedDeserialPicture++];
+            sk_sp<SkPicture> pic = ReadPicture(path.c_str());
+            sk_sp<SkData> data = pic ? SkMappedPicture::Serialize(pic.get()) : nullptr;
+            if (!data) {
+                continue;
+            }
+            SkString name = SkOSPath::Basename(path.c_str());
+            fSourceType = "skp";
+            fBenchType  = "deserial_mapped";
+            fSKPBytes = static_cast<double>(data->size());
+            fSKPOps   = 0;
+            return new DeserializePictureBench(name.c_str(), std::move(data));
+        }
+
+        // Add all .skps as TiledRasterBenches, once for each thread count.
+        while (fCurrentTiledThreads < FLAGS_tiledRasterThreads.count()) {
+            while (fCurrentTiledSKP < fSKPs.count()) {
+                const SkString& path = fSKPs[fCurrentTiledSKP++];
+                sk_sp<SkPicture> pic = ReadPicture(path.c_str());
+                if (!pic) {
+                    continue;
+                }
+                int threads = atoi(FLAGS_tiledRasterThreads[fCurrentTiledThreads]);
+                if (threads < 1) {
+                    SkDebugf("Can't parse %s from --tiledRasterThreads as a thread count.\n",
+                             FLAGS_tiledRasterThreads[fCurrentTiledThreads]);
+                    exit(1);
+                }
+                SkString name = SkOSPath::Basename(path.c_str());
+                fSourceType = "skp";
+                fBenchType  = "tiled_playback";
+                fTiledThreads = threads;
+                return new TiledRasterBench(name.c_str(), pic.get(), threads,
+                                            FLAGS_tiledRasterTiles);
+            }
+            fCurrentTiledSKP = 0;
+            fCurrentTiledThreads++;
+        }
+
         // Then once each for each scale as SKPBenches (playback).
         while (fCurrentScale < fScales.count()) {
             while (fCurrentSKP < fSKPs.count()) {
@@ -810,7 +863,13 @@ public:
                     continue;
                 }
 
-                if (FLAGS_bbh) {
+                if (FLAGS_mappedSKPs) {
+                    // Mapped pictures carry their own R-tree.
+                    pic = SkMappedPicture::Make(SkMappedPicture::Serialize(pic.get()));
+                    if (!pic) {
+                        continue;
+                    }
+                } else if (FLAGS_bbh) {
                     // The SKP we read off disk doesn't have a BBH.  Re-record so it grows one.
                     SkRTreeFactory factory;
                     SkPictureRecorder recorder;
@@ -821,7 +880,7 @@ public:
                 }
                 SkString name = SkOSPath::Basename(path.c_str());
                 fSourceType = "skp";
-                fBenchType = "playback";
+                fBenchType = FLAGS_mappedSKPs ? "playback_mapped" : "playback";
                 return new SKPBench(name.c_str(), pic.get(), fClip, fScales[fCurrentScale],
                                     FLAGS_loopSKP);
             }
@@ -1080,6 +1139,10 @@ public:
             SkASSERT_RELEASE(fCurrentScale < fScales.count());  // debugging paranoia
             log.appendString("scale", SkStringPrintf("%.2g", fScales[fCurrentScale]).c_str());
         }
+        if (0 == strcmp(fBenchType, "tiled_playback")) {
+            log.appendString("threads", SkStringPrintf("%d", fTiledThreads).c_str());
+            log.appendString("tiles", SkStringPrintf("%d", FLAGS_tiledRasterTiles).c_str());
+        }
     }
 
     void fillCurrentMetrics(NanoJSONResultsWriter& log) const {
@@ -1123,6 +1186,10 @@ private:
     const char* fBenchType;   // How we bench it: micro, recording, playback, ...
     int fCurrentRecording = 0;
     int fCurrentDeserialPicture = 0;
+    int fCurrentMappedDeserialPicture = 0;
+    int fCurrentTiledSKP = 0;
+    int fCurrentTiledThreads = 0;
+    int fTiledThreads = 0;
     int fCurrentMSKP = 0;
     int fCurrentScale = 0;
     int fCurrentSKP = 0;
@@ -1265,6 +1332,9 @@ int main(int argc, char** argv) {
     gUseSkVMBlitter = FLAGS_skvm;
     gSkVMAllowJIT = FLAGS_jit;
     gSkVMJITViaDylib = FLAGS_dylib;
+    if (!FLAGS_skvmProgramCacheDir.isEmpty()) {
+        SkGraphics::SetProgramCacheDirectory(FLAGS_skvmProgramCacheDir[0]);
+    }
 
     int runs = 0;
     BenchmarkStream benchStream;
@@ -1490,6 +1560,18 @@ int main(int argc, char** argv) {
     log.endObject(); // config
     log.endBench();
 
+    if (FLAGS_skvm) {
+        SkVMBlitter::ProgramCacheStats stats = SkVMBlitter::GetProgramCacheStats();
+        log.beginBench("skvm_program_cache", 0, 0);
+        log.beginObject("meta"); // config
+        log.appendS64("hits", stats.hits);
+        log.appendS64("disk_hits", stats.diskHits);
+        log.appendS64("misses", stats.misses);
+        log.appendMetric("compile_ms", stats.compileMs);
+        log.endObject(); // config
+        log.endBench();
+    }
+
     RunSkSLMemoryBenchmarks(&log);
 
     log.endObject(); // results
@@ -10,10 +10,12 @@
 #include "include/core/SkCanvas.h"
 #include "include/core/SkCustomMesh.h"
 #include "include/core/SkSurface.h"
+#include "include/core/SkVertices.h"
 #include "include/effects/SkGradientShader.h"
 #include "src/core/SkCanvasPriv.h"
 
 #include <memory>
+#include <vector>
 
 namespace skiagm {
 class CustomMeshGM : public skiagm::GM {
@@ -356,4 +358,144 @@ constexpr CustomMeshColorSpaceGM::Vertex CustomMeshColorSpaceGM::kQuad[];
 
 DEF_GM( return new CustomMeshColorSpaceGM; )
 
+// Draws the same grid of triangles with drawVertices() and with drawCustomMesh(), in pairs of
+// columns, flat and in perspective. Rows use per-vertex colors, texture coordinates, and both.
+// Each custom mesh should look just like the SkVertices to its left.
+class CustomMeshVsVerticesGM : public skiagm::GM {
+public:
+    CustomMeshVsVerticesGM() {}
+
+protected:
+    using Attribute = SkCustomMeshSpecification::Attribute;
+    using Varying   = SkCustomMeshSpecification::Varying;
+
+    SkISize onISize() override { return {4*kCell, 3*kCell}; }
+
+    void onOnceBeforeDraw() override {
+        static const Attribute kAttributes[]{
+                {Attribute::Type::kFloat2,        0, SkString{"pos"}  },
+                {Attribute::Type::kFloat2,        8, SkString{"uv"}   },
+                {Attribute::Type::kUByte4_unorm, 16, SkString{"color"}},
+        };
+        static const Varying kVaryings[]{
+                {Varying::Type::kHalf4,  SkString{"color"}},
+                {Varying::Type::kFloat2, SkString{"uv"}   },
+        };
+        static constexpr char kVS[] = R"(
+                float2 main(in Attributes a, out Varyings v) {
+                    v.color = a.color.bgra;
+                    v.uv    = a.uv;
+                    return a.pos;
+                }
+        )";
+        static constexpr const char* kFSes[] = {
+                R"(void   main(in Varyings v, out half4 color) { color = v.color; })",
+                R"(float2 main(in Varyings v) { return v.uv; })",
+                R"(float2 main(in Varyings v, out half4 color) { color = v.color; return v.uv; })",
+        };
+        for (size_t i = 0; i < SK_ARRAY_COUNT(kFSes); ++i) {
+            auto [spec, error] = SkCustomMeshSpecification::Make(
+                    SkMakeSpan(kAttributes, SK_ARRAY_COUNT(kAttributes)),
+                    sizeof(Vertex),
+                    SkMakeSpan(kVaryings, SK_ARRAY_COUNT(kVaryings)),
+                    SkString(kVS),
+                    SkString(kFSes[i]));
+            if (!spec) {
+                SkDebugf("%s\n", error.c_str());
+            }
+            fSpecs[i] = std::move(spec);
+        }
+
+        for (int y = 0; y <= kGrid; ++y)
+        for (int x = 0; x <= kGrid; ++x) {
+            const float step = (kCell - 2*kInset) / (float)kGrid;
+            SkPoint pos = {kInset + x*step + ((y & 1) ? step/3 : 0), kInset + y*step};
+            SkColor color = SkColorSetARGB(0xFF, 255*x/kGrid, 255*y/kGrid, 255 - 15*(x + y));
+            fVertices.push_back({pos, pos*0.25f, color});
+            fPositions.push_back(pos);
+            fTexs.push_back(pos*0.25f);
+            fColors.push_back(color);
+            if (x > 0 && y > 0) {
+                uint16_t i = y*(kGrid + 1) + x;
+                uint16_t tl = i - kGrid - 2, tr = i - kGrid - 1, bl = i - 1;
+                fIndices.insert(fIndices.end(), {tl, tr, i, tl, i, bl});
+            }
+        }
+
+        static constexpr SkColor kShaderColors[] = {SK_ColorWHITE, SK_ColorBLACK};
+        fShader = SkGradientShader::MakeRadial({5, 5}, 4, kShaderColors, nullptr, 2,
+                                               SkTileMode::kMirror);
+    }
+
+    SkString onShortName() override { return SkString("custommesh_vs_vertices"); }
+
+    DrawResult onDraw(SkCanvas* canvas, SkString*) override {
+        SkMatrix persp;
+        persp.setPerspY(SK_Scalar1 / 300);
+
+        for (int row = 0; row < 3; ++row) {
+            const bool colors = row != 1,
+                       texs   = row != 0;
+            SkPaint paint;
+            paint.setColor(SK_ColorWHITE);
+            paint.setShader(texs ? fShader : nullptr);
+
+            auto verts = SkVertices::MakeCopy(SkVertices::kTriangles_VertexMode,
+                                              (int)fPositions.size(),
+                                              fPositions.data(),
+                                              texs   ? fTexs.data()   : nullptr,
+                                              colors ? fColors.data() : nullptr,
+                                              (int)fIndices.size(),
+                                              fIndices.data());
+            for (int col = 0; col < 4; ++col) {
+                canvas->save();
+                canvas->translate(col*kCell, row*kCell);
+                if (col >= 2) {
+                    canvas->concat(persp);
+                }
+                if (col & 1) {
+                    SkCustomMesh cm;
+                    cm.spec    = fSpecs[row];
+                    cm.mode    = SkCustomMesh::Mode::kTriangles;
+                    cm.bounds  = SkRect::MakeWH(kCell, kCell);
+                    cm.vb      = fVertices.data();
+                    cm.vcount  = (int)fVertices.size();
+                    cm.indices = fIndices.data();
+                    cm.icount  = (int)fIndices.size();
+                    SkCanvasPriv::DrawCustomMesh(canvas,
+                                                 std::move(cm),
+                                                 SkBlender::Mode(SkBlendMode::kModulate),
+                                                 paint);
+                } else {
+                    canvas->drawVertices(verts, SkBlendMode::kModulate, paint);
+                }
+                canvas->restore();
+            }
+        }
+        return DrawResult::kOk;
+    }
+
+private:
+    struct Vertex {
+        SkPoint pos;
+        SkPoint uv;
+        SkColor color;
+    };
+
+    static constexpr int kCell  = 128;
+    static constexpr int kGrid  = 8;
+    static constexpr int kInset = 8;
+
+    std::vector<Vertex>   fVertices;
+    std::vector<SkPoint>  fPositions, fTexs;
+    std::vector<SkColor>  fColors;
+    std::vector<uint16_t> fIndices;
+
+    sk_sp<SkCustomMeshSpecification> fSpecs[3];
+
+    sk_sp<SkShader> fShader;
+};
+
+DEF_GM( return new CustomMeshVsVerticesGM; )
+
 }  // namespace skiagm
@@ -27,6 +27,7 @@
 class SkAndroidCodec;
 class SkColorSpace;
 class SkData;
+class SkExecutor;
 class SkFrameHolder;
 class SkImage;
 class SkPngChunkReader;
@@ -289,6 +290,7 @@ public:
             , fSubset(nullptr)
             , fFrameIndex(0)
             , fPriorFrame(kNoFrame)
+            , fExecutor(nullptr)
         {}
 
         ZeroInitialized            fZeroInitialized;
@@ -332,6 +334,18 @@ public:
          *  If set to kNoFrame, the codec will decode any necessary required frame(s) first.
          */
         int                        fPriorFrame;
+
+        /**
+         *  If not NULL, codecs that support it will swizzle and color transform decoded rows on
+         *  this executor while the calling thread decompresses the rows that follow. The
+         *  decoded pixels are identical either way.
+         *
+         *  Currently used by PNG and WebP, in getPixels and incremental decodes, when a color
+         *  transform is needed. Large JPEGs with restart markers are decoded by getPixels in
+         *  bands, in parallel on the executor. The executor must outlive the decode call that
+         *  uses it.
+         */
+        SkExecutor*                fExecutor;
     };
 
     /**
@@ -2392,6 +2392,7 @@ private:
     friend class SkNoDrawCanvas;    // needs resetForNextPicture()
     friend class SkNWayCanvas;
     friend class SkPictureRecord;   // predrawNotify (why does it need it? <reed>)
+    friend class SkRecorder;        // predrawNotify, when recording for a tiled raster surface
     friend class SkOverdrawCanvas;
     friend class SkRasterHandleAllocator;
 protected:
@@ -17,10 +17,12 @@
 #include "include/core/SkRefCnt.h"
 #include "include/core/SkSpan.h"
 #include "include/core/SkString.h"
+#include "include/private/SkOnce.h"
 
 #include <vector>
 
 namespace SkSL { struct Program; }
+namespace skvm { class Program; }
 
 /**
  * A specification for custom meshes. Specifies the vertex buffer attributes and stride, the
@@ -166,6 +168,10 @@ private:
     bool                               fHasLocalCoords;
     sk_sp<SkColorSpace>                fColorSpace;
     SkAlphaType                        fAlphaType;
+
+    // The vertex program as run by the raster backend, built on first use.
+    mutable SkOnce                         fVertexProgramOnce;
+    mutable std::unique_ptr<skvm::Program> fVertexProgram;
 };
 
 /**
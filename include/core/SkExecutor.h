@@ -22,6 +22,12 @@ public:
     static std::unique_ptr<SkExecutor> MakeLIFOThreadPool(int threads = 0,
                                                           bool allowBorrowing = true);
 
+    // Create a thread pool SkExecutor where each thread keeps its own queue of the work it adds,
+    // and idle threads steal work from the others.  This suits work that adds more work,
+    // like SkTaskGroup::batch() or nested SkTaskGroups.
+    static std::unique_ptr<SkExecutor> MakeWorkStealingPool(int threads = 0,
+                                                            bool allowBorrowing = true);
+
     // There is always a default SkExecutor available by calling SkExecutor::GetDefault().
     static SkExecutor& GetDefault();
     static void SetDefault(SkExecutor*);  // Does not take ownership.  Not thread safe.
@@ -106,6 +106,28 @@ public:
      */
     static void DumpMemoryStatistics(SkTraceMemoryDump* dump);
 
+    /**
+     *  Returns how many times the pixels of a lazy (generator-backed) image have been decoded to
+     *  draw or read them on the CPU.
+     */
+    static int64_t GetLazyImageDecodeCount();
+
+    /**
+     *  Returns how many times a thread that needed a lazy image's pixels waited on another thread
+     *  already decoding them and shared its result, rather than decoding the image again.
+     */
+    static int64_t GetLazyImageDecodesCoalescedCount();
+
+    /**
+     *  Lazy images that can decode to 8-bit YUVA planes (e.g. most JPEGs) may be drawn on the CPU
+     *  straight from those planes, rather than from RGBA pixels converted from them. That saves
+     *  the memory and time of the conversion, but each draw then converts the pixels it samples.
+     *  This is off by default.
+     *
+     *  Returns the previous setting.
+     */
+    static bool SetRasterDrawsFromYUVAPlanes(bool enabled);
+
     /**
      *  Free as much globally cached memory as possible. This will purge all private caches in Skia,
      *  including font and image caches.
@@ -141,6 +163,13 @@ public:
      *  Call early in main() to allow Skia to use a JIT to accelerate CPU-bound operations.
      */
     static void AllowJIT();
+
+    /**
+     *  Programs that Skia builds for CPU drawing are cached in memory and shared by all threads.
+     *  If a directory is set here, they are also saved there, and later runs of your program can
+     *  load them from there rather than building them again.  Pass nullptr to stop.
+     */
+    static void SetProgramCacheDirectory(const char* dir);
 };
 
 class SkAutoGraphics {
@@ -27,6 +27,7 @@
 
 class SkData;
 class SkCanvas;
+class SkExecutor;
 class SkImage;
 class SkImageFilter;
 class SkImageGenerator;
@@ -1098,6 +1099,36 @@ public:
      */
     sk_sp<SkImage> withDefaultMipmaps() const;
 
+    /** Client-provided context that is passed to client-provided PrefetchCallback. */
+    using PrefetchContext = void*;
+
+    /** Client-provided callback to prefetchRaster(), called once the prefetch is done with
+        whether the pixels it was asked for are ready.
+    */
+    using PrefetchCallback = void(PrefetchContext, bool success);
+
+    /** Makes the pixels that drawing SkImage on a raster canvas would use ready ahead of time,
+        on one of executor's threads. A lazy image (e.g. from SkImage::MakeFromEncoded or
+        SkImage::MakeFromPicture) is decoded into the raster image cache, and if drawing it
+        scaled to targetSize with sampling would use a mipmap level, that level is built into
+        the mipmap cache. Later draws find them there rather than decoding while they draw.
+
+        The image is kept alive until the prefetch is done, and then callback, if not nullptr,
+        is called with context on executor's thread. Texture-backed images cannot be prefetched;
+        for them callback is called right away with success false.
+
+        Prefetched pixels stay cached only as long as the caches' budgets allow.
+
+        @param executor    runs the decode
+        @param sampling    how the image will be drawn
+        @param targetSize  about the size, in device pixels, the image will be drawn at
+        @param callback    function to call when the prefetch is done, or nullptr
+        @param context     passed to callback
+    */
+    void prefetchRaster(SkExecutor& executor, const SkSamplingOptions& sampling,
+                        SkISize targetSize, PrefetchCallback callback = nullptr,
+                        PrefetchContext context = nullptr) const;
+
 #if SK_SUPPORT_GPU
     /** Returns SkImage backed by GPU texture associated with context. Returned SkImage is
         compatible with SkSurface created with dstColorSpace. The returned SkImage respects
@@ -88,6 +88,16 @@ public:
         return this->getPixels(pm.info(), pm.writable_addr(), pm.rowBytes());
     }
 
+    /**
+     *  Returns a size near getInfo()'s dimensions scaled by desiredScale (0 < desiredScale < 1)
+     *  that getPixels() can decode to directly, for less than decoding at full size costs (e.g.
+     *  a JPEG at 1/2, 1/4 or 1/8 scale). The size may be smaller than asked for. If the generator
+     *  cannot scale, this returns getInfo()'s dimensions.
+     */
+    SkISize getScaledDimensions(float desiredScale) const {
+        return this->onGetScaledDimensions(desiredScale);
+    }
+
     /**
      *  If decoding to YUV is supported, this returns true. Otherwise, this
      *  returns false and the caller will ignore output parameter yuvaPixmapInfo.
@@ -178,6 +188,7 @@ protected:
     virtual sk_sp<SkData> onRefEncodedData() { return nullptr; }
     struct Options {};
     virtual bool onGetPixels(const SkImageInfo&, void*, size_t, const Options&) { return false; }
+    virtual SkISize onGetScaledDimensions(float) const { return fInfo.dimensions(); }
     virtual bool onIsValid(GrRecordingContext*) const { return true; }
     virtual bool onQueryYUVAInfo(const SkYUVAPixmapInfo::SupportedDataTypes&,
                                  SkYUVAPixmapInfo*) const { return false; }
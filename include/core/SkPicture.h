@@ -239,6 +239,7 @@ private:
     SkPicture();
     friend class SkBigPicture;
     friend class SkEmptyPicture;
+    friend class SkMappedPicture;
     friend class SkPicturePriv;
     template <typename> friend class SkMiniPicture;
 
@@ -33,6 +33,13 @@ public:
     enum FinishFlags {
     };
 
+    enum RecordFlags {
+        // When recording with a bounding box hierarchy, also find the draws that later opaque
+        // draws hide completely, so that playback can skip them.  This adds work to
+        // finishRecordingAsPicture() that pays off for pictures that are played back many times.
+        kSkipOccludedDraws_RecordFlag = 1 << 0,
+    };
+
     /** Returns the canvas that records the drawing commands.
         @param bounds the cull rect used when recording this picture. Any drawing the falls outside
                       of this rect is undefined, and may be drawn or it may not.
@@ -40,9 +47,11 @@ public:
         @param recordFlags optional flags that control recording.
         @return the canvas.
     */
-    SkCanvas* beginRecording(const SkRect& bounds, sk_sp<SkBBoxHierarchy> bbh);
+    SkCanvas* beginRecording(const SkRect& bounds, sk_sp<SkBBoxHierarchy> bbh,
+                             uint32_t recordFlags = 0);
 
-    SkCanvas* beginRecording(const SkRect& bounds, SkBBHFactory* bbhFactory = nullptr);
+    SkCanvas* beginRecording(const SkRect& bounds, SkBBHFactory* bbhFactory = nullptr,
+                             uint32_t recordFlags = 0);
 
     SkCanvas* beginRecording(SkScalar width, SkScalar height,
                              SkBBHFactory* bbhFactory = nullptr) {
@@ -104,6 +113,7 @@ private:
     bool                        fActivelyRecording;
     SkRect                      fCullRect;
     sk_sp<SkBBoxHierarchy>      fBBH;
+    uint32_t                    fRecordFlags;
     std::unique_ptr<SkRecorder> fRecorder;
     sk_sp<SkRecord>             fRecord;
     std::unique_ptr<SkMiniRecorder> fMiniRecorder;
@@ -112,7 +112,8 @@ private:
 
     void setTemporarilyImmutable();
     void restoreMutability();
-    friend class SkSurface_Raster;   // For the two methods above.
+    friend class SkSurface_Raster;       // For the two methods above.
+    friend class SkSurface_RasterTiled;  // For the two methods above.
 
     void setImmutableWithID(uint32_t genID);
     friend void SkBitmapCache_setImmutableWithID(SkPixelRef*, uint32_t);
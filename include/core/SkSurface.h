@@ -27,7 +27,9 @@
 
 class SkCanvas;
 class SkDeferredDisplayList;
+class SkExecutor;
 class SkPaint;
+class SkRegion;
 class SkSurfaceCharacterization;
 class GrBackendRenderTarget;
 class GrBackendSemaphore;
@@ -173,6 +175,32 @@ public:
     static sk_sp<SkSurface> MakeRasterN32Premul(int width, int height,
                                                 const SkSurfaceProps* surfaceProps = nullptr);
 
+    /** Allocates raster SkSurface whose SkCanvas records draws instead of rasterizing them
+        immediately. Recorded draws are played back when the contents of the surface are needed:
+        by makeImageSnapshot(), peekPixels(), readPixels(), writePixels(), draw() or flush().
+        Playback splits the surface into tiles, bands of rows which are rasterized concurrently
+        on executor. The resulting pixels match those of a surface returned by MakeRaster().
+
+        Draws that read back from the surface while drawing (saveLayer() with a backdrop
+        filter, or an Android framework saveBehind) make playback fall back to a single tile.
+
+        SkCanvas returned by this SkSurface cannot peek or read pixels; use the SkSurface
+        methods instead. Allocates and zeroes pixel memory, deleted when SkSurface is deleted.
+
+        @param imageInfo     width, height, SkColorType, SkAlphaType, SkColorSpace,
+                             of raster surface; width and height must be greater than zero
+        @param executor      runs tile playback; if nullptr, SkExecutor::GetDefault() is used.
+                             Must outlive the returned SkSurface.
+        @param tileCount     number of tiles to split playback into; if zero or less, a default
+                             is chosen. Tiles are at least 64 rows tall.
+        @param surfaceProps  LCD striping orientation and setting for device independent fonts;
+                             may be nullptr
+        @return              SkSurface if all parameters are valid; otherwise, nullptr
+    */
+    static sk_sp<SkSurface> MakeRasterTiled(const SkImageInfo& imageInfo, SkExecutor* executor,
+                                            int tileCount = 0,
+                                            const SkSurfaceProps* surfaceProps = nullptr);
+
     /** Caller data passed to RenderTarget/TextureReleaseProc; may be nullptr. */
     typedef void* ReleaseContext;
 
@@ -511,6 +539,34 @@ public:
     */
     void notifyContentWillChange(ContentChangeMode mode);
 
+    /** Starts or stops tracking the region of pixels that drawing to SkSurface may change, for
+        clients that only want to encode or present what changed since the last frame. Only
+        raster surfaces, such as those returned by MakeRaster() and MakeRasterDirect(), can
+        track.
+
+        The region is conservative: it covers the clipped device bounds of each draw, which
+        includes pixels the draw left as they were, and once it is made of many rects it is
+        simplified to their bounds. Pixels written by writePixels() are included.
+        Pixels changed outside of SkCanvas, such as through peekPixels() or after
+        notifyContentWillChange(), are not.
+
+        @param enabled  true to start tracking with an empty region, false to stop tracking
+        @return         true if SkSurface can track its dirty region
+    */
+    bool setDirtyRegionTracking(bool enabled);
+
+    /** Returns the pixels that may have changed since tracking started or resetDirtyRegion()
+        was last called. Returns an empty region if SkSurface is not tracking.
+
+        @return  region of pixels that may have changed
+    */
+    SkRegion dirtyRegion();
+
+    /** Empties the region returned by dirtyRegion(), e.g. once those pixels have been encoded
+        or presented. Tracking continues.
+    */
+    void resetDirtyRegion();
+
     /** Returns the recording context being used by the SkSurface.
 
         @return the recording context, if available; nullptr otherwise
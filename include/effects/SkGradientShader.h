@@ -54,6 +54,14 @@ public:
          *  example: https://fiddle.skia.org/c/@GradientShader_MakeLinear
          */
         kInterpolateColorsInPremul_Flag = 1 << 0,
+
+        /** Hint that this gradient will be drawn often enough, or has enough stops (think
+         *  heatmaps), that it is worth baking into a color table. The raster backend then
+         *  looks up each pixel in a premultiplied table of 256 or 1024 colors, shared by all
+         *  draws of an identical gradient through SkResourceCache. Hard stops are only as
+         *  sharp as one table entry. Other backends ignore this flag.
+         */
+        kCacheColorLUT_Flag = 1 << 1,
     };
 
     /** Returns a shader that generates a linear gradient between the two specified points.
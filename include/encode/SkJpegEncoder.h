@@ -10,6 +10,7 @@
 
 #include "include/encode/SkEncoder.h"
 
+class SkExecutor;
 class SkJpegEncoderMgr;
 class SkWStream;
 
@@ -61,6 +62,27 @@ public:
          *  In the second case, the encoder supports linear or legacy blending.
          */
         AlphaOption fAlphaOption = AlphaOption::kIgnore;
+
+        /**
+         *  If non-zero, a restart marker is written after every |fRestartInterval| rows of
+         *  MCUs (8 or 16 rows of pixels each, depending on |fDownsample|).  Decoders, SkCodec
+         *  among them, can decode the stretches between restart markers in parallel, at the
+         *  cost of a slightly larger file.
+         *
+         *  |fRestartInterval| must be in [0, 65535].
+         */
+        int fRestartInterval = 0;
+
+        /**
+         *  If not null, large images encoded in one call (Encode(), or encodeRows() of every
+         *  row) are split into strips of MCU rows that are encoded in parallel on this
+         *  executor, and joined into one baseline jpeg with a restart marker between strips.
+         *  The strips share the standard Huffman tables rather than ones optimized for the
+         *  image, so the file is a few percent larger.  It decodes to the same pixels.
+         *
+         *  The executor must outlive the encode.
+         */
+        SkExecutor* fExecutor = nullptr;
     };
 
     /**
@@ -11,6 +11,7 @@
 #include "include/core/SkDataTable.h"
 #include "include/encode/SkEncoder.h"
 
+class SkExecutor;
 class SkPngEncoderMgr;
 class SkWStream;
 
@@ -44,6 +45,15 @@ public:
          */
         FilterFlag fFilterFlags = FilterFlag::kAll;
 
+        /**
+         *  If true and multiple filters are chosen, Skia picks each row's filter itself (using
+         *  libpng's heuristic, but vectorized) and compresses the filtered rows with zlib,
+         *  instead of leaving both to libpng.  This is much faster at low zlib levels.
+         *
+         *  The output decodes to the same pixels, but is not byte for byte what libpng writes.
+         */
+        bool fSelectFiltersWithSkia = false;
+
         /**
          *  Must be in [0, 9] where 9 corresponds to maximal compression.  This value is passed
          *  directly to zlib.  0 is a special case to skip zlib entirely, creating dramatically
@@ -59,6 +69,16 @@ public:
          *  and the (2i + 1)-th entry is the text for the i-th comment.
          */
         sk_sp<SkDataTable> fComments;
+
+        /**
+         *  If not null, large images encoded in one call (Encode(), or encodeRows() of every
+         *  row) are filtered and compressed in strips of rows in parallel on this executor.
+         *  The strips are joined into one standard zlib stream, which decodes to the same
+         *  pixels as a serial encode but is not byte for byte identical to it.
+         *
+         *  The executor must outlive the encode.
+         */
+        SkExecutor* fExecutor = nullptr;
     };
 
     /**
@@ -9,12 +9,47 @@
 #define SkAnimCodecPlayer_DEFINED
 
 #include "include/codec/SkCodec.h"
+#include "include/private/SkMutex.h"
 
+#include <memory>
+#include <vector>
+
+class SkExecutor;
 class SkImage;
+class SkTaskGroup;
 
 class SkAnimCodecPlayer {
 public:
+    struct Options {
+        /**
+         *  The most bytes of decoded frames to keep cached. Once the cache is over budget, the
+         *  least recently used frames are dropped, keeping the snapshots (see below) for last.
+         *  The current frame is never dropped, so the cache may exceed a very small budget.
+         *
+         *  0 (the default) means no limit: every frame stays cached once decoded.
+         */
+        size_t      fCacheBudget = 0;
+
+        /**
+         *  Frames that depend on prior frames are decoded on top of their required frame, so
+         *  seeking into a long run of such frames can mean many decodes. Every frame that
+         *  would be this many decodes away from the nearest independent frame or snapshot is
+         *  made a snapshot, so that as long as the snapshots fit in the budget, no frame is more
+         *  than fSnapshotInterval decodes away.
+         */
+        int         fSnapshotInterval = 8;
+
+        /**
+         *  If set, getFrame() decodes the next fPrefetchCount frames after the current one on
+         *  this executor, so that playing the animation forward rarely waits on a decode.
+         *  The executor must outlive the player.
+         */
+        SkExecutor* fExecutor = nullptr;
+        int         fPrefetchCount = 2;
+    };
+
     SkAnimCodecPlayer(std::unique_ptr<SkCodec> codec);
+    SkAnimCodecPlayer(std::unique_ptr<SkCodec> codec, const Options&);
     ~SkAnimCodecPlayer();
 
     /**
@@ -46,14 +81,30 @@ public:
 
 
 private:
+    const Options                   fOptions;
     std::unique_ptr<SkCodec>        fCodec;
     SkImageInfo                     fImageInfo;
     std::vector<SkCodec::FrameInfo> fFrameInfos;
+    std::vector<bool>               fIsSnapshot;
+    size_t                          fFrameBytes = 0;
+    uint32_t                        fTotalDuration;
+
+    // Guards everything below, as well as fCodec, while frames may be prefetched.
+    SkMutex                         fMutex;
     std::vector<sk_sp<SkImage> >    fImages;
+    std::vector<uint64_t>           fLastUse;
+    uint64_t                        fUseCount = 0;
+    size_t                          fCacheBytes = 0;
     int                             fCurrIndex = 0;
-    uint32_t                        fTotalDuration;
+    bool                            fPrefetchPending = false;
+
+    // Declared last so that it is destroyed (and waited on) first.
+    std::unique_ptr<SkTaskGroup>    fPrefetchTasks;
 
     sk_sp<SkImage> getFrameAt(int index);
+    sk_sp<SkImage> decodeFrame(int index, int priorIndex, const sk_sp<SkImage>& prior);
+    void cacheFrame(int index, sk_sp<SkImage>);
+    void prefetch();
 };
 
 #endif
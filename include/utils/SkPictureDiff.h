@@ -0,0 +1,38 @@
+/*
+ * Copyright 2022 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkPictureDiff_DEFINED
+#define SkPictureDiff_DEFINED
+
+#include "include/core/SkMatrix.h"
+#include "include/core/SkRect.h"
+#include "include/core/SkRegion.h"
+
+class SkPicture;
+
+class SK_API SkPictureDiff {
+public:
+    /**
+     *  Returns the pixels that may differ between drawing before and drawing after, each with
+     *  the given matrix, into a device covering deviceBounds.  Pixels outside the region are
+     *  guaranteed to come out the same.  Either picture may be null, which is treated like an
+     *  empty picture.
+     *
+     *  The pictures are compared op by op, after unrolling any nested pictures and drawables.
+     *  Ops match when their paints, geometry, images (by unique ID), matrices and clips are the
+     *  same, and only the bounds of the ops that don't match are damaged.  Layers whose paint has
+     *  no image filter are compared op by op too, and other layers as a whole.  The bounds of
+     *  layers with a backdrop are damaged whenever anything else is.
+     *
+     *  To bring pixels holding before up to date, clip to the region, reset the pixels under it
+     *  to the background before was drawn over (e.g. by clearing them), and draw after.
+     */
+    static SkRegion Damage(const SkPicture* before, const SkPicture* after,
+                           const SkIRect& deviceBounds, const SkMatrix& matrix = SkMatrix::I());
+};
+
+#endif
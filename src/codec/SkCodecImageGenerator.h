@@ -101,6 +101,10 @@ protected:
                      size_t rowBytes,
                      const Options& opts) override;
 
+    SkISize onGetScaledDimensions(float desiredScale) const override {
+        return this->getScaledDimensions(desiredScale);
+    }
+
     bool onQueryYUVAInfo(const SkYUVAPixmapInfo::SupportedDataTypes&,
                          SkYUVAPixmapInfo*) const override;
 
@@ -16,6 +16,11 @@
 #include "src/codec/SkCodecPriv.h"
 #include "src/codec/SkJpegDecoderMgr.h"
 #include "src/codec/SkParseEncodedOrigin.h"
+#include "src/core/SkTaskGroup.h"
+
+#include <atomic>
+#include <numeric>
+#include <vector>
 
 // stdio is needed for libjpeg-turbo
 #include <stdio.h>
@@ -520,6 +525,232 @@ static inline bool needs_swizzler_to_convert_from_cmyk(J_COLOR_SPACE jpegColorTy
     return !hasCMYKColorSpace || !hasColorSpaceXform;
 }
 
+// Where the restart intervals of a baseline, single scan jpeg lie in its encoded data.
+struct RestartIntervals {
+    size_t              fHeightOffset = 0;  // of the image height in the SOF segment
+    size_t              fScanBegin    = 0;  // of the entropy-coded data, just past the SOS segment
+    size_t              fScanEnd      = 0;  // of the EOI marker
+    std::vector<size_t> fMarkers;           // of each RSTn marker, in order
+    int                 fInterval     = 0;  // MCUs between restart markers
+};
+
+static bool find_restart_intervals(const uint8_t* data, size_t size, RestartIntervals* ri) {
+    constexpr uint8_t kSOF0 = 0xC0, kSOF1 = 0xC1, kDHT = 0xC4, kSOF15 = 0xCF,
+                      kSOI  = 0xD8, kSOS  = 0xDA, kDRI = 0xDD;
+    auto get16 = [data](size_t offset) { return (data[offset] << 8) | data[offset + 1]; };
+
+    if (size < 2 || data[0] != 0xFF || data[1] != kSOI) {
+        return false;
+    }
+
+    int frameComponents = 0;
+    size_t offset = 2;
+    for (;;) {
+        if (offset + 4 > size || data[offset] != 0xFF) {
+            return false;
+        }
+        const uint8_t marker = data[offset + 1];
+        if (marker == 0xFF) {
+            offset++;  // fill byte
+            continue;
+        }
+        const size_t segment = offset + 2,
+                     length  = get16(segment);  // includes the length itself
+        if (length < 2 || segment + length > size) {
+            return false;
+        }
+
+        if (marker == kSOF0 || marker == kSOF1) {
+            if (ri->fHeightOffset || length < 8) {
+                return false;
+            }
+            ri->fHeightOffset = segment + 3;
+            frameComponents = data[segment + 7];
+        } else if (marker >= kSOF0 && marker <= kSOF15 && marker != kDHT) {
+            // Progressive, lossless, arithmetic coded, ... frames.
+            return false;
+        } else if (marker == kDRI) {
+            if (length != 4) {
+                return false;
+            }
+            ri->fInterval = get16(segment + 2);
+        } else if (marker == kSOS) {
+            // Only a single scan with every component interleaved has its restart intervals
+            // spanning the whole image.
+            if (!ri->fHeightOffset || !ri->fInterval || length < 3 ||
+                data[segment + 2] != frameComponents) {
+                return false;
+            }
+            ri->fScanBegin = segment + length;
+            break;
+        }
+        offset = segment + length;
+    }
+
+    // In entropy-coded data, an 0xFF byte is either stuffed (followed by 0x00) or starts a marker.
+    for (offset = ri->fScanBegin; offset + 1 < size;) {
+        auto ff = static_cast<const uint8_t*>(memchr(data + offset, 0xFF, size - offset - 1));
+        if (!ff) {
+            return false;
+        }
+        offset = ff - data;
+        const uint8_t marker = data[offset + 1];
+        if (marker == 0x00) {
+            offset += 2;
+        } else if (marker == 0xFF) {
+            offset += 1;  // fill byte
+        } else if (marker >= JPEG_RST0 && marker <= JPEG_RST0 + 7) {
+            if (marker - JPEG_RST0 != (int)(ri->fMarkers.size() & 7)) {
+                return false;
+            }
+            ri->fMarkers.push_back(offset);
+            offset += 2;
+        } else if (marker == JPEG_EOI) {
+            ri->fScanEnd = offset;
+            return true;
+        } else {
+            // Another scan, a DNL marker, ...
+            return false;
+        }
+    }
+    return false;
+}
+
+// Restart markers reset the entropy decoder, so the MCU rows between them can be decoded on their
+// own. Decoding in parallel is only worth it for large images, in bands of many rows each.
+static constexpr SkRowBanding kBanding = {1024 * 1024, 256};
+
+bool SkJpegCodec::decodeRestartIntervalsInParallel(const SkImageInfo& dstInfo, void* dst,
+                                                   size_t rowBytes, SkExecutor* executor) {
+    const jpeg_decompress_struct* dinfo = fDecoderMgr->dinfo();
+    const int width  = dstInfo.width(),
+              height = dstInfo.height();
+    if (!executor ||
+        !kBanding.worthSplitting(sk_64_mul(width, height)) ||
+        dstInfo.dimensions() != this->dimensions() ||
+        dinfo->progressive_mode ||
+        !dinfo->restart_interval ||
+        JCS_CMYK == dinfo->out_color_space) {
+        return false;
+    }
+
+    SkStream* stream = this->stream();
+    auto data = static_cast<const uint8_t*>(stream->getMemoryBase());
+    RestartIntervals ri;
+    if (!data || !find_restart_intervals(data, stream->getLength(), &ri) ||
+        ri.fInterval != (int)dinfo->restart_interval) {
+        return false;
+    }
+
+    // A single component scan codes 8x8 blocks, an interleaved one MCUs spanning every component.
+    int mcuWidth = 8, mcuHeight = 8;
+    if (dinfo->num_components > 1) {
+        mcuWidth  *= dinfo->max_h_samp_factor;
+        mcuHeight *= dinfo->max_v_samp_factor;
+    }
+    const int mcusPerRow = (width  + mcuWidth  - 1) / mcuWidth,
+              mcuRows    = (height + mcuHeight - 1) / mcuHeight;
+    const int intervals  = (int)ri.fMarkers.size() + 1;
+    if (intervals != (sk_64_mul(mcusPerRow, mcuRows) + ri.fInterval - 1) / ri.fInterval) {
+        return false;
+    }
+
+    // Bands can only begin at MCU rows that also begin a restart interval, every rowStep rows.
+    // Each band decodes (and throws away) the step before and after it as well, so upsampling
+    // the chroma at its edges sees the same neighbors as a decode of the whole image would.
+    const int rowStep = ri.fInterval / std::gcd(ri.fInterval, mcusPerRow),
+              steps   = mcuRows / rowStep;
+    const int bandCount = std::min(kBanding.bandCount(height, sk_64_mul(width, height)),
+                                   steps / 4);
+    if (bandCount < 2) {
+        return false;
+    }
+
+    auto interval_for_row = [&](int mcuRow) {
+        return mcuRow == mcuRows ? intervals
+                                 : (int)(sk_64_mul(mcuRow, mcusPerRow) / ri.fInterval);
+    };
+    auto interval_begin = [&](int i) { return i == 0 ? ri.fScanBegin : ri.fMarkers[i - 1] + 2; };
+    auto interval_end   = [&](int i) { return i == intervals - 1 ? ri.fScanEnd : ri.fMarkers[i]; };
+
+    // Decoding into the dst in place needs no row of storage, just like readRows().
+    const bool xformFromStorage = this->colorXform() && sizeof(uint32_t) != dstInfo.bytesPerPixel();
+
+    // Decodes the MCU rows [first, last).
+    auto decode_band = [&](int first, int last) {
+        const int begin = std::max(0, first - rowStep),
+                  end   = std::min(mcuRows, last + rowStep);
+        const int skipRows   = (first - begin) * mcuHeight,
+                  rows       = std::min(height, last * mcuHeight) - first * mcuHeight,
+                  bandHeight = std::min(height, end * mcuHeight) - begin * mcuHeight;
+
+        // A jpeg of just this band: the headers, with the height patched, and its intervals,
+        // with the restart markers between them renumbered from zero.
+        const int firstInterval = interval_for_row(begin),
+                  endInterval   = interval_for_row(end);
+        const size_t headerSize = ri.fScanBegin,
+                     scanBegin  = interval_begin(firstInterval),
+                     scanSize   = interval_end(endInterval - 1) - scanBegin;
+        SkAutoTMalloc<uint8_t> bandData(headerSize + scanSize + 2);
+        uint8_t* bandScan = bandData.get() + headerSize;
+        memcpy(bandData.get(), data, headerSize);
+        bandData[ri.fHeightOffset + 0] = bandHeight >> 8;
+        bandData[ri.fHeightOffset + 1] = bandHeight & 0xFF;
+        memcpy(bandScan, data + scanBegin, scanSize);
+        for (int i = firstInterval; i < endInterval - 1; i++) {
+            bandScan[ri.fMarkers[i] - scanBegin + 1] = JPEG_RST0 + ((i - firstInterval) & 7);
+        }
+        bandScan[scanSize + 0] = 0xFF;
+        bandScan[scanSize + 1] = JPEG_EOI;
+
+        SkMemoryStream bandStream(bandData.get(), headerSize + scanSize + 2, false);
+        JpegDecoderMgr bandMgr(&bandStream);
+        SkAutoTMalloc<uint32_t> xformSrcRow(xformFromStorage ? width : 0);
+
+        skjpeg_error_mgr::AutoPushJmpBuf jmp(bandMgr.errorMgr());
+        if (setjmp(jmp)) {
+            return false;
+        }
+
+        bandMgr.init();
+        jpeg_decompress_struct* bandInfo = bandMgr.dinfo();
+        if (JPEG_HEADER_OK != jpeg_read_header(bandInfo, true)) {
+            return false;
+        }
+        bandInfo->out_color_space     = dinfo->out_color_space;
+        bandInfo->dither_mode         = dinfo->dither_mode;
+        bandInfo->dct_method          = dinfo->dct_method;
+        bandInfo->do_fancy_upsampling = dinfo->do_fancy_upsampling;
+        if (!jpeg_start_decompress(bandInfo) ||
+            bandInfo->output_width  != (JDIMENSION)width ||
+            bandInfo->output_height != (JDIMENSION)bandHeight) {
+            return false;
+        }
+
+        // The rows skipped before the band are decoded into its first row, which is rewritten.
+        void* bandDst = SkTAddOffset<void>(dst, first * mcuHeight * rowBytes);
+        for (int y = -skipRows; y < rows; y++) {
+            void* rowDst = SkTAddOffset<void>(bandDst, std::max(y, 0) * rowBytes);
+            JSAMPLE* decodeDst = xformFromStorage ? (JSAMPLE*)xformSrcRow.get() : (JSAMPLE*)rowDst;
+            if (1 != jpeg_read_scanlines(bandInfo, &decodeDst, 1)) {
+                return false;
+            }
+            if (y >= 0 && this->colorXform()) {
+                this->applyColorXform(rowDst, decodeDst, width);
+            }
+        }
+        return true;
+    };
+
+    std::atomic<bool> success{true};
+    SkRowBanding::Run(executor, mcuRows, bandCount, rowStep, [&](int, int first, int last) {
+        if (!decode_band(first, last)) {
+            success = false;
+        }
+    });
+    return success;
+}
+
 /*
  * Performs the jpeg decode
  */
@@ -532,6 +763,10 @@ SkCodec::Result SkJpegCodec::onGetPixels(const SkImageInfo& dstInfo,
         return kUnimplemented;
     }
 
+    if (this->decodeRestartIntervalsInParallel(dstInfo, dst, dstRowBytes, options.fExecutor)) {
+        return kSuccess;
+    }
+
     // Get a pointer to the decompress info since we will use it quite frequently
     jpeg_decompress_struct* dinfo = fDecoderMgr->dinfo();
 
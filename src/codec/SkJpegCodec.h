@@ -109,6 +109,14 @@ private:
     bool SK_WARN_UNUSED_RESULT allocateStorage(const SkImageInfo& dstInfo);
     int readRows(const SkImageInfo& dstInfo, void* dst, size_t rowBytes, int count, const Options&);
 
+    /*
+     * If there is an executor, and the image has restart markers and is large enough to be worth
+     * it, decodes it in bands split along them, in parallel on the executor, and returns true.
+     * Otherwise returns false without having started the decode.
+     */
+    bool decodeRestartIntervalsInParallel(const SkImageInfo& dstInfo, void* dst,
+                                          size_t rowBytes, SkExecutor* executor);
+
     /*
      * Scanline decoding.
      */
@@ -18,6 +18,7 @@
 #include "src/codec/SkColorTable.h"
 #include "src/codec/SkPngCodec.h"
 #include "src/codec/SkPngPriv.h"
+#include "src/codec/SkRowPipeline.h"
 #include "src/codec/SkSwizzler.h"
 #include "src/core/SkOpts.h"
 
@@ -445,11 +446,28 @@ void SkPngCodec::allocateStorage(const SkImageInfo& dstInfo) {
             const size_t colorXformBytes = dstInfo.width() * bytesPerPixel;
             fStorage.reset(colorXformBytes);
             fColorXformSrcRow = fStorage.get();
+            fColorXformSrcRowBytes = colorXformBytes;
             break;
         }
     }
 }
 
+void SkPngCodec::initializeRowPipeline(const Options& options) {
+    fRowPipeline = nullptr;
+    // The swizzle alone is too cheap to be worth handing off; the color xform is not. (Palette
+    // images only xform their color table.)
+    if (!options.fExecutor || !this->xformOnDecode()) {
+        return;
+    }
+
+    const size_t srcRowBytes = png_get_rowbytes(this->png_ptr(), this->info_ptr());
+    fRowPipeline = std::make_unique<SkRowPipeline>(*options.fExecutor, srcRowBytes,
+                                                   fColorXformSrcRowBytes,
+                                                   [this](void* dst, const void* src, void* tmp) {
+        this->applyXformRow(dst, src, tmp);
+    });
+}
+
 static skcms_PixelFormat png_select_xform_format(const SkEncodedInfo& info) {
     // We use kRGB and kRGBA formats because color PNGs are always RGB or RGBA.
     if (16 == info.bitsPerComponent()) {
@@ -466,6 +484,10 @@ static skcms_PixelFormat png_select_xform_format(const SkEncodedInfo& info) {
 }
 
 void SkPngCodec::applyXformRow(void* dst, const void* src) {
+    this->applyXformRow(dst, src, fColorXformSrcRow);
+}
+
+void SkPngCodec::applyXformRow(void* dst, const void* src, void* colorXformSrcRow) {
     switch (fXformMode) {
         case kSwizzleOnly_XformMode:
             fSwizzler->swizzle(dst, (const uint8_t*) src);
@@ -474,12 +496,40 @@ void SkPngCodec::applyXformRow(void* dst, const void* src) {
             this->applyColorXform(dst, src, fXformWidth);
             break;
         case kSwizzleColor_XformMode:
-            fSwizzler->swizzle(fColorXformSrcRow, (const uint8_t*) src);
-            this->applyColorXform(dst, fColorXformSrcRow, fXformWidth);
+            fSwizzler->swizzle(colorXformSrcRow, (const uint8_t*) src);
+            this->applyColorXform(dst, colorXformSrcRow, fXformWidth);
             break;
     }
 }
 
+void SkPngCodec::pushXformRow(void* dst, const void* src) {
+    if (fRowPipeline) {
+        fRowPipeline->push(dst, src);
+    } else {
+        this->applyXformRow(dst, src);
+    }
+}
+
+void SkPngCodec::xformRows(void* dst, size_t dstRowBytes, const void* src, size_t srcRowBytes,
+                           int count) {
+    if (fRowPipeline) {
+        fRowPipeline->pushRows(dst, dstRowBytes, src, srcRowBytes, count);
+        fRowPipeline->finish();
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        this->applyXformRow(dst, src);
+        dst = SkTAddOffset<void>(dst, dstRowBytes);
+        src = SkTAddOffset<const void>(src, srcRowBytes);
+    }
+}
+
+void SkPngCodec::finishXformRows() {
+    if (fRowPipeline) {
+        fRowPipeline->finish();
+    }
+}
+
 static SkCodec::Result log_and_return_error(bool success) {
     if (success) return SkCodec::kIncompleteInput;
 #ifdef SK_BUILD_FOR_ANDROID_FRAMEWORK
@@ -535,6 +585,7 @@ private:
         fLastRow = height - 1;
 
         const bool success = this->processData();
+        this->finishXformRows();
         if (success && fRowsWrittenToOutput == height) {
             return kSuccess;
         }
@@ -549,7 +600,7 @@ private:
     void allRowsCallback(png_bytep row, int rowNum) {
         SkASSERT(rowNum == fRowsWrittenToOutput);
         fRowsWrittenToOutput++;
-        this->applyXformRow(fDst, row);
+        this->pushXformRow(fDst, row);
         fDst = SkTAddOffset<void>(fDst, fRowBytes);
     }
 
@@ -570,6 +621,7 @@ private:
         }
 
         const bool success = this->processData();
+        this->finishXformRows();
         if (success && fRowsWrittenToOutput == fRowsNeeded) {
             return kSuccess;
         }
@@ -592,7 +644,7 @@ private:
 
         // If there is no swizzler, all rows are needed.
         if (!this->swizzler() || this->swizzler()->rowNeeded(rowNum - fFirstRow)) {
-            this->applyXformRow(fDst, row);
+            this->pushXformRow(fDst, row);
             fDst = SkTAddOffset<void>(fDst, fRowBytes);
             fRowsWrittenToOutput++;
         }
@@ -681,13 +733,8 @@ private:
         fLinesDecoded = 0;
 
         const bool success = this->processData();
-        png_bytep srcRow = fInterlaceBuffer.get();
         // FIXME: When resuming, this may rewrite rows that did not change.
-        for (int rowNum = 0; rowNum < fLinesDecoded; rowNum++) {
-            this->applyXformRow(dst, srcRow);
-            dst = SkTAddOffset<void>(dst, rowBytes);
-            srcRow = SkTAddOffset<png_byte>(srcRow, fPng_rowbytes);
-        }
+        this->xformRows(dst, rowBytes, fInterlaceBuffer.get(), fPng_rowbytes, fLinesDecoded);
         if (success && fInterlacedComplete) {
             return kSuccess;
         }
@@ -729,17 +776,14 @@ private:
 
         // Offset srcRow by get_start_coord rows. We do not need to account for fFirstRow,
         // since the first row in fInterlaceBuffer corresponds to fFirstRow.
-        int srcRow = get_start_coord(sampleY);
-        void* dst = fDst;
+        const int srcRow = get_start_coord(sampleY);
         int rowsWrittenToOutput = 0;
-        while (rowsWrittenToOutput < rowsNeeded && srcRow < fLinesDecoded) {
-            png_bytep src = SkTAddOffset<png_byte>(fInterlaceBuffer.get(), fPng_rowbytes * srcRow);
-            this->applyXformRow(dst, src);
-            dst = SkTAddOffset<void>(dst, fRowBytes);
-
-            rowsWrittenToOutput++;
-            srcRow += sampleY;
+        if (srcRow < fLinesDecoded) {
+            rowsWrittenToOutput = std::min(rowsNeeded,
+                                           (fLinesDecoded - srcRow + sampleY - 1) / sampleY);
         }
+        png_bytep src = SkTAddOffset<png_byte>(fInterlaceBuffer.get(), fPng_rowbytes * srcRow);
+        this->xformRows(fDst, fRowBytes, src, fPng_rowbytes * sampleY, rowsWrittenToOutput);
 
         if (success && fInterlacedComplete) {
             return kSuccess;
@@ -991,6 +1035,7 @@ SkPngCodec::SkPngCodec(SkEncodedInfo&& encodedInfo, std::unique_ptr<SkStream> st
     , fPng_ptr(png_ptr)
     , fInfo_ptr(info_ptr)
     , fColorXformSrcRow(nullptr)
+    , fColorXformSrcRowBytes(0)
     , fBitDepth(bitDepth)
     , fIdatLength(0)
     , fDecodedIdat(false)
@@ -1164,7 +1209,10 @@ SkCodec::Result SkPngCodec::onGetPixels(const SkImageInfo& dstInfo, void* dst,
 
     this->allocateStorage(dstInfo);
     this->initializeXformParams();
-    return this->decodeAllRows(dst, rowBytes, rowsDecoded);
+    this->initializeRowPipeline(options);
+    const Result decodeResult = this->decodeAllRows(dst, rowBytes, rowsDecoded);
+    fRowPipeline = nullptr;
+    return decodeResult;
 }
 
 SkCodec::Result SkPngCodec::onStartIncrementalDecode(const SkImageInfo& dstInfo,
@@ -1175,6 +1223,7 @@ SkCodec::Result SkPngCodec::onStartIncrementalDecode(const SkImageInfo& dstInfo,
     }
 
     this->allocateStorage(dstInfo);
+    this->initializeRowPipeline(options);
 
     int firstRow, lastRow;
     if (options.fSubset) {
@@ -15,6 +15,7 @@
 #include "src/codec/SkColorTable.h"
 #include "src/codec/SkSwizzler.h"
 
+class SkRowPipeline;
 class SkStream;
 
 class SkPngCodec : public SkCodec {
@@ -54,6 +55,17 @@ protected:
 
     SkSampler* getSampler(bool createIfNecessary) override;
     void applyXformRow(void* dst, const void* src);
+    void applyXformRow(void* dst, const void* src, void* colorXformSrcRow);
+
+    // Like applyXformRow, but hands the row to fRowPipeline if there is one. src is copied, so
+    // it may be reused right away, but dst is not written until finishXformRows().
+    void pushXformRow(void* dst, const void* src);
+
+    // Applies the xforms to count rows, on fRowPipeline if there is one, and waits for them.
+    void xformRows(void* dst, size_t dstRowBytes, const void* src, size_t srcRowBytes, int count);
+
+    // Waits for any rows given to pushXformRow to be written.
+    void finishXformRows();
 
     voidp png_ptr() { return fPng_ptr; }
     voidp info_ptr() { return fInfo_ptr; }
@@ -84,8 +96,12 @@ protected:
     std::unique_ptr<SkSwizzler> fSwizzler;
     SkAutoTMalloc<uint8_t>      fStorage;
     void*                       fColorXformSrcRow;
+    size_t                      fColorXformSrcRowBytes;
     const int                   fBitDepth;
 
+    // Set when Options::fExecutor asks for the xforms to run alongside decompression.
+    std::unique_ptr<SkRowPipeline> fRowPipeline;
+
 private:
 
     enum XformMode {
@@ -104,6 +120,7 @@ private:
     SkCodec::Result initializeXforms(const SkImageInfo& dstInfo, const Options&);
     void initializeSwizzler(const SkImageInfo& dstInfo, const Options&, bool skipFormatConversion);
     void allocateStorage(const SkImageInfo& dstInfo);
+    void initializeRowPipeline(const Options&);
     void destroyReadStruct();
 
     virtual Result decodeAllRows(void* dst, size_t rowBytes, int* rowsDecoded) = 0;
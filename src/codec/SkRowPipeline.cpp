@@ -0,0 +1,120 @@
+/*
+ * Copyright 2022 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "src/codec/SkRowPipeline.h"
+
+#include "include/private/SkTo.h"
+
+#include <algorithm>
+#include <cstring>
+
+// Large enough batches amortize the cost of a task, small enough ones keep every thread busy
+// and let the first rows be converted while the decompressor is still early in the image.
+static constexpr size_t kBatchBytes = 128 * 1024;
+static constexpr int    kMaxRowsPerBatch = 64;
+
+// Bounds the memory used for copied rows when the decoder outruns the conversion.
+static constexpr size_t kMaxBatches = 8;
+
+SkRowPipeline::SkRowPipeline(SkExecutor& executor, size_t srcRowBytes, size_t scratchBytes,
+                             ConvertProc proc)
+    : fExecutor(executor)
+    , fSrcRowBytes(srcRowBytes)
+    , fScratchBytes(scratchBytes)
+    , fRowsPerBatch(SkTo<int>(std::max<size_t>(1, std::min<size_t>(kMaxRowsPerBatch,
+                                                                   kBatchBytes / srcRowBytes))))
+    , fProc(std::move(proc))
+    , fTaskGroup(executor) {}
+
+SkRowPipeline::Batch* SkRowPipeline::acquire() {
+    for (;;) {
+        {
+            SkAutoMutexExclusive lock(fMutex);
+            if (!fFreeBatches.empty()) {
+                Batch* batch = fFreeBatches.back();
+                fFreeBatches.pop_back();
+                return batch;
+            }
+        }
+        if (fBatches.size() < kMaxBatches) {
+            fBatches.push_back(std::make_unique<Batch>());
+            Batch* batch = fBatches.back().get();
+            batch->fScratch.reset(fScratchBytes);
+            return batch;
+        }
+        // Every batch is in flight. Like SkTaskGroup::wait(), help out rather than block.
+        fExecutor.borrow();
+    }
+}
+
+void SkRowPipeline::release(Batch* batch) {
+    SkAutoMutexExclusive lock(fMutex);
+    fFreeBatches.push_back(batch);
+}
+
+void SkRowPipeline::push(void* dst, const void* src) {
+    if (!fCurrent) {
+        fCurrent = this->acquire();
+        if (!fCurrent->fRows) {
+            fCurrent->fRows.reset(fSrcRowBytes * fRowsPerBatch);
+        }
+        fCurrent->fDsts.clear();
+    }
+
+    const size_t index = fCurrent->fDsts.size();
+    memcpy(fCurrent->fRows.get() + index * fSrcRowBytes, src, fSrcRowBytes);
+    fCurrent->fDsts.push_back(dst);
+    if (SkToInt(fCurrent->fDsts.size()) == fRowsPerBatch) {
+        this->submitCurrent();
+    }
+}
+
+void SkRowPipeline::submitCurrent() {
+    Batch* batch = fCurrent;
+    fCurrent = nullptr;
+    fTaskGroup.add([this, batch] {
+        const uint8_t* src = batch->fRows.get();
+        for (void* dst : batch->fDsts) {
+            fProc(dst, src, batch->fScratch.get());
+            src += fSrcRowBytes;
+        }
+        this->release(batch);
+    });
+}
+
+void SkRowPipeline::pushRows(void* dst, size_t dstRowBytes, const void* src, size_t srcRowBytes,
+                             int count) {
+    for (int start = 0; start < count; start += fRowsPerBatch) {
+        const int rows = std::min(fRowsPerBatch, count - start);
+        // The rows are converted where they are, so the batch only lends its scratch.
+        Batch* batch = this->acquire();
+        void* dstRow = SkTAddOffset<void>(dst, start * dstRowBytes);
+        const void* srcRow = SkTAddOffset<const void>(src, start * srcRowBytes);
+        fTaskGroup.add([=] {
+            void* d = dstRow;
+            const void* s = srcRow;
+            for (int i = 0; i < rows; i++) {
+                fProc(d, s, batch->fScratch.get());
+                d = SkTAddOffset<void>(d, dstRowBytes);
+                s = SkTAddOffset<const void>(s, srcRowBytes);
+            }
+            this->release(batch);
+        });
+    }
+}
+
+void SkRowPipeline::finish() {
+    if (fCurrent) {
+        if (fCurrent->fDsts.empty()) {
+            this->release(fCurrent);
+            fCurrent = nullptr;
+        } else {
+            this->submitCurrent();
+        }
+    }
+    fTaskGroup.wait();
+}
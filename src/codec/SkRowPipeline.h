@@ -0,0 +1,86 @@
+/*
+ * Copyright 2022 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkRowPipeline_DEFINED
+#define SkRowPipeline_DEFINED
+
+#include "include/core/SkExecutor.h"
+#include "include/private/SkMutex.h"
+#include "include/private/SkNoncopyable.h"
+#include "include/private/SkTemplates.h"
+#include "src/core/SkTaskGroup.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ *  Overlaps a codec's per-row conversion (swizzle and/or color transform) with its decompression.
+ *
+ *  The decoding thread hands rows to the pipeline as they come out of the decompressor, and the
+ *  conversion runs on an SkExecutor in batches of rows while the decoding thread moves on to
+ *  the next rows. Each row is converted by exactly the same proc as it would be serially, so the
+ *  output is identical.
+ *
+ *  Only the thread that created the pipeline may call push(), pushRows() and finish().
+ */
+class SkRowPipeline : SkNoncopyable {
+public:
+    // Converts one row from src into dst. scratch points to scratchBytes of memory that is not
+    // shared with any other concurrent call.
+    using ConvertProc = std::function<void(void* dst, const void* src, void* scratch)>;
+
+    SkRowPipeline(SkExecutor&, size_t srcRowBytes, size_t scratchBytes, ConvertProc);
+    ~SkRowPipeline() { this->finish(); }
+
+    /**
+     *  Copies srcRowBytes from src, to be converted into dst later. src may be reused as soon as
+     *  this returns, but dst must not be touched until finish().
+     */
+    void push(void* dst, const void* src);
+
+    /**
+     *  Converts count rows without copying them first. Neither src nor dst may be touched until
+     *  finish(). src and dst may be the same memory, if the ConvertProc can work in place.
+     */
+    void pushRows(void* dst, size_t dstRowBytes, const void* src, size_t srcRowBytes, int count);
+
+    /**
+     *  Blocks until every row pushed so far has been converted. The pipeline may be reused
+     *  afterwards.
+     */
+    void finish();
+
+private:
+    struct Batch {
+        SkAutoTMalloc<uint8_t> fRows;
+        SkAutoTMalloc<uint8_t> fScratch;
+        std::vector<void*>     fDsts;
+    };
+
+    Batch* acquire();
+    void release(Batch*);
+    void submitCurrent();
+
+    SkExecutor&                         fExecutor;
+    const size_t                        fSrcRowBytes;
+    const size_t                        fScratchBytes;
+    const int                           fRowsPerBatch;
+    const ConvertProc                   fProc;
+
+    SkMutex                             fMutex;
+    std::vector<std::unique_ptr<Batch>> fBatches;      // Every batch allocated so far.
+    std::vector<Batch*>                 fFreeBatches;  // Guarded by fMutex.
+
+    // Rows pushed since the last batch was submitted. Owned by the decoding thread.
+    Batch*                              fCurrent = nullptr;
+
+    // Declared last so that it is destroyed (and waited on) before the batches.
+    SkTaskGroup                         fTaskGroup;
+};
+
+#endif  // SkRowPipeline_DEFINED
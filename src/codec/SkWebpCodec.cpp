@@ -14,6 +14,7 @@
 #include "include/private/SkTo.h"
 #include "src/codec/SkCodecPriv.h"
 #include "src/codec/SkParseEncodedOrigin.h"
+#include "src/codec/SkRowPipeline.h"
 #include "src/codec/SkSampler.h"
 #include "src/core/SkRasterPipeline.h"
 #include "src/core/SkStreamPriv.h"
@@ -485,9 +486,58 @@ SkCodec::Result SkWebpCodec::onGetPixels(const SkImageInfo& dstInfo, void* dst,
         return kInvalidInput;
     }
 
+    const size_t dstBpp = dstInfo.bytesPerPixel();
+    dst = SkTAddOffset<void>(dst, dstBpp * dstX + rowBytes * dstY);
+    const size_t srcRowBytes = config.output.u.RGBA.stride;
+
+    // With an executor, hand libwebp the data a piece at a time, and color transform the rows
+    // finished by each piece while it decodes the next one. Destroyed (and so waited on) before
+    // the memory it reads and writes.
+    std::unique_ptr<SkRowPipeline> pipeline;
+    if (options.fExecutor && this->colorXform() && !blendWithPrevFrame) {
+        pipeline = std::make_unique<SkRowPipeline>(*options.fExecutor, srcRowBytes, 0,
+                [this, scaledWidth](void* xformDst, const void* xformSrc, void*) {
+            this->applyColorXform(xformDst, xformSrc, scaledWidth);
+        });
+    }
+
+    VP8StatusCode status;
+    if (pipeline) {
+        const uint8_t* xformSrc = config.output.u.RGBA.rgba;
+        const size_t pieceSize = std::max<size_t>(frame.fragment.size / 16, 16 * 1024);
+        int rowsXformed = 0;
+        auto xformRowsUpTo = [&](int lastY) {
+            if (lastY > rowsXformed) {
+                pipeline->pushRows(SkTAddOffset<void>(dst, rowsXformed * rowBytes), rowBytes,
+                                   xformSrc + rowsXformed * srcRowBytes, srcRowBytes,
+                                   lastY - rowsXformed);
+                rowsXformed = lastY;
+            }
+        };
+
+        size_t bytesGiven = 0;
+        do {
+            bytesGiven = std::min(frame.fragment.size, bytesGiven + pieceSize);
+            // In this mode libwebp expects all of the data so far, not just the new piece.
+            status = WebPIUpdate(idec, frame.fragment.bytes, bytesGiven);
+            int lastY;
+            if (VP8_STATUS_SUSPENDED == status
+                    && WebPIDecGetRGB(idec, &lastY, nullptr, nullptr, nullptr)) {
+                xformRowsUpTo(lastY);
+            }
+        } while (VP8_STATUS_SUSPENDED == status && bytesGiven < frame.fragment.size);
+
+        if (VP8_STATUS_OK == status) {
+            xformRowsUpTo(scaledHeight);
+        }
+        pipeline->finish();
+    } else {
+        status = WebPIUpdate(idec, frame.fragment.bytes, frame.fragment.size);
+    }
+
     int rowsDecoded = 0;
     SkCodec::Result result;
-    switch (WebPIUpdate(idec, frame.fragment.bytes, frame.fragment.size)) {
+    switch (status) {
         case VP8_STATUS_OK:
             rowsDecoded = scaledHeight;
             result = kSuccess;
@@ -504,12 +554,8 @@ SkCodec::Result SkWebpCodec::onGetPixels(const SkImageInfo& dstInfo, void* dst,
             return kInvalidInput;
     }
 
-    const size_t dstBpp = dstInfo.bytesPerPixel();
-    dst = SkTAddOffset<void>(dst, dstBpp * dstX + rowBytes * dstY);
-    const size_t srcRowBytes = config.output.u.RGBA.stride;
-
     const auto dstCT = dstInfo.colorType();
-    if (this->colorXform()) {
+    if (this->colorXform() && !pipeline) {
         uint32_t* xformSrc = (uint32_t*) config.output.u.RGBA.rgba;
         SkBitmap tmp;
         void* xformDst;
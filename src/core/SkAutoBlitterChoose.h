@@ -35,8 +35,10 @@ public:
         if (!matrixProvider) {
             matrixProvider = draw.fMatrixProvider;
         }
-        fBlitter = SkBlitter::Choose(draw.fDst, *matrixProvider, paint, &fAlloc, drawCoverage,
-                                     draw.fRC->clipShader());
+        fBlitter = draw.restrictBlitter(SkBlitter::Choose(draw.fDst, *matrixProvider, paint,
+                                                          &fAlloc, drawCoverage,
+                                                          draw.fRC->clipShader()),
+                                        &fAlloc);
         return fBlitter;
     }
 
@@ -16,12 +16,14 @@ SkBigPicture::SkBigPicture(const SkRect& cull,
                            sk_sp<SkRecord> record,
                            std::unique_ptr<SnapshotArray> drawablePicts,
                            sk_sp<SkBBoxHierarchy> bbh,
+                           std::unique_ptr<SkBitSet> occluded,
                            size_t approxBytesUsedBySubPictures)
     : fCullRect(cull)
     , fApproxBytesUsedBySubPictures(approxBytesUsedBySubPictures)
     , fRecord(std::move(record))
     , fDrawablePicts(std::move(drawablePicts))
     , fBBH(std::move(bbh))
+    , fOccluded(std::move(occluded))
 {}
 
 void SkBigPicture::playback(SkCanvas* canvas, AbortCallback* callback) const {
@@ -36,7 +38,8 @@ void SkBigPicture::playback(SkCanvas* canvas, AbortCallback* callback) const {
                  nullptr,
                  this->drawableCount(),
                  useBBH ? fBBH.get() : nullptr,
-                 callback);
+                 callback,
+                 SkRecordCanSkipOccluded(canvas) ? fOccluded.get() : nullptr);
 }
 
 void SkBigPicture::partialPlayback(SkCanvas* canvas,
@@ -79,6 +82,7 @@ int SkBigPicture::approximateOpCount(bool nested) const {
 size_t SkBigPicture::approximateBytesUsed() const {
     size_t bytes = sizeof(*this) + fRecord->bytesUsed() + fApproxBytesUsedBySubPictures;
     if (fBBH) { bytes += fBBH->bytesUsed(); }
+    if (fOccluded) { bytes += fOccluded->size() / 8; }
     return bytes;
 }
 
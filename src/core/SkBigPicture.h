@@ -14,6 +14,7 @@
 #include "include/private/SkNoncopyable.h"
 #include "include/private/SkOnce.h"
 #include "include/private/SkTemplates.h"
+#include "src/utils/SkBitSet.h"
 
 class SkBBoxHierarchy;
 class SkMatrix;
@@ -39,6 +40,7 @@ public:
                  sk_sp<SkRecord>,
                  std::unique_ptr<SnapshotArray>,
                  sk_sp<SkBBoxHierarchy>,
+                 std::unique_ptr<SkBitSet> occluded,
                  size_t approxBytesUsedBySubPictures);
 
 
@@ -57,6 +59,8 @@ public:
 // Used by GrRecordReplaceDraw
     const SkBBoxHierarchy* bbh() const { return fBBH.get(); }
     const SkRecord*     record() const { return fRecord.get(); }
+// Ops hidden by later draws, skipped during playback when possible (see SkRecordDraw.h)
+    const SkBitSet*   occluded() const { return fOccluded.get(); }
 
 private:
     int drawableCount() const;
@@ -67,6 +71,7 @@ private:
     sk_sp<const SkRecord>                fRecord;
     std::unique_ptr<const SnapshotArray> fDrawablePicts;
     sk_sp<const SkBBoxHierarchy>         fBBH;
+    std::unique_ptr<const SkBitSet>      fOccluded;
 };
 
 #endif//SkBigPicture_DEFINED
@@ -38,6 +38,13 @@ SkBitmapCacheDesc SkBitmapCacheDesc::Make(const SkImage* image) {
     return Make(image->uniqueID(), bounds);
 }
 
+SkBitmapCacheDesc SkBitmapCacheDesc::MakeScaled(const SkImage* image, SkISize scaledDimensions) {
+    SkASSERT(!scaledDimensions.isEmpty());
+    SkBitmapCacheDesc desc = Make(image);
+    desc.fScaledDimensions = scaledDimensions;
+    return desc;
+}
+
 namespace {
 static unsigned gBitmapKeyNamespaceLabel;
 
@@ -175,9 +182,10 @@ void SkBitmapCache::PrivateDeleteRec(Rec* rec) { delete rec; }
 
 SkBitmapCache::RecPtr SkBitmapCache::Alloc(const SkBitmapCacheDesc& desc, const SkImageInfo& info,
                                            SkPixmap* pmap) {
-    // Ensure that the info matches the subset (i.e. the subset is the entire image)
-    SkASSERT(info.width() == desc.fSubset.width());
-    SkASSERT(info.height() == desc.fSubset.height());
+    // Ensure that the info matches the subset (i.e. the subset is the entire image), or the
+    // smaller size it was decoded at
+    SkASSERT(info.dimensions() == (desc.fScaledDimensions.isEmpty() ? desc.fSubset.size()
+                                                                    : desc.fScaledDimensions));
 
     const size_t rb = info.minRowBytes();
     size_t size = info.computeByteSize(rb);
@@ -290,7 +298,8 @@ const SkMipmap* SkMipmapCache::AddAndRef(const SkImage_Base* image, SkResourceCa
         return nullptr;
     }
 
-    SkMipmap* mipmap = SkMipmap::Build(src, get_fact(localCache));
+    // Only the levels the draws ask for are computed.
+    SkMipmap* mipmap = SkMipmap::BuildLazily(src.pixmap(), get_fact(localCache));
     if (mipmap) {
         MipMapRec* rec = new MipMapRec(SkBitmapCacheDesc::Make(image), mipmap);
         CHECK_LOCAL(localCache, add, Add, rec);
@@ -26,6 +26,7 @@ void SkNotifyBitmapGenIDIsStale(uint32_t bitmapGenID);
 struct SkBitmapCacheDesc {
     uint32_t    fImageID;       // != 0
     SkIRect     fSubset;        // always set to a valid rect (entire or subset)
+    SkISize     fScaledDimensions;  // the size the pixels were decoded at, or {0, 0} if full size
 
     void validate() const {
         SkASSERT(fImageID);
@@ -34,6 +35,8 @@ struct SkBitmapCacheDesc {
     }
 
     static SkBitmapCacheDesc Make(const SkImage*);
+    // For an image's pixels decoded at a smaller size, cached separately from the full size ones.
+    static SkBitmapCacheDesc MakeScaled(const SkImage*, SkISize scaledDimensions);
     static SkBitmapCacheDesc Make(uint32_t genID, const SkIRect& subset);
 };
 
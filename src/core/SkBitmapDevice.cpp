@@ -13,19 +13,25 @@
 #include "include/core/SkPaint.h"
 #include "include/core/SkPath.h"
 #include "include/core/SkPixmap.h"
+#include "include/core/SkRSXform.h"
 #include "include/core/SkRasterHandleAllocator.h"
 #include "include/core/SkShader.h"
 #include "include/core/SkSurface.h"
 #include "include/core/SkVertices.h"
+#include "include/core/SkYUVAPixmaps.h"
+#include "include/private/SkTo.h"
+#include "src/core/SkCachedData.h"
 #include "src/core/SkDraw.h"
 #include "src/core/SkGlyphRun.h"
 #include "src/core/SkImageFilterCache.h"
 #include "src/core/SkImageFilter_Base.h"
+#include "src/core/SkMipmapAccessor.h"
 #include "src/core/SkRasterClip.h"
 #include "src/core/SkSpecialImage.h"
 #include "src/core/SkStrikeCache.h"
 #include "src/core/SkTLazy.h"
 #include "src/image/SkImage_Base.h"
+#include "src/shaders/SkImageShader.h"
 
 struct Bounder {
     SkRect  fBounds;
@@ -58,6 +64,7 @@ class SkDrawTiler {
     // fCurr... are only used if fNeedTiling
     SkTLazy<SkPostTranslateMatrixProvider> fTileMatrixProvider;
     SkRasterClip                           fTileRC;
+    SkIRect                                fTileBlitBounds;
     SkIPoint                               fOrigin;
 
     bool            fDone, fNeedsTiling;
@@ -116,6 +123,7 @@ public:
             fDraw.fDst = fRootPixmap;
             fDraw.fMatrixProvider = dev;
             fDraw.fRC = &dev->fRCStack.rc();
+            fDraw.fBlitBounds = dev->blitBounds();
             fOrigin.set(0, 0);
         }
     }
@@ -170,6 +178,10 @@ private:
         fDevice->fRCStack.rc().translate(-fOrigin.x(), -fOrigin.y(), &fTileRC);
         fTileRC.op(SkIRect::MakeWH(fDraw.fDst.width(), fDraw.fDst.height()),
                    SkClipOp::kIntersect);
+        if (const SkIRect* blitBounds = fDevice->blitBounds()) {
+            fTileBlitBounds = blitBounds->makeOffset(-fOrigin.x(), -fOrigin.y());
+            fDraw.fBlitBounds = &fTileBlitBounds;
+        }
     }
 };
 
@@ -194,6 +206,7 @@ public:
         }
         fMatrixProvider = dev;
         fRC = &dev->fRCStack.rc();
+        fBlitBounds = dev->blitBounds();
     }
 };
 
@@ -324,6 +337,9 @@ bool SkBitmapDevice::onWritePixels(const SkPixmap& pm, int x, int y) {
 
     if (fBitmap.writePixels(pm, x, y)) {
         fBitmap.notifyPixelsChanged();
+        if (fTracksDirtyRegion) {
+            this->markDirty(SkIRect::MakeXYWH(x, y, pm.width(), pm.height()));
+        }
         return true;
     }
     return false;
@@ -333,18 +349,55 @@ bool SkBitmapDevice::onReadPixels(const SkPixmap& pm, int x, int y) {
     return fBitmap.readPixels(pm, x, y);
 }
 
+void SkBitmapDevice::markDirty(const SkRect* localBounds, const SkPaint& paint) {
+    SkIRect dirty = fRCStack.rc().getBounds();
+    if (localBounds && paint.canComputeFastBounds() && !this->localToDevice().hasPerspective()) {
+        SkRect storage;
+        const SkRect& bounds = paint.computeFastBounds(*localBounds, &storage);
+        // Anti-aliasing can touch the pixels just outside of the bounds.
+        if (!dirty.intersect(this->localToDevice().mapRect(bounds).makeOutset(1, 1).roundOut())) {
+            return;
+        }
+    }
+    this->markDirty(dirty);
+}
+
+void SkBitmapDevice::markDirty(const SkIRect& deviceBounds) {
+    SkIRect dirty = deviceBounds;
+    // Checking first keeps the region from being rebuilt when a draw lands where others have.
+    if (dirty.intersect(fBitmap.bounds()) && !fDirtyRegion.contains(dirty)) {
+        fDirtyRegion.op(dirty, SkRegion::kUnion_Op);
+        // Each union costs more as the region grows, so once it's made of many rects (e.g. from
+        // draws scattered all over) give up on its shape and keep just its bounds.
+        if (fDirtyRegion.computeRegionComplexity() > kMaxDirtyRegionComplexity) {
+            fDirtyRegion.setRect(fDirtyRegion.getBounds());
+        }
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 void SkBitmapDevice::drawPaint(const SkPaint& paint) {
+    if (fTracksDirtyRegion) {
+        this->markDirty(nullptr, paint);
+    }
     BDDraw(this).drawPaint(paint);
 }
 
 void SkBitmapDevice::drawPoints(SkCanvas::PointMode mode, size_t count,
                                 const SkPoint pts[], const SkPaint& paint) {
+    if (fTracksDirtyRegion && count > 0) {
+        SkRect bounds;
+        bounds.setBounds(pts, SkToInt(count));
+        this->markDirty(&bounds, paint);
+    }
     LOOP_TILER( drawPoints(mode, count, pts, paint, nullptr), nullptr)
 }
 
 void SkBitmapDevice::drawRect(const SkRect& r, const SkPaint& paint) {
+    if (fTracksDirtyRegion) {
+        this->markDirty(&r, paint);
+    }
     LOOP_TILER( drawRect(r, paint), Bounder(r, paint))
 }
 
@@ -360,6 +413,9 @@ void SkBitmapDevice::drawRRect(const SkRRect& rrect, const SkPaint& paint) {
     // required to override drawRRect.
     this->drawPath(SkPath::RRect(rrect), paint, true);
 #else
+    if (fTracksDirtyRegion) {
+        this->markDirty(&rrect.getBounds(), paint);
+    }
     LOOP_TILER( drawRRect(rrect, paint), Bounder(rrect.getBounds(), paint))
 #endif
 }
@@ -367,6 +423,9 @@ void SkBitmapDevice::drawRRect(const SkRRect& rrect, const SkPaint& paint) {
 void SkBitmapDevice::drawPath(const SkPath& path,
                               const SkPaint& paint,
                               bool pathIsMutable) {
+    if (fTracksDirtyRegion) {
+        this->markDirty(path.isInverseFillType() ? nullptr : &path.getBounds(), paint);
+    }
     const SkRect* bounds = nullptr;
     if (SkDrawTiler::NeedsTiling(this) && !path.isInverseFillType()) {
         bounds = &path.getBounds();
@@ -383,6 +442,11 @@ void SkBitmapDevice::drawPath(const SkPath& path,
 void SkBitmapDevice::drawBitmap(const SkBitmap& bitmap, const SkMatrix& matrix,
                                 const SkRect* dstOrNull, const SkSamplingOptions& sampling,
                                 const SkPaint& paint) {
+    if (fTracksDirtyRegion) {
+        const SkRect drawn = dstOrNull ? *dstOrNull
+                                       : matrix.mapRect(SkRect::Make(bitmap.dimensions()));
+        this->markDirty(&drawn, paint);
+    }
     const SkRect* bounds = dstOrNull;
     SkRect storage;
     if (!bounds && SkDrawTiler::NeedsTiling(this)) {
@@ -412,10 +476,42 @@ void SkBitmapDevice::drawImageRect(const SkImage* image, const SkRect* src, cons
     SkASSERT(dst.isSorted());
 
     SkBitmap bitmap;
-    // TODO: Elevate direct context requirement to public API and remove cheat.
-    auto dContext = as_IB(image)->directContext();
-    if (!as_IB(image)->getROPixels(dContext, &bitmap)) {
-        return;
+    SkRect scaledSrc;
+    SkMatrix inv;
+    if (SkMatrix::Concat(this->localToDevice(),
+                         SkMatrix::RectToRect(src ? *src : SkRect::Make(image->bounds()), dst))
+                .invert(&inv) &&
+        SkMipmapAccessor::GetScaledPixels(as_IB(image), inv, &bitmap)) {
+        // Draw the smaller decode in place of the image, from the same part of it.
+        if (src) {
+            scaledSrc = SkMatrix::Scale(SkIntToScalar(bitmap.width())  / image->width(),
+                                        SkIntToScalar(bitmap.height()) / image->height())
+                                .mapRect(*src);
+            src = &scaledSrc;
+        }
+    } else {
+        // Images backed by YUVA planes are drawn by their shader straight from the planes, unless
+        // that could filter in pixels from outside of a strict src.
+        if (sampling.mipmap == SkMipmapMode::kNone && !sampling.useCubic &&
+            (!src || src->contains(SkRect::Make(image->bounds())) ||
+             constraint == SkCanvas::kFast_SrcRectConstraint)) {
+            SkYUVAPixmaps pixmaps;
+            if (sk_sp<SkCachedData> planes = as_IB(image)->getROPlanes(&pixmaps)) {
+                const SkMatrix matrix = SkMatrix::RectToRect(
+                        src ? *src : SkRect::Make(image->bounds()), dst);
+                SkPaint paintWithShader(paint);
+                paintWithShader.setStyle(SkPaint::kFill_Style);
+                paintWithShader.setShader(SkImageShader::MakeFromPlanes(
+                        sk_ref_sp(image), std::move(planes), pixmaps, sampling, &matrix));
+                this->drawRect(dst, paintWithShader);
+                return;
+            }
+        }
+        // TODO: Elevate direct context requirement to public API and remove cheat.
+        auto dContext = as_IB(image)->directContext();
+        if (!as_IB(image)->getROPixels(dContext, &bitmap)) {
+            return;
+        }
     }
 
     SkRect      bitmapBounds, tmpSrc, tmpDst;
@@ -525,6 +621,10 @@ void SkBitmapDevice::onDrawGlyphRunList(SkCanvas* canvas,
                                         const SkGlyphRunList& glyphRunList,
                                         const SkPaint& paint) {
     SkASSERT(!glyphRunList.hasRSXForm());
+    if (fTracksDirtyRegion) {
+        const SkRect bounds = glyphRunList.sourceBounds();
+        this->markDirty(&bounds, paint);
+    }
     LOOP_TILER( drawGlyphRunList(canvas, &fGlyphPainter, glyphRunList, paint), nullptr )
 }
 
@@ -536,12 +636,20 @@ void SkBitmapDevice::drawVertices(const SkVertices* vertices,
         blender = SkBlender::Mode(SkBlendMode::kDst);
     }
 #endif
+    if (fTracksDirtyRegion) {
+        this->markDirty(&vertices->bounds(), paint);
+    }
     BDDraw(this).drawVertices(vertices, std::move(blender), paint);
 }
 
 #ifdef SK_ENABLE_SKSL
-void SkBitmapDevice::drawCustomMesh(SkCustomMesh, sk_sp<SkBlender>, const SkPaint&) {
-    // TODO: Implement
+void SkBitmapDevice::drawCustomMesh(SkCustomMesh cm,
+                                    sk_sp<SkBlender> blender,
+                                    const SkPaint& paint) {
+    if (fTracksDirtyRegion) {
+        this->markDirty(&cm.bounds, paint);
+    }
+    BDDraw(this).drawCustomMesh(cm, std::move(blender), paint);
 }
 #endif
 
@@ -556,6 +664,17 @@ void SkBitmapDevice::drawAtlas(const SkRSXform xform[],
         this->INHERITED::drawAtlas(xform, tex, colors, count, std::move(blender), paint);
         return;
     }
+    if (fTracksDirtyRegion) {
+        SkRect bounds = SkRect::MakeEmpty();
+        for (int i = 0; i < count; i++) {
+            SkPoint quad[4];
+            xform[i].toQuad(tex[i].width(), tex[i].height(), quad);
+            SkRect r;
+            r.setBounds(quad, 4);
+            bounds.join(r);
+        }
+        this->markDirty(&bounds, paint);
+    }
     BDDraw(this).drawAtlas(xform, tex, colors, count, std::move(blender), paint);
 }
 
@@ -579,6 +698,14 @@ void SkBitmapDevice::drawSpecial(SkSpecialImage* src,
 
     SkBitmap resultBM;
     if (src->getROPixels(&resultBM)) {
+        if (fTracksDirtyRegion) {
+            SkIRect dirty = fRCStack.rc().getBounds();
+            if (localToDevice.hasPerspective() ||
+                dirty.intersect(localToDevice.mapRect(SkRect::Make(resultBM.dimensions()))
+                                             .makeOutset(1, 1).roundOut())) {
+                this->markDirty(dirty);
+            }
+        }
         SkDraw draw;
         SkMatrixProvider matrixProvider(localToDevice);
         if (!this->accessPixels(&draw.fDst)) {
@@ -586,6 +713,7 @@ void SkBitmapDevice::drawSpecial(SkSpecialImage* src,
         }
         draw.fMatrixProvider = &matrixProvider;
         draw.fRC = &fRCStack.rc();
+        draw.fBlitBounds = this->blitBounds();
         draw.drawBitmap(resultBM, SkMatrix::I(), nullptr, sampling, paint);
     }
 }
@@ -704,3 +832,18 @@ SkBaseDevice::ClipType SkBitmapDevice::onGetClipType() const {
 SkIRect SkBitmapDevice::onDevClipBounds() const {
     return fRCStack.rc().getBounds();
 }
+
+SkIRect SkBitmapDevice::filterOutputBounds(const skif::Mapping& mapping) const {
+    SkIRect bounds = this->devClipBounds();
+    // Only trim the output when it is drawn without resampling; otherwise the pixels just inside
+    // the blit bounds could sample past the edge of the trimmed output.
+    const SkMatrix& layerToDevice = mapping.deviceMatrix();
+    if (fHasBlitBounds && layerToDevice.isTranslate() &&
+        SkScalarIsInt(layerToDevice.getTranslateX()) &&
+        SkScalarIsInt(layerToDevice.getTranslateY())) {
+        if (!bounds.intersect(fBlitBounds)) {
+            bounds.setEmpty();
+        }
+    }
+    return bounds;
+}
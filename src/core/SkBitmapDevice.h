@@ -13,6 +13,7 @@
 #include "include/core/SkColor.h"
 #include "include/core/SkImageInfo.h"
 #include "include/core/SkRect.h"
+#include "include/core/SkRegion.h"
 #include "include/core/SkScalar.h"
 #include "include/core/SkSize.h"
 #include "src/core/SkDevice.h"
@@ -60,6 +61,29 @@ public:
     static SkBitmapDevice* Create(const SkImageInfo&, const SkSurfaceProps&,
                                   SkRasterHandleAllocator* = nullptr);
 
+    /**
+     *  Keeps draws from writing any pixel outside of bounds (in device space). Unlike a clip this
+     *  does not change how anything is rasterized or how big layers are, so the pixels inside
+     *  come out exactly as they would if the whole device were drawn.
+     */
+    void setBlitBounds(const SkIRect& bounds) {
+        fBlitBounds = bounds;
+        fHasBlitBounds = true;
+    }
+
+    /**
+     *  While tracking, the device accumulates the region of its pixels that drawing may have
+     *  changed: the clipped device bounds of each draw, and the pixels written by writePixels.
+     *  Once the region is made of many rects it is simplified to its bounds.
+     *  Turning tracking on or off empties the region.
+     */
+    void setTracksDirtyRegion(bool tracks) {
+        fTracksDirtyRegion = tracks;
+        fDirtyRegion.setEmpty();
+    }
+    const SkRegion& dirtyRegion() const { return fDirtyRegion; }
+    void resetDirtyRegion() { fDirtyRegion.setEmpty(); }
+
 protected:
     void* getRasterHandle() const override { return fRasterHandle; }
 
@@ -127,6 +151,7 @@ protected:
     void validateDevBounds(const SkIRect& r) override;
     ClipType onGetClipType() const override;
     SkIRect onDevClipBounds() const override;
+    SkIRect filterOutputBounds(const skif::Mapping&) const override;
 
     void drawBitmap(const SkBitmap&, const SkMatrix&, const SkRect* dstOrNull,
                     const SkSamplingOptions&, const SkPaint&);
@@ -150,10 +175,26 @@ private:
 
     SkImageFilterCache* getImageFilterCache() override;
 
+    const SkIRect* blitBounds() const { return fHasBlitBounds ? &fBlitBounds : nullptr; }
+
+    // Adds the device bounds of a draw with the given local bounds (or of the clip, if they are
+    // null or the paint can't bound the draw), or device bounds, to fDirtyRegion.  Only call
+    // while tracking.
+    void markDirty(const SkRect* localBounds, const SkPaint&);
+    void markDirty(const SkIRect& deviceBounds);
+
+    // Past this many intervals (see SkRegion::computeRegionComplexity) fDirtyRegion collapses
+    // to its bounds.
+    inline static constexpr int kMaxDirtyRegionComplexity = 16;
+
     SkBitmap    fBitmap;
     void*       fRasterHandle = nullptr;
     SkRasterClipStack  fRCStack;
     SkGlyphRunListPainter fGlyphPainter;
+    bool        fHasBlitBounds = false;
+    SkIRect     fBlitBounds;
+    bool        fTracksDirtyRegion = false;
+    SkRegion    fDirtyRegion;
 
 
     using INHERITED = SkBaseDevice;
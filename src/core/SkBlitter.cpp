@@ -480,9 +480,27 @@ void SkRectClipBlitter::blitMask(const SkMask& mask, const SkIRect& clip) {
 }
 
 const SkPixmap* SkRectClipBlitter::justAnOpaqueColor(uint32_t* value) {
+    // As with the other clipping blitters, callers that write straight into the returned pixels
+    // clip those writes themselves (see SkDraw's blit bounds).
     return fBlitter->justAnOpaqueColor(value);
 }
 
+void SkRectClipBlitter::blitAntiH2(int x, int y, U8CPU a0, U8CPU a1) {
+    if (y_in_rect(y, fClipRect) && fClipRect.fLeft <= x && x + 1 < fClipRect.fRight) {
+        fBlitter->blitAntiH2(x, y, a0, a1);
+    } else {
+        this->SkBlitter::blitAntiH2(x, y, a0, a1);
+    }
+}
+
+void SkRectClipBlitter::blitAntiV2(int x, int y, U8CPU a0, U8CPU a1) {
+    if (x_in_rect(x, fClipRect) && fClipRect.fTop <= y && y + 1 < fClipRect.fBottom) {
+        fBlitter->blitAntiV2(x, y, a0, a1);
+    } else {
+        this->SkBlitter::blitAntiV2(x, y, a0, a1);
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 void SkRgnClipBlitter::blitH(int x, int y, int width) {
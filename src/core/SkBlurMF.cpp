@@ -75,6 +75,7 @@ public:
 
     void computeFastBounds(const SkRect&, SkRect*) const override;
     bool asABlur(BlurRec*) const override;
+    bool asAnalyticBlur(const SkMatrix&, SkScalar* devSigma) const override;
 
 
 protected:
@@ -146,6 +147,18 @@ bool SkBlurMaskFilterImpl::asABlur(BlurRec* rec) const {
     return true;
 }
 
+bool SkBlurMaskFilterImpl::asAnalyticBlur(const SkMatrix& matrix, SkScalar* devSigma) const {
+    if (fBlurStyle != kNormal_SkBlurStyle) {
+        return false;
+    }
+    SkScalar sigma = this->computeXformedSigma(matrix);
+    if (!(sigma > 0)) {
+        return false;
+    }
+    *devSigma = sigma;
+    return true;
+}
+
 bool SkBlurMaskFilterImpl::filterMask(SkMask* dst, const SkMask& src,
                                       const SkMatrix& matrix,
                                       SkIPoint* margin) const {
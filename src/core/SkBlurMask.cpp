@@ -8,6 +8,7 @@
 #include "src/core/SkBlurMask.h"
 
 #include "include/core/SkColorPriv.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkMath.h"
 #include "include/private/SkTPin.h"
 #include "include/private/SkTemplates.h"
@@ -131,7 +132,7 @@ bool SkBlurMask::BoxBlur(SkMask* dst, const SkMask& src, SkScalar sigma, SkBlurS
         }
         return false;
     }
-    const SkIPoint border = blurFilter.blur(src, dst);
+    const SkIPoint border = blurFilter.blur(src, dst, &SkExecutor::GetDefault());
     // If src.fImage is null, then this call is only to calculate the border.
     if (src.fImage != nullptr && dst->fImage == nullptr) {
         return false;
@@ -63,6 +63,11 @@ public:
         canvas->internal_private_resetClip();
     }
 
+    // Whether the clip may only partially cover some pixels.
+    static bool IsClipAA(const SkCanvas* canvas) {
+        return canvas->androidFramework_isClipAA();
+    }
+
 #if GR_TEST_UTILS
 #if SK_GPU_V1
     static skgpu::v1::SurfaceDrawContext* TopDeviceSurfaceDrawContext(SkCanvas*);
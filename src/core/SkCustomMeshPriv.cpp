@@ -9,6 +9,23 @@
 
 #ifdef SK_ENABLE_SKSL
 
+#include "src/core/SkVM.h"
+#include "src/sksl/codegen/SkSLVMCodeGenerator.h"
+#include "src/sksl/ir/SkSLProgram.h"
+
+const skvm::Program* SkCustomMeshSpecificationPriv::VertexProgram(
+        const SkCustomMeshSpecification& spec) {
+    spec.fVertexProgramOnce([&] {
+        const SkSL::FunctionDefinition* main = SkSL::Program_GetFunction(*spec.fVS, "main");
+        skvm::Builder b;
+        if (main && SkSL::ProgramToSkVM(*spec.fVS, *main, &b, /*debugTrace=*/nullptr,
+                                        /*uniforms=*/{})) {
+            spec.fVertexProgram = std::make_unique<skvm::Program>(b.done("CustomMeshVS"));
+        }
+    });
+    return spec.fVertexProgram.get();
+}
+
 static int min_vcount_for_mode(SkCustomMesh::Mode mode) {
     switch (mode) {
         case SkCustomMesh::Mode::kTriangles:     return 3;
@@ -26,6 +26,13 @@ struct SkCustomMeshSpecificationPriv {
     static const SkSL::Program* VS(const SkCustomMeshSpecification& spec) { return spec.fVS.get(); }
     static const SkSL::Program* FS(const SkCustomMeshSpecification& spec) { return spec.fFS.get(); }
 
+    /**
+     * The vertex program compiled to SkVM, or null if it can't be. It is called as
+     *   p.eval(n, attributeSlots..., varyingSlots..., positionX, positionY)
+     * with one float per vertex for every slot of the Attributes and Varyings structs.
+     */
+    static const skvm::Program* VertexProgram(const SkCustomMeshSpecification&);
+
     static int Hash(const SkCustomMeshSpecification& spec) { return spec.fHash; }
 
     static ColorType GetColorType(const SkCustomMeshSpecification& spec) { return spec.fColorType; }
@@ -323,7 +323,7 @@ void SkBaseDevice::drawFilteredImage(const skif::Mapping& mapping, SkSpecialImag
     SkASSERT(!paint.getImageFilter() && !paint.getMaskFilter());
 
     skif::LayerSpace<SkIRect> targetOutput = mapping.deviceToLayer(
-            skif::DeviceSpace<SkIRect>(this->devClipBounds()));
+            skif::DeviceSpace<SkIRect>(this->filterOutputBounds(mapping)));
 
     // FIXME If the saved layer (so src) was created to use F16, should we do all image filtering
     // in F16 and then only flatten to the destination color encoding at the end?
@@ -334,6 +334,10 @@ protected:
      */
     virtual void drawFilteredImage(const skif::Mapping& mapping, SkSpecialImage* src,
                                    const SkImageFilter*, const SkSamplingOptions&, const SkPaint&);
+    // The device space pixels that drawFilteredImage() asks the filter to produce.
+    virtual SkIRect filterOutputBounds(const skif::Mapping&) const {
+        return this->devClipBounds();
+    }
 
     virtual sk_sp<SkSpecialImage> makeSpecial(const SkBitmap&);
     virtual sk_sp<SkSpecialImage> makeSpecial(const SkImage*);
@@ -72,6 +72,18 @@ bool SkDraw::computeConservativeLocalClipBounds(SkRect* localBounds) const {
     return true;
 }
 
+SkBlitter* SkDraw::restrictBlitter(SkBlitter* blitter, SkArenaAlloc* alloc) const {
+    if (!blitter || !fBlitBounds) {
+        return blitter;
+    }
+    if (fBlitBounds->isEmpty()) {
+        return alloc->make<SkNullBlitter>();
+    }
+    auto clipper = alloc->make<SkRectClipBlitter>();
+    clipper->init(blitter, *fBlitBounds);
+    return clipper;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 void SkDraw::drawPaint(const SkPaint& paint) const {
@@ -98,13 +110,14 @@ struct PtProcRec {
 
     // computed values
     SkRect   fClipBounds;
+    SkIRect  fPixelBounds;  // fRC's bounds, limited to the blit bounds for procs that write pixels
     SkScalar fRadius;
 
     typedef void (*Proc)(const PtProcRec&, const SkPoint devPts[], int count,
                          SkBlitter*);
 
     bool init(SkCanvas::PointMode, const SkPaint&, const SkMatrix* matrix,
-              const SkRasterClip*);
+              const SkRasterClip*, const SkIRect* blitBounds);
     Proc chooseProc(SkBlitter** blitter);
 
 private:
@@ -129,7 +142,7 @@ static void bw_pt_rect_16_hair_proc(const PtProcRec& rec,
                                     const SkPoint devPts[], int count,
                                     SkBlitter* blitter) {
     SkASSERT(rec.fRC->isRect());
-    const SkIRect& r = rec.fRC->getBounds();
+    const SkIRect& r = rec.fPixelBounds;
     uint32_t value;
     const SkPixmap* dst = blitter->justAnOpaqueColor(&value);
     SkASSERT(dst);
@@ -150,7 +163,7 @@ static void bw_pt_rect_32_hair_proc(const PtProcRec& rec,
                                     const SkPoint devPts[], int count,
                                     SkBlitter* blitter) {
     SkASSERT(rec.fRC->isRect());
-    const SkIRect& r = rec.fRC->getBounds();
+    const SkIRect& r = rec.fPixelBounds;
     uint32_t value;
     const SkPixmap* dst = blitter->justAnOpaqueColor(&value);
     SkASSERT(dst);
@@ -243,7 +256,8 @@ static void aa_square_proc(const PtProcRec& rec, const SkPoint devPts[],
 
 // If this returns true, then chooseProc() must return a valid proc
 bool PtProcRec::init(SkCanvas::PointMode mode, const SkPaint& paint,
-                     const SkMatrix* matrix, const SkRasterClip* rc) {
+                     const SkMatrix* matrix, const SkRasterClip* rc,
+                     const SkIRect* blitBounds) {
     if ((unsigned)mode > (unsigned)SkCanvas::kPolygon_PointMode) {
         return false;
     }
@@ -275,6 +289,10 @@ bool PtProcRec::init(SkCanvas::PointMode mode, const SkPaint& paint,
         fClip = nullptr;
         fRC = rc;
         fClipBounds = clipBounds;
+        fPixelBounds = rc->getBounds();
+        if (blitBounds && !fPixelBounds.intersect(*blitBounds)) {
+            fPixelBounds.setEmpty();
+        }
         fRadius = radius;
         return true;
     }
@@ -365,7 +383,7 @@ void SkDraw::drawPoints(SkCanvas::PointMode mode, size_t count,
 
     SkMatrix ctm = fMatrixProvider->localToDevice();
     PtProcRec rec;
-    if (!device && rec.init(mode, paint, &ctm, fRC)) {
+    if (!device && rec.init(mode, paint, &ctm, fRC, fBlitBounds)) {
         SkAutoBlitterChoose blitter(*this, nullptr, paint);
 
         SkPoint             devPts[MAX_DEV_PTS];
@@ -1103,8 +1121,10 @@ void SkDraw::drawBitmap(const SkBitmap& bitmap, const SkMatrix& prematrix,
         if (clipHandlesSprite(*fRC, ix, iy, pmap)) {
             SkSTArenaAlloc<kSkBlitterContextSize> allocator;
             // blitter will be owned by the allocator.
-            SkBlitter* blitter = SkBlitter::ChooseSprite(fDst, *paint, pmap, ix, iy, &allocator,
-                                                         fRC->clipShader());
+            SkBlitter* blitter = this->restrictBlitter(
+                    SkBlitter::ChooseSprite(fDst, *paint, pmap, ix, iy, &allocator,
+                                            fRC->clipShader()),
+                    &allocator);
             if (blitter) {
                 SkScan::FillIRect(SkIRect::MakeXYWH(ix, iy, pmap.width(), pmap.height()),
                                   *fRC, blitter);
@@ -1165,8 +1185,9 @@ void SkDraw::drawSprite(const SkBitmap& bitmap, int x, int y, const SkPaint& ori
     if (nullptr == paint.getColorFilter() && clipHandlesSprite(*fRC, x, y, pmap)) {
         // blitter will be owned by the allocator.
         SkSTArenaAlloc<kSkBlitterContextSize> allocator;
-        SkBlitter* blitter = SkBlitter::ChooseSprite(fDst, paint, pmap, x, y, &allocator,
-                                                     fRC->clipShader());
+        SkBlitter* blitter = this->restrictBlitter(
+                SkBlitter::ChooseSprite(fDst, paint, pmap, x, y, &allocator, fRC->clipShader()),
+                &allocator);
         if (blitter) {
             SkScan::FillIRect(bounds, *fRC, blitter);
             return;
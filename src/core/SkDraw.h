@@ -17,8 +17,10 @@
 #include "src/core/SkGlyphRunPainter.h"
 #include "src/core/SkMask.h"
 
+class SkArenaAlloc;
 class SkBitmap;
 class SkClipStack;
+struct SkCustomMesh;
 class SkBaseDevice;
 class SkBlitter;
 class SkMatrix;
@@ -66,6 +68,9 @@ public:
                              const SkGlyphRunList& glyphRunList,
                              const SkPaint& paint) const;
     void    drawVertices(const SkVertices*, sk_sp<SkBlender>, const SkPaint&) const;
+#ifdef SK_ENABLE_SKSL
+    void    drawCustomMesh(const SkCustomMesh&, sk_sp<SkBlender>, const SkPaint&) const;
+#endif
     void  drawAtlas(const SkRSXform[], const SkRect[], const SkColor[], int count,
                     sk_sp<SkBlender>, const SkPaint&);
 
@@ -157,9 +162,18 @@ private:
     bool SK_WARN_UNUSED_RESULT computeConservativeLocalClipBounds(SkRect* bounds) const;
 
 public:
+    /**
+     *  Returns blitter, or if fBlitBounds is set, a wrapper (allocated in alloc) that keeps it
+     *  from touching any pixel outside of fBlitBounds.
+     */
+    SkBlitter* restrictBlitter(SkBlitter* blitter, SkArenaAlloc* alloc) const;
+
     SkPixmap                fDst;
     const SkMatrixProvider* fMatrixProvider{nullptr};  // required
     const SkRasterClip*     fRC{nullptr};              // required
+    // If set, no pixel outside of these device bounds is written. Unlike fRC, this does not
+    // change how anything is rasterized, so pixels inside come out exactly as they would without.
+    const SkIRect*          fBlitBounds{nullptr};      // optional
 
 #ifdef SK_DEBUG
     void validate() const;
@@ -157,8 +157,8 @@ void SkDraw::drawAtlas(const SkRSXform xform[],
             isOpaque = false;
         }
 
-        auto blitter = SkCreateRasterPipelineBlitter(
-                fDst, p, pipeline, isOpaque, &alloc, fRC->clipShader());
+        auto blitter = this->restrictBlitter(SkCreateRasterPipelineBlitter(
+                fDst, p, pipeline, isOpaque, &alloc, fRC->clipShader()), &alloc);
         if (!blitter) {
             return false;
         }
@@ -195,8 +195,9 @@ void SkDraw::drawAtlas(const SkRSXform xform[],
             shader = as_SB(updateShader);
         }
         p.setShader(sk_ref_sp(shader));
-        if (auto blitter = SkVMBlitter::Make(fDst, p, *fMatrixProvider, &alloc,
-                                             fRC->clipShader())) {
+        if (auto blitter = this->restrictBlitter(SkVMBlitter::Make(fDst, p, *fMatrixProvider,
+                                                                   &alloc, fRC->clipShader()),
+                                                 &alloc)) {
             SkPath scratchPath;
             for (int i = 0; i < count; ++i) {
                 if (colorShader) {
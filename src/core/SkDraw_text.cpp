@@ -39,8 +39,9 @@ void SkDraw::paintMasks(SkDrawableGlyphBuffer* accepted, const SkPaint& paint) c
 
     // The size used for a typical blitter.
     SkSTArenaAlloc<3308> alloc;
-    SkBlitter* blitter =
-            SkBlitter::Choose(fDst, *fMatrixProvider, paint, &alloc, false, fRC->clipShader());
+    SkBlitter* blitter = this->restrictBlitter(
+            SkBlitter::Choose(fDst, *fMatrixProvider, paint, &alloc, false, fRC->clipShader()),
+            &alloc);
 
     SkAAClipBlitterWrapper wrapper{*fRC, blitter};
     blitter = wrapper.getBlitter();
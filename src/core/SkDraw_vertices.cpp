@@ -16,6 +16,7 @@
 #include "src/core/SkRasterClip.h"
 #include "src/core/SkRasterPipeline.h"
 #include "src/core/SkScan.h"
+#include "src/core/SkUtils.h"
 #include "src/core/SkVM.h"
 #include "src/core/SkVMBlitter.h"
 #include "src/core/SkVertState.h"
@@ -24,6 +25,14 @@
 #include "src/shaders/SkComposeShader.h"
 #include "src/shaders/SkShaderBase.h"
 
+#ifdef SK_ENABLE_SKSL
+#include "include/core/SkCustomMesh.h"
+#include "src/core/SkColorSpaceXformSteps.h"
+#include "src/core/SkCustomMeshPriv.h"
+#include "src/sksl/codegen/SkSLVMCodeGenerator.h"
+#include "src/sksl/ir/SkSLProgram.h"
+#endif
+
 struct Matrix43 {
     float fMat[12];    // column major
 
@@ -389,8 +398,9 @@ void SkDraw::drawFixedVertices(const SkVertices* vertices,
         shaderPaint.setShader(sk_ref_sp(shader));
 
         if (!texCoords) {  // only tricolor shader
-            auto blitter = SkCreateRasterPipelineBlitter(
-                    fDst, shaderPaint, *fMatrixProvider, outerAlloc, this->fRC->clipShader());
+            auto blitter = this->restrictBlitter(SkCreateRasterPipelineBlitter(
+                    fDst, shaderPaint, *fMatrixProvider, outerAlloc, this->fRC->clipShader()),
+                    outerAlloc);
             if (!blitter) {
                 return false;
             }
@@ -426,8 +436,9 @@ void SkDraw::drawFixedVertices(const SkVertices* vertices,
                 }
             }
 
-            auto blitter = SkCreateRasterPipelineBlitter(
-                    fDst, shaderPaint, pipeline, isOpaque, outerAlloc, fRC->clipShader());
+            auto blitter = this->restrictBlitter(SkCreateRasterPipelineBlitter(
+                    fDst, shaderPaint, pipeline, isOpaque, outerAlloc, fRC->clipShader()),
+                    outerAlloc);
             if (!blitter) {
                 return false;
             }
@@ -465,8 +476,9 @@ void SkDraw::drawFixedVertices(const SkVertices* vertices,
                 }
 
                 // It'd be nice if we could detect this will fail earlier.
-                auto blitter = SkCreateRasterPipelineBlitter(
-                        fDst, shaderPaint, *matrixProvider, &innerAlloc, this->fRC->clipShader());
+                auto blitter = this->restrictBlitter(SkCreateRasterPipelineBlitter(
+                        fDst, shaderPaint, *matrixProvider, &innerAlloc, this->fRC->clipShader()),
+                        &innerAlloc);
                 if (!blitter) {
                     return false;
                 }
@@ -492,8 +504,9 @@ void SkDraw::drawFixedVertices(const SkVertices* vertices,
 
         SkPaint shaderPaint{paint};
         shaderPaint.setShader(sk_ref_sp(shader));
-        auto blitter = SkVMBlitter::Make(
-                fDst, shaderPaint, *fMatrixProvider, outerAlloc, this->fRC->clipShader());
+        auto blitter = this->restrictBlitter(SkVMBlitter::Make(
+                fDst, shaderPaint, *fMatrixProvider, outerAlloc, this->fRC->clipShader()),
+                outerAlloc);
         if (!blitter) {
             return;
         }
@@ -561,3 +574,338 @@ void SkDraw::drawVertices(const SkVertices* vertices,
 
     this->drawFixedVertices(vertices, std::move(blender), paint, ctmInv, dev2, dev3, &outerAlloc);
 }
+
+#ifdef SK_ENABLE_SKSL
+
+using Attribute = SkCustomMeshSpecification::Attribute;
+using Varying   = SkCustomMeshSpecification::Varying;
+
+static constexpr int kMaxAttributeSlots = 4 * SkCustomMeshSpecification::kMaxAttributes;
+static constexpr int kMaxVaryingSlots   = 4 * SkCustomMeshSpecification::kMaxVaryings;
+
+static int attribute_slot_count(const SkCustomMeshSpecification& spec) {
+    int slots = 0;
+    for (const Attribute& a : spec.attributes()) {
+        slots += SkSLTypeVecLength(SkCustomMeshSpecificationPriv::AttrTypeAsSLType(a.type));
+    }
+    return slots;
+}
+
+static int varying_slot_count(const SkCustomMeshSpecification& spec) {
+    int slots = 0;
+    for (const Varying& v : SkCustomMeshSpecificationPriv::Varyings(spec)) {
+        slots += SkSLTypeVecLength(SkCustomMeshSpecificationPriv::VaryingTypeAsSLType(v.type));
+    }
+    // An empty Varyings struct gets a placeholder bool, which still takes up a slot.
+    return std::max(slots, 1);
+}
+
+// Unpacks the attributes of 'count' vertices into one float per slot per vertex, with 'slotStride'
+// floats between the starts of successive slots in 'dst'.
+static void unpack_attributes(const SkCustomMeshSpecification& spec, const char* vertices,
+                              int count, float dst[], int slotStride) {
+    for (const Attribute& a : spec.attributes()) {
+        const char* src = vertices + a.offset;
+        if (a.type == Attribute::Type::kUByte4_unorm) {
+            for (int i = 0; i < count; ++i, src += spec.stride()) {
+                for (int c = 0; c < 4; ++c) {
+                    dst[c*slotStride + i] = (uint8_t)src[c] * (1/255.0f);
+                }
+            }
+            dst += 4*slotStride;
+        } else {
+            const int n = SkSLTypeVecLength(SkCustomMeshSpecificationPriv::AttrTypeAsSLType(a.type));
+            for (int i = 0; i < count; ++i, src += spec.stride()) {
+                for (int c = 0; c < n; ++c) {
+                    dst[c*slotStride + i] = sk_unaligned_load<float>(src + c*sizeof(float));
+                }
+            }
+            dst += n*slotStride;
+        }
+    }
+}
+
+// Runs a custom mesh's fragment program over one triangle at a time. Each pixel's barycentric
+// coordinates are computed from its device position, as in SkTriColorShader, and used to
+// interpolate the vertex program's local position and varyings. The fragment program's color (if
+// any) is then blended with the paint's shader, sampled at the fragment program's local coords.
+class SkCustomMeshShader : public SkShaderBase {
+public:
+    SkCustomMeshShader(const SkCustomMeshSpecification& spec,
+                       int varyingSlots,
+                       sk_sp<SkShader> paintShader,
+                       sk_sp<SkBlender> blender,
+                       bool usePersp,
+                       SkArenaAlloc* alloc)
+            : fSpec(spec)
+            , fVaryingSlots(varyingSlots)
+            , fPaintShader(std::move(paintShader))
+            , fBlender(std::move(blender))
+            , fUsePersp(usePersp)
+            , fCoeffs(alloc->makeArrayDefault<float>(9 + 3*(2 + varyingSlots))) {}
+
+    // This gets called for each triangle, without rebuilding the program. 'varyings' holds
+    // 'vertexCount' values for each varying slot in turn.
+    bool update(const SkMatrix& ctmInv, const SkPoint positions[], const float varyings[],
+                int vertexCount, int index0, int index1, int index2);
+
+protected:
+#ifdef SK_ENABLE_LEGACY_SHADERCONTEXT
+    Context* onMakeContext(const ContextRec& rec, SkArenaAlloc* alloc) const override {
+        return nullptr;
+    }
+#endif
+
+    skvm::Color onProgram(skvm::Builder*,
+                          skvm::Coord, skvm::Coord, skvm::Color,
+                          const SkMatrixProvider&, const SkMatrix*, const SkColorInfo&,
+                          skvm::Uniforms*, SkArenaAlloc*) const override;
+
+private:
+    // For serialization.  This will never be called.
+    Factory getFactory() const override { return nullptr; }
+    const char* getTypeName() const override { return nullptr; }
+
+    const SkCustomMeshSpecification& fSpec;
+    const int                        fVaryingSlots;
+    const sk_sp<SkShader>            fPaintShader;
+    const sk_sp<SkBlender>           fBlender;
+    const bool                       fUsePersp;
+
+    // A 3x3 matrix from device space to barycentric coordinates, followed by the value at the
+    // first vertex and the deltas to the second and third for x, y, and each varying slot.
+    float* const fCoeffs;
+
+    using INHERITED = SkShaderBase;
+};
+
+skvm::Color SkCustomMeshShader::onProgram(skvm::Builder* b,
+                                          skvm::Coord device, skvm::Coord local, skvm::Color paint,
+                                          const SkMatrixProvider&, const SkMatrix*,
+                                          const SkColorInfo& dst, skvm::Uniforms* uniforms,
+                                          SkArenaAlloc* alloc) const {
+    const SkSL::Program& fs = *SkCustomMeshSpecificationPriv::FS(fSpec);
+    const SkSL::FunctionDefinition* main = SkSL::Program_GetFunction(fs, "main");
+    if (!main) {
+        return {};
+    }
+
+    skvm::Uniform coeffs = uniforms->pushPtr(fCoeffs);
+
+    auto dot = [&, x = local.x, y = local.y](int row) {
+        return b->mad(x, b->arrayF(coeffs, 3*row + 0),
+                         b->mad(y, b->arrayF(coeffs, 3*row + 1),
+                                   b->arrayF(coeffs, 3*row + 2)));
+    };
+    skvm::F32 u = dot(0),
+              v = dot(1);
+    if (fUsePersp) {
+        skvm::F32 w = 1.0f / dot(2);
+        u *= w;
+        v *= w;
+    }
+
+    auto interpolate = [&](int slot) {
+        const int i = 9 + 3*slot;
+        return b->mad(u, b->arrayF(coeffs, i + 1),
+                         b->mad(v, b->arrayF(coeffs, i + 2),
+                                   b->arrayF(coeffs, i)));
+    };
+
+    const bool hasColor = SkCustomMeshSpecificationPriv::HasColors(fSpec);
+    skvm::Val args[kMaxVaryingSlots + 4];
+    int nargs = 0;
+    for (int slot = 0; slot < fVaryingSlots; ++slot) {
+        args[nargs++] = interpolate(2 + slot).id;
+    }
+    if (hasColor) {
+        for (int c = 0; c < 4; ++c) {
+            args[nargs++] = b->splat(0.0f).id;
+        }
+    }
+
+    skvm::Val ret[2];
+    const int nret = SkCustomMeshSpecificationPriv::HasLocalCoords(fSpec) ? 2 : 0;
+    if (!SkSL::ProgramToSkVM(fs, *main, b, /*debugTrace=*/nullptr, /*uniforms=*/{}, device,
+                             SkMakeSpan(args, nargs), SkMakeSpan(ret, nret))) {
+        return {};
+    }
+
+    // Without local coords from the fragment program, the paint's shader sees the interpolated
+    // position from the vertex program, just as if it had been drawn with the CTM.
+    skvm::Coord coord = nret ? skvm::Coord{{b, ret[0]}, {b, ret[1]}}
+                             : skvm::Coord{interpolate(0), interpolate(1)};
+    skvm::Color src = as_SB(fPaintShader)->program(b, device, coord, paint,
+                                                    SkOverrideDeviceMatrixProvider(SkMatrix::I()),
+                                                    /*localM=*/nullptr, dst, uniforms, alloc);
+    if (!src || !hasColor) {
+        return src;
+    }
+
+    skvm::Color color = {{b, args[fVaryingSlots + 0]},
+                         {b, args[fVaryingSlots + 1]},
+                         {b, args[fVaryingSlots + 2]},
+                         {b, args[fVaryingSlots + 3]}};
+    color = SkColorSpaceXformSteps{SkCustomMeshSpecificationPriv::ColorSpace(fSpec),
+                                   SkCustomMeshSpecificationPriv::AlphaType(fSpec),
+                                   dst.colorSpace(), kPremul_SkAlphaType}
+                    .program(b, uniforms, color);
+    return as_BB(fBlender)->program(b, src, color, dst, uniforms, alloc);
+}
+
+bool SkCustomMeshShader::update(const SkMatrix& ctmInv, const SkPoint positions[],
+                                const float varyings[], int vertexCount,
+                                int index0, int index1, int index2) {
+    const SkPoint p0 = positions[index0],
+                  p1 = positions[index1],
+                  p2 = positions[index2];
+    SkMatrix m, im;
+    m.setAll(p1.fX - p0.fX, p2.fX - p0.fX, p0.fX,
+             p1.fY - p0.fY, p2.fY - p0.fY, p0.fY,
+             0,             0,             1);
+    if (!m.invert(&im)) {
+        return false;
+    }
+    SkMatrix::Concat(im, ctmInv).get9(fCoeffs);
+
+    auto set = [this](int slot, float v0, float v1, float v2) {
+        float* c = fCoeffs + 9 + 3*slot;
+        c[0] = v0;
+        c[1] = v1 - v0;
+        c[2] = v2 - v0;
+    };
+    set(0, p0.fX, p1.fX, p2.fX);
+    set(1, p0.fY, p1.fY, p2.fY);
+    for (int slot = 0; slot < fVaryingSlots; ++slot) {
+        const float* v = varyings + slot*vertexCount;
+        set(2 + slot, v[index0], v[index1], v[index2]);
+    }
+    return true;
+}
+
+void SkDraw::drawCustomMesh(const SkCustomMesh& cm,
+                            sk_sp<SkBlender> blender,
+                            const SkPaint& paint) const {
+    const SkCustomMeshSpecification& spec = *cm.spec;
+    const int vertexCount = cm.vcount;
+    const int indexCount = cm.indices ? cm.icount : 0;
+
+    // abort early if there is nothing to draw
+    if ((!cm.indices && vertexCount < 3) || fRC->isEmpty()) {
+        return;
+    }
+    SkMatrix ctm = fMatrixProvider->localToDevice();
+    SkMatrix ctmInv;
+    if (!ctm.invert(&ctmInv)) {
+        return;
+    }
+    const skvm::Program* vertexProgram = SkCustomMeshSpecificationPriv::VertexProgram(spec);
+    if (!vertexProgram) {
+        return;
+    }
+
+    const int attributeSlots = attribute_slot_count(spec),
+              varyingSlots   = varying_slot_count(spec);
+    SkASSERT(attributeSlots <= kMaxAttributeSlots && varyingSlots <= kMaxVaryingSlots);
+
+    constexpr int kBatch = 256;
+    SkSTArenaAlloc<4096> alloc;
+    float*   attributes = alloc.makeArrayDefault<float>(attributeSlots*kBatch);
+    float*   varyings   = alloc.makeArray<float>(varyingSlots*vertexCount);
+    float*   xs         = alloc.makeArrayDefault<float>(vertexCount);
+    float*   ys         = alloc.makeArrayDefault<float>(vertexCount);
+    SkPoint* positions  = alloc.makeArrayDefault<SkPoint>(vertexCount);
+
+    // Run the vertex program over the vertex buffer a batch at a time, unpacking each batch of
+    // attributes into one float per slot per vertex, as the program expects.
+    const char* vb = static_cast<const char*>(cm.vb);
+    void* args[kMaxAttributeSlots + kMaxVaryingSlots + 2];
+    for (int start = 0; start < vertexCount; start += kBatch) {
+        const int n = std::min(kBatch, vertexCount - start);
+        unpack_attributes(spec, vb + start*spec.stride(), n, attributes, kBatch);
+
+        int arg = 0;
+        for (int slot = 0; slot < attributeSlots; ++slot) {
+            args[arg++] = attributes + slot*kBatch;
+        }
+        for (int slot = 0; slot < varyingSlots; ++slot) {
+            args[arg++] = varyings + slot*vertexCount + start;
+        }
+        args[arg++] = xs + start;
+        args[arg++] = ys + start;
+        vertexProgram->eval(n, args);
+    }
+    for (int i = 0; i < vertexCount; ++i) {
+        positions[i] = {xs[i], ys[i]};
+    }
+
+    SkPoint*  dev2 = nullptr;
+    SkPoint3* dev3 = nullptr;
+
+    if (ctm.hasPerspective()) {
+        dev3 = alloc.makeArray<SkPoint3>(vertexCount);
+        ctm.mapHomogeneousPoints(dev3, positions, vertexCount);
+        if (!SkScalarsAreFinite((const SkScalar*)dev3, vertexCount * 3)) {
+            return;
+        }
+    } else {
+        dev2 = alloc.makeArray<SkPoint>(vertexCount);
+        ctm.mapPoints(dev2, positions, vertexCount);
+
+        SkRect bounds;
+        // this also sets bounds to empty if we see a non-finite value
+        bounds.setBounds(dev2, vertexCount);
+        if (bounds.isEmpty()) {
+            return;
+        }
+    }
+
+    VertState state(vertexCount, cm.indices, indexCount);
+    VertState::Proc vertProc = state.chooseProc(cm.mode == SkCustomMesh::Mode::kTriangles
+                                                        ? SkVertices::kTriangles_VertexMode
+                                                        : SkVertices::kTriangleStrip_VertexMode);
+
+    // If the fragment program produces neither a color nor local coords, it can't affect the
+    // result, and the triangles can be filled with the paint as-is.
+    if (!SkCustomMeshSpecificationPriv::HasColors(spec) &&
+        !SkCustomMeshSpecificationPriv::HasLocalCoords(spec)) {
+        SkAutoBlitterChoose blitter(*this, nullptr, paint);
+        while (vertProc(&state)) {
+            fill_triangle(state, blitter.get(), *fRC, dev2, dev3);
+        }
+        return;
+    }
+
+    // As with drawVertices(), the blender applies to the fragment program's color and the opaque
+    // paint color when there is no paint shader.
+    sk_sp<SkShader> paintShader = paint.refShader();
+    if (!paintShader) {
+        paintShader = SkShaders::Color(paint.getColor4f().makeOpaque(), nullptr);
+    }
+    if (!SkCustomMeshSpecificationPriv::HasColors(spec)) {
+        blender = nullptr;
+    }
+    auto meshShader = alloc.make<SkCustomMeshShader>(spec,
+                                                     varyingSlots,
+                                                     std::move(paintShader),
+                                                     std::move(blender),
+                                                     ctm.hasPerspective(),
+                                                     &alloc);
+    SkPaint shaderPaint(paint);
+    shaderPaint.setShader(sk_ref_sp(meshShader));
+
+    auto blitter = this->restrictBlitter(SkVMBlitter::Make(fDst, shaderPaint, *fMatrixProvider,
+                                                           &alloc, this->fRC->clipShader()),
+                                         &alloc);
+    if (!blitter) {
+        return;
+    }
+    while (vertProc(&state)) {
+        if (meshShader->update(ctmInv, positions, varyings, vertexCount,
+                               state.f0, state.f1, state.f2)) {
+            fill_triangle(state, blitter, *fRC, dev2, dev3);
+        }
+    }
+}
+
+#endif  // SK_ENABLE_SKSL
@@ -10,7 +10,10 @@
 #include "include/private/SkSemaphore.h"
 #include "include/private/SkSpinlock.h"
 #include "include/private/SkTArray.h"
+#include "src/core/SkWorkStealingDeque.h"
+#include <atomic>
 #include <deque>
+#include <memory>
 #include <thread>
 
 #if defined(SK_BUILD_FOR_WIN)
@@ -139,6 +142,143 @@ private:
     bool                  fAllowBorrowing;
 };
 
+// An SkWorkStealingPool gives each of its threads a deque of its own.  Work added by one of those
+// threads goes onto that thread's deque, where its owner pops the newest work first and idle
+// threads steal the oldest.  Work added by any other thread goes onto a shared FIFO queue.
+//
+// Just like SkThreadPool, fWorkAvailable counts work not yet claimed by any thread.  A thread must
+// claim a unit of work from fWorkAvailable before it takes work from any queue; it's then
+// guaranteed to find work somewhere, though it may have to look around a little.
+class SkWorkStealingPool final : public SkExecutor {
+public:
+    explicit SkWorkStealingPool(int threads, bool allowBorrowing)
+            : fAllowBorrowing(allowBorrowing) {
+        for (int i = 0; i < threads; i++) {
+            fDeques.push_back(std::make_unique<SkWorkStealingDeque<Work>>());
+        }
+        for (int i = 0; i < threads; i++) {
+            fThreads.emplace_back(&Loop, this, i);
+        }
+    }
+
+    ~SkWorkStealingPool() override {
+        // Signal each thread that it's time to shut down.
+        for (int i = 0; i < fThreads.count(); i++) {
+            this->add(nullptr);
+        }
+        // Wait for each thread to shut down.
+        for (int i = 0; i < fThreads.count(); i++) {
+            fThreads[i].join();
+        }
+        // Like SkThreadPool, run all the work added before we started shutting down.  A thread may
+        // have taken its signal to shut down while others' deques still held work, so run what's
+        // left here.  That work may add more, which now lands on fQueue.
+        auto run = [](Work* work) {
+            std::unique_ptr<Work> owned(work);
+            if (*owned) {
+                (*owned)();
+            }
+        };
+        for (auto& deque : fDeques) {
+            while (Work* work = deque->steal()) {
+                run(work);
+            }
+        }
+        while (!fQueue.empty()) {
+            Work* work = fQueue.front();
+            fQueue.pop_front();
+            run(work);
+        }
+    }
+
+    void add(std::function<void(void)> fn) override {
+        Work* work = new Work(std::move(fn));
+        if (gCurrentPool == this) {
+            fDeques[gCurrentIndex]->push(work);
+        } else {
+            SkAutoMutexExclusive lock(fQueueLock);
+            fQueue.push_back(work);
+            fQueueSize.fetch_add(1, std::memory_order_release);
+        }
+        // Tell the Loop() threads to pick it up.
+        fWorkAvailable.signal(1);
+    }
+
+    void borrow() override {
+        // If there is work waiting and we're allowed to borrow work, do it.
+        if (fAllowBorrowing && fWorkAvailable.try_wait()) {
+            SkAssertResult(this->do_work());
+        }
+    }
+
+private:
+    using Work = std::function<void(void)>;
+
+    // This method should be called only after claiming work from fWorkAvailable.
+    bool do_work() {
+        std::unique_ptr<Work> work(this->find_work());
+        if (!*work) {
+            return false;  // This is Loop()'s signal to shut down.
+        }
+
+        (*work)();
+        return true;
+    }
+
+    Work* find_work() {
+        const int self = gCurrentPool == this ? gCurrentIndex : -1,
+                  n    = fDeques.count();
+        while (true) {
+            if (self >= 0) {
+                if (Work* work = fDeques[self]->pop()) {
+                    return work;
+                }
+            }
+            if (fQueueSize.load(std::memory_order_acquire) > 0) {
+                SkAutoMutexExclusive lock(fQueueLock);
+                if (!fQueue.empty()) {
+                    Work* work = fQueue.front();
+                    fQueue.pop_front();
+                    fQueueSize.fetch_sub(1, std::memory_order_relaxed);
+                    return work;
+                }
+            }
+            for (int i = 1; i <= n; i++) {
+                int victim = (self + i + n) % n;
+                if (victim != self) {
+                    if (Work* work = fDeques[victim]->steal()) {
+                        return work;
+                    }
+                }
+            }
+            // Whatever we claimed is still being pushed, or we lost a race to steal it.
+            std::this_thread::yield();
+        }
+    }
+
+    static void Loop(SkWorkStealingPool* pool, int index) {
+        gCurrentPool  = pool;
+        gCurrentIndex = index;
+        do {
+            pool->fWorkAvailable.wait();
+        } while (pool->do_work());
+    }
+
+    static thread_local SkWorkStealingPool* gCurrentPool;
+    static thread_local int                 gCurrentIndex;
+
+    SkTArray<std::thread>                                    fThreads;
+    SkTArray<std::unique_ptr<SkWorkStealingDeque<Work>>>     fDeques;
+    std::deque<Work*>                                        fQueue;
+    std::atomic<int>                                         fQueueSize{0};
+    SkMutex                                                  fQueueLock;
+    SkSemaphore                                              fWorkAvailable;
+    bool                                                     fAllowBorrowing;
+};
+
+thread_local SkWorkStealingPool* SkWorkStealingPool::gCurrentPool  = nullptr;
+thread_local int                 SkWorkStealingPool::gCurrentIndex = -1;
+
 std::unique_ptr<SkExecutor> SkExecutor::MakeFIFOThreadPool(int threads, bool allowBorrowing) {
     using WorkList = std::deque<std::function<void(void)>>;
     return std::make_unique<SkThreadPool<WorkList>>(threads > 0 ? threads : num_cores(),
@@ -149,3 +289,7 @@ std::unique_ptr<SkExecutor> SkExecutor::MakeLIFOThreadPool(int threads, bool all
     return std::make_unique<SkThreadPool<WorkList>>(threads > 0 ? threads : num_cores(),
                                                     allowBorrowing);
 }
+std::unique_ptr<SkExecutor> SkExecutor::MakeWorkStealingPool(int threads, bool allowBorrowing) {
+    return std::make_unique<SkWorkStealingPool>(threads > 0 ? threads : num_cores(),
+                                                allowBorrowing);
+}
@@ -26,6 +26,7 @@
 #include "src/core/SkStrikeCache.h"
 #include "src/core/SkTSearch.h"
 #include "src/core/SkTypefaceCache.h"
+#include "src/core/SkVMBlitter.h"
 
 #include <stdlib.h>
 
@@ -130,3 +131,7 @@ extern bool gSkVMAllowJIT;
 void SkGraphics::AllowJIT() {
     gSkVMAllowJIT = true;
 }
+
+void SkGraphics::SetProgramCacheDirectory(const char* dir) {
+    SkVMBlitter::SetProgramCacheDirectory(dir);
+}
@@ -0,0 +1,420 @@
+/*
+ * Copyright 2022 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "src/core/SkMappedPicture.h"
+
+#include "include/core/SkCanvas.h"
+#include "include/core/SkData.h"
+#include "include/core/SkImage.h"
+#include "include/core/SkSerialProcs.h"
+#include "include/core/SkStream.h"
+#include "include/private/SkTHash.h"
+#include "include/private/SkTo.h"
+#include "src/core/SkPictureData.h"
+#include "src/core/SkPictureFlat.h"
+#include "src/core/SkPicturePlayback.h"
+#include "src/core/SkRecord.h"
+#include "src/core/SkRecordDraw.h"
+#include "src/core/SkRecorder.h"
+
+#include <cstring>
+#include <vector>
+
+/*
+ *  The layout, in native byte order:
+ *
+ *    Header
+ *    ops        the op data of an SkPictureData, as in a regular serialized picture
+ *    opOffsets  uint32_t[opCount], the offset of each op into the op data
+ *    rtree      SkRTree::FlatNode[rtreeNodeCount], indexing ops by their bounds
+ *    resources  the rest of the SkPictureData (paints, paths, typefaces, sub-pictures, ...)
+ *    images     the encoded images that the resources refer to with an ImageRef
+ *
+ *  Each section starts on a 16-byte boundary.
+ */
+
+static const char kMagic[] = { 's', 'k', 'i', 'a', 'p', 'm', 'a', 'p' };
+static constexpr size_t kSectionAlignment = 16;
+
+namespace {
+
+struct Section {
+    uint64_t fOffset;
+    uint64_t fSize;
+};
+
+struct Header {
+    char                fMagic[8];
+    uint32_t            fVersion;       // Of the ops and resources, as in SkPictInfo.
+    uint32_t            fOpCount;
+    uint32_t            fNestedOpCount;
+    uint32_t            fRTreeNodeCount;
+    SkRect              fCullRect;
+    SkRTree::FlatBranch fRTreeRoot;
+    uint32_t            fPad;
+    Section             fOps;
+    Section             fOpOffsets;
+    Section             fRTree;
+    Section             fResources;
+    Section             fImages;
+};
+static_assert(sizeof(Header) == 144, "");
+static_assert(sizeof(SkRTree::FlatNode) % 4 == 0, "");
+
+// Stands in for an encoded image in the resources.
+struct ImageRef {
+    uint32_t fTag;
+    uint32_t fPad;
+    uint64_t fOffset;   // Into the images section.
+    uint64_t fSize;
+};
+static constexpr uint32_t kImageRefTag = SkSetFourByteTag('m', 'i', 'm', 'g');
+
+struct ImageWriter {
+    const SkSerialProcs*             fProcs;
+    SkDynamicMemoryWStream           fStream;
+    SkTHashMap<uint32_t, ImageRef>   fRefs;     // By image unique ID.
+};
+
+struct ImageReader {
+    const SkDeserialProcs*           fProcs;
+    sk_sp<SkData>                    fImages;
+    SkTHashMap<uint64_t, sk_sp<SkImage>> fCache;   // By offset.
+};
+
+// Plays back an SkPictureData into an SkRecord, noting which records each op made. The playback
+// asks its abort callback before each op, once the op's offset is known.
+class OpSplitter final : public SkPicture::AbortCallback {
+public:
+    OpSplitter(const SkPicturePlayback* playback, const SkRecord* record)
+        : fPlayback(playback), fRecord(record) {}
+
+    bool abort() override {
+        fOpOffsets.push_back(SkToU32(fPlayback->curOpID()));
+        fFirstRecords.push_back(fRecord->count());
+        return false;
+    }
+
+    const SkPicturePlayback* fPlayback;
+    const SkRecord*          fRecord;
+    std::vector<uint32_t>    fOpOffsets;
+    std::vector<int>         fFirstRecords;
+};
+
+}  // namespace
+
+static sk_sp<SkData> serialize_image(SkImage* image, void* ctx) {
+    auto writer = static_cast<ImageWriter*>(ctx);
+    const SkSerialProcs* procs = writer->fProcs;
+
+    // SkReadBuffer only restores the alpha type of images it decodes itself, so leave these inline.
+    if (image->alphaType() == kUnpremul_SkAlphaType) {
+        return procs && procs->fImageProc ? procs->fImageProc(image, procs->fImageCtx) : nullptr;
+    }
+
+    ImageRef* ref = writer->fRefs.find(image->uniqueID());
+    if (!ref) {
+        sk_sp<SkData> encoded;
+        if (procs && procs->fImageProc) {
+            encoded = procs->fImageProc(image, procs->fImageCtx);
+        }
+        if (!encoded) {
+            encoded = image->encodeToData();
+        }
+        if (!encoded) {
+            return nullptr;
+        }
+        ImageRef newRef = {kImageRefTag, 0, writer->fStream.bytesWritten(), encoded->size()};
+        writer->fStream.write(encoded->data(), encoded->size());
+        writer->fStream.padToAlign4();
+        ref = writer->fRefs.set(image->uniqueID(), newRef);
+    }
+    return SkData::MakeWithCopy(ref, sizeof(*ref));
+}
+
+static sk_sp<SkImage> deserialize_image(const void* data, size_t length, void* ctx) {
+    auto reader = static_cast<ImageReader*>(ctx);
+    const SkDeserialProcs* procs = reader->fProcs;
+
+    ImageRef ref;
+    if (length == sizeof(ref)) {
+        memcpy(&ref, data, sizeof(ref));
+    }
+    if (length != sizeof(ref) || ref.fTag != kImageRefTag) {
+        // An image that was written inline.
+        return procs && procs->fImageProc ? procs->fImageProc(data, length, procs->fImageCtx)
+                                          : nullptr;
+    }
+
+    if (sk_sp<SkImage>* image = reader->fCache.find(ref.fOffset)) {
+        return *image;
+    }
+    const size_t size = reader->fImages->size();
+    if (ref.fOffset > size || ref.fSize > size - ref.fOffset) {
+        return nullptr;
+    }
+    // A subset refs the mapped data instead of copying it, and so does the lazy image.
+    sk_sp<SkData> encoded = SkData::MakeSubset(reader->fImages.get(), ref.fOffset, ref.fSize);
+    sk_sp<SkImage> image;
+    if (procs && procs->fImageProc) {
+        image = procs->fImageProc(encoded->data(), encoded->size(), procs->fImageCtx);
+    }
+    if (!image) {
+        image = SkImage::MakeFromEncoded(std::move(encoded));
+    }
+    if (image) {
+        reader->fCache.set(ref.fOffset, image);
+    }
+    return image;
+}
+
+static DrawType op_type(const SkData& ops, uint32_t offset) {
+    uint32_t opAndSize;
+    memcpy(&opAndSize, ops.bytes() + offset, sizeof(opAndSize));
+    return (DrawType)(opAndSize >> 24);
+}
+
+static Section write_section(SkDynamicMemoryWStream* stream, const void* data, size_t size) {
+    static constexpr char kZeros[kSectionAlignment] = {};
+    stream->write(kZeros, SkAlignTo(stream->bytesWritten(), kSectionAlignment) -
+                          stream->bytesWritten());
+    Section section = {stream->bytesWritten(), size};
+    stream->write(data, size);
+    return section;
+}
+
+sk_sp<SkData> SkMappedPicture::Serialize(const SkPicture* picture, const SkSerialProcs* procs) {
+    if (!picture) {
+        return nullptr;
+    }
+    const SkPictInfo info = picture->createHeader();
+    std::unique_ptr<SkPictureData> data(picture->backport());
+    if (!data || !data->opData()) {
+        return nullptr;
+    }
+    const SkData& ops = *data->opData();
+
+    // Find where each op starts, and its bounds from those of the records it plays back as.
+    SkRecord record;
+    SkPicturePlayback playback(data.get());
+    OpSplitter splitter(&playback, &record);
+    {
+        SkRecorder recorder(&record, info.fCullRect);
+        playback.draw(&recorder, &splitter, nullptr);
+    }
+    const int opCount = SkToInt(splitter.fOpOffsets.size());
+    std::vector<SkRect> recordBounds(record.count());
+    std::vector<SkBBoxHierarchy::Metadata> meta(record.count());
+    SkRecordFillBounds(info.fCullRect, record, recordBounds.data(), meta.data());
+
+    std::vector<SkRect> opBounds(opCount, SkRect::MakeEmpty());
+    std::vector<int> openSaves;
+    for (int i = 0; i < opCount; ++i) {
+        const int end = i + 1 < opCount ? splitter.fFirstRecords[i + 1] : record.count();
+        if (splitter.fFirstRecords[i] == end) {
+            // Ops that make no records draw everywhere.  Notably SkCanvas defers save() until
+            // it's needed, so its Save record (if any) is made by a later op.
+            opBounds[i] = info.fCullRect;
+        }
+        for (int j = splitter.fFirstRecords[i]; j < end; ++j) {
+            opBounds[i].join(recordBounds[j]);
+        }
+
+        // Every save op and its restore must be drawn together, or the restore would pop some
+        // other save, or a skipped restore leave the block's matrix and clip on later ops.
+        // So give each save its restore's bounds, which are those of the whole block.
+        switch (op_type(ops, splitter.fOpOffsets[i])) {
+            case SAVE:
+            case SAVE_LAYER_SAVELAYERREC:
+            case SAVE_BEHIND:
+                openSaves.push_back(i);
+                break;
+            case RESTORE:
+                if (!openSaves.empty()) {
+                    opBounds[openSaves.back()] = opBounds[i];
+                    openSaves.pop_back();
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    SkRTree rtree;
+    rtree.insert(opBounds.data(), opCount);
+    std::vector<SkRTree::FlatNode> rtreeNodes(rtree.flatNodeCount());
+    const SkRTree::FlatBranch rtreeRoot = rtree.flatten(rtreeNodes.data());
+
+    ImageWriter images;
+    images.fProcs = procs;
+    SkSerialProcs resourceProcs = procs ? *procs : SkSerialProcs();
+    resourceProcs.fImageProc = serialize_image;
+    resourceProcs.fImageCtx = &images;
+    SkDynamicMemoryWStream resources;
+    data->serializeResources(&resources, resourceProcs, nullptr);
+    sk_sp<SkData> resourceData = resources.detachAsData();
+    sk_sp<SkData> imageData = images.fStream.detachAsData();
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.fMagic, kMagic, sizeof(kMagic));
+    header.fVersion = info.getVersion();
+    header.fOpCount = SkToU32(opCount);
+    header.fNestedOpCount = SkToU32(picture->approximateOpCount(true));
+    header.fRTreeNodeCount = SkToU32(rtreeNodes.size());
+    header.fCullRect = info.fCullRect;
+    header.fRTreeRoot = rtreeRoot;
+
+    SkDynamicMemoryWStream stream;
+    stream.write(&header, sizeof(header));
+    header.fOps = write_section(&stream, ops.data(), ops.size());
+    header.fOpOffsets = write_section(&stream, splitter.fOpOffsets.data(),
+                                      opCount * sizeof(uint32_t));
+    header.fRTree = write_section(&stream, rtreeNodes.data(),
+                                  rtreeNodes.size() * sizeof(SkRTree::FlatNode));
+    header.fResources = write_section(&stream, resourceData->data(), resourceData->size());
+    header.fImages = write_section(&stream, imageData->data(), imageData->size());
+
+    // Now that the sections are placed, fill them in.
+    sk_sp<SkData> result = stream.detachAsData();
+    memcpy(result->writable_data(), &header, sizeof(header));
+    return result;
+}
+
+bool SkMappedPicture::IsMappedPicture(const void* data, size_t size) {
+    return data && size >= sizeof(Header) && 0 == memcmp(data, kMagic, sizeof(kMagic));
+}
+
+static bool valid_section(const Section& section, size_t dataSize) {
+    return section.fOffset % kSectionAlignment == 0 &&
+           section.fOffset <= dataSize &&
+           section.fSize <= dataSize - section.fOffset;
+}
+
+sk_sp<SkPicture> SkMappedPicture::Make(sk_sp<const SkData> data, const SkDeserialProcs* procs) {
+    if (!data || !IsMappedPicture(data->data(), data->size())) {
+        return nullptr;
+    }
+    if (!SkIsAlign8(reinterpret_cast<uintptr_t>(data->data()))) {
+        data = SkData::MakeWithCopy(data->data(), data->size());
+    }
+    const auto& header = *static_cast<const Header*>(data->data());
+
+    SkPictInfo info;
+    memcpy(info.fMagic, "skiapict", sizeof(info.fMagic));
+    info.setVersion(header.fVersion);
+    info.fCullRect = header.fCullRect;
+    if (!SkPicture::IsValidPictInfo(info) || !info.fCullRect.isFinite()) {
+        return nullptr;
+    }
+
+    const size_t size = data->size();
+    if (!valid_section(header.fOps, size) ||
+        !valid_section(header.fOpOffsets, size) ||
+        !valid_section(header.fRTree, size) ||
+        !valid_section(header.fResources, size) ||
+        !valid_section(header.fImages, size)) {
+        return nullptr;
+    }
+    // SkPicturePlayback reads the ops 4 bytes at a time, and each op is at least that big.
+    const size_t opsSize = header.fOps.fSize;
+    if (header.fOpCount > SK_MaxS32 || header.fNestedOpCount > SK_MaxS32 ||
+        header.fRTreeNodeCount > SK_MaxS32) {
+        return nullptr;
+    }
+    if (0 == opsSize || !SkIsAlign4(opsSize) ||
+        header.fOpCount > opsSize / sizeof(uint32_t) ||
+        header.fOpCount * sizeof(uint32_t) != header.fOpOffsets.fSize) {
+        return nullptr;
+    }
+    const auto bytes = static_cast<const uint8_t*>(data->data());
+    const auto opOffsets = reinterpret_cast<const uint32_t*>(bytes + header.fOpOffsets.fOffset);
+    for (uint32_t i = 0; i < header.fOpCount; ++i) {
+        if (!SkIsAlign4(opOffsets[i]) || opOffsets[i] >= opsSize ||
+            (i > 0 && opOffsets[i] <= opOffsets[i - 1])) {
+            return nullptr;
+        }
+    }
+    if (header.fRTreeNodeCount > header.fRTree.fSize / sizeof(SkRTree::FlatNode) ||
+        header.fRTreeNodeCount * sizeof(SkRTree::FlatNode) != header.fRTree.fSize) {
+        return nullptr;
+    }
+    const auto rtreeNodes = reinterpret_cast<const SkRTree::FlatNode*>(bytes +
+                                                                        header.fRTree.fOffset);
+    if (!SkRTree::ValidateFlat(rtreeNodes, SkToInt(header.fRTreeNodeCount), header.fRTreeRoot,
+                               SkToInt(header.fOpCount))) {
+        return nullptr;
+    }
+
+    ImageReader images;
+    images.fProcs = procs;
+    images.fImages = SkData::MakeSubset(data.get(), header.fImages.fOffset, header.fImages.fSize);
+    SkDeserialProcs resourceProcs = procs ? *procs : SkDeserialProcs();
+    resourceProcs.fImageProc = deserialize_image;
+    resourceProcs.fImageCtx = &images;
+
+    SkMemoryStream resources(bytes + header.fResources.fOffset, header.fResources.fSize,
+                             /*copyData=*/false);
+    std::unique_ptr<SkPictureData> pictureData(SkPictureData::CreateFromStream(
+            &resources, info, resourceProcs,
+            SkData::MakeSubset(data.get(), header.fOps.fOffset, opsSize)));
+    if (!pictureData) {
+        return nullptr;
+    }
+
+    return sk_sp<SkPicture>(new SkMappedPicture(std::move(data), std::move(pictureData),
+                                                info.fCullRect, SkToInt(header.fOpCount),
+                                                SkToInt(header.fNestedOpCount), opOffsets,
+                                                rtreeNodes, SkToInt(header.fRTreeNodeCount),
+                                                header.fRTreeRoot));
+}
+
+SkMappedPicture::SkMappedPicture(sk_sp<const SkData> data,
+                                 std::unique_ptr<SkPictureData> pictureData,
+                                 const SkRect& cull,
+                                 int opCount,
+                                 int nestedOpCount,
+                                 const uint32_t opOffsets[],
+                                 const SkRTree::FlatNode rtreeNodes[],
+                                 int rtreeNodeCount,
+                                 const SkRTree::FlatBranch& rtreeRoot)
+    : fData(std::move(data))
+    , fPictureData(std::move(pictureData))
+    , fCullRect(cull)
+    , fOpCount(opCount)
+    , fNestedOpCount(nestedOpCount)
+    , fOpOffsets(opOffsets)
+    , fRTreeNodes(rtreeNodes)
+    , fRTreeNodeCount(rtreeNodeCount)
+    , fRTreeRoot(rtreeRoot) {}
+
+SkMappedPicture::~SkMappedPicture() = default;
+
+void SkMappedPicture::playback(SkCanvas* canvas, AbortCallback* callback) const {
+    SkASSERT(canvas);
+    SkPicturePlayback playback(fPictureData.get());
+
+    // If the query contains the whole picture, don't bother with the R-tree.
+    const SkRect query = canvas->getLocalClipBounds();
+    if (0 == fRTreeNodeCount || query.contains(fCullRect)) {
+        playback.draw(canvas, callback, nullptr);
+        return;
+    }
+
+    std::vector<int> ops;
+    SkRTree::FlatSearch(fRTreeNodes, fRTreeRoot, query, &ops);
+    std::vector<uint32_t> offsets(ops.size());
+    for (size_t i = 0; i < ops.size(); ++i) {
+        offsets[i] = fOpOffsets[ops[i]];
+    }
+    playback.draw(canvas, offsets.data(), SkToInt(offsets.size()), callback);
+}
+
+size_t SkMappedPicture::approximateBytesUsed() const {
+    // The images are left out, as they are only decoded (and cached elsewhere) when drawn.
+    return sizeof(*this) + fPictureData->opData()->size() +
+           fOpCount * sizeof(uint32_t) + fRTreeNodeCount * sizeof(SkRTree::FlatNode);
+}
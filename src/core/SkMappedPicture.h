@@ -0,0 +1,70 @@
+/*
+ * Copyright 2022 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkMappedPicture_DEFINED
+#define SkMappedPicture_DEFINED
+
+#include "include/core/SkPicture.h"
+#include "include/core/SkRect.h"
+#include "src/core/SkRTree.h"
+
+#include <memory>
+
+class SkData;
+class SkPictureData;
+struct SkDeserialProcs;
+struct SkSerialProcs;
+
+/**
+ *  An SkPicture that plays back straight out of its serialized data, which is laid out to be
+ *  mapped from a file (e.g. by SkData::MakeFromFileName()) rather than parsed into an SkRecord.
+ *
+ *  Next to the usual serialized picture, the data holds the offset of every op and an R-tree of
+ *  their bounds, so that clipped playback only reads the ops it needs. Encoded images are stored
+ *  out of line and only decoded when they are drawn, without copying the encoded bytes.
+ */
+class SkMappedPicture final : public SkPicture {
+public:
+    ~SkMappedPicture() override;
+
+    // Returns the picture in the mapped format, or nullptr if it can't be serialized.
+    static sk_sp<SkData> Serialize(const SkPicture*, const SkSerialProcs* = nullptr);
+
+    // Returns true if the data starts like a picture in the mapped format.
+    static bool IsMappedPicture(const void* data, size_t size);
+
+    // Returns nullptr if the data is not a valid picture in the mapped format. The picture refs
+    // the data, and reads its ops, offsets and R-tree in place as long as the data is 8-byte
+    // aligned (mapped files and SkData's own allocations are).
+    static sk_sp<SkPicture> Make(sk_sp<const SkData>, const SkDeserialProcs* = nullptr);
+
+// SkPicture overrides
+    void playback(SkCanvas*, AbortCallback*) const override;
+    SkRect cullRect() const override { return fCullRect; }
+    int approximateOpCount(bool nested) const override {
+        return nested ? fNestedOpCount : fOpCount;
+    }
+    size_t approximateBytesUsed() const override;
+
+private:
+    SkMappedPicture(sk_sp<const SkData>, std::unique_ptr<SkPictureData>, const SkRect& cull,
+                    int opCount, int nestedOpCount, const uint32_t opOffsets[],
+                    const SkRTree::FlatNode rtreeNodes[], int rtreeNodeCount,
+                    const SkRTree::FlatBranch& rtreeRoot);
+
+    const sk_sp<const SkData>            fData;
+    const std::unique_ptr<SkPictureData> fPictureData;
+    const SkRect                         fCullRect;
+    const int                            fOpCount;
+    const int                            fNestedOpCount;
+    const uint32_t*                      fOpOffsets;
+    const SkRTree::FlatNode*             fRTreeNodes;
+    const int                            fRTreeNodeCount;
+    const SkRTree::FlatBranch            fRTreeRoot;
+};
+
+#endif
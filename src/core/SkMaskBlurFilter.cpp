@@ -13,11 +13,15 @@
 #include "include/private/SkTPin.h"
 #include "include/private/SkTemplates.h"
 #include "include/private/SkTo.h"
+#include "include/private/SkVx.h"
 #include "src/core/SkArenaAlloc.h"
 #include "src/core/SkGaussFilter.h"
+#include "src/core/SkTaskGroup.h"
 
 #include <cmath>
+#include <array>
 #include <climits>
+#include <utility>
 
 namespace {
 static const double kPi = 3.14159265358979323846264338327950288;
@@ -212,6 +216,124 @@ public:
         uint32_t* fBuffer2End;
     };
 
+    // Like Scan, but blurs kLanes rows at once, one row per SIMD lane. Each step writes the kLanes
+    // results next to each other in dst, which is how the transposing passes below lay them out.
+    // The results are identical to running Scan on each row.
+    class LaneScan {
+    public:
+        static constexpr int kLanes = 4;
+        using Sums = skvx::Vec<kLanes, uint32_t>;
+
+        LaneScan(uint64_t weight, int noChangeCount,
+                 Sums* buffer0, Sums* buffer0End,
+                 Sums* buffer1, Sums* buffer1End,
+                 Sums* buffer2, Sums* buffer2End)
+            : fWeight{weight}
+            , fNoChangeCount{noChangeCount}
+            , fBuffer0{buffer0}
+            , fBuffer0End{buffer0End}
+            , fBuffer1{buffer1}
+            , fBuffer1End{buffer1End}
+            , fBuffer2{buffer2}
+            , fBuffer2End{buffer2End}
+        { }
+
+        template <typename AlphaIter> void blur(std::array<AlphaIter, kLanes> src, int width,
+                                                uint8_t* dst, int dstStride, uint8_t* dstEnd) const {
+            Sums* cursors[3] = {fBuffer0, fBuffer1, fBuffer2};
+
+            std::fill(fBuffer0, fBuffer2End, Sums(0));
+
+            Sums sums[3] = {0, 0, 0};
+
+            // Consume the source generating pixels.
+            for (int x = 0; x < width; ++x, dst += dstStride) {
+                Sums leadingEdge;
+                for (int i = 0; i < kLanes; ++i) {
+                    leadingEdge[i] = *src[i];
+                    ++src[i];
+                }
+                this->step(leadingEdge, sums, cursors).store(dst);
+            }
+
+            // The leading edge is off the right side of the mask.
+            for (int i = 0; i < fNoChangeCount; i++, dst += dstStride) {
+                this->step(Sums(0), sums, cursors).store(dst);
+            }
+
+            // Starting from the right, fill in the rest of the buffer.
+            std::fill(fBuffer0, fBuffer2End, Sums(0));
+
+            sums[0] = sums[1] = sums[2] = 0;
+
+            uint8_t* dstCursor = dstEnd;
+            while (dstCursor > dst) {
+                dstCursor -= dstStride;
+                Sums leadingEdge;
+                for (int i = 0; i < kLanes; ++i) {
+                    leadingEdge[i] = *(--src[i]);
+                }
+                this->step(leadingEdge, sums, cursors).store(dstCursor);
+            }
+        }
+
+    private:
+        inline static constexpr uint64_t kHalf = static_cast<uint64_t>(1) << 31;
+
+        // Add leadingEdge to the running sums, and return the scaled result for it. The same
+        // sequence of operations as each iteration of Scan::blur().
+        SK_ALWAYS_INLINE skvx::Vec<kLanes, uint8_t> step(const Sums& leadingEdge, Sums sums[3],
+                                                         Sums* cursors[3]) const {
+            sums[0] += leadingEdge;
+            sums[1] += sums[0];
+            sums[2] += sums[1];
+
+            Sums result = this->finalScale(sums[2]);
+
+            sums[2] -= *cursors[2];
+            *cursors[2] = sums[1];
+            cursors[2] = (cursors[2] + 1) < fBuffer2End ? cursors[2] + 1 : fBuffer2;
+
+            sums[1] -= *cursors[1];
+            *cursors[1] = sums[0];
+            cursors[1] = (cursors[1] + 1) < fBuffer1End ? cursors[1] + 1 : fBuffer1;
+
+            sums[0] -= *cursors[0];
+            *cursors[0] = leadingEdge;
+            cursors[0] = (cursors[0] + 1) < fBuffer0End ? cursors[0] + 1 : fBuffer0;
+
+            return skvx::cast<uint8_t>(result);
+        }
+
+        Sums finalScale(const Sums& sum) const {
+            return skvx::cast<uint32_t>((skvx::cast<uint64_t>(sum) * fWeight + kHalf) >> 32);
+        }
+
+        uint64_t fWeight;
+        int      fNoChangeCount;
+        Sums*    fBuffer0;
+        Sums*    fBuffer0End;
+        Sums*    fBuffer1;
+        Sums*    fBuffer1End;
+        Sums*    fBuffer2;
+        Sums*    fBuffer2End;
+    };
+
+    LaneScan makeLaneScan(int width, LaneScan::Sums* buffer) const {
+        LaneScan::Sums* buffer0, *buffer0End, *buffer1, *buffer1End, *buffer2, *buffer2End;
+        buffer0 = buffer;
+        buffer0End = buffer1 = buffer0 + fPass0Size;
+        buffer1End = buffer2 = buffer1 + fPass1Size;
+        buffer2End = buffer2 + fPass2Size;
+        int noChangeCount = fSlidingWindow > width ? fSlidingWindow - width : 0;
+
+        return LaneScan(
+            fWeight, noChangeCount,
+            buffer0, buffer0End,
+            buffer1, buffer1End,
+            buffer2, buffer2End);
+    }
+
     Scan makeBlurScan(int width, uint32_t* buffer) const {
         uint32_t* buffer0, *buffer0End, *buffer1, *buffer1End, *buffer2, *buffer2End;
         buffer0 = buffer;
@@ -235,6 +357,35 @@ public:
     int      fPass2Size;
 };
 
+// Masks with at least this many destination pixels are blurred in bands on an executor.
+static constexpr SkRowBanding kBanding = {256 * 256, 64};
+
+// Blur rows [y0, y1) of a mask, writing row y transposed into column y of dst. rowAt(y) returns the
+// begin and end iterators of row y. Whole groups of rows go through LaneScan, the rest through Scan.
+template <typename RowAt>
+void blur_rows(const PlanGauss& plan, int width, RowAt&& rowAt, int y0, int y1,
+               uint8_t* dst, int dstStride, size_t dstSize,
+               uint32_t* buffer, PlanGauss::LaneScan::Sums* laneBuffer) {
+    constexpr int kLanes = PlanGauss::LaneScan::kLanes;
+    static_assert(kLanes == 4, "laneStarts() below starts one row per lane.");
+    auto laneStarts = [&](int y, auto... i) {
+        return std::array<decltype(rowAt(y).first), kLanes>{rowAt(y + i).first...};
+    };
+
+    int y = y0;
+    const PlanGauss::LaneScan& laneScan = plan.makeLaneScan(width, laneBuffer);
+    for (; y + kLanes <= y1; y += kLanes) {
+        laneScan.blur(laneStarts(y, 0, 1, 2, 3), width,
+                      &dst[y], dstStride, &dst[y] + dstSize);
+    }
+
+    const PlanGauss::Scan& scan = plan.makeBlurScan(width, buffer);
+    for (; y < y1; ++y) {
+        auto [start, end] = rowAt(y);
+        scan.blur(start, end, &dst[y], dstStride, &dst[y] + dstSize);
+    }
+}
+
 } // namespace
 
 // NB 135 is the largest sigma that will not cause a buffer full of 255 mask values to overflow
@@ -954,7 +1105,7 @@ static SkIPoint small_blur(double sigmaX, double sigmaY, const SkMask& src, SkMa
 
 // TODO: assuming sigmaW = sigmaH. Allow different sigmas. Right now the
 // API forces the sigmas to be the same.
-SkIPoint SkMaskBlurFilter::blur(const SkMask& src, SkMask* dst) const {
+SkIPoint SkMaskBlurFilter::blur(const SkMask& src, SkMask* dst, SkExecutor* executor) const {
 
     if (fSigmaW < 2.0 && fSigmaH < 2.0) {
         return small_blur(fSigmaW, fSigmaH, src, dst);
@@ -985,9 +1136,6 @@ SkIPoint SkMaskBlurFilter::blur(const SkMask& src, SkMask* dst) const {
         dstH = dst->fBounds.height();
     SkASSERT(srcW >= 0 && srcH >= 0 && dstW >= 0 && dstH >= 0);
 
-    auto bufferSize = std::max(planW.bufferSize(), planH.bufferSize());
-    auto buffer = alloc.makeArrayDefault<uint32_t>(bufferSize);
-
     // Blur both directions.
     int tmpW = srcH,
         tmpH = dstW;
@@ -998,44 +1146,58 @@ SkIPoint SkMaskBlurFilter::blur(const SkMask& src, SkMask* dst) const {
     }
     auto tmp = alloc.makeArrayDefault<uint8_t>(tmpW * tmpH);
 
+    // Large masks are blurred in bands of rows on the executor. The scans are not thread-safe,
+    // so each band gets its own buffers.
+    int64_t area = executor ? (int64_t)dstW * dstH : 0;
+    int bandsW = kBanding.bandCount(srcH, area),
+        bandsH = kBanding.bandCount(tmpH, area),
+        bands  = std::max(bandsW, bandsH);
+
+    auto bufferSize = std::max(planW.bufferSize(), planH.bufferSize());
+    auto buffers     = alloc.makeArrayDefault<uint32_t>(bufferSize * bands);
+    auto laneBuffers = alloc.makeArrayDefault<PlanGauss::LaneScan::Sums>(bufferSize * bands);
+
+    // Keep whole groups of lanes in each band.
+    auto forEachBand = [&](int rows, int bandCount, auto&& fn) {
+        SkRowBanding::Run(executor, rows, bandCount, PlanGauss::LaneScan::kLanes,
+                          [&](int band, int y0, int y1) {
+            fn(y0, y1, buffers + band * bufferSize, laneBuffers + band * bufferSize);
+        });
+    };
+
     // Blur horizontally, and transpose.
-    const PlanGauss::Scan& scanW = planW.makeBlurScan(srcW, buffer);
+    auto blurW = [&](auto start, auto end) {
+        auto rowAt = [&](int y) {
+            auto rowStart = start, rowEnd = end;
+            rowStart >>= SkToU32(y * src.fRowBytes);
+            rowEnd   >>= SkToU32(y * src.fRowBytes);
+            return std::make_pair(rowStart, rowEnd);
+        };
+        forEachBand(srcH, bandsW, [&](int y0, int y1, uint32_t* buffer,
+                                      PlanGauss::LaneScan::Sums* laneBuffer) {
+            blur_rows(planW, srcW, rowAt, y0, y1, tmp, tmpW, tmpW * tmpH, buffer, laneBuffer);
+        });
+    };
     switch (src.fFormat) {
         case SkMask::kBW_Format: {
             const uint8_t* bwStart = src.fImage;
-            auto start = SkMask::AlphaIter<SkMask::kBW_Format>(bwStart, 0);
-            auto end = SkMask::AlphaIter<SkMask::kBW_Format>(bwStart + (srcW / 8), srcW % 8);
-            for (int y = 0; y < srcH; ++y, start >>= src.fRowBytes, end >>= src.fRowBytes) {
-                auto tmpStart = &tmp[y];
-                scanW.blur(start, end, tmpStart, tmpW, tmpStart + tmpW * tmpH);
-            }
+            blurW(SkMask::AlphaIter<SkMask::kBW_Format>(bwStart, 0),
+                  SkMask::AlphaIter<SkMask::kBW_Format>(bwStart + (srcW / 8), srcW % 8));
         } break;
         case SkMask::kA8_Format: {
             const uint8_t* a8Start = src.fImage;
-            auto start = SkMask::AlphaIter<SkMask::kA8_Format>(a8Start);
-            auto end = SkMask::AlphaIter<SkMask::kA8_Format>(a8Start + srcW);
-            for (int y = 0; y < srcH; ++y, start >>= src.fRowBytes, end >>= src.fRowBytes) {
-                auto tmpStart = &tmp[y];
-                scanW.blur(start, end, tmpStart, tmpW, tmpStart + tmpW * tmpH);
-            }
+            blurW(SkMask::AlphaIter<SkMask::kA8_Format>(a8Start),
+                  SkMask::AlphaIter<SkMask::kA8_Format>(a8Start + srcW));
         } break;
         case SkMask::kARGB32_Format: {
             const uint32_t* argbStart = reinterpret_cast<const uint32_t*>(src.fImage);
-            auto start = SkMask::AlphaIter<SkMask::kARGB32_Format>(argbStart);
-            auto end = SkMask::AlphaIter<SkMask::kARGB32_Format>(argbStart + srcW);
-            for (int y = 0; y < srcH; ++y, start >>= src.fRowBytes, end >>= src.fRowBytes) {
-                auto tmpStart = &tmp[y];
-                scanW.blur(start, end, tmpStart, tmpW, tmpStart + tmpW * tmpH);
-            }
+            blurW(SkMask::AlphaIter<SkMask::kARGB32_Format>(argbStart),
+                  SkMask::AlphaIter<SkMask::kARGB32_Format>(argbStart + srcW));
         } break;
         case SkMask::kLCD16_Format: {
             const uint16_t* lcdStart = reinterpret_cast<const uint16_t*>(src.fImage);
-            auto start = SkMask::AlphaIter<SkMask::kLCD16_Format>(lcdStart);
-            auto end = SkMask::AlphaIter<SkMask::kLCD16_Format>(lcdStart + srcW);
-            for (int y = 0; y < srcH; ++y, start >>= src.fRowBytes, end >>= src.fRowBytes) {
-                auto tmpStart = &tmp[y];
-                scanW.blur(start, end, tmpStart, tmpW, tmpStart + tmpW * tmpH);
-            }
+            blurW(SkMask::AlphaIter<SkMask::kLCD16_Format>(lcdStart),
+                  SkMask::AlphaIter<SkMask::kLCD16_Format>(lcdStart + srcW));
         } break;
         default:
             SK_ABORT("Unhandled format.");
@@ -1043,14 +1205,15 @@ SkIPoint SkMaskBlurFilter::blur(const SkMask& src, SkMask* dst) const {
 
     // Blur vertically (scan in memory order because of the transposition),
     // and transpose back to the original orientation.
-    const PlanGauss::Scan& scanH = planH.makeBlurScan(tmpW, buffer);
-    for (int y = 0; y < tmpH; y++) {
-        auto tmpStart = &tmp[y * tmpW];
-        auto dstStart = &dst->fImage[y];
-
-        scanH.blur(tmpStart, tmpStart + tmpW,
-                   dstStart, dst->fRowBytes, dstStart + dst->fRowBytes * dstH);
-    }
+    auto tmpRowAt = [&](int y) {
+        const uint8_t* tmpStart = &tmp[y * tmpW];
+        return std::make_pair(tmpStart, tmpStart + tmpW);
+    };
+    forEachBand(tmpH, bandsH, [&](int y0, int y1, uint32_t* buffer,
+                                  PlanGauss::LaneScan::Sums* laneBuffer) {
+        blur_rows(planH, tmpW, tmpRowAt, y0, y1, dst->fImage, dst->fRowBytes,
+                  dst->fRowBytes * dstH, buffer, laneBuffer);
+    });
 
     return {SkTo<int32_t>(borderW), SkTo<int32_t>(borderH)};
 }
@@ -15,6 +15,8 @@
 #include "include/core/SkTypes.h"
 #include "src/core/SkMask.h"
 
+class SkExecutor;
+
 // Implement a single channel Gaussian blur. The specifics for implementation are taken from:
 // https://drafts.fxtf.org/filters/#feGaussianBlurElement
 class SkMaskBlurFilter {
@@ -27,7 +29,8 @@ public:
     bool hasNoBlur() const;
 
     // Given a src SkMask, generate dst SkMask returning the border width and height.
-    SkIPoint blur(const SkMask& src, SkMask* dst) const;
+    // If executor is not null, large masks are blurred in bands of rows on it.
+    SkIPoint blur(const SkMask& src, SkMask* dst, SkExecutor* executor = nullptr) const;
 
 private:
     const double fSigmaW;
@@ -9,12 +9,16 @@
 
 #include "include/core/SkPath.h"
 #include "include/core/SkRRect.h"
+#include "include/private/SkTPin.h"
+#include "src/core/SkArenaAlloc.h"
 #include "src/core/SkAutoMalloc.h"
 #include "src/core/SkBlitter.h"
 #include "src/core/SkCachedData.h"
 #include "src/core/SkDraw.h"
 #include "src/core/SkPathPriv.h"
 #include "src/core/SkRasterClip.h"
+#include "src/core/SkRasterPipeline.h"
+#include "src/core/SkRectPriv.h"
 #include "src/core/SkReadBuffer.h"
 #include "src/core/SkWriteBuffer.h"
 
@@ -206,6 +210,190 @@ static void draw_nine(const SkMask& mask, const SkIRect& outerR, const SkIPoint&
     }
 }
 
+// The pixels whose centers lie inside r.
+static SkIRect centers_inside(const SkRect& r) {
+    return SkIRect::MakeLTRB(SkScalarCeilToInt(r.fLeft - 0.5f),
+                             SkScalarCeilToInt(r.fTop - 0.5f),
+                             SkScalarFloorToInt(r.fRight + 0.5f),
+                             SkScalarFloorToInt(r.fBottom + 0.5f));
+}
+
+using CoverageFn = std::function<void(size_t, size_t, size_t, size_t)>;
+
+// Runs a coverage pipeline, which stores to *dstCtx, over r and blits it a strip of rows at a time.
+static void blit_coverage(const CoverageFn& run, SkRasterPipeline_MemoryCtx* dstCtx,
+                          const SkIRect& r, SkBlitter* blitter) {
+    constexpr int kStripBytes = 4*1024;
+    const int width = r.width(),
+              rows  = std::max(1, std::min(r.height(), kStripBytes / width));
+    SkAutoSMalloc<kStripBytes> storage(rows * width);
+    uint8_t* strip = (uint8_t*)storage.get();
+
+    SkMask mask;
+    mask.fImage    = strip;
+    mask.fRowBytes = width;
+    mask.fFormat   = SkMask::kA8_Format;
+    dstCtx->stride = width;
+    for (int y = r.top(); y < r.bottom(); y += rows) {
+        const int h = std::min(rows, r.bottom() - y);
+        dstCtx->pixels = strip - (r.left() + (size_t)y * width);
+        run(r.left(), y, width, h);
+
+        mask.fBounds.setLTRB(r.left(), y, r.right(), y + h);
+        blitter->blitMask(mask, mask.fBounds);
+    }
+}
+
+// Blits the blurred coverage over outerR, clipped to clipR. holeR, which must be inside outerR,
+// is either filled (full coverage) or skipped (no coverage) without running a pipeline. Pixels
+// in the columns or rows of straightR are drawn with rectRun; only the corners outside it need
+// rrectRun, if there is one.
+static void draw_analytic_clipped(const CoverageFn& rectRun, const CoverageFn* rrectRun,
+                                  SkRasterPipeline_MemoryCtx* dstCtx,
+                                  const SkIRect& outerR, const SkIRect& holeR, bool fillHole,
+                                  const SkIRect& straightR, const SkIRect& clipR,
+                                  SkBlitter* blitter) {
+    if (fillHole) {
+        blitClippedRect(blitter, holeR, clipR);
+    }
+
+    const SkIRect bands[] = {
+        SkIRect::MakeLTRB(outerR.left(), outerR.top(),   outerR.right(), holeR.top()),
+        SkIRect::MakeLTRB(outerR.left(), holeR.top(),    holeR.left(),   holeR.bottom()),
+        SkIRect::MakeLTRB(holeR.right(), holeR.top(),    outerR.right(), holeR.bottom()),
+        SkIRect::MakeLTRB(outerR.left(), holeR.bottom(), outerR.right(), outerR.bottom()),
+    };
+    for (const SkIRect& band : bands) {
+        SkIRect r;
+        if (!r.intersect(band, clipR)) {
+            continue;
+        }
+        if (!rrectRun || (r.top() >= straightR.top() && r.bottom() <= straightR.bottom())) {
+            blit_coverage(rectRun, dstCtx, r, blitter);
+            continue;
+        }
+        const int xs[] = {
+            r.left(),
+            SkTPin(straightR.left(), r.left(), r.right()),
+            SkTPin(straightR.right(), SkTPin(straightR.left(), r.left(), r.right()), r.right()),
+            r.right(),
+        };
+        for (int i = 0; i < 3; i++) {
+            if (xs[i] < xs[i+1]) {
+                blit_coverage(i == 1 ? rectRun : *rrectRun, dstCtx,
+                              SkIRect::MakeLTRB(xs[i], r.top(), xs[i+1], r.bottom()), blitter);
+            }
+        }
+    }
+}
+
+static void draw_analytic(const SkRasterPipeline_BlurRectCtx& ctx, bool rounded,
+                          const SkIRect& outerR, SkIRect holeR, bool fillHole,
+                          const SkIRect& straightR, const SkRasterClip& clip, SkBlitter* blitter) {
+    if (!holeR.intersect(outerR)) {
+        holeR = SkIRect::MakeLTRB(outerR.left(), outerR.bottom(), outerR.right(), outerR.bottom());
+    }
+
+    SkSTArenaAlloc<512> alloc;
+    SkRasterPipeline_MemoryCtx dstCtx = {nullptr, 0};
+    auto compile = [&](SkRasterPipeline::StockStage stage) {
+        SkRasterPipeline p(&alloc);
+        p.append(SkRasterPipeline::seed_shader);
+        p.append(stage, &ctx);
+        p.append(SkRasterPipeline::store_a8, &dstCtx);
+        return p.compile();
+    };
+    const CoverageFn rectRun  = compile(SkRasterPipeline::blur_rect_coverage);
+    const CoverageFn rrectRun = rounded ? compile(SkRasterPipeline::blur_rrect_coverage)
+                                        : CoverageFn();
+
+    // if we get here, we need to (possibly) resolve the clip and blitter
+    SkAAClipBlitterWrapper wrapper(clip, blitter);
+    blitter = wrapper.getBlitter();
+
+    SkRegion::Cliperator clipper(wrapper.getRgn(), outerR);
+    while (!clipper.done()) {
+        draw_analytic_clipped(rectRun, rounded ? &rrectRun : nullptr, &dstCtx, outerR, holeR,
+                              fillHole, straightR, clipper.rect(), blitter);
+        clipper.next();
+    }
+}
+
+// Draws one rect, or the frame between two nested rects, blurred with sigma.
+static bool draw_analytic_rects(const SkRect rects[], int count, SkScalar sigma,
+                                const SkRasterClip& clip, SkBlitter* blitter) {
+    const SkScalar reach = 3 * sigma;   // The blur kernel is zero past 3*sigma.
+    const SkRect outer = rects[0].makeOutset(reach, reach);
+    if (!SkRectPriv::FitsInFixed(outer)) {
+        return false;
+    }
+
+    SkRasterPipeline_BlurRectCtx ctx = {};
+    ctx.l = rects[0].fLeft;
+    ctx.t = rects[0].fTop;
+    ctx.r = rects[0].fRight;
+    ctx.b = rects[0].fBottom;
+    ctx.invTwoSigma = 1 / (2 * sigma);
+
+    SkIRect holeR = centers_inside(rects[0].makeInset(reach, reach));
+    bool fillHole = true;
+    if (count == 2) {
+        ctx.innerL = rects[1].fLeft;
+        ctx.innerT = rects[1].fTop;
+        ctx.innerR = rects[1].fRight;
+        ctx.innerB = rects[1].fBottom;
+        ctx.hasInner = true;
+
+        holeR = centers_inside(rects[1].makeInset(reach, reach));
+        fillHole = false;
+    }
+    const SkIRect outerR = outer.roundOut();
+    draw_analytic(ctx, false, outerR, holeR, fillHole, outerR, clip, blitter);
+    return true;
+}
+
+static bool draw_analytic_rrect(const SkRRect& rrect, SkScalar sigma,
+                                const SkRasterClip& clip, SkBlitter* blitter) {
+    if (rrect.isRect()) {
+        return draw_analytic_rects(&rrect.rect(), 1, sigma, clip, blitter);
+    }
+    const SkVector radii = rrect.getSimpleRadii();
+    if (!(rrect.isSimple() || rrect.isOval()) || radii.fX != radii.fY) {
+        return false;
+    }
+
+    // Pixels whose blur reaches into a corner integrate the kernel in slices. Once the corners
+    // get big that costs more than blitting a cached nine patch, so leave those to the mask.
+    constexpr SkScalar kMaxCornerSize = 32;
+    const SkScalar reach = 3 * sigma;
+    if (radii.fX + 2 * reach > kMaxCornerSize) {
+        return false;
+    }
+    const SkRect& rect = rrect.rect();
+    const SkRect outer = rect.makeOutset(reach, reach);
+    if (!SkRectPriv::FitsInFixed(outer)) {
+        return false;
+    }
+
+    SkRasterPipeline_BlurRectCtx ctx = {};
+    ctx.l = rect.fLeft;
+    ctx.t = rect.fTop;
+    ctx.r = rect.fRight;
+    ctx.b = rect.fBottom;
+    ctx.radius = radii.fX;
+    ctx.invTwoSigma = 1 / (2 * sigma);
+    // Corners that are sharp relative to the blur need finer slices to stay within a few
+    // values of the exact integral.
+    ctx.slices = SkTPin(4 * SkScalarCeilToInt(SkScalarSqrt(radii.fX / sigma)), 4, 16);
+
+    // Only the band between the corners is sure to be fully covered, and only the corners need
+    // more than the separable rect coverage.
+    const SkIRect holeR     = centers_inside(rect.makeInset(reach, reach + radii.fY)),
+                  straightR = centers_inside(rect.makeInset(reach + radii.fX, reach + radii.fY));
+    draw_analytic(ctx, true, outer.roundOut(), holeR, true, straightR, clip, blitter);
+    return true;
+}
+
 static int countNestedRects(const SkPath& path, SkRect rects[2]) {
     if (SkPathPriv::IsNestedFillRects(path, rects)) {
         return 2;
@@ -213,8 +401,32 @@ static int countNestedRects(const SkPath& path, SkRect rects[2]) {
     return path.isRect(&rects[0]);
 }
 
+static bool draw_analytic_path(const SkPath& path, SkScalar sigma,
+                               const SkRasterClip& clip, SkBlitter* blitter) {
+    if (path.isInverseFillType()) {
+        return false;
+    }
+    SkRect rects[2];
+    if (int rectCount = countNestedRects(path, rects)) {
+        return draw_analytic_rects(rects, rectCount, sigma, clip, blitter);
+    }
+    SkRect oval;
+    if (path.isOval(&oval)) {
+        return draw_analytic_rrect(SkRRect::MakeOval(oval), sigma, clip, blitter);
+    }
+    SkRRect rrect;
+    return path.isRRect(&rrect) && draw_analytic_rrect(rrect, sigma, clip, blitter);
+}
+
 bool SkMaskFilterBase::filterRRect(const SkRRect& devRRect, const SkMatrix& matrix,
                                    const SkRasterClip& clip, SkBlitter* blitter) const {
+    // Evaluating the blur directly needs no mask memory and respects fractional geometry.
+    SkScalar sigma;
+    if (this->asAnalyticBlur(matrix, &sigma) &&
+        draw_analytic_rrect(devRRect, sigma, clip, blitter)) {
+        return true;
+    }
+
     // Attempt to speed up drawing by creating a nine patch. If a nine patch
     // cannot be used, return false to allow our caller to recover and perform
     // the drawing another way.
@@ -233,6 +445,12 @@ bool SkMaskFilterBase::filterRRect(const SkRRect& devRRect, const SkMatrix& matr
 bool SkMaskFilterBase::filterPath(const SkPath& devPath, const SkMatrix& matrix,
                                   const SkRasterClip& clip, SkBlitter* blitter,
                                   SkStrokeRec::InitStyle style) const {
+    SkScalar sigma;
+    if (SkStrokeRec::kFill_InitStyle == style && this->asAnalyticBlur(matrix, &sigma) &&
+        draw_analytic_path(devPath, sigma, clip, blitter)) {
+        return true;
+    }
+
     SkRect rects[2];
     int rectCount = 0;
     if (SkStrokeRec::kFill_InitStyle == style) {
@@ -300,6 +518,10 @@ SkMaskFilterBase::filterRRectToNine(const SkRRect&, const SkMatrix&,
     return kUnimplemented_FilterReturn;
 }
 
+bool SkMaskFilterBase::asAnalyticBlur(const SkMatrix&, SkScalar*) const {
+    return false;
+}
+
 SkMaskFilterBase::FilterReturn
 SkMaskFilterBase::filterRectsToNine(const SkRect[], int count, const SkMatrix&,
                                     const SkIRect& clipBounds, NinePatch*) const {
@@ -218,6 +218,14 @@ protected:
                                            const SkIRect& clipBounds,
                                            NinePatch*) const;
 
+    /**
+     *  Override if your subclass is a normal style blur whose coverage of a rect, a pair of
+     *  nested rects, or a round rect with circular corners can be computed in closed form by the
+     *  blur_rect_coverage and blur_rrect_coverage stages of SkRasterPipeline. On success return
+     *  true and the device space sigma; the caller then draws those shapes without a mask.
+     */
+    virtual bool asAnalyticBlur(const SkMatrix&, SkScalar* devSigma) const;
+
 private:
     friend class SkDraw;
 
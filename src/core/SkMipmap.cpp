@@ -6,6 +6,7 @@
  */
 
 #include "include/core/SkBitmap.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkTypes.h"
 #include "include/private/SkColorData.h"
 #include "include/private/SkHalf.h"
@@ -16,7 +17,9 @@
 #include "src/core/SkMathPriv.h"
 #include "src/core/SkMipmap.h"
 #include "src/core/SkMipmapBuilder.h"
+#include "src/core/SkTaskGroup.h"
 #include <new>
+#include <vector>
 
 //
 // ColorTypeFilter is the "Type" we pass to some downsample template functions.
@@ -384,169 +387,168 @@ template <typename F> void downsample_3_3(void* dst, const void* src, size_t src
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
-size_t SkMipmap::AllocLevelsSize(int levelCount, size_t pixelSize) {
-    if (levelCount < 0) {
-        return 0;
-    }
-    int64_t size = sk_64_mul(levelCount + 1, sizeof(Level)) + pixelSize;
-    if (!SkTFitsIn<int32_t>(size)) {
-        return 0;
-    }
-    return SkTo<int32_t>(size);
-}
-
-SkMipmap* SkMipmap::Build(const SkPixmap& src, SkDiscardableFactoryProc fact,
-                          bool computeContents) {
-    typedef void FilterProc(void*, const void* srcPtr, size_t srcRB, int count);
-
-    FilterProc* proc_1_2 = nullptr;
-    FilterProc* proc_1_3 = nullptr;
-    FilterProc* proc_2_1 = nullptr;
-    FilterProc* proc_2_2 = nullptr;
-    FilterProc* proc_2_3 = nullptr;
-    FilterProc* proc_3_1 = nullptr;
-    FilterProc* proc_3_2 = nullptr;
-    FilterProc* proc_3_3 = nullptr;
+typedef void FilterProc(void*, const void* srcPtr, size_t srcRB, int count);
+
+struct FilterProcs {
+    FilterProc* proc_1_2;
+    FilterProc* proc_1_3;
+    FilterProc* proc_2_1;
+    FilterProc* proc_2_2;
+    FilterProc* proc_2_3;
+    FilterProc* proc_3_1;
+    FilterProc* proc_3_2;
+    FilterProc* proc_3_3;
+};
 
-    const SkColorType ct = src.colorType();
-    const SkAlphaType at = src.alphaType();
+template <typename F> static FilterProcs filter_procs() {
+    return { downsample_1_2<F>, downsample_1_3<F>, downsample_2_1<F>, downsample_2_2<F>,
+             downsample_2_3<F>, downsample_3_1<F>, downsample_3_2<F>, downsample_3_3<F> };
+}
 
+static bool choose_filter_procs(SkColorType ct, FilterProcs* procs) {
     switch (ct) {
         case kRGBA_8888_SkColorType:
         case kBGRA_8888_SkColorType:
-            proc_1_2 = downsample_1_2<ColorTypeFilter_8888>;
-            proc_1_3 = downsample_1_3<ColorTypeFilter_8888>;
-            proc_2_1 = downsample_2_1<ColorTypeFilter_8888>;
-            proc_2_2 = downsample_2_2<ColorTypeFilter_8888>;
-            proc_2_3 = downsample_2_3<ColorTypeFilter_8888>;
-            proc_3_1 = downsample_3_1<ColorTypeFilter_8888>;
-            proc_3_2 = downsample_3_2<ColorTypeFilter_8888>;
-            proc_3_3 = downsample_3_3<ColorTypeFilter_8888>;
-            break;
+            *procs = filter_procs<ColorTypeFilter_8888>();
+            return true;
         case kRGB_565_SkColorType:
-            proc_1_2 = downsample_1_2<ColorTypeFilter_565>;
-            proc_1_3 = downsample_1_3<ColorTypeFilter_565>;
-            proc_2_1 = downsample_2_1<ColorTypeFilter_565>;
-            proc_2_2 = downsample_2_2<ColorTypeFilter_565>;
-            proc_2_3 = downsample_2_3<ColorTypeFilter_565>;
-            proc_3_1 = downsample_3_1<ColorTypeFilter_565>;
-            proc_3_2 = downsample_3_2<ColorTypeFilter_565>;
-            proc_3_3 = downsample_3_3<ColorTypeFilter_565>;
-            break;
+            *procs = filter_procs<ColorTypeFilter_565>();
+            return true;
         case kARGB_4444_SkColorType:
-            proc_1_2 = downsample_1_2<ColorTypeFilter_4444>;
-            proc_1_3 = downsample_1_3<ColorTypeFilter_4444>;
-            proc_2_1 = downsample_2_1<ColorTypeFilter_4444>;
-            proc_2_2 = downsample_2_2<ColorTypeFilter_4444>;
-            proc_2_3 = downsample_2_3<ColorTypeFilter_4444>;
-            proc_3_1 = downsample_3_1<ColorTypeFilter_4444>;
-            proc_3_2 = downsample_3_2<ColorTypeFilter_4444>;
-            proc_3_3 = downsample_3_3<ColorTypeFilter_4444>;
-            break;
+            *procs = filter_procs<ColorTypeFilter_4444>();
+            return true;
         case kAlpha_8_SkColorType:
         case kGray_8_SkColorType:
         case kR8_unorm_SkColorType:
-            proc_1_2 = downsample_1_2<ColorTypeFilter_8>;
-            proc_1_3 = downsample_1_3<ColorTypeFilter_8>;
-            proc_2_1 = downsample_2_1<ColorTypeFilter_8>;
-            proc_2_2 = downsample_2_2<ColorTypeFilter_8>;
-            proc_2_3 = downsample_2_3<ColorTypeFilter_8>;
-            proc_3_1 = downsample_3_1<ColorTypeFilter_8>;
-            proc_3_2 = downsample_3_2<ColorTypeFilter_8>;
-            proc_3_3 = downsample_3_3<ColorTypeFilter_8>;
-            break;
+            *procs = filter_procs<ColorTypeFilter_8>();
+            return true;
         case kRGBA_F16Norm_SkColorType:
         case kRGBA_F16_SkColorType:
-            proc_1_2 = downsample_1_2<ColorTypeFilter_RGBA_F16>;
-            proc_1_3 = downsample_1_3<ColorTypeFilter_RGBA_F16>;
-            proc_2_1 = downsample_2_1<ColorTypeFilter_RGBA_F16>;
-            proc_2_2 = downsample_2_2<ColorTypeFilter_RGBA_F16>;
-            proc_2_3 = downsample_2_3<ColorTypeFilter_RGBA_F16>;
-            proc_3_1 = downsample_3_1<ColorTypeFilter_RGBA_F16>;
-            proc_3_2 = downsample_3_2<ColorTypeFilter_RGBA_F16>;
-            proc_3_3 = downsample_3_3<ColorTypeFilter_RGBA_F16>;
-            break;
+            *procs = filter_procs<ColorTypeFilter_RGBA_F16>();
+            return true;
         case kR8G8_unorm_SkColorType:
-            proc_1_2 = downsample_1_2<ColorTypeFilter_88>;
-            proc_1_3 = downsample_1_3<ColorTypeFilter_88>;
-            proc_2_1 = downsample_2_1<ColorTypeFilter_88>;
-            proc_2_2 = downsample_2_2<ColorTypeFilter_88>;
-            proc_2_3 = downsample_2_3<ColorTypeFilter_88>;
-            proc_3_1 = downsample_3_1<ColorTypeFilter_88>;
-            proc_3_2 = downsample_3_2<ColorTypeFilter_88>;
-            proc_3_3 = downsample_3_3<ColorTypeFilter_88>;
-            break;
+            *procs = filter_procs<ColorTypeFilter_88>();
+            return true;
         case kR16G16_unorm_SkColorType:
-            proc_1_2 = downsample_1_2<ColorTypeFilter_1616>;
-            proc_1_3 = downsample_1_3<ColorTypeFilter_1616>;
-            proc_2_1 = downsample_2_1<ColorTypeFilter_1616>;
-            proc_2_2 = downsample_2_2<ColorTypeFilter_1616>;
-            proc_2_3 = downsample_2_3<ColorTypeFilter_1616>;
-            proc_3_1 = downsample_3_1<ColorTypeFilter_1616>;
-            proc_3_2 = downsample_3_2<ColorTypeFilter_1616>;
-            proc_3_3 = downsample_3_3<ColorTypeFilter_1616>;
-            break;
+            *procs = filter_procs<ColorTypeFilter_1616>();
+            return true;
         case kA16_unorm_SkColorType:
-            proc_1_2 = downsample_1_2<ColorTypeFilter_16>;
-            proc_1_3 = downsample_1_3<ColorTypeFilter_16>;
-            proc_2_1 = downsample_2_1<ColorTypeFilter_16>;
-            proc_2_2 = downsample_2_2<ColorTypeFilter_16>;
-            proc_2_3 = downsample_2_3<ColorTypeFilter_16>;
-            proc_3_1 = downsample_3_1<ColorTypeFilter_16>;
-            proc_3_2 = downsample_3_2<ColorTypeFilter_16>;
-            proc_3_3 = downsample_3_3<ColorTypeFilter_16>;
-            break;
+            *procs = filter_procs<ColorTypeFilter_16>();
+            return true;
         case kRGBA_1010102_SkColorType:
         case kBGRA_1010102_SkColorType:
-            proc_1_2 = downsample_1_2<ColorTypeFilter_1010102>;
-            proc_1_3 = downsample_1_3<ColorTypeFilter_1010102>;
-            proc_2_1 = downsample_2_1<ColorTypeFilter_1010102>;
-            proc_2_2 = downsample_2_2<ColorTypeFilter_1010102>;
-            proc_2_3 = downsample_2_3<ColorTypeFilter_1010102>;
-            proc_3_1 = downsample_3_1<ColorTypeFilter_1010102>;
-            proc_3_2 = downsample_3_2<ColorTypeFilter_1010102>;
-            proc_3_3 = downsample_3_3<ColorTypeFilter_1010102>;
-            break;
+            *procs = filter_procs<ColorTypeFilter_1010102>();
+            return true;
         case kA16_float_SkColorType:
-            proc_1_2 = downsample_1_2<ColorTypeFilter_Alpha_F16>;
-            proc_1_3 = downsample_1_3<ColorTypeFilter_Alpha_F16>;
-            proc_2_1 = downsample_2_1<ColorTypeFilter_Alpha_F16>;
-            proc_2_2 = downsample_2_2<ColorTypeFilter_Alpha_F16>;
-            proc_2_3 = downsample_2_3<ColorTypeFilter_Alpha_F16>;
-            proc_3_1 = downsample_3_1<ColorTypeFilter_Alpha_F16>;
-            proc_3_2 = downsample_3_2<ColorTypeFilter_Alpha_F16>;
-            proc_3_3 = downsample_3_3<ColorTypeFilter_Alpha_F16>;
-            break;
+            *procs = filter_procs<ColorTypeFilter_Alpha_F16>();
+            return true;
         case kR16G16_float_SkColorType:
-            proc_1_2 = downsample_1_2<ColorTypeFilter_F16F16>;
-            proc_1_3 = downsample_1_3<ColorTypeFilter_F16F16>;
-            proc_2_1 = downsample_2_1<ColorTypeFilter_F16F16>;
-            proc_2_2 = downsample_2_2<ColorTypeFilter_F16F16>;
-            proc_2_3 = downsample_2_3<ColorTypeFilter_F16F16>;
-            proc_3_1 = downsample_3_1<ColorTypeFilter_F16F16>;
-            proc_3_2 = downsample_3_2<ColorTypeFilter_F16F16>;
-            proc_3_3 = downsample_3_3<ColorTypeFilter_F16F16>;
-            break;
+            *procs = filter_procs<ColorTypeFilter_F16F16>();
+            return true;
         case kR16G16B16A16_unorm_SkColorType:
-            proc_1_2 = downsample_1_2<ColorTypeFilter_16161616>;
-            proc_1_3 = downsample_1_3<ColorTypeFilter_16161616>;
-            proc_2_1 = downsample_2_1<ColorTypeFilter_16161616>;
-            proc_2_2 = downsample_2_2<ColorTypeFilter_16161616>;
-            proc_2_3 = downsample_2_3<ColorTypeFilter_16161616>;
-            proc_3_1 = downsample_3_1<ColorTypeFilter_16161616>;
-            proc_3_2 = downsample_3_2<ColorTypeFilter_16161616>;
-            proc_3_3 = downsample_3_3<ColorTypeFilter_16161616>;
-            break;
+            *procs = filter_procs<ColorTypeFilter_16161616>();
+            return true;
 
         case kUnknown_SkColorType:
         case kRGB_888x_SkColorType:     // TODO: use 8888?
         case kRGB_101010x_SkColorType:  // TODO: use 1010102?
         case kBGR_101010x_SkColorType:  // TODO: use 1010102?
         case kRGBA_F32_SkColorType:
-            return nullptr;
+            return false;
 
         case kSRGBA_8888_SkColorType:  // TODO: needs careful handling
-            return nullptr;
+            return false;
+    }
+    SkUNREACHABLE;
+}
+
+// Picks the filter that makes a level from a src level of the given size.
+static FilterProc* choose_filter_proc(const FilterProcs& procs, int width, int height) {
+    if (height & 1) {
+        if (height == 1) {        // src-height is 1
+            if (width & 1) {      // src-width is 3
+                return procs.proc_3_1;
+            } else {              // src-width is 2
+                return procs.proc_2_1;
+            }
+        } else {                  // src-height is 3
+            if (width & 1) {
+                if (width == 1) { // src-width is 1
+                    return procs.proc_1_3;
+                } else {          // src-width is 3
+                    return procs.proc_3_3;
+                }
+            } else {              // src-width is 2
+                return procs.proc_2_3;
+            }
+        }
+    } else {                      // src-height is 2
+        if (width & 1) {
+            if (width == 1) {     // src-width is 1
+                return procs.proc_1_2;
+            } else {              // src-width is 3
+                return procs.proc_3_2;
+            }
+        } else {                  // src-width is 2
+            return procs.proc_2_2;
+        }
+    }
+}
+
+// Levels with at least this many pixels are downsampled in bands on an executor.
+static constexpr SkRowBanding kBanding = {256 * 256, 32};
+
+static void downsample_level(const FilterProcs& procs, const SkPixmap& srcPM,
+                             const SkPixmap& dstPM) {
+    FilterProc* proc = choose_filter_proc(procs, srcPM.width(), srcPM.height());
+    const size_t srcRB = srcPM.rowBytes();
+    const size_t dstRB = dstPM.rowBytes();
+
+    auto downsample_rows = [&](int y0, int y1) {
+        const void* srcBasePtr = (const char*)srcPM.addr() + srcRB * 2 * y0;
+        void* dstBasePtr = (char*)dstPM.writable_addr() + dstRB * y0;
+        for (int y = y0; y < y1; y++) {
+            proc(dstBasePtr, srcBasePtr, srcRB, dstPM.width());
+            srcBasePtr = (const char*)srcBasePtr + srcRB * 2; // jump two rows
+            dstBasePtr = (char*)dstBasePtr + dstRB;
+        }
+    };
+
+    const int height = dstPM.height();
+    SkRowBanding::Run(&SkExecutor::GetDefault(), height,
+                      kBanding.bandCount(height, sk_64_mul(dstPM.width(), height)), 1,
+                      [&](int, int y0, int y1) { downsample_rows(y0, y1); });
+}
+
+// Computes levels [begin, end), each from the one before it, and the first from base. base is
+// only read if begin is 0.
+static void compute_levels(const SkPixmap& base, const SkMipmap::Level levels[],
+                           int begin, int end) {
+    FilterProcs procs;
+    SkAssertResult(choose_filter_procs(levels[0].fPixmap.colorType(), &procs));
+    for (int i = begin; i < end; ++i) {
+        downsample_level(procs, i == 0 ? base : levels[i - 1].fPixmap, levels[i].fPixmap);
+    }
+}
+
+size_t SkMipmap::AllocLevelsSize(int levelCount, size_t pixelSize) {
+    if (levelCount < 0) {
+        return 0;
+    }
+    int64_t size = sk_64_mul(levelCount + 1, sizeof(Level)) + pixelSize;
+    if (!SkTFitsIn<int32_t>(size)) {
+        return 0;
+    }
+    return SkTo<int32_t>(size);
+}
+
+SkMipmap* SkMipmap::Allocate(const SkImageInfo& src, SkDiscardableFactoryProc fact) {
+    const SkColorType ct = src.colorType();
+    const SkAlphaType at = src.alphaType();
+
+    FilterProcs procs;
+    if (!choose_filter_procs(ct, &procs)) {
+        return nullptr;
     }
 
     if (src.width() <= 1 && src.height() <= 1) {
@@ -577,7 +579,7 @@ SkMipmap* SkMipmap::Build(const SkPixmap& src, SkDiscardableFactoryProc fact,
     }
 
     // init
-    mipmap->fCS = sk_ref_sp(src.info().colorSpace());
+    mipmap->fCS = sk_ref_sp(src.colorSpace());
     mipmap->fCount = countLevels;
     mipmap->fLevels = (Level*)mipmap->writable_data();
     SkASSERT(mipmap->fLevels);
@@ -588,43 +590,12 @@ SkMipmap* SkMipmap::Build(const SkPixmap& src, SkDiscardableFactoryProc fact,
     int         width = src.width();
     int         height = src.height();
     uint32_t    rowBytes;
-    SkPixmap    srcPM(src);
 
     // Depending on architecture and other factors, the pixel data alignment may need to be as
     // large as 8 (for F16 pixels). See the comment on SkMipmap::Level.
     SkASSERT(SkIsAlign8((uintptr_t)addr));
 
     for (int i = 0; i < countLevels; ++i) {
-        FilterProc* proc;
-        if (height & 1) {
-            if (height == 1) {        // src-height is 1
-                if (width & 1) {      // src-width is 3
-                    proc = proc_3_1;
-                } else {              // src-width is 2
-                    proc = proc_2_1;
-                }
-            } else {                  // src-height is 3
-                if (width & 1) {
-                    if (width == 1) { // src-width is 1
-                        proc = proc_1_3;
-                    } else {          // src-width is 3
-                        proc = proc_3_3;
-                    }
-                } else {              // src-width is 2
-                    proc = proc_2_3;
-                }
-            }
-        } else {                      // src-height is 2
-            if (width & 1) {
-                if (width == 1) {     // src-width is 1
-                    proc = proc_1_2;
-                } else {              // src-width is 3
-                    proc = proc_3_2;
-                }
-            } else {                  // src-width is 2
-                proc = proc_2_2;
-            }
-        }
         width = std::max(1, width >> 1);
         height = std::max(1, height >> 1);
         rowBytes = SkToU32(SkColorTypeMinRowBytes(ct, width));
@@ -635,20 +606,6 @@ SkMipmap* SkMipmap::Build(const SkPixmap& src, SkDiscardableFactoryProc fact,
         new (&levels[i].fPixmap) SkPixmap(SkImageInfo::Make(width, height, ct, at), addr, rowBytes);
         levels[i].fScale  = SkSize::Make(SkIntToScalar(width)  / src.width(),
                                          SkIntToScalar(height) / src.height());
-
-        const SkPixmap& dstPM = levels[i].fPixmap;
-        if (computeContents) {
-            const void* srcBasePtr = srcPM.addr();
-            void* dstBasePtr = dstPM.writable_addr();
-
-            const size_t srcRB = srcPM.rowBytes();
-            for (int y = 0; y < height; y++) {
-                proc(dstBasePtr, srcBasePtr, srcRB, width);
-                srcBasePtr = (char*)srcBasePtr + srcRB * 2; // jump two rows
-                dstBasePtr = (char*)dstBasePtr + dstPM.rowBytes();
-            }
-        }
-        srcPM = dstPM;
         addr += height * rowBytes;
     }
     SkASSERT(addr == baseAddr + size);
@@ -657,6 +614,79 @@ SkMipmap* SkMipmap::Build(const SkPixmap& src, SkDiscardableFactoryProc fact,
     return mipmap;
 }
 
+SkMipmap* SkMipmap::Build(const SkPixmap& src, SkDiscardableFactoryProc fact,
+                          bool computeContents) {
+    SkMipmap* mipmap = Allocate(src.info(), fact);
+    if (!mipmap) {
+        return nullptr;
+    }
+    if (computeContents) {
+        compute_levels(src, mipmap->fLevels, 0, mipmap->fCount);
+    }
+    mipmap->fComputedCount.store(mipmap->fCount, std::memory_order_relaxed);
+    return mipmap;
+}
+
+SkMipmap* SkMipmap::BuildLazily(const SkPixmap& src, SkDiscardableFactoryProc fact) {
+    SkMipmap* mipmap = Allocate(src.info(), fact);
+    if (!mipmap) {
+        return nullptr;
+    }
+    compute_levels(src, mipmap->fLevels, 0, 1);
+    mipmap->fComputedCount.store(1, std::memory_order_relaxed);
+    return mipmap;
+}
+
+bool SkMipmap::computeLevels(int count) const {
+    SkASSERT(count <= fCount);
+    if (fComputedCount.load(std::memory_order_acquire) >= count) {
+        return true;
+    }
+
+    // Downsampling large levels waits on the default executor, which may run other work that
+    // draws with this mipmap and so needs fLazyMutex. So we compute the missing levels into
+    // storage of our own without the lock held, and only take it to copy them in.
+    int computed;
+    std::vector<Level> levels;
+    {
+        SkAutoMutexExclusive lock(fLazyMutex);
+        computed = fComputedCount.load(std::memory_order_relaxed);
+        if (computed >= count) {
+            return true;
+        }
+        if (nullptr == fLevels) {
+            return false;
+        }
+        // Levels below computed don't change anymore, so it's safe to read them unlocked.
+        levels.assign(fLevels, fLevels + count);
+    }
+
+    // The first level is computed up front, so no level needs the base.
+    SkASSERT(computed > 0);
+    std::vector<SkBitmap> storage(count - computed);
+    for (int i = computed; i < count; ++i) {
+        SkBitmap& bitmap = storage[i - computed];
+        if (!bitmap.tryAllocPixels(levels[i].fPixmap.info())) {
+            return false;
+        }
+        levels[i].fPixmap = bitmap.pixmap();
+    }
+    compute_levels(SkPixmap(), levels.data(), computed, count);
+
+    SkAutoMutexExclusive lock(fLazyMutex);
+    if (nullptr == fLevels) {
+        return false;
+    }
+    // Another thread may have computed some of these levels while we were.
+    for (int i = fComputedCount.load(std::memory_order_relaxed); i < count; ++i) {
+        SkAssertResult(levels[i].fPixmap.readPixels(fLevels[i].fPixmap));
+    }
+    if (fComputedCount.load(std::memory_order_relaxed) < count) {
+        fComputedCount.store(count, std::memory_order_release);
+    }
+    return true;
+}
+
 int SkMipmap::ComputeLevelCount(int baseWidth, int baseHeight) {
     if (baseWidth < 1 || baseHeight < 1) {
         return 0;
@@ -757,6 +787,9 @@ bool SkMipmap::extractLevel(SkSize scaleSize, Level* levelPtr) const {
     if (level > fCount) {
         level = fCount;
     }
+    if (!this->computeLevels(level)) {
+        return false;
+    }
     if (levelPtr) {
         *levelPtr = fLevels[level - 1];
         // need to augment with our colorspace
@@ -813,6 +846,9 @@ bool SkMipmap::getLevel(int index, Level* levelPtr) const {
     if (index > fCount - 1) {
         return false;
     }
+    if (!this->computeLevels(index + 1)) {
+        return false;
+    }
     if (levelPtr) {
         *levelPtr = fLevels[index];
         // need to augment with our colorspace
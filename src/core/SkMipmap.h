@@ -12,9 +12,12 @@
 #include "include/core/SkScalar.h"
 #include "include/core/SkSize.h"
 #include "include/private/SkImageInfoPriv.h"
+#include "include/private/SkMutex.h"
 #include "src/core/SkCachedData.h"
 #include "src/shaders/SkShaderBase.h"
 
+#include <atomic>
+
 class SkBitmap;
 class SkData;
 class SkDiscardableMemory;
@@ -38,6 +41,11 @@ public:
 
     static SkMipmap* Build(const SkBitmap& src, SkDiscardableFactoryProc);
 
+    // Like Build(), but only the first level is computed up front. The others are computed from it
+    // when getLevel() or extractLevel() first asks for them (or a smaller one), so the mipmap does
+    // not need to hold on to src.
+    static SkMipmap* BuildLazily(const SkPixmap& src, SkDiscardableFactoryProc);
+
     // Determines how many levels a SkMipmap will have without creating that mipmap.
     // This does not include the base mipmap level that the user provided when
     // creating the SkMipmap.
@@ -86,11 +94,22 @@ private:
     Level*              fLevels;    // managed by the baseclass, may be null due to onDataChanged.
     int                 fCount;
 
+    // Levels [0, fComputedCount) have their contents. The rest are filled in under fLazyMutex.
+    mutable SkMutex          fLazyMutex;
+    mutable std::atomic<int> fComputedCount{0};
+
     SkMipmap(void* malloc, size_t size) : INHERITED(malloc, size) {}
     SkMipmap(size_t size, SkDiscardableMemory* dm) : INHERITED(size, dm) {}
 
     static size_t AllocLevelsSize(int levelCount, size_t pixelSize);
 
+    // Allocates a mipmap with the levels for src laid out, but not computed.
+    static SkMipmap* Allocate(const SkImageInfo& src, SkDiscardableFactoryProc);
+
+    // Computes the contents of any of the first 'count' levels that don't have them yet. Returns
+    // false if the levels have been purged.
+    bool computeLevels(int count) const;
+
     using INHERITED = SkCachedData;
 };
 
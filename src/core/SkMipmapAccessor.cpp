@@ -10,6 +10,7 @@
 #include "include/private/SkTemplates.h"
 #include "src/core/SkArenaAlloc.h"
 #include "src/core/SkBitmapCache.h"
+#include "src/core/SkImagePriv.h"
 #include "src/core/SkMipmap.h"
 #include "src/core/SkMipmapAccessor.h"
 #include "src/image/SkImage_Base.h"
@@ -26,8 +27,38 @@ static sk_sp<const SkMipmap> try_load_mips(const SkImage_Base* image) {
     return mips;
 }
 
+bool SkMipmapAccessor::GetScaledPixels(const SkImage_Base* image, const SkMatrix& inv,
+                                       SkBitmap* bitmap) {
+    SkSize invScale;
+    SkISize scaledDimensions;
+    if (!inv.decomposeScale(&invScale, nullptr) ||
+        !image->getScaledDecodeDimensions({1/invScale.width(), 1/invScale.height()},
+                                          &scaledDimensions)) {
+        return false;
+    }
+    return image->getScaledROPixels(scaledDimensions, bitmap);
+}
+
 SkMipmapAccessor::SkMipmapAccessor(const SkImage_Base* image, const SkMatrix& inv,
                                    SkMipmapMode requestedMode) {
+    SkBitmap scaled;
+    if (GetScaledPixels(image, inv, &scaled)) {
+        // Draw from the smaller decode in place of the image. Any mipmaps we need are built from
+        // it too, and cached for as long as its pixels are.
+        sk_sp<SkImage> scaledImage = SkMakeImageFromRasterBitmap(scaled, kNever_SkCopyPixelsMode);
+        if (scaledImage) {
+            this->init(as_IB(scaledImage.get()),
+                       SkMatrix::Scale(SkIntToScalar(scaled.width())  / image->width(),
+                                       SkIntToScalar(scaled.height()) / image->height()) * inv,
+                       requestedMode);
+            return;
+        }
+    }
+    this->init(image, inv, requestedMode);
+}
+
+void SkMipmapAccessor::init(const SkImage_Base* image, const SkMatrix& inv,
+                            SkMipmapMode requestedMode) {
     SkMipmapMode resolvedMode = requestedMode;
     fLowerWeight = 0;
 
@@ -21,6 +21,12 @@ public:
     // Returns null on failure
     static SkMipmapAccessor* Make(SkArenaAlloc*, const SkImage*, const SkMatrix& inv, SkMipmapMode);
 
+    // A lazy image drawn smaller than it is may be able to decode straight to a smaller size that
+    // is still large enough for the draw, e.g. a JPEG at 1/2, 1/4 or 1/8 scale, which is much
+    // cheaper to decode and cache than the full image. If it can, this returns true and those
+    // pixels, to be drawn in place of the image's own (with mipmaps built from them, if needed).
+    static bool GetScaledPixels(const SkImage_Base*, const SkMatrix& inv, SkBitmap*);
+
     std::pair<SkPixmap, SkMatrix> level() const {
         SkASSERT(fUpper.addr() != nullptr);
         return std::make_pair(fUpper, fUpperInv);
@@ -45,6 +51,8 @@ private:
     SkBitmap              fBaseStorage;
     sk_sp<const SkMipmap> fCurrMip;
 
+    void init(const SkImage_Base*, const SkMatrix& inv, SkMipmapMode requestedMode);
+
 public:
     // Don't call publicly -- this is only public for SkArenaAlloc to access it inside Make()
     SkMipmapAccessor(const SkImage_Base*, const SkMatrix& inv, SkMipmapMode requestedMode);
@@ -89,6 +89,8 @@ namespace SkOpts {
     DEFINE_DEFAULT(S32_alpha_D32_filter_DXDY);
 
     DEFINE_DEFAULT(interpret_skvm);
+    DEFINE_DEFAULT(decode_skvm_threaded);
+    DEFINE_DEFAULT(interpret_skvm_threaded);
 #undef DEFINE_DEFAULT
 
 #define M(st) (StageFn)SK_OPTS_NS::st,
@@ -16,6 +16,7 @@
 struct SkBitmapProcState;
 namespace skvm {
 struct InterpreterInstruction;
+struct ThreadedInstruction;
 class TraceHook;
 }
 
@@ -84,6 +85,15 @@ namespace SkOpts {
                                   int nregs, int loop, const int strides[],
                                   skvm::TraceHook* traceHooks[], int nTraceHooks,
                                   int nargs, int n, void* args[]);
+
+    // Decode insts for interpret_skvm_threaded() into out[0..ninsts], once for each stride.
+    extern void (*decode_skvm_threaded)(const skvm::InterpreterInstruction insts[], int ninsts,
+                                        int loop, bool strideK, skvm::ThreadedInstruction out[]);
+    extern void (*interpret_skvm_threaded)(const skvm::ThreadedInstruction strideK[],
+                                           const skvm::ThreadedInstruction stride1[],
+                                           int nregs, int loop, const int strides[],
+                                           skvm::TraceHook* traceHooks[], int nTraceHooks,
+                                           int nargs, int n, void* args[]);
 }  // namespace SkOpts
 
 /** Similar to memset(), but it assigns a 16, 32, or 64-bit value into the buffer.
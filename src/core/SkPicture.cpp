@@ -12,6 +12,7 @@
 #include "include/core/SkSerialProcs.h"
 #include "include/private/SkTo.h"
 #include "src/core/SkCanvasPriv.h"
+#include "src/core/SkMappedPicture.h"
 #include "src/core/SkMathPriv.h"
 #include "src/core/SkPictureCommon.h"
 #include "src/core/SkPictureData.h"
@@ -144,6 +145,10 @@ sk_sp<SkPicture> SkPicture::MakeFromData(const void* data, size_t size,
     if (!data) {
         return nullptr;
     }
+    if (SkMappedPicture::IsMappedPicture(data, size)) {
+        // The mapped picture plays back out of its data, so it needs its own copy.
+        return SkMappedPicture::Make(SkData::MakeWithCopy(data, size), procs);
+    }
     SkMemoryStream stream(data, size);
     return MakeFromStream(&stream, procs, nullptr);
 }
@@ -152,6 +157,9 @@ sk_sp<SkPicture> SkPicture::MakeFromData(const SkData* data, const SkDeserialPro
     if (!data) {
         return nullptr;
     }
+    if (SkMappedPicture::IsMappedPicture(data->data(), data->size())) {
+        return SkMappedPicture::Make(sk_ref_sp(data), procs);
+    }
     SkMemoryStream stream(data->data(), data->size());
     return MakeFromStream(&stream, procs, nullptr);
 }
@@ -207,6 +207,12 @@ void SkPictureData::serialize(SkWStream* stream, const SkSerialProcs& procs,
     write_tag_size(stream, SK_PICT_READER_TAG, fOpData->size());
     stream->write(fOpData->bytes(), fOpData->size());
 
+    this->serializeResources(stream, procs, topLevelTypeFaceSet, textBlobsOnly);
+}
+
+void SkPictureData::serializeResources(SkWStream* stream, const SkSerialProcs& procs,
+                                       SkRefCntSet* topLevelTypeFaceSet,
+                                       bool textBlobsOnly) const {
     // We serialize all typefaces into the typeface section of the top-level picture.
     SkRefCntSet localTypefaceSet;
     SkRefCntSet* typefaceSet = topLevelTypeFaceSet ? topLevelTypeFaceSet : &localTypefaceSet;
@@ -484,6 +490,22 @@ SkPictureData* SkPictureData::CreateFromStream(SkStream* stream,
     return data.release();
 }
 
+SkPictureData* SkPictureData::CreateFromStream(SkStream* stream,
+                                               const SkPictInfo& info,
+                                               const SkDeserialProcs& procs,
+                                               sk_sp<SkData> opData) {
+    std::unique_ptr<SkPictureData> data(new SkPictureData(info));
+    if (!data->parseStream(stream, procs, &data->fTFPlayback)) {
+        return nullptr;
+    }
+    // The stream should only have held the resources.
+    if (data->fOpData || !opData) {
+        return nullptr;
+    }
+    data->fOpData = std::move(opData);
+    return data.release();
+}
+
 SkPictureData* SkPictureData::CreateFromBuffer(SkReadBuffer& buffer,
                                                const SkPictInfo& info) {
     std::unique_ptr<SkPictureData> data(new SkPictureData(info));
@@ -81,9 +81,17 @@ public:
                                            const SkPictInfo&,
                                            const SkDeserialProcs&,
                                            SkTypefacePlayback*);
+    // Reads what serializeResources() wrote, and plays back the given op data.
+    static SkPictureData* CreateFromStream(SkStream*,
+                                           const SkPictInfo&,
+                                           const SkDeserialProcs&,
+                                           sk_sp<SkData> opData);
     static SkPictureData* CreateFromBuffer(SkReadBuffer&, const SkPictInfo&);
 
     void serialize(SkWStream*, const SkSerialProcs&, SkRefCntSet*, bool textBlobsOnly=false) const;
+    // Like serialize(), but leaves out the op data.
+    void serializeResources(SkWStream*, const SkSerialProcs&, SkRefCntSet*,
+                            bool textBlobsOnly=false) const;
     void flatten(SkWriteBuffer&) const;
 
     const sk_sp<SkData>& opData() const { return fOpData; }
@@ -47,30 +47,71 @@ void SkPicturePlayback::draw(SkCanvas* canvas,
     SkAutoCanvasRestore acr(canvas, false);
 
     while (!reader.eof() && reader.isValid()) {
+        // Set before asking the callback, so that it can tell which op is next (SkMappedPicture
+        // relies on this to find where each op starts).
+        fCurOffset = reader.offset();
+
         if (callback && callback->abort()) {
             return;
         }
 
-        fCurOffset = reader.offset();
+        if (!this->drawOp(&reader, canvas, initialMatrix)) {
+            return;
+        }
+    }
+
+    // need to propagate invalid state to the parent reader
+    if (buffer) {
+        buffer->validate(reader.isValid());
+    }
+}
+
+void SkPicturePlayback::draw(SkCanvas* canvas, const uint32_t opOffsets[], int count,
+                             SkPicture::AbortCallback* callback) {
+    AutoResetOpID aroi(this);
+    SkASSERT(0 == fCurOffset);
+
+    const SkData* opData = fPictureData->opData().get();
+    SkReadBuffer reader(opData->bytes(), opData->size());
 
-        uint32_t bits = reader.readInt();
-        uint32_t op   = bits >> 24,
-                 size = bits & 0xffffff;
-        if (size == 0xffffff) {
-            size = reader.readInt();
+    SkM44 initialMatrix = canvas->getLocalToDevice();
+
+    SkAutoCanvasRestore acr(canvas, false);
+
+    for (int i = 0; i < count && reader.isValid(); ++i) {
+        if (callback && callback->abort()) {
+            return;
+        }
+
+        // Ops may skip ahead (e.g. to the restore after an empty clip), so always seek from
+        // the start.
+        reader.setMemory(opData->bytes(), opData->size());
+        if (!reader.validate(SkIsAlign4(opOffsets[i]) && opOffsets[i] < opData->size())) {
+            return;
         }
+        reader.skip(opOffsets[i]);
+        fCurOffset = reader.offset();
 
-        if (!reader.validate(size > 0 && op > UNUSED && op <= LAST_DRAWTYPE_ENUM)) {
+        if (!this->drawOp(&reader, canvas, initialMatrix)) {
             return;
         }
+    }
+}
 
-        this->handleOp(&reader, (DrawType)op, size, canvas, initialMatrix);
+bool SkPicturePlayback::drawOp(SkReadBuffer* reader, SkCanvas* canvas, const SkM44& initialMatrix) {
+    uint32_t bits = reader->readInt();
+    uint32_t op   = bits >> 24,
+             size = bits & 0xffffff;
+    if (size == 0xffffff) {
+        size = reader->readInt();
     }
 
-    // need to propagate invalid state to the parent reader
-    if (buffer) {
-        buffer->validate(reader.isValid());
+    if (!reader->validate(size > 0 && op > UNUSED && op <= LAST_DRAWTYPE_ENUM)) {
+        return false;
     }
+
+    this->handleOp(reader, (DrawType)op, size, canvas, initialMatrix);
+    return true;
 }
 
 static void validate_offsetToRestore(SkReadBuffer* reader, size_t offsetToRestore) {
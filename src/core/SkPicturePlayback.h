@@ -25,6 +25,9 @@ public:
 
     void draw(SkCanvas* canvas, SkPicture::AbortCallback*, SkReadBuffer* buffer);
 
+    // Draws only the ops that start at the given offsets into the op data, in order.
+    void draw(SkCanvas* canvas, const uint32_t opOffsets[], int count, SkPicture::AbortCallback*);
+
     // TODO: remove the curOp calls after cleaning up GrGatherDevice
     // Return the ID of the operation currently being executed when playing
     // back. 0 indicates no call is active.
@@ -37,6 +40,9 @@ protected:
     // The offset of the current operation when within the draw method
     size_t fCurOffset;
 
+    // Reads the op at the reader's offset and draws it. Returns false if the op is invalid.
+    bool drawOp(SkReadBuffer* reader, SkCanvas* canvas, const SkM44& initialMatrix);
+
     void handleOp(SkReadBuffer* reader,
                   DrawType op,
                   uint32_t size,
@@ -21,6 +21,7 @@
 
 SkPictureRecorder::SkPictureRecorder() {
     fActivelyRecording = false;
+    fRecordFlags = 0;
     fMiniRecorder = std::make_unique<SkMiniRecorder>();
     fRecorder = std::make_unique<SkRecorder>(nullptr, SkRect::MakeEmpty(), fMiniRecorder.get());
 }
@@ -28,11 +29,13 @@ SkPictureRecorder::SkPictureRecorder() {
 SkPictureRecorder::~SkPictureRecorder() {}
 
 SkCanvas* SkPictureRecorder::beginRecording(const SkRect& userCullRect,
-                                            sk_sp<SkBBoxHierarchy> bbh) {
+                                            sk_sp<SkBBoxHierarchy> bbh,
+                                            uint32_t recordFlags) {
     const SkRect cullRect = userCullRect.isEmpty() ? SkRect::MakeEmpty() : userCullRect;
 
     fCullRect = cullRect;
     fBBH = std::move(bbh);
+    fRecordFlags = recordFlags;
 
     if (!fRecord) {
         fRecord.reset(new SkRecord);
@@ -42,8 +45,9 @@ SkCanvas* SkPictureRecorder::beginRecording(const SkRect& userCullRect,
     return this->getRecordingCanvas();
 }
 
-SkCanvas* SkPictureRecorder::beginRecording(const SkRect& bounds, SkBBHFactory* factory) {
-    return this->beginRecording(bounds, factory ? (*factory)() : nullptr);
+SkCanvas* SkPictureRecorder::beginRecording(const SkRect& bounds, SkBBHFactory* factory,
+                                            uint32_t recordFlags) {
+    return this->beginRecording(bounds, factory ? (*factory)() : nullptr, recordFlags);
 }
 
 SkCanvas* SkPictureRecorder::getRecordingCanvas() {
@@ -74,6 +78,7 @@ sk_sp<SkPicture> SkPictureRecorder::finishRecordingAsPicture() {
         drawableList ? drawableList->newDrawableSnapshot() : nullptr
     };
 
+    std::unique_ptr<SkBitSet> occluded;
     if (fBBH) {
         SkAutoTMalloc<SkRect> bounds(fRecord->count());
         SkAutoTMalloc<SkBBoxHierarchy::Metadata> meta(fRecord->count());
@@ -81,6 +86,14 @@ sk_sp<SkPicture> SkPictureRecorder::finishRecordingAsPicture() {
 
         fBBH->insert(bounds, meta, fRecord->count());
 
+        // With the bounds at hand, find the draws that later draws will hide, if asked to.
+        if (fRecordFlags & kSkipOccludedDraws_RecordFlag) {
+            occluded = std::make_unique<SkBitSet>(fRecord->count());
+            if (SkRecordComputeOccluded(*fRecord, bounds, occluded.get()) == 0) {
+                occluded.reset();
+            }
+        }
+
         // Now that we've calculated content bounds, we can update fCullRect, often trimming it.
         SkRect bbhBound = SkRect::MakeEmpty();
         for (int i = 0; i < fRecord->count(); i++) {
@@ -99,6 +112,7 @@ sk_sp<SkPicture> SkPictureRecorder::finishRecordingAsPicture() {
                                     std::move(fRecord),
                                     std::move(pictList),
                                     std::move(fBBH),
+                                    std::move(occluded),
                                     subPictureBytes);
 }
 
@@ -7,6 +7,8 @@
 
 #include "src/core/SkRTree.h"
 
+#include "include/private/SkTo.h"
+
 SkRTree::SkRTree() : fCount(0) {}
 
 void SkRTree::insert(const SkRect boundsArray[], int N) {
@@ -170,3 +172,84 @@ size_t SkRTree::bytesUsed() const {
 
     return byteCount;
 }
+
+SkRTree::FlatBranch SkRTree::flatten(FlatNode nodes[]) const {
+    for (size_t i = 0; i < fNodes.size(); ++i) {
+        const Node& node = fNodes[i];
+        nodes[i].fNumChildren = node.fNumChildren;
+        nodes[i].fLevel = node.fLevel;
+        for (int j = 0; j < node.fNumChildren; ++j) {
+            const Branch& branch = node.fChildren[j];
+            nodes[i].fChildren[j].fIndex = 0 == node.fLevel
+                                                   ? SkToU32(branch.fOpIndex)
+                                                   : SkToU32(branch.fSubtree - fNodes.data());
+            nodes[i].fChildren[j].fBounds = branch.fBounds;
+        }
+        for (int j = node.fNumChildren; j < kMaxChildren; ++j) {
+            nodes[i].fChildren[j] = {0, SkRect::MakeEmpty()};
+        }
+    }
+    if (0 == fCount) {
+        return {0, SkRect::MakeEmpty()};
+    }
+    return {SkToU32(fRoot.fSubtree - fNodes.data()), fRoot.fBounds};
+}
+
+bool SkRTree::ValidateFlat(const FlatNode nodes[], int nodeCount, const FlatBranch& root,
+                           int opCount) {
+    // Deep enough for far more ops than fit in a picture.
+    static constexpr int kMaxLevel = 32;
+
+    if (0 == nodeCount) {
+        return true;
+    }
+    if (root.fIndex >= SkToU32(nodeCount) || nodes[root.fIndex].fLevel > kMaxLevel) {
+        return false;
+    }
+    // How many branches point at each node.  Levels alone would allow many branches to share
+    // one subtree, which a search would then visit exponentially many times.
+    std::vector<uint8_t> parents(nodeCount, 0);
+    for (int i = 0; i < nodeCount; ++i) {
+        const FlatNode& node = nodes[i];
+        if (node.fNumChildren < 1 || node.fNumChildren > kMaxChildren) {
+            return false;
+        }
+        for (int j = 0; j < node.fNumChildren; ++j) {
+            const uint32_t index = node.fChildren[j].fIndex;
+            if (0 == node.fLevel) {
+                if (index >= SkToU32(opCount)) {
+                    return false;
+                }
+            } else if (index >= SkToU32(nodeCount) || nodes[index].fLevel != node.fLevel - 1 ||
+                       parents[index]++ > 0) {
+                // Each step down a level guarantees that searches end, and each node having
+                // at most one parent that they visit it at most once.
+                return false;
+            }
+        }
+    }
+    // Every node but the root has exactly one parent, so it is a tree that reaches every node.
+    for (int i = 0; i < nodeCount; ++i) {
+        if (parents[i] != (SkToU32(i) == root.fIndex ? 0 : 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SkRTree::FlatSearch(const FlatNode nodes[], const FlatBranch& root, const SkRect& query,
+                         std::vector<int>* results) {
+    if (!SkRect::Intersects(root.fBounds, query)) {
+        return;
+    }
+    const FlatNode& node = nodes[root.fIndex];
+    for (int i = 0; i < node.fNumChildren; ++i) {
+        if (SkRect::Intersects(node.fChildren[i].fBounds, query)) {
+            if (0 == node.fLevel) {
+                results->push_back(SkToInt(node.fChildren[i].fIndex));
+            } else {
+                FlatSearch(nodes, node.fChildren[i], query, results);
+            }
+        }
+    }
+}
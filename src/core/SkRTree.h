@@ -46,6 +46,31 @@ public:
     static const int kMinChildren = 6,
                      kMaxChildren = 11;
 
+    // A flattened tree refers to its nodes by index rather than by pointer, so that it can be
+    // written out and searched in place, e.g. straight out of a mapped file (see SkMappedPicture).
+    struct FlatBranch {
+        uint32_t fIndex;    // Of a node, or of an op in a level 0 node.
+        SkRect   fBounds;
+    };
+
+    struct FlatNode {
+        uint16_t   fNumChildren;
+        uint16_t   fLevel;
+        FlatBranch fChildren[kMaxChildren];
+    };
+
+    int flatNodeCount() const { return (int)fNodes.size(); }
+
+    // Writes flatNodeCount() nodes to nodes, and returns the branch to search from.
+    FlatBranch flatten(FlatNode nodes[]) const;
+
+    // Returns true if nodes is a tree that FlatSearch() can safely search, whose op indices are all
+    // less than opCount.
+    static bool ValidateFlat(const FlatNode nodes[], int nodeCount, const FlatBranch& root,
+                             int opCount);
+    static void FlatSearch(const FlatNode nodes[], const FlatBranch& root, const SkRect& query,
+                           std::vector<int>* results);
+
 private:
     struct Node;
 
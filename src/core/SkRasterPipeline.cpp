@@ -363,27 +363,31 @@ void SkRasterPipeline::append_gamut_clamp_if_normalized(const SkImageInfo& info)
     }
 }
 
-SkRasterPipeline::StartPipelineFn SkRasterPipeline::build_pipeline(void** ip) const {
-    if (!gForceHighPrecisionRasterPipeline) {
-        // We'll try to build a lowp pipeline, but if that fails fallback to a highp float pipeline.
-        void** reset_point = ip;
+bool SkRasterPipeline::isLowp() const {
+    if (gForceHighPrecisionRasterPipeline || !fStages) {
+        return false;
+    }
+    for (const StageList* st = fStages; st; st = st->prev) {
+        if (!SkOpts::stages_lowp[st->stage]) {
+            return false;
+        }
+    }
+    return true;
+}
 
+SkRasterPipeline::StartPipelineFn SkRasterPipeline::build_pipeline(void** ip) const {
+    // We'll build a lowp pipeline if every stage has a lowp implementation,
+    // otherwise fall back to a highp float pipeline.
+    if (this->isLowp()) {
         // Stages are stored backwards in fStages, so we reverse here, back to front.
         *--ip = (void*)SkOpts::just_return_lowp;
         for (const StageList* st = fStages; st; st = st->prev) {
-            if (auto fn = SkOpts::stages_lowp[st->stage]) {
-                if (st->ctx) {
-                    *--ip = st->ctx;
-                }
-                *--ip = (void*)fn;
-            } else {
-                ip = reset_point;
-                break;
+            if (st->ctx) {
+                *--ip = st->ctx;
             }
+            *--ip = (void*)SkOpts::stages_lowp[st->stage];
         }
-        if (ip != reset_point) {
-            return SkOpts::start_pipeline_lowp;
-        }
+        return SkOpts::start_pipeline_lowp;
     }
 
     *--ip = (void*)SkOpts::just_return_highp;
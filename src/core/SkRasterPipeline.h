@@ -65,6 +65,7 @@ class SkData;
     M(alpha_to_red) M(alpha_to_red_dst)                            \
     M(bt709_luminance_or_luma_to_alpha) M(bt709_luminance_or_luma_to_rgb) \
     M(bilerp_clamp_8888) M(bicubic_clamp_8888)                     \
+    M(sample_yuva)                                                 \
     M(store_u16_be)                                                \
     M(load_src) M(store_src) M(store_src_a) M(load_dst) M(store_dst) \
     M(scale_u8) M(scale_565) M(scale_1_float) M(scale_native)      \
@@ -108,6 +109,7 @@ class SkData;
     M(byte_tables)                                                 \
     M(rgb_to_hsl) M(hsl_to_rgb)                                    \
     M(gauss_a_to_rgba)                                             \
+    M(blur_rect_coverage) M(blur_rrect_coverage)                   \
     M(emboss)                                                      \
     M(swizzle)
 
@@ -155,6 +157,28 @@ struct SkRasterPipeline_SamplerCtx2 : public SkRasterPipeline_GatherCtx {
     float invWidth, invHeight;
 };
 
+// 8-bit Y, U, V and (optionally) A planes, sampled with the image clamped to its edges, and the
+// row-major matrix from YUVA to RGBA.  Each channel's pixels point at its byte in its plane's
+// first pixel, and scaleX/scaleY take image coordinates to plane coordinates.  Subsampled
+// channels are always filtered, at the pixel's center when the image is sampled nearest, the
+// way libjpeg's fancy upsampling does.
+struct SkRasterPipeline_YUVACtx {
+    struct Channel {
+        const uint8_t* pixels;
+        int            stride;  // In bytes.
+        int            bpp;
+        float          width;
+        float          height;
+        float          scaleX;
+        float          scaleY;
+        bool           linear;
+        bool           snap;
+    };
+    Channel channels[4];
+    bool    hasAlpha;
+    float   matrix[20];
+};
+
 struct SkRasterPipeline_CallbackCtx {
     void (*fn)(SkRasterPipeline_CallbackCtx* self, int active_pixels/*<= SkRasterPipeline_kMaxStride*/);
 
@@ -184,6 +208,18 @@ struct SkRasterPipeline_2PtConicalCtx {
              fP1;
 };
 
+// Blurred rect (less an optional inner rect) or circular-cornered round rect, for the
+// blur_rect_coverage and blur_rrect_coverage stages.  invTwoSigma is 1/(2*sigma) of the blur,
+// and blur_rrect_coverage integrates over the corners in 'slices' steps.
+struct SkRasterPipeline_BlurRectCtx {
+    float l, t, r, b;
+    float innerL, innerT, innerR, innerB;
+    float radius;
+    float invTwoSigma;
+    int   slices;
+    bool  hasInner;
+};
+
 struct SkRasterPipeline_UniformColorCtx {
     float r,g,b,a;
     uint16_t rgba[4];  // [0,255] in a 16-bit lane.
@@ -255,6 +291,10 @@ public:
 
     bool empty() const { return fStages == nullptr; }
 
+    // Returns true if run() and compile() will use the 16-bit lowp stages for this pipeline,
+    // false if any stage needs the highp float stages (or highp has been forced).
+    bool isLowp() const;
+
 private:
     struct StageList {
         StageList* prev;
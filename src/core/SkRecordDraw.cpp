@@ -10,7 +10,9 @@
 #include "src/core/SkCanvasPriv.h"
 #include "src/core/SkColorFilterBase.h"
 #include "src/core/SkImageFilter_Base.h"
+#include "src/core/SkPaintPriv.h"
 #include "src/core/SkRecordDraw.h"
+#include "src/utils/SkBitSet.h"
 #include "src/utils/SkPatchUtils.h"
 
 void SkRecordDraw(const SkRecord& record,
@@ -19,7 +21,8 @@ void SkRecordDraw(const SkRecord& record,
                   SkDrawable* const drawables[],
                   int drawableCount,
                   const SkBBoxHierarchy* bbh,
-                  SkPicture::AbortCallback* callback) {
+                  SkPicture::AbortCallback* callback,
+                  const SkBitSet* occluded) {
     SkAutoCanvasRestore saveRestore(canvas, true /*save now, restore at exit*/);
 
     if (bbh) {
@@ -38,6 +41,9 @@ void SkRecordDraw(const SkRecord& record,
             if (callback && callback->abort()) {
                 return;
             }
+            if (occluded && occluded->test(ops[i])) {
+                continue;
+            }
             // This visit call uses the SkRecords::Draw::operator() to call
             // methods on the |canvas|, wrapped by methods defined with the
             // DRAW() macro.
@@ -50,6 +56,9 @@ void SkRecordDraw(const SkRecord& record,
             if (callback && callback->abort()) {
                 return;
             }
+            if (occluded && occluded->test(i)) {
+                continue;
+            }
             // This visit call uses the SkRecords::Draw::operator() to call
             // methods on the |canvas|, wrapped by methods defined with the
             // DRAW() macro.
@@ -559,3 +568,236 @@ void SkRecordFillBounds(const SkRect& cullRect, const SkRecord& record,
         }
     }
 }
+
+namespace SkRecords {
+
+// This is an SkRecord visitor that notes, for SkRecordComputeOccluded(), which draws could be
+// hidden by later draws, which draws are opaque enough to hide them, and which clip each op is
+// drawn under.
+//
+// Only draws outside of any saveLayer are considered: ops inside a layer cover its pixels, not
+// the canvas's.  A layer may also read the pixels drawn before it (backdrop filters, SaveBehind),
+// so SaveLayer and SaveBehind are barriers that no occluder may hide earlier draws across.  The clip is tracked as an id that changes with every clip op and is restored
+// along with the rest of the canvas state, so two draws with the same id are clipped the same.
+class FindOccluders : SkNoncopyable {
+public:
+    struct Op {
+        bool barrier  = false;  // An op that may read what was drawn before it.
+        bool hideable = false;  // A draw that can be skipped when something covers its bounds.
+        bool occluder = false;  // A draw that covers all of its bounds with opaque pixels.
+        int  clip     = 0;      // Clip this op is drawn under, 0 if there's no clip.
+        bool clipAA   = false;  // Whether that clip may only partially cover some pixels.
+    };
+
+    explicit FindOccluders(Op ops[]) : fOps(ops) {}
+
+    void setCurrentOp(int currentOp) { fCurrentOp = currentOp; }
+
+    template <typename T> void operator()(const T& op) {
+        this->updateCTM(op);
+        this->updateClip(op);
+
+        Op& info = fOps[fCurrentOp];
+        info.barrier = IsBarrier(op);
+        info.clip    = fClip;
+        info.clipAA  = fClipAA;
+        if ((T::kTags & kDraw_Tag) && fLayers == 0) {
+            info.hideable = IsHideable(op);
+            info.occluder = this->isOccluder(op);
+        }
+    }
+
+private:
+    struct SaveState {
+        int  clip;
+        bool clipAA;
+        bool isLayer;
+    };
+
+    // Only Restore, SetMatrix, Concat, and Translate change the CTM.
+    template <typename T> void updateCTM(const T&) {}
+    void updateCTM(const Restore& op)   { fCTM = op.matrix; }
+    void updateCTM(const SetMatrix& op) { fCTM = op.matrix; }
+    void updateCTM(const SetM44& op)    { fCTM = op.matrix.asM33(); }
+    void updateCTM(const Concat44& op)  { fCTM.preConcat(op.matrix.asM33()); }
+    void updateCTM(const Concat& op)    { fCTM.preConcat(op.matrix); }
+    void updateCTM(const Scale& op)     { fCTM.preScale(op.sx, op.sy); }
+    void updateCTM(const Translate& op) { fCTM.preTranslate(op.dx, op.dy); }
+
+    template <typename T> void updateClip(const T&) {}
+    void updateClip(const Save&)           { this->pushSave(false); }
+    void updateClip(const SaveLayer&)      { this->pushSave(true); }
+    void updateClip(const SaveBehind&)     { this->pushSave(true); }
+    void updateClip(const Restore&)        { this->popSave(); }
+    void updateClip(const ClipPath& op)    { this->clip(op.opAA.aa()); }
+    void updateClip(const ClipRRect& op)   { this->clip(op.opAA.aa()); }
+    void updateClip(const ClipRect& op)    { this->clip(op.opAA.aa()); }
+    void updateClip(const ClipRegion&)     { this->clip(false); }
+    void updateClip(const ClipShader&)     { this->clip(true); }
+    void updateClip(const ResetClip&)      { this->clip(false); fClipAA = false; }
+
+    void pushSave(bool isLayer) {
+        fSaveStack.push_back({fClip, fClipAA, isLayer});
+        fLayers += isLayer;
+    }
+
+    void popSave() {
+        if (fSaveStack.isEmpty()) {
+            return;
+        }
+        SaveState state;
+        fSaveStack.pop(&state);
+        fClip   = state.clip;
+        fClipAA = state.clipAA;
+        fLayers -= state.isLayer;
+    }
+
+    void clip(bool aa) {
+        fClip = ++fClipCount;
+        fClipAA |= aa;
+    }
+
+    template <typename T> static bool IsBarrier(const T&) { return false; }
+    static bool IsBarrier(const SaveLayer&)  { return true; }
+    static bool IsBarrier(const SaveBehind&) { return true; }
+
+    // Any draw could be hidden, except for those that may have effects other than their pixels,
+    // or whose bounds don't include every pixel they touch.
+    template <typename T> static bool IsHideable(const T&) { return true; }
+    static bool IsHideable(const DrawDrawable&) { return false; }
+    static bool IsHideable(const DrawPicture&)  { return false; }  // May draw outside its cull.
+    static bool IsHideable(const DrawPoints&)   { return false; }  // Hairlines may outgrow bounds.
+
+    // Only draws whose bounds are exactly the (opaque) pixels they fill can hide others.
+    template <typename T> bool isOccluder(const T&) const { return false; }
+    bool isOccluder(const DrawPaint& op) const {
+        return Overwrites(&op.paint, SkPaintPriv::kNone_ShaderOverrideOpacity);
+    }
+    bool isOccluder(const DrawRect& op) const {
+        return fCTM.rectStaysRect()
+            && op.paint.getStyle() == SkPaint::kFill_Style
+            && Overwrites(&op.paint, SkPaintPriv::kNone_ShaderOverrideOpacity);
+    }
+    bool isOccluder(const DrawImage& op) const {
+        return fCTM.rectStaysRect()
+            && op.image->isOpaque()
+            && Overwrites(op.paint, SkPaintPriv::kOpaque_ShaderOverrideOpacity);
+    }
+    bool isOccluder(const DrawImageRect& op) const {
+        return fCTM.rectStaysRect()
+            && op.image->isOpaque()
+            && SkRect::Make(op.image->bounds()).contains(op.src)
+            && Overwrites(op.paint, SkPaintPriv::kOpaque_ShaderOverrideOpacity);
+    }
+
+    static bool Overwrites(const SkPaint* paint, SkPaintPriv::ShaderOverrideOpacity opacity) {
+        if (paint && (paint->getPathEffect() || paint->getMaskFilter() ||
+                      paint->getImageFilter())) {
+            return false;
+        }
+        return SkPaintPriv::Overwrites(paint, opacity);
+    }
+
+    Op*                  fOps;
+    int                  fCurrentOp = 0;
+    SkMatrix             fCTM;
+    int                  fClip = 0;
+    int                  fClipCount = 0;
+    bool                 fClipAA = false;
+    int                  fLayers = 0;
+    SkTDArray<SaveState> fSaveStack;
+};
+
+}  // namespace SkRecords
+
+int SkRecordComputeOccluded(const SkRecord& record, const SkRect bounds[], SkBitSet* occluded) {
+    SkASSERT(occluded->size() == (size_t)record.count());
+
+    SkAutoTArray<SkRecords::FindOccluders::Op> ops(record.count());
+    {
+        SkRecords::FindOccluders visitor(ops.get());
+        for (int i = 0; i < record.count(); i++) {
+            visitor.setCurrentOp(i);
+            record.visit(i, visitor);
+        }
+    }
+
+    // Walk back through the record, keeping the largest few occluders we've seen so far.
+    // They're kept as arrays of their edges, so every draw is tested against all of them at
+    // once, without branching.  Unused slots are inverted rects that contain nothing.
+    constexpr int kMaxOccluders = 8;
+    SkScalar left  [kMaxOccluders], top   [kMaxOccluders],
+             right [kMaxOccluders], bottom[kMaxOccluders],
+             area  [kMaxOccluders];
+    int      clip  [kMaxOccluders];
+    auto clearOccluders = [&] {
+        for (int j = 0; j < kMaxOccluders; j++) {
+            left [j] = top   [j] =  SK_ScalarInfinity;
+            right[j] = bottom[j] = -SK_ScalarInfinity;
+            area [j] = 0;
+            clip [j] = 0;
+        }
+    };
+    clearOccluders();
+    int smallest = 0;
+
+    int found = 0;
+    for (int i = record.count() - 1; i >= 0; i--) {
+        const SkRecords::FindOccluders::Op& op = ops[i];
+        if (op.barrier) {
+            clearOccluders();
+            smallest = 0;
+            continue;
+        }
+        const SkRect& r = bounds[i];
+        if (op.hideable && !r.isEmpty()) {
+            // An occluder under no clip hides the draw wherever the draw is clipped to.
+            // Otherwise they must share the same clip.
+            int hidden = 0;
+            for (int j = 0; j < kMaxOccluders; j++) {
+                hidden |= (left [j] <= r.fLeft ) & (top   [j] <= r.fTop   )
+                        & (right[j] >= r.fRight) & (bottom[j] >= r.fBottom)
+                        & ((clip[j] == 0) | (clip[j] == op.clip));
+            }
+            if (hidden) {
+                occluded->set(i);
+                found++;
+                continue;
+            }
+        }
+
+        // Pixels partially covered by an anti-aliased clip still show what's under them.
+        // The inset keeps anti-aliased edges of the occluder from counting as covered.
+        if (op.occluder && !op.clipAA) {
+            const SkRect rect = r.makeInset(1, 1);
+            if (rect.isEmpty() || rect.width() * rect.height() <= area[smallest]) {
+                continue;
+            }
+            left  [smallest] = rect.fLeft;
+            top   [smallest] = rect.fTop;
+            right [smallest] = rect.fRight;
+            bottom[smallest] = rect.fBottom;
+            area  [smallest] = rect.width() * rect.height();
+            clip  [smallest] = op.clip;
+            for (int j = 0; j < kMaxOccluders; j++) {
+                if (area[j] < area[smallest]) {
+                    smallest = j;
+                }
+            }
+        }
+    }
+    return found;
+}
+
+bool SkRecordCanSkipOccluded(const SkCanvas* canvas) {
+    // Canvases without pixels (recorders, documents) keep every op.
+    if (canvas->imageInfo().colorType() == kUnknown_SkColorType) {
+        return false;
+    }
+    // Occluders are inset by one unit, which must cover at least a pixel in each direction.
+    const SkMatrix ctm = canvas->getTotalMatrix();
+    if (!ctm.rectStaysRect() || ctm.getMinScale() < 1) {
+        return false;
+    }
+    return !SkCanvasPriv::IsClipAA(canvas);
+}
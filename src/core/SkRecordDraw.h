@@ -14,6 +14,7 @@
 #include "src/core/SkBigPicture.h"
 #include "src/core/SkRecord.h"
 
+class SkBitSet;
 class SkDrawable;
 class SkLayerInfo;
 
@@ -27,10 +28,21 @@ void SkRecordFillBounds(const SkRect& cullRect, const SkRecord&,
 void SkRecordComputeLayers(const SkRect& cullRect, const SkRecord&, SkRect bounds[],
                            const SkBigPicture::SnapshotArray*, SkLayerInfo* data);
 
+// Find the draws in the record that are entirely covered by a later opaque draw, given the
+// bounds from SkRecordFillBounds(), and set their bits in occluded.  Returns how many were found.
+// Covering draws are inset by one unit first, so skipping the covered draws changes no pixels as
+// long as the record is drawn at a scale of at least one (see SkRecordCanSkipOccluded()).
+int SkRecordComputeOccluded(const SkRecord&, const SkRect bounds[], SkBitSet* occluded);
+
+// Returns true if the draws found by SkRecordComputeOccluded() may be skipped on this canvas.
+bool SkRecordCanSkipOccluded(const SkCanvas*);
+
 // Draw an SkRecord into an SkCanvas.  A convenience wrapper around SkRecords::Draw.
+// If occluded is set, the ops whose bits are set in it are skipped.
 void SkRecordDraw(const SkRecord&, SkCanvas*, SkPicture const* const drawablePicts[],
                   SkDrawable* const drawables[], int drawableCount,
-                  const SkBBoxHierarchy*, SkPicture::AbortCallback*);
+                  const SkBBoxHierarchy*, SkPicture::AbortCallback*,
+                  const SkBitSet* occluded = nullptr);
 
 // Draw a portion of an SkRecord into an SkCanvas.
 // When drawing a portion of an SkRecord the CTM on the passed in canvas must be
@@ -47,7 +47,8 @@ SkPicture* SkRecordedDrawable::onNewPictureSnapshot() {
     for (int i = 0; pictList && i < pictList->count(); i++) {
         subPictureBytes += pictList->begin()[i]->approximateBytesUsed();
     }
-    return new SkBigPicture(fBounds, fRecord, std::move(pictList), fBBH, subPictureBytes);
+    return new SkBigPicture(fBounds, fRecord, std::move(pictList), fBBH, nullptr,
+                            subPictureBytes);
 }
 
 void SkRecordedDrawable::flatten(SkWriteBuffer& buffer) const {
@@ -77,6 +77,7 @@ void SkRecorder::reset(SkRecord* record, const SkRect& bounds, SkMiniRecorder* m
     this->resetCanvas(safe_picture_bounds(bounds));
     SkASSERT(this->imageInfo().width() >= 0 && this->imageInfo().height() >= 0);
     fMiniRecorder = mr;
+    fSaveDraws.reset();
 }
 
 void SkRecorder::forgetRecord() {
@@ -91,6 +92,12 @@ void SkRecorder::append(Args&&... args) {
     if (fMiniRecorder) {
         this->flushMiniRecorder();
     }
+    if constexpr ((T::kTags & SkRecords::kDraw_Tag) != 0) {
+        // Let a surface that defers its draws through us know its contents are about to change.
+        if (!this->predrawNotify()) {
+            return;
+        }
+    }
     new (fRecord->append<T>()) T{std::forward<Args>(args)...};
 }
 
@@ -316,10 +323,12 @@ void SkRecorder::onFlush() {
 }
 
 void SkRecorder::willSave() {
+    fSaveDraws.push_back(false);
     this->append<SkRecords::Save>();
 }
 
 SkCanvas::SaveLayerStrategy SkRecorder::getSaveLayerStrategy(const SaveLayerRec& rec) {
+    fSaveDraws.push_back(true);
     this->append<SkRecords::SaveLayer>(this->copy(rec.fBounds)
                     , this->copy(rec.fPaint)
                     , sk_ref_sp(rec.fBackdrop)
@@ -329,11 +338,20 @@ SkCanvas::SaveLayerStrategy SkRecorder::getSaveLayerStrategy(const SaveLayerRec&
 }
 
 bool SkRecorder::onDoSaveBehind(const SkRect* subset) {
+    fSaveDraws.push_back(true);
     this->append<SkRecords::SaveBehind>(this->copy(subset));
     return false;
 }
 
 void SkRecorder::didRestore() {
+    // Restoring a layer (or a saveBehind) draws it, so that's when the surface's contents change.
+    // Unlike a draw, the restore is recorded regardless, to keep the record's saves balanced.
+    if (!fSaveDraws.isEmpty()) {
+        if (fSaveDraws.back()) {
+            this->predrawNotify();
+        }
+        fSaveDraws.pop();
+    }
     this->append<SkRecords::Restore>(this->getTotalMatrix());
 }
 
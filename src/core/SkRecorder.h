@@ -136,6 +136,9 @@ private:
     std::unique_ptr<SkDrawableList> fDrawableList;
 
     SkMiniRecorder* fMiniRecorder;
+
+    // One entry per open save, true if restoring it draws (a saveLayer or saveBehind).
+    SkTDArray<bool> fSaveDraws;
 };
 
 #endif//SkRecorder_DEFINED
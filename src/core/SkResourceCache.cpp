@@ -12,6 +12,7 @@
 #include "include/private/SkTo.h"
 #include "src/core/SkDiscardableMemory.h"
 #include "src/core/SkImageFilter_Base.h"
+#include "src/core/SkMathPriv.h"
 #include "src/core/SkMessageBus.h"
 #include "src/core/SkMipmap.h"
 #include "src/core/SkOpts.h"
@@ -84,23 +85,33 @@ void SkResourceCache::init() {
     fHash = new Hash;
     fTotalBytesUsed = 0;
     fCount = 0;
-    fSingleAllocationByteLimit = 0;
 
-    // One of these should be explicit set by the caller after we return.
-    fTotalByteLimit = 0;
+    // These should be explicit set by the caller after we return.
+    fBudget = nullptr;
     fDiscardableFactory = nullptr;
 }
 
 SkResourceCache::SkResourceCache(DiscardableFactory factory)
         : fPurgeSharedIDInbox(SK_InvalidUniqueID) {
     this->init();
+    fOwnedBudget = std::make_unique<Budget>();
+    fBudget = fOwnedBudget.get();
     fDiscardableFactory = factory;
 }
 
 SkResourceCache::SkResourceCache(size_t byteLimit)
         : fPurgeSharedIDInbox(SK_InvalidUniqueID) {
     this->init();
-    fTotalByteLimit = byteLimit;
+    fOwnedBudget = std::make_unique<Budget>();
+    fBudget = fOwnedBudget.get();
+    fBudget->fByteLimit.store(byteLimit, std::memory_order_relaxed);
+}
+
+SkResourceCache::SkResourceCache(DiscardableFactory factory, Budget* sharedBudget)
+        : fPurgeSharedIDInbox(SK_InvalidUniqueID) {
+    this->init();
+    fBudget = sharedBudget;
+    fDiscardableFactory = factory;
 }
 
 SkResourceCache::~SkResourceCache() {
@@ -174,7 +185,10 @@ void SkResourceCache::add(Rec* rec, void* payload) {
     }
 
     // since the new rec may push us over-budget, we perform a purge check now
-    this->purgeAsNeeded();
+    // (unless we're sharing our budget, in which case Shards::purgeAsNeeded() decides who purges)
+    if (fOwnedBudget) {
+        this->purgeAsNeeded();
+    }
 }
 
 void SkResourceCache::remove(Rec* rec) {
@@ -187,6 +201,8 @@ void SkResourceCache::remove(Rec* rec) {
 
     fTotalBytesUsed -= used;
     fCount -= 1;
+    fBudget->fBytesUsed.fetch_sub(used, std::memory_order_relaxed);
+    fBudget->fCount.fetch_sub(1, std::memory_order_relaxed);
 
     //SkDebugf("-RC count [%3d] bytes %d\n", fCount, fTotalBytesUsed);
 
@@ -201,7 +217,7 @@ void SkResourceCache::remove(Rec* rec) {
     delete rec;
 }
 
-void SkResourceCache::purgeAsNeeded(bool forcePurge) {
+bool SkResourceCache::overBudget() const {
     size_t byteLimit;
     int    countLimit;
 
@@ -210,12 +226,18 @@ void SkResourceCache::purgeAsNeeded(bool forcePurge) {
         byteLimit = UINT32_MAX;  // no limit based on bytes
     } else {
         countLimit = SK_MaxS32; // no limit based on count
-        byteLimit = fTotalByteLimit;
+        byteLimit = fBudget->fByteLimit.load(std::memory_order_relaxed);
     }
 
+    return fBudget->fBytesUsed.load(std::memory_order_relaxed) >= byteLimit
+        || fBudget->fCount    .load(std::memory_order_relaxed) >= countLimit;
+}
+
+void SkResourceCache::purgeAsNeeded(bool forcePurge) {
+    // When we share our budget, we can only purge our own Recs.  See Shards::purgeAsNeeded().
     Rec* rec = fTail;
     while (rec) {
-        if (!forcePurge && fTotalBytesUsed < byteLimit && fCount < countLimit) {
+        if (!forcePurge && !this->overBudget()) {
             break;
         }
 
@@ -227,6 +249,16 @@ void SkResourceCache::purgeAsNeeded(bool forcePurge) {
     }
 }
 
+bool SkResourceCache::purgeLeastRecentlyUsed() {
+    for (Rec* rec = fTail; rec; rec = rec->fPrev) {
+        if (rec->canBePurged()) {
+            this->remove(rec);
+            return true;
+        }
+    }
+    return false;
+}
+
 //#define SK_TRACK_PURGE_SHAREDID_HITRATE
 
 #ifdef SK_TRACK_PURGE_SHAREDID_HITRATE
@@ -284,25 +316,27 @@ void SkResourceCache::visitAll(Visitor visitor, void* context) {
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
 size_t SkResourceCache::setTotalByteLimit(size_t newLimit) {
-    size_t prevLimit = fTotalByteLimit;
-    fTotalByteLimit = newLimit;
+    size_t prevLimit = fBudget->fByteLimit.exchange(newLimit, std::memory_order_relaxed);
     if (newLimit < prevLimit) {
         this->purgeAsNeeded();
     }
     return prevLimit;
 }
 
-SkCachedData* SkResourceCache::newCachedData(size_t bytes) {
-    this->checkMessages();
-
-    if (fDiscardableFactory) {
-        SkDiscardableMemory* dm = fDiscardableFactory(bytes);
+static SkCachedData* new_cached_data(SkResourceCache::DiscardableFactory factory, size_t bytes) {
+    if (factory) {
+        SkDiscardableMemory* dm = factory(bytes);
         return dm ? new SkCachedData(bytes, dm) : nullptr;
     } else {
         return new SkCachedData(sk_malloc_throw(bytes), bytes);
     }
 }
 
+SkCachedData* SkResourceCache::newCachedData(size_t bytes) {
+    this->checkMessages();
+    return new_cached_data(fDiscardableFactory, bytes);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 void SkResourceCache::release(Rec* rec) {
@@ -323,10 +357,17 @@ void SkResourceCache::release(Rec* rec) {
     }
 
     rec->fNext = rec->fPrev = nullptr;
+    this->updateOldestUse();
+}
+
+void SkResourceCache::updateOldestUse() {
+    fOldestUse.store(fTail ? fTail->fLastUse : UINT64_MAX, std::memory_order_relaxed);
 }
 
 void SkResourceCache::moveToHead(Rec* rec) {
+    rec->fLastUse = fBudget->fUseCount.fetch_add(1, std::memory_order_relaxed);
     if (fHead == rec) {
+        this->updateOldestUse();  // We may also be the tail.
         return;
     }
 
@@ -340,6 +381,7 @@ void SkResourceCache::moveToHead(Rec* rec) {
     fHead->fPrev = rec;
     rec->fNext = fHead;
     fHead = rec;
+    this->updateOldestUse();
 
     this->validate();
 }
@@ -356,8 +398,12 @@ void SkResourceCache::addToHead(Rec* rec) {
     if (!fTail) {
         fTail = rec;
     }
+    rec->fLastUse = fBudget->fUseCount.fetch_add(1, std::memory_order_relaxed);
+    this->updateOldestUse();
     fTotalBytesUsed += rec->bytesUsed();
     fCount += 1;
+    fBudget->fBytesUsed.fetch_add(rec->bytesUsed(), std::memory_order_relaxed);
+    fBudget->fCount.fetch_add(1, std::memory_order_relaxed);
 
     this->validate();
 }
@@ -417,26 +463,24 @@ void SkResourceCache::dump() const {
 }
 
 size_t SkResourceCache::setSingleAllocationByteLimit(size_t newLimit) {
-    size_t oldLimit = fSingleAllocationByteLimit;
-    fSingleAllocationByteLimit = newLimit;
-    return oldLimit;
+    return fBudget->fSingleAllocationByteLimit.exchange(newLimit, std::memory_order_relaxed);
 }
 
 size_t SkResourceCache::getSingleAllocationByteLimit() const {
-    return fSingleAllocationByteLimit;
+    return fBudget->fSingleAllocationByteLimit.load(std::memory_order_relaxed);
 }
 
 size_t SkResourceCache::getEffectiveSingleAllocationByteLimit() const {
     // fSingleAllocationByteLimit == 0 means the caller is asking for our default
-    size_t limit = fSingleAllocationByteLimit;
+    size_t limit = this->getSingleAllocationByteLimit();
 
     // if we're not discardable (i.e. we are fixed-budget) then cap the single-limit
     // to our budget.
     if (nullptr == fDiscardableFactory) {
         if (0 == limit) {
-            limit = fTotalByteLimit;
+            limit = this->getTotalByteLimit();
         } else {
-            limit = std::min(limit, fTotalByteLimit);
+            limit = std::min(limit, this->getTotalByteLimit());
         }
     }
     return limit;
@@ -452,99 +496,188 @@ void SkResourceCache::checkMessages() {
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static SkResourceCache* gResourceCache = nullptr;
-static SkMutex& resource_cache_mutex() {
-    static SkMutex& mutex = *(new SkMutex);
-    return mutex;
-}
+// This can be defined by the caller's build system.  Must be a power of two.
+#ifndef SK_RESOURCE_CACHE_SHARD_COUNT
+    #define SK_RESOURCE_CACHE_SHARD_COUNT 16
+#endif
+
+/**
+ *  The global cache, split into shards by key hash so that threads looking up different keys
+ *  rarely contend for the same lock.  Each shard is an SkResourceCache with its own mutex and
+ *  LRU list, and all the shards share one Budget.  The Budget also numbers every add and find,
+ *  and each shard publishes the number of its least recently used Rec, so when we go over budget
+ *  we can purge the least recently used Rec of the whole cache, as an unsharded cache would.
+ */
+class SkResourceCache::Shards {
+public:
+    static Shards* Get() {
+        static Shards* shards = new Shards;
+        return shards;
+    }
+
+    struct Shard {
+        SkMutex                          fMutex;
+        std::unique_ptr<SkResourceCache> fCache;
+    };
+
+    Shard& shardFor(const Key& key) {
+        // SkTHashTable indexes its slots with the low bits of the hash, so we use the high bits.
+        return fShards[kShardBits ? key.hash() >> (32 - kShardBits) : 0];
+    }
 
-/** Must hold resource_cache_mutex() when calling. */
-static SkResourceCache* get_cache() {
-    // resource_cache_mutex() is always held when this is called, so we don't need to be fancy in here.
-    resource_cache_mutex().assertHeld();
-    if (nullptr == gResourceCache) {
+    // Any shard will do for the shared budget or the (also shared, unchanging) discardable
+    // factory.  These are safe to use without holding that shard's mutex.
+    SkResourceCache* any() { return fShards[0].fCache.get(); }
+
+    // Set when a purge message is posted, so CheckMessages() only locks every shard when there
+    // may be something for them.  (Each shard also checks its own inbox whenever it's used.)
+    std::atomic<bool> fMessagesPending{false};
+
+    template <typename Fn>
+    void forEach(Fn&& fn) {
+        for (Shard& shard : fShards) {
+            SkAutoMutexExclusive am(shard.fMutex);
+            fn(shard.fCache.get());
+        }
+    }
+
+    // Until we're back under budget, purge the least recently used Rec of any shard.  Stops
+    // early once no shard has anything left to purge.  Must not hold any shard's mutex.
+    void purgeAsNeeded() {
+        bool exhausted[kShardCount] = {};  // Shards we've found have nothing they can purge.
+        while (this->any()->overBudget()) {
+            Shard* oldest = nullptr;
+            uint64_t oldestUse = UINT64_MAX;
+            for (int i = 0; i < kShardCount; ++i) {
+                uint64_t use = fShards[i].fCache->fOldestUse.load(std::memory_order_relaxed);
+                if (!exhausted[i] && use < oldestUse) {
+                    oldest = &fShards[i];
+                    oldestUse = use;
+                }
+            }
+            if (!oldest) {
+                break;
+            }
+            SkAutoMutexExclusive am(oldest->fMutex);
+            if (!oldest->fCache->purgeLeastRecentlyUsed()) {
+                exhausted[oldest - fShards] = true;
+            }
+        }
+    }
+
+    size_t setTotalByteLimit(size_t newLimit) {
+        size_t prevLimit = fBudget.fByteLimit.exchange(newLimit, std::memory_order_relaxed);
+        if (newLimit < prevLimit) {
+            this->purgeAsNeeded();
+        }
+        return prevLimit;
+    }
+
+private:
+    static constexpr int kShardBits  = SkNextLog2_portable(SK_RESOURCE_CACHE_SHARD_COUNT);
+    static constexpr int kShardCount = 1 << kShardBits;
+    static_assert(kShardCount == SK_RESOURCE_CACHE_SHARD_COUNT,
+                  "SK_RESOURCE_CACHE_SHARD_COUNT must be a power of two");
+
+    Shards() {
 #ifdef SK_USE_DISCARDABLE_SCALEDIMAGECACHE
-        gResourceCache = new SkResourceCache(SkDiscardableMemory::Create);
+        DiscardableFactory factory = SkDiscardableMemory::Create;
 #else
-        gResourceCache = new SkResourceCache(SK_DEFAULT_IMAGE_CACHE_LIMIT);
+        DiscardableFactory factory = nullptr;
+        fBudget.fByteLimit.store(SK_DEFAULT_IMAGE_CACHE_LIMIT, std::memory_order_relaxed);
 #endif
+        for (Shard& shard : fShards) {
+            shard.fCache.reset(new SkResourceCache(factory, &fBudget));
+        }
     }
-    return gResourceCache;
-}
+
+    Budget fBudget;
+    Shard  fShards[kShardCount];
+};
 
 size_t SkResourceCache::GetTotalBytesUsed() {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->getTotalBytesUsed();
+    return Shards::Get()->any()->fBudget->fBytesUsed.load(std::memory_order_relaxed);
 }
 
 size_t SkResourceCache::GetTotalByteLimit() {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->getTotalByteLimit();
+    return Shards::Get()->any()->getTotalByteLimit();
 }
 
 size_t SkResourceCache::SetTotalByteLimit(size_t newLimit) {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->setTotalByteLimit(newLimit);
+    return Shards::Get()->setTotalByteLimit(newLimit);
 }
 
 SkResourceCache::DiscardableFactory SkResourceCache::GetDiscardableFactory() {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->discardableFactory();
+    return Shards::Get()->any()->discardableFactory();
 }
 
 SkCachedData* SkResourceCache::NewCachedData(size_t bytes) {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->newCachedData(bytes);
+    CheckMessages();
+    return new_cached_data(GetDiscardableFactory(), bytes);
 }
 
 void SkResourceCache::Dump() {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    get_cache()->dump();
+    int    count = 0;
+    size_t bytes = 0;
+    Shards::Get()->forEach([&](SkResourceCache* cache) {
+        cache->validate();
+        count += cache->fCount;
+        bytes += cache->fTotalBytesUsed;
+    });
+    SkDebugf("SkResourceCache: count=%d bytes=%zu %s\n",
+             count, bytes, GetDiscardableFactory() ? "discardable" : "malloc");
 }
 
 size_t SkResourceCache::SetSingleAllocationByteLimit(size_t size) {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->setSingleAllocationByteLimit(size);
+    // All the shards share this limit, so setting it through any of them sets it for all.
+    return Shards::Get()->any()->setSingleAllocationByteLimit(size);
 }
 
 size_t SkResourceCache::GetSingleAllocationByteLimit() {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->getSingleAllocationByteLimit();
+    return Shards::Get()->any()->getSingleAllocationByteLimit();
 }
 
 size_t SkResourceCache::GetEffectiveSingleAllocationByteLimit() {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->getEffectiveSingleAllocationByteLimit();
+    return Shards::Get()->any()->getEffectiveSingleAllocationByteLimit();
 }
 
 void SkResourceCache::PurgeAll() {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->purgeAll();
+    Shards::Get()->forEach([](SkResourceCache* cache) { cache->purgeAll(); });
 }
 
 void SkResourceCache::CheckMessages() {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->checkMessages();
+    // Every shard has its own inbox, and each purge message is delivered to all of them.
+    Shards* shards = Shards::Get();
+    if (shards->fMessagesPending.exchange(false, std::memory_order_acquire)) {
+        shards->forEach([](SkResourceCache* cache) { cache->checkMessages(); });
+    }
 }
 
 bool SkResourceCache::Find(const Key& key, FindVisitor visitor, void* context) {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->find(key, visitor, context);
+    Shards::Shard& shard = Shards::Get()->shardFor(key);
+    SkAutoMutexExclusive am(shard.fMutex);
+    return shard.fCache->find(key, visitor, context);
 }
 
 void SkResourceCache::Add(Rec* rec, void* payload) {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    get_cache()->add(rec, payload);
+    Shards* shards = Shards::Get();
+    {
+        Shards::Shard& shard = shards->shardFor(rec->getKey());
+        SkAutoMutexExclusive am(shard.fMutex);
+        shard.fCache->add(rec, payload);
+    }
+    // Since the new rec may push us over-budget, we perform a purge check now.
+    shards->purgeAsNeeded();
 }
 
 void SkResourceCache::VisitAll(Visitor visitor, void* context) {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    get_cache()->visitAll(visitor, context);
+    Shards::Get()->forEach([&](SkResourceCache* cache) { cache->visitAll(visitor, context); });
 }
 
 void SkResourceCache::PostPurgeSharedID(uint64_t sharedID) {
     if (sharedID) {
         SkMessageBus<PurgeSharedIDMessage, uint32_t>::Post(PurgeSharedIDMessage(sharedID));
+        Shards::Get()->fMessagesPending.store(true, std::memory_order_release);
     }
 }
 
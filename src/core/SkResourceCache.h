@@ -12,6 +12,9 @@
 #include "include/private/SkTDArray.h"
 #include "src/core/SkMessageBus.h"
 
+#include <atomic>
+#include <memory>
+
 class SkCachedData;
 class SkDiscardableMemory;
 class SkTraceMemoryDump;
@@ -25,6 +28,8 @@ class SkTraceMemoryDump;
  *
  *  As a convenience, a global instance is also defined, which can be safely
  *  access across threads via the static methods (e.g. FindAndLock, etc.).
+ *  The global instance is split by key hash into shards, each with its own lock and LRU list,
+ *  all purging against one shared budget.
  */
 class SkResourceCache {
 public:
@@ -103,8 +108,9 @@ public:
         virtual SkDiscardableMemory* diagnostic_only_getDiscardable() const { return nullptr; }
 
     private:
-        Rec*    fNext;
-        Rec*    fPrev;
+        Rec*     fNext;
+        Rec*     fPrev;
+        uint64_t fLastUse;  // When this was last added or found, from Budget::fUseCount.
 
         friend class SkResourceCache;
     };
@@ -222,7 +228,7 @@ public:
     void visitAll(Visitor, void* context);
 
     size_t getTotalBytesUsed() const { return fTotalBytesUsed; }
-    size_t getTotalByteLimit() const { return fTotalByteLimit; }
+    size_t getTotalByteLimit() const { return fBudget->fByteLimit.load(std::memory_order_relaxed); }
 
     /**
      *  This is respected by SkBitmapProcState::possiblyScaleImage.
@@ -258,29 +264,55 @@ public:
     void dump() const;
 
 private:
+    // What a cache purges against.  A standalone cache owns its Budget;
+    // the shards of the global cache all share one.
+    struct Budget {
+        std::atomic<size_t> fBytesUsed{0};
+        std::atomic<int>    fCount{0};
+        std::atomic<size_t> fByteLimit{0};
+        std::atomic<size_t> fSingleAllocationByteLimit{0};
+        // Counts adds and finds, to order the Recs of all the caches sharing this by last use.
+        std::atomic<uint64_t> fUseCount{0};
+    };
+
+    // The global cache.
+    class Shards;
+
+    // Construct one shard of the global cache.
+    SkResourceCache(DiscardableFactory, Budget*);
+
     Rec*    fHead;
     Rec*    fTail;
+    // fTail's fLastUse, or UINT64_MAX if we're empty.  Read without our owner's lock to find the
+    // cache sharing our Budget with the least recently used Rec.
+    std::atomic<uint64_t> fOldestUse{UINT64_MAX};
 
     class Hash;
     Hash*   fHash;
 
     DiscardableFactory  fDiscardableFactory;
 
+    std::unique_ptr<Budget> fOwnedBudget;
+    Budget*                 fBudget;
+
+    // Just the Recs in this cache, which may be one of several sharing fBudget.
     size_t  fTotalBytesUsed;
-    size_t  fTotalByteLimit;
-    size_t  fSingleAllocationByteLimit;
     int     fCount;
 
     SkMessageBus<PurgeSharedIDMessage, uint32_t>::Inbox fPurgeSharedIDInbox;
 
     void checkMessages();
+    bool overBudget() const;
     void purgeAsNeeded(bool forcePurge = false);
+    // Purges the least recently used Rec that can be purged, returning false if there was none.
+    bool purgeLeastRecentlyUsed();
 
     // linklist management
     void moveToHead(Rec*);
     void addToHead(Rec*);
     void release(Rec*);
     void remove(Rec*);
+    void updateOldestUse();
 
     void init();    // called by constructors
 
@@ -6,8 +6,11 @@
  */
 
 #include "include/core/SkExecutor.h"
+#include "include/private/SkTPin.h"
 #include "src/core/SkTaskGroup.h"
 
+#include <algorithm>
+
 SkTaskGroup::SkTaskGroup(SkExecutor& executor) : fPending(0), fExecutor(executor) {}
 
 void SkTaskGroup::add(std::function<void(void)> fn) {
@@ -19,14 +22,37 @@ void SkTaskGroup::add(std::function<void(void)> fn) {
 }
 
 void SkTaskGroup::batch(int N, std::function<void(int)> fn) {
-    // TODO: I really thought we had some sort of more clever chunking logic.
-    fPending.fetch_add(+N, std::memory_order_relaxed);
-    for (int i = 0; i < N; i++) {
-        fExecutor.add([=] {
-            fn(i);
-            fPending.fetch_add(-1, std::memory_order_release);
-        });
+    if (N <= 0) {
+        return;
     }
+    // We never split the batch into more than about this many pieces.
+    // Small batches still get one task per call to fn.
+    static constexpr int kMaxPieces = 256;
+
+    this->addRange(0, N, std::max(1, N / kMaxPieces),
+                   std::make_shared<const std::function<void(int)>>(std::move(fn)));
+}
+
+void SkTaskGroup::addRange(int start, int end, int grain,
+                           std::shared_ptr<const std::function<void(int)>> fn) {
+    fPending.fetch_add(+1, std::memory_order_relaxed);
+    fExecutor.add([=] {
+        // Keep splitting off the front half of our range as a new task until what's left is
+        // small enough to run here.  The biggest halves get added first, and a work-stealing
+        // executor hands out its oldest work first, so idle threads steal big pieces.  An
+        // executor that runs work as soon as it's added (like the default one) thus calls fn
+        // in index order, as it would for N separate add()s.
+        int s = start;
+        while (end - s > grain) {
+            int mid = s + (end - s) / 2;
+            this->addRange(s, mid, grain, fn);
+            s = mid;
+        }
+        for (int i = s; i < end; i++) {
+            (*fn)(i);
+        }
+        fPending.fetch_add(-1, std::memory_order_release);
+    });
 }
 
 bool SkTaskGroup::done() const {
@@ -43,6 +69,37 @@ void SkTaskGroup::wait() {
     }
 }
 
+int SkRowBanding::bandCount(int rows, int64_t area) const {
+    if (!this->worthSplitting(area)) {
+        return 1;
+    }
+    return SkTPin(rows / fMinBandRows, 1, fMaxBands);
+}
+
+void SkRowBanding::Run(SkExecutor* executor, int rows, int bandCount, int rowAlign,
+                       const std::function<void(int band, int y0, int y1)>& fn) {
+    SkASSERT(bandCount >= 1 && rowAlign >= 1);
+    int bandRows = (rows + bandCount - 1) / bandCount;
+    bandRows = (bandRows + rowAlign - 1) / rowAlign * rowAlign;
+    auto runBand = [&](int band) {
+        int y0 = band * bandRows,
+            y1 = std::min(rows, y0 + bandRows);
+        if (y0 < y1) {
+            fn(band, y0, y1);
+        }
+    };
+
+    if (bandCount == 1 || !executor) {
+        for (int band = 0; band < bandCount; band++) {
+            runBand(band);
+        }
+        return;
+    }
+    SkTaskGroup taskGroup(*executor);
+    taskGroup.batch(bandCount, runBand);
+    taskGroup.wait();
+}
+
 SkTaskGroup::Enabler::Enabler(int threads) {
     if (threads) {
         fThreadPool = SkExecutor::MakeLIFOThreadPool(threads);
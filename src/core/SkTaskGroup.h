@@ -13,6 +13,7 @@
 #include "include/private/SkNoncopyable.h"
 #include <atomic>
 #include <functional>
+#include <memory>
 
 class SkTaskGroup : SkNoncopyable {
 public:
@@ -24,6 +25,9 @@ public:
     void add(std::function<void(void)> fn);
 
     // Add a batch of N tasks, all calling fn with different arguments.
+    // The batch starts as a single task that splits itself up as it runs,
+    // so large batches cost far fewer than N calls to the executor's add().
+    // On an executor that runs work inline, fn is called with 0, 1, ... N-1 in order.
     void batch(int N, std::function<void(int)> fn);
 
     // Returns true if all Tasks previously add()ed to this SkTaskGroup have run.
@@ -41,8 +45,31 @@ public:
     };
 
 private:
+    void addRange(int start, int end, int grain,
+                  std::shared_ptr<const std::function<void(int)>> fn);
+
     std::atomic<int32_t> fPending;
     SkExecutor&          fExecutor;
 };
 
+// Work over the rows of an image can be split into bands that run on an executor. Images with
+// fewer than fMinArea pixels are not worth the cost of handing out the work; larger ones get a
+// band for every fMinBandRows rows, up to fMaxBands.
+struct SkRowBanding {
+    int64_t fMinArea;
+    int     fMinBandRows = 1;
+    int     fMaxBands    = 16;
+
+    bool worthSplitting(int64_t area) const { return area >= fMinArea; }
+
+    // How many bands to split rows into, for area pixels of work in all.
+    int bandCount(int rows, int64_t area) const;
+
+    // Calls fn(band, y0, y1) for each of bandCount bands covering rows [0, rows), and waits for
+    // them all. Every band but the last is a multiple of rowAlign rows. The bands run on executor
+    // if there is more than one of them, and right here otherwise, or if executor is null.
+    static void Run(SkExecutor* executor, int rows, int bandCount, int rowAlign,
+                    const std::function<void(int band, int y0, int y1)>& fn);
+};
+
 #endif//SkTaskGroup_DEFINED
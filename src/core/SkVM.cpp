@@ -162,6 +162,10 @@ namespace skvm {
 
     struct Program::Impl {
         std::vector<InterpreterInstruction> instructions;
+        // Decoded for stride=K, then for stride=1, with handlers only interpret_threaded can run.
+        // Empty (and interpret_threaded null) if we interpret with SkOpts::interpret_skvm().
+        std::vector<ThreadedInstruction> threaded;
+        decltype(SkOpts::interpret_skvm_threaded) interpret_threaded = nullptr;
         int regs = 0;
         int loop = 0;
         std::vector<int> strides;
@@ -169,6 +173,7 @@ namespace skvm {
         std::unique_ptr<viz::Visualizer> visualizer;
 
         std::atomic<void*> jit_entry{nullptr};   // TODO: minimal std::memory_orders
+        bool   jit_always = false;               // Run jit_entry even if !gSkVMAllowJIT.
         size_t jit_size = 0;
         void*  dylib    = nullptr;
 
@@ -591,13 +596,15 @@ namespace skvm {
     }
 
     Program Builder::done(const char* debug_name,
-                          bool allow_jit) const {
-        return this->done(debug_name, allow_jit, /*visualizer=*/nullptr);
+                          bool allow_jit,
+                          bool allow_threaded) const {
+        return this->done(debug_name, allow_jit, /*visualizer=*/nullptr, allow_threaded);
     }
 
     Program Builder::done(const char* debug_name,
                           bool allow_jit,
-                          std::unique_ptr<viz::Visualizer> visualizer) const {
+                          std::unique_ptr<viz::Visualizer> visualizer,
+                          bool allow_threaded) const {
         char buf[64] = "skvm-jit-";
         if (!debug_name) {
             *SkStrAppendU32(buf+9, this->hash()) = '\0';
@@ -608,7 +615,16 @@ namespace skvm {
         return {optimized,
                 std::move(visualizer),
                 fStrides,
-                fTraceHooks, debug_name, allow_jit};
+                fTraceHooks, debug_name, allow_jit, allow_threaded};
+    }
+
+    Program Builder::done(const char* debug_name, Engine engine) const {
+        char buf[64] = "skvm-jit-";
+        if (!debug_name) {
+            *SkStrAppendU32(buf+9, this->hash()) = '\0';
+            debug_name = buf;
+        }
+        return {this->optimize(), fStrides, fTraceHooks, debug_name, engine};
     }
 
     uint64_t Builder::hash() const {
@@ -2614,7 +2630,7 @@ namespace skvm {
         // Ordinarily we'd never find ourselves with non-null jit_entry and !gSkVMAllowJIT, but it
         // can happen during interactive programs like Viewer that toggle gSkVMAllowJIT on and off,
         // due to timing or program caching.
-        if (jit_entry != nullptr && gSkVMAllowJIT) {
+        if (jit_entry != nullptr && (gSkVMAllowJIT || fImpl->jit_always)) {
         #if SKVM_JIT_STATS
             jits++;
             fast += n;
@@ -2639,6 +2655,15 @@ namespace skvm {
     #endif
 
         // So we'll sometimes use the interpreter here even if later calls will use the JIT.
+        if (fImpl->interpret_threaded) {
+            const ThreadedInstruction* strideK = fImpl->threaded.data();
+            const ThreadedInstruction* stride1 = strideK + fImpl->instructions.size() + 1;
+            fImpl->interpret_threaded(strideK, stride1,
+                                      this->nregs(), this->loop(), fImpl->strides.data(),
+                                      fImpl->traceHooks.data(), fImpl->traceHooks.size(),
+                                      this->nargs(), n, args);
+            return;
+        }
         SkOpts::interpret_skvm(fImpl->instructions.data(), (int)fImpl->instructions.size(),
                                this->nregs(), this->loop(), fImpl->strides.data(),
                                fImpl->traceHooks.data(), fImpl->traceHooks.size(),
@@ -3123,11 +3148,26 @@ namespace skvm {
                      std::unique_ptr<viz::Visualizer> visualizer,
                      const std::vector<int>& strides,
                      const std::vector<TraceHook*>& traceHooks,
-                     const char* debug_name, bool allow_jit) : Program() {
+                     const char* debug_name, bool allow_jit, bool allow_threaded) : Program() {
         fImpl->visualizer = std::move(visualizer);
         fImpl->strides = strides;
         fImpl->traceHooks = traceHooks;
-        if (gSkVMAllowJIT && allow_jit) {
+        this->setup(instructions, debug_name, gSkVMAllowJIT && allow_jit, allow_threaded);
+    }
+
+    Program::Program(const std::vector<OptimizedInstruction>& instructions,
+                     const std::vector<int>& strides,
+                     const std::vector<TraceHook*>& traceHooks,
+                     const char* debug_name, Engine engine) : Program() {
+        fImpl->strides = strides;
+        fImpl->traceHooks = traceHooks;
+        fImpl->jit_always = engine == Engine::kJIT;
+        this->setup(instructions, debug_name, engine == Engine::kJIT, engine != Engine::kSwitch);
+    }
+
+    void Program::setup(const std::vector<OptimizedInstruction>& instructions,
+                        const char* debug_name, bool allow_jit, bool allow_threaded) {
+        if (allow_jit) {
         #if 1 && defined(SKVM_LLVM)
             this->setupLLVM(instructions, debug_name);
         #elif 1 && defined(SKVM_JIT)
@@ -3137,6 +3177,12 @@ namespace skvm {
 
         // Might as well do this after setupLLVM() to get a little more time to compile.
         this->setupInterpreter(instructions);
+
+        // A Program with JIT code only interprets if gSkVMAllowJIT is turned off later, and then
+        // the switch-based interpreter will do.  (LLVM finishes compiling later, so we can't tell.)
+        if (allow_threaded && fImpl->jit_entry.load() == nullptr) {
+            this->setupThreadedInterpreter();
+        }
     }
 
     std::vector<InterpreterInstruction> Program::instructions() const { return fImpl->instructions; }
@@ -3245,6 +3291,18 @@ namespace skvm {
         }
     }
 
+    void Program::setupThreadedInterpreter() {
+        // Decode everything up front for the threaded interpreter, once for each stride.
+        // SkOpts may be re-initialized later, so we hold on to the interpreter that matches.
+        const int ninsts = (int)fImpl->instructions.size();
+        fImpl->interpret_threaded = SkOpts::interpret_skvm_threaded;
+        fImpl->threaded.resize(2 * (ninsts + 1));
+        SkOpts::decode_skvm_threaded(fImpl->instructions.data(), ninsts, fImpl->loop,
+                                     /*strideK=*/true,  fImpl->threaded.data());
+        SkOpts::decode_skvm_threaded(fImpl->instructions.data(), ninsts, fImpl->loop,
+                                     /*strideK=*/false, fImpl->threaded.data() + ninsts + 1);
+    }
+
 #if defined(SKVM_JIT)
 
     namespace SkVMJitTypes {
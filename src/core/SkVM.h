@@ -613,21 +613,34 @@ namespace skvm {
         virtual void scope(int delta) = 0;
     };
 
+    // The ways a Program can run.  kJIT falls back to kThreaded where we can't JIT.
+    enum class Engine { kSwitch, kThreaded, kJIT };
+
     class Builder {
     public:
         Builder(bool createDuplicates = false);
         Builder(Features, bool createDuplicates = false);
 
+        // Programs that don't JIT run on the threaded interpreter, or with !allow_threaded on the
+        // simpler switch-based one.
         Program done(const char* debug_name,
                      bool allow_jit,
-                     std::unique_ptr<viz::Visualizer> visualizer) const;
+                     std::unique_ptr<viz::Visualizer> visualizer,
+                     bool allow_threaded=true) const;
         Program done(const char* debug_name = nullptr,
-                     bool allow_jit=true) const;
+                     bool allow_jit=true,
+                     bool allow_threaded=true) const;
+        // Runs on exactly this engine, whatever gSkVMAllowJIT says, e.g. to compare engines.
+        Program done(const char* debug_name, Engine) const;
 
         // Mostly for debugging, tests, etc.
         std::vector<Instruction> program() const { return fProgram; }
         std::vector<OptimizedInstruction> optimize(viz::Visualizer* visualizer = nullptr) const;
 
+        // With optimize(), enough to construct the same Program done() would, e.g. to save it.
+        const std::vector<int>& strides() const { return fStrides; }
+        bool hasTraceHooks() const { return !fTraceHooks.empty(); }
+
         // Returns a trace-hook ID which must be passed to the trace opcodes.
         int attachTraceHook(TraceHook*);
 
@@ -1031,13 +1044,25 @@ namespace skvm {
         int immA,immB,immC;
     };
 
+    // An InterpreterInstruction decoded for the threaded interpreter: fn is the handler that
+    // runs it, and maybe the next few instructions too.
+    struct ThreadedInstruction {
+        void (*fn)();
+        Reg d,x,y,z,w;
+        int immA,immB,immC;
+    };
+
     class Program {
     public:
         Program(const std::vector<OptimizedInstruction>& instructions,
                 std::unique_ptr<viz::Visualizer> visualizer,
                 const std::vector<int>& strides,
                 const std::vector<TraceHook*>& traceHooks,
-                const char* debug_name, bool allow_jit);
+                const char* debug_name, bool allow_jit, bool allow_threaded=true);
+        Program(const std::vector<OptimizedInstruction>& instructions,
+                const std::vector<int>& strides,
+                const std::vector<TraceHook*>& traceHooks,
+                const char* debug_name, Engine);
 
         Program();
         ~Program();
@@ -1073,7 +1098,10 @@ namespace skvm {
         viz::Visualizer* visualizer();
 
     private:
+        void setup(const std::vector<OptimizedInstruction>&, const char* debug_name,
+                   bool allow_jit, bool allow_threaded);
         void setupInterpreter(const std::vector<OptimizedInstruction>&);
+        void setupThreadedInterpreter();
         void setupJIT        (const std::vector<OptimizedInstruction>&, const char* debug_name);
         void setupLLVM       (const std::vector<OptimizedInstruction>&, const char* debug_name);
 
@@ -5,8 +5,12 @@
  * found in the LICENSE file.
  */
 
+#include "include/core/SkData.h"
+#include "include/core/SkStream.h"
+#include "include/core/SkTime.h"
 #include "include/private/SkImageInfoPriv.h"
 #include "include/private/SkMacros.h"
+#include "include/private/SkMutex.h"
 #include "src/core/SkArenaAlloc.h"
 #include "src/core/SkBlendModePriv.h"
 #include "src/core/SkBlenderBase.h"
@@ -21,8 +25,11 @@
 #include "src/core/SkVM.h"
 #include "src/core/SkVMBlitter.h"
 #include "src/shaders/SkColorFilterShader.h"
+#include "src/utils/SkVMVisualizer.h"
 
+#include <atomic>
 #include <cinttypes>
+#include <cstdio>
 
 namespace {
 
@@ -552,33 +559,39 @@ SkVMBlitter::SkVMBlitter(const SkPixmap& device,
         , fParams(EffectiveParams(device, sprite, paint, matrices, std::move(clip)))
         , fKey(CacheKey(fParams, &fUniforms, &fAlloc, ok)) {}
 
-SkVMBlitter::~SkVMBlitter() {
-    if (fStoreToCache) {
-        if (SkLRUCache<Key, skvm::Program>* cache = TryAcquireProgramCache()) {
-            auto cache_program = [&](SkTLazy<skvm::Program>& program, Coverage coverage) {
-                if (program.isValid() && !program->hasTraceHooks()) {
-                    cache->insert_or_update(fKey.withCoverage(coverage), std::move(*program));
-                }
-            };
-            for (int c = 0; c < Coverage::kCount; c++) {
-                cache_program(fPrograms[c], static_cast<Coverage>(c));
-            }
+SkVMBlitter::~SkVMBlitter() = default;
 
-            ReleaseProgramCache();
-        }
+// All threads share one cache of programs.  Blitters hold their own refs to the programs they
+// use, so a program stays alive while in use even if the cache drops it.  The cache is split into
+// shards by key, each with its own lock, so threads drawing different things rarely contend.
+static constexpr int kProgramCacheShards = 16,
+                     kProgramCacheCount  = 256;
+
+struct SkVMBlitter::ProgramCacheShard {
+    SkMutex      mutex;
+    ProgramCache cache SK_GUARDED_BY(mutex){kProgramCacheCount / kProgramCacheShards};
+
+    static ProgramCacheShard* All() {
+        static ProgramCacheShard* shards = new ProgramCacheShard[kProgramCacheShards];
+        return shards;
     }
-}
 
-SkLRUCache<SkVMBlitter::Key, skvm::Program>* SkVMBlitter::TryAcquireProgramCache() {
-#if defined(SKVM_JIT)
-    thread_local static SkLRUCache<Key, skvm::Program> cache{64};
-    return &cache;
-#else
-    // iOS now supports thread_local since iOS 9.
-    // On the other hand, we'll never be able to JIT there anyway.
-    // It's probably fine to not cache any interpreted programs, anywhere.
-    return nullptr;
-#endif
+    static ProgramCacheShard& For(const Key& key) {
+        // The cache's hash table indexes by the low bits of the same hash, so shard by the high.
+        static_assert(kProgramCacheShards == 1 << (32 - 28));
+        return All()[SkGoodHash()(key) >> 28];
+    }
+};
+
+void SkVMBlitter::ForEachCachedProgram(
+        const std::function<void(const Key&, std::shared_ptr<skvm::Program>*)>& fn) {
+    for (int i = 0; i < kProgramCacheShards; i++) {
+        ProgramCacheShard& shard = ProgramCacheShard::All()[i];
+        SkAutoMutexExclusive lock(shard.mutex);
+        shard.cache.foreach([&](const Key* key, std::shared_ptr<skvm::Program>* program) {
+            fn(*key, program);
+        });
+    }
 }
 
 SkString SkVMBlitter::DebugName(const Key& key) {
@@ -593,31 +606,265 @@ SkString SkVMBlitter::DebugName(const Key& key) {
                           key.coverage);
 }
 
-void SkVMBlitter::ReleaseProgramCache() {}
+static struct {
+    std::atomic<int64_t> hits{0},
+                         diskHits{0},
+                         misses{0},
+                         compileNanos{0};
+} gProgramCacheStats;
+
+SkVMBlitter::ProgramCacheStats SkVMBlitter::GetProgramCacheStats() {
+    return {
+        gProgramCacheStats.hits.load(),
+        gProgramCacheStats.diskHits.load(),
+        gProgramCacheStats.misses.load(),
+        gProgramCacheStats.compileNanos.load() * 1e-6,
+    };
+}
+
+void SkVMBlitter::PurgeProgramCache() {
+    for (int i = 0; i < kProgramCacheShards; i++) {
+        ProgramCacheShard& shard = ProgramCacheShard::All()[i];
+        SkAutoMutexExclusive lock(shard.mutex);
+        shard.cache.reset();
+    }
+}
+
+// Programs saved to disk are a header, the program's strides, then its optimized instructions,
+// all int32_t.  The version is derived from the list of ops and the instruction layout, so files
+// written by a build whose ops differ from ours are ignored without anyone remembering to bump it.
+static constexpr int kInstructionInts = 10;
+
+static constexpr uint32_t program_file_version() {
+    constexpr char kOps[] =
+    #define M(op) #op " "
+        SKVM_OPS(M);
+    #undef M
+    uint32_t hash = 2166136261;  // FNV-1a
+    for (char c : kOps) {
+        hash = (hash ^ (uint8_t)c) * 16777619;
+    }
+    hash = (hash ^ (uint32_t)sizeof(skvm::OptimizedInstruction)) * 16777619;
+    return (hash ^ (uint32_t)kInstructionInts) * 16777619;
+}
+
+static constexpr uint32_t kProgramFileMagic   = SkSetFourByteTag('s','k','v','m'),
+                          kProgramFileVersion = program_file_version();
+
+struct ProgramFileHeader {
+    uint32_t magic,
+             version,
+             checksum,      // SkOpts::hash() of everything after the header.
+             strideCount,
+             instructionCount;
+};
+
+static SkMutex& program_dir_mutex() {
+    static SkMutex& mutex = *(new SkMutex);
+    return mutex;
+}
+
+static SkString* program_dir() {
+    static SkString* dir = new SkString;
+    return dir;
+}
+
+void SkVMBlitter::SetProgramCacheDirectory(const char* dir) {
+    SkAutoMutexExclusive lock(program_dir_mutex());
+    program_dir()->set(dir ? dir : "");
+}
+
+// Returns where we'd save or load this program, or an empty string if we don't do that.
+static SkString program_path(const SkString& name) {
+    SkAutoMutexExclusive lock(program_dir_mutex());
+    if (program_dir()->isEmpty()) {
+        return SkString();
+    }
+    return SkStringPrintf("%s/%s.skvm", program_dir()->c_str(), name.c_str());
+}
+
+static std::shared_ptr<skvm::Program> load_program(const SkString& path, const SkString& name) {
+    sk_sp<SkData> data = SkData::MakeFromFileName(path.c_str());
+    if (!data || data->size() < sizeof(ProgramFileHeader)) {
+        return nullptr;
+    }
+    ProgramFileHeader header;
+    memcpy(&header, data->data(), sizeof(header));
+
+    const void* body = data->bytes() + sizeof(header);
+    const size_t bodySize = data->size() - sizeof(header);
+    if (header.magic   != kProgramFileMagic   ||
+        header.version != kProgramFileVersion ||
+        header.checksum != SkOpts::hash(body, bodySize)) {
+        return nullptr;
+    }
+
+    // Everything after the header is int32_t, and we know exactly how many there should be.
+    const size_t nstrides = header.strideCount,
+                 ninsts   = header.instructionCount;
+    if (bodySize != (nstrides + ninsts * kInstructionInts) * sizeof(int32_t)) {
+        return nullptr;
+    }
+    auto next = [ptr = (const char*)body]() mutable {
+        int32_t v;
+        memcpy(&v, ptr, sizeof(v));
+        ptr += sizeof(v);
+        return v;
+    };
+
+    std::vector<int> strides(nstrides);
+    for (int& stride : strides) {
+        if ((stride = next()) < 0) {
+            return nullptr;
+        }
+    }
+
+    // Only rebuild programs that make sense, in case the file was written by a different build.
+    constexpr int kOpCount = 0
+    #define M(op) + 1
+        SKVM_OPS(M);
+    #undef M
+    auto valid_arg = [](skvm::Val arg, int i) { return arg == skvm::NA || (0 <= arg && arg < i); };
+
+    // Ops that read or write through a program argument must name one we have, with a stride
+    // (bytes per varying lane, or 0 for uniforms) that fits what they access.
+    auto valid_memory = [&](const skvm::OptimizedInstruction& inst) {
+        using skvm::Op;
+        const bool uniform = inst.op == Op::gather8  || inst.op == Op::gather16 ||
+                             inst.op == Op::gather32 || inst.op == Op::uniform32 ||
+                             inst.op == Op::array32;
+        if (!uniform && !skvm::touches_varying_memory(inst.op)) {
+            return true;
+        }
+        if (!(0 <= inst.immA && inst.immA < (int)nstrides)) {
+            return false;
+        }
+        const int stride = strides[inst.immA];
+        if (uniform) {
+            return stride == 0 && inst.immB >= 0 && (inst.op != Op::array32 || inst.immC >= 0);
+        }
+        switch (inst.op) {
+            case Op::store8:  case Op::load8:  return stride >=  1;
+            case Op::store16: case Op::load16: return stride >=  2;
+            case Op::store32: case Op::load32: return stride >=  4;
+            case Op::store64:                  return stride >=  8;
+            case Op::load64:                   return stride >=  8 && (inst.immB == 0 ||
+                                                                       inst.immB == 1);
+            case Op::store128:                 return stride >= 16;
+            case Op::load128:                  return stride >= 16 && 0 <= inst.immB
+                                                                   && inst.immB < 4;
+            default:                           return false;
+        }
+    };
+
+    std::vector<skvm::OptimizedInstruction> instructions(ninsts);
+    for (int i = 0; i < (int)ninsts; i++) {
+        skvm::OptimizedInstruction& inst = instructions[i];
+        int op = next();
+        inst.op        = (skvm::Op)op;
+        inst.x         = next();
+        inst.y         = next();
+        inst.z         = next();
+        inst.w         = next();
+        inst.immA      = next();
+        inst.immB      = next();
+        inst.immC      = next();
+        inst.death     = next();
+        inst.can_hoist = next() != 0;
+        // We never save trace ops, and couldn't rebuild their hooks if we had.
+        if (!(0 <= op && op < kOpCount) || skvm::is_trace(inst.op) || !valid_memory(inst) ||
+            !valid_arg(inst.x, i) || !valid_arg(inst.y, i) ||
+            !valid_arg(inst.z, i) || !valid_arg(inst.w, i) ||
+            !(i <= inst.death && inst.death <= (int)ninsts)) {
+            return nullptr;
+        }
+    }
+    return std::make_shared<skvm::Program>(instructions, /*visualizer=*/nullptr, strides,
+                                           /*traceHooks=*/std::vector<skvm::TraceHook*>{},
+                                           name.c_str(), /*allow_jit=*/true);
+}
+
+static void save_program(const SkString& path,
+                         const std::vector<skvm::OptimizedInstruction>& instructions,
+                         const std::vector<int>& strides) {
+    SkDynamicMemoryWStream body;
+    for (int stride : strides) {
+        body.write32(stride);
+    }
+    for (const skvm::OptimizedInstruction& inst : instructions) {
+        const int32_t ints[kInstructionInts] = {
+            (int32_t)inst.op, inst.x, inst.y, inst.z, inst.w,
+            inst.immA, inst.immB, inst.immC, inst.death, inst.can_hoist,
+        };
+        body.write(ints, sizeof(ints));
+    }
+    sk_sp<SkData> data = body.detachAsData();
+
+    const ProgramFileHeader header = {
+        kProgramFileMagic,
+        kProgramFileVersion,
+        SkOpts::hash(data->data(), data->size()),
+        SkToU32(strides.size()),
+        SkToU32(instructions.size()),
+    };
+
+    // Write to a temporary file first, so no one ever loads a partly written program.
+    static std::atomic<uint32_t> gUniq{0};
+    SkString tmp = SkStringPrintf("%s.%u.%" PRIx64 ".tmp", path.c_str(), gUniq++,
+                                  (uint64_t)SkTime::GetNSecs());
+    {
+        SkFILEWStream file(tmp.c_str());
+        if (!file.isValid() ||
+            !file.write(&header, sizeof(header)) ||
+            !file.write(data->data(), data->size())) {
+            return;
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+    }
+}
 
 skvm::Program* SkVMBlitter::buildProgram(Coverage coverage) {
     // eg, blitter re-use...
-    if (fProgramPtrs[coverage]) {
-        return fProgramPtrs[coverage];
+    if (fPrograms[coverage]) {
+        return fPrograms[coverage].get();
     }
 
     // Next, cache lookup...
     Key key = fKey.withCoverage(coverage);
+    ProgramCacheShard& shard = ProgramCacheShard::For(key);
     {
-        skvm::Program* p = nullptr;
-        if (SkLRUCache<Key, skvm::Program>* cache = TryAcquireProgramCache()) {
-            p = cache->find(key);
-            ReleaseProgramCache();
+        std::shared_ptr<skvm::Program> p;
+        {
+            SkAutoMutexExclusive lock(shard.mutex);
+            if (std::shared_ptr<skvm::Program>* found = shard.cache.find(key)) {
+                p = *found;
+            }
         }
         if (p) {
             SkASSERT(!p->empty());
-            fProgramPtrs[coverage] = p;
-            return p;
+            gProgramCacheStats.hits++;
+            fPrograms[coverage] = std::move(p);
+            return fPrograms[coverage].get();
+        }
+    }
+
+    // Maybe we built it in an earlier run and saved it to disk...
+    const SkString name = DebugName(key),
+                   path = program_path(name);
+    if (!path.isEmpty()) {
+        if (std::shared_ptr<skvm::Program> p = load_program(path, name)) {
+            gProgramCacheStats.diskHits++;
+            fPrograms[coverage] = p;
+            SkAutoMutexExclusive lock(shard.mutex);
+            shard.cache.insert_or_update(key, std::move(p));
+            return fPrograms[coverage].get();
         }
     }
 
     // Okay, let's build it...
-    fStoreToCache = true;
+    const double start = SkTime::GetNSecs();
 
     // We don't really _need_ to rebuild fUniforms here.
     // It's just more natural to have effects unconditionally emit them,
@@ -630,12 +877,27 @@ skvm::Program* SkVMBlitter::buildProgram(Coverage coverage) {
     SkASSERTF(fUniforms.buf.size() == prev,
               "%zu, prev was %zu", fUniforms.buf.size(), prev);
 
-    skvm::Program program = builder.done(DebugName(key).c_str());
+    // Programs with trace hooks are only for debugging, and we never cache them.
+    const bool cacheable = !builder.hasTraceHooks();
+
+    std::vector<skvm::OptimizedInstruction> optimized;
+    skvm::Program program;
+    if (cacheable) {
+        // This is what builder.done() does, but we hold on to the instructions to save them.
+        optimized = builder.optimize();
+        program = skvm::Program(optimized, /*visualizer=*/nullptr, builder.strides(),
+                                /*traceHooks=*/{}, name.c_str(), /*allow_jit=*/true);
+    } else {
+        program = builder.done(name.c_str());
+    }
+    gProgramCacheStats.misses++;
+    gProgramCacheStats.compileNanos += (int64_t)(SkTime::GetNSecs() - start);
+
     if ((false)) {
         static std::atomic<int> missed{0},
                                 total{0};
         if (!program.hasJIT()) {
-            SkDebugf("\ncouldn't JIT %s\n", DebugName(key).c_str());
+            SkDebugf("\ncouldn't JIT %s\n", name.c_str());
             builder.dump();
             program.dump();
 
@@ -646,8 +908,18 @@ skvm::Program* SkVMBlitter::buildProgram(Coverage coverage) {
                                 total.load(), missed.load()); });
         }
     }
-    fProgramPtrs[coverage] = fPrograms[coverage].set(std::move(program));
-    return fProgramPtrs[coverage];
+    fPrograms[coverage] = std::make_shared<skvm::Program>(std::move(program));
+
+    if (cacheable) {
+        {
+            SkAutoMutexExclusive lock(shard.mutex);
+            shard.cache.insert_or_update(key, fPrograms[coverage]);
+        }
+        if (!path.isEmpty()) {
+            save_program(path, optimized, builder.strides());
+        }
+    }
+    return fPrograms[coverage].get();
 }
 
 void SkVMBlitter::updateUniforms(int right, int y) {
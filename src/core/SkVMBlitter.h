@@ -11,9 +11,11 @@
 #include "src/core/SkArenaAlloc.h"
 #include "src/core/SkBlitter.h"
 #include "src/core/SkLRUCache.h"
-#include "src/core/SkTLazy.h"
 #include "src/core/SkVM.h"
 
+#include <functional>
+#include <memory>
+
 class SkVMBlitter final : public SkBlitter {
 public:
     static SkVMBlitter* Make(const SkPixmap& dst,
@@ -39,6 +41,19 @@ public:
 
     ~SkVMBlitter() override;
 
+    // Blitter programs are cached in memory and shared by all threads.  If a directory is set,
+    // programs are also saved there, and loaded from there before building them from scratch.
+    static void SetProgramCacheDirectory(const char* dir);  // nullptr or "" for none.
+    static void PurgeProgramCache();
+
+    struct ProgramCacheStats {
+        int64_t hits;       // Found in the in-memory cache.
+        int64_t diskHits;   // Loaded from the cache directory.
+        int64_t misses;     // Built from scratch.
+        double  compileMs;  // Total time spent building those misses.
+    };
+    static ProgramCacheStats GetProgramCacheStats();
+
 private:
     enum Coverage { Full, UniformF, MaskA8, MaskLCD16, Mask3D, kCount };
     struct Key {
@@ -81,9 +96,14 @@ private:
                              skvm::Uniforms* uniforms, SkArenaAlloc* alloc);
     static Key CacheKey(const Params& params,
                         skvm::Uniforms* uniforms, SkArenaAlloc* alloc, bool* ok);
-    static SkLRUCache<Key, skvm::Program>* TryAcquireProgramCache();
     static SkString DebugName(const Key& key);
-    static void ReleaseProgramCache();
+
+    using ProgramCache = SkLRUCache<Key, std::shared_ptr<skvm::Program>>;
+    struct ProgramCacheShard;
+    // Calls fn on each cached program, with the part of the cache holding it locked.  fn may
+    // replace the cached program, but must not change the one it points to; blitters share it.
+    static void ForEachCachedProgram(
+            const std::function<void(const Key&, std::shared_ptr<skvm::Program>*)>& fn);
 
     skvm::Program* buildProgram(Coverage coverage);
     void updateUniforms(int right, int y);
@@ -100,9 +120,7 @@ private:
     SkArenaAlloc    fAlloc{2*sizeof(void*)};  // but a few effects need to ref large content.
     const Params    fParams;
     const Key       fKey;
-    bool            fStoreToCache = false;
-    skvm::Program*         fProgramPtrs[Coverage::kCount] = {nullptr};
-    SkTLazy<skvm::Program> fPrograms[Coverage::kCount];
+    std::shared_ptr<skvm::Program> fPrograms[Coverage::kCount];
 
     friend class Viewer;
 };
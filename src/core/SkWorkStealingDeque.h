@@ -0,0 +1,129 @@
+/*
+ * Copyright 2022 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkWorkStealingDeque_DEFINED
+#define SkWorkStealingDeque_DEFINED
+
+#include "include/core/SkTypes.h"
+#include "include/private/SkTArray.h"
+#include "src/core/SkMathPriv.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// A Chase-Lev work-stealing deque of T*, following
+//     'Correct and Efficient Work-Stealing for Weak Memory Models' (Lê, Pop, Cohen, Nardelli)
+//
+// A single owner thread may push() and pop() at the bottom, last in, first out.
+// Any other thread may steal() from the top, first in, first out.
+// None of these calls block; pop() and steal() return nullptr when they come up empty,
+// which for steal() may also mean it lost a race for the last item.
+template <typename T>
+class SkWorkStealingDeque {
+public:
+    explicit SkWorkStealingDeque(int initialCapacity = 64)
+        : fArray(new Array(SkNextPow2(std::max(initialCapacity, 2)))) {}
+
+    ~SkWorkStealingDeque() { delete fArray.load(std::memory_order_relaxed); }
+
+    SkWorkStealingDeque(const SkWorkStealingDeque&) = delete;
+    SkWorkStealingDeque& operator=(const SkWorkStealingDeque&) = delete;
+
+    // Owner only.
+    void push(T* item) {
+        int64_t b = fBottom.load(std::memory_order_relaxed),
+                t = fTop.load(std::memory_order_acquire);
+        Array* a = fArray.load(std::memory_order_relaxed);
+        if (b - t > a->fMask) {
+            a = this->grow(a, t, b);
+        }
+        a->put(b, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        fBottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // Owner only.
+    T* pop() {
+        int64_t b = fBottom.load(std::memory_order_relaxed) - 1;
+        Array* a = fArray.load(std::memory_order_relaxed);
+        fBottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = fTop.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            // Empty.
+            fBottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        T* item = a->get(b);
+        if (t == b) {
+            // This was the last item, so we race any thieves for it.
+            if (!fTop.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                        std::memory_order_relaxed)) {
+                item = nullptr;
+            }
+            fBottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    // Any thread.
+    T* steal() {
+        int64_t t = fTop.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = fBottom.load(std::memory_order_acquire);
+
+        if (t >= b) {
+            return nullptr;
+        }
+        Array* a = fArray.load(std::memory_order_acquire);
+        T* item = a->get(t);
+        if (!fTop.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                    std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return item;
+    }
+
+    // A racy estimate of whether there's anything left, for heuristics only.
+    bool looksEmpty() const {
+        return fBottom.load(std::memory_order_relaxed) <= fTop.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Array {
+        explicit Array(int64_t capacity)
+            : fMask(capacity - 1)
+            , fItems(new std::atomic<T*>[capacity]) {}
+
+        T* get(int64_t i) const { return fItems[i & fMask].load(std::memory_order_relaxed); }
+        void put(int64_t i, T* item) { fItems[i & fMask].store(item, std::memory_order_relaxed); }
+
+        const int64_t fMask;
+        std::unique_ptr<std::atomic<T*>[]> fItems;
+    };
+
+    Array* grow(Array* a, int64_t t, int64_t b) {
+        Array* bigger = new Array(2 * (a->fMask + 1));
+        for (int64_t i = t; i < b; i++) {
+            bigger->put(i, a->get(i));
+        }
+        // Thieves may still be reading the old array, so we keep it around until we die.
+        fRetired.push_back(std::unique_ptr<Array>(a));
+        fArray.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+
+    alignas(64) std::atomic<int64_t> fTop{0};
+    alignas(64) std::atomic<int64_t> fBottom{0};
+    std::atomic<Array*>              fArray;
+    SkTArray<std::unique_ptr<Array>> fRetired;  // Owner only.
+};
+
+#endif//SkWorkStealingDeque_DEFINED
@@ -7,11 +7,13 @@
 
 #include "include/core/SkBitmap.h"
 #include "include/core/SkData.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkImageEncoder.h"
 #include "include/core/SkImageFilter.h"
 #include "include/core/SkImageGenerator.h"
 #include "include/core/SkPicture.h"
 #include "include/core/SkSurface.h"
+#include "src/core/SkArenaAlloc.h"
 #include "src/core/SkBitmapCache.h"
 #include "src/core/SkCachedData.h"
 #include "src/core/SkColorSpacePriv.h"
@@ -19,6 +21,7 @@
 #include "src/core/SkImageFilter_Base.h"
 #include "src/core/SkImagePriv.h"
 #include "src/core/SkMipmap.h"
+#include "src/core/SkMipmapAccessor.h"
 #include "src/core/SkMipmapBuilder.h"
 #include "src/core/SkNextID.h"
 #include "src/core/SkSpecialImage.h"
@@ -717,6 +720,30 @@ sk_sp<SkImage> SkImage::withDefaultMipmaps() const {
     return this->withMipmaps(nullptr);
 }
 
+void SkImage::prefetchRaster(SkExecutor& executor, const SkSamplingOptions& sampling,
+                             SkISize targetSize, PrefetchCallback callback,
+                             PrefetchContext context) const {
+    if (this->isTextureBacked() || targetSize.isEmpty()) {
+        if (callback) {
+            callback(context, false);
+        }
+        return;
+    }
+
+    executor.add([image = sk_ref_sp(this), sampling, targetSize, callback, context]() {
+        // Accessing the levels a draw at targetSize would sample decodes and caches them just as
+        // the draw would.
+        SkMatrix inv = SkMatrix::Scale(SkIntToScalar(image->width())  / targetSize.width(),
+                                       SkIntToScalar(image->height()) / targetSize.height());
+        SkSTArenaAlloc<sizeof(SkMipmapAccessor)> alloc;
+        bool success =
+                SkMipmapAccessor::Make(&alloc, image.get(), inv, sampling.mipmap) != nullptr;
+        if (callback) {
+            callback(context, success);
+        }
+    });
+}
+
 sk_sp<SkImage> SkMipmapBuilder::attachTo(const SkImage* src) {
     return src->withMipmaps(fMM);
 }
@@ -28,6 +28,7 @@ class GrDirectContext;
 class GrImageContext;
 class GrSamplerState;
 class SkCachedData;
+class SkYUVAPixmaps;
 
 enum {
     kNeedNewImageUniqueID = 0
@@ -131,6 +132,24 @@ public:
     virtual bool getROPixels(GrDirectContext*, SkBitmap*,
                              CachingHint = kAllow_CachingHint) const = 0;
 
+    // An image that can decode to a smaller size than its own, like a JPEG at 1/2, 1/4 or 1/8
+    // scale, returns the smallest such size that is still about 'scale' times its own size or
+    // larger. Returns false if there is none, or if the image is already decoded at full size.
+    virtual bool getScaledDecodeDimensions(SkSize scale, SkISize* dimensions) const {
+        return false;
+    }
+
+    // Like getROPixels(), but decoded at dimensions returned by getScaledDecodeDimensions().
+    virtual bool getScaledROPixels(SkISize dimensions, SkBitmap*,
+                                   CachingHint = kAllow_CachingHint) const {
+        return false;
+    }
+
+    // An image whose pixels come from 8-bit YUVA planes, like most JPEGs, returns those planes
+    // for the CPU to sample in place, along with the data that keeps them alive. Returns null if
+    // there are no planes, or if this image's RGBA pixels are already at hand anyway.
+    virtual sk_sp<SkCachedData> getROPlanes(SkYUVAPixmaps*) const { return nullptr; }
+
     virtual sk_sp<SkImage> onMakeSubset(const SkIRect&, GrDirectContext*) const = 0;
 
     virtual sk_sp<SkData> onRefEncoded() const { return nullptr; }
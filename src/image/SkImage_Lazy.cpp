@@ -9,17 +9,22 @@
 
 #include "include/core/SkBitmap.h"
 #include "include/core/SkData.h"
+#include "include/core/SkGraphics.h"
 #include "include/core/SkImageGenerator.h"
+#include "include/private/SkFloatingPoint.h"
 #include "src/core/SkBitmapCache.h"
 #include "src/core/SkCachedData.h"
 #include "src/core/SkImagePriv.h"
 #include "src/core/SkNextID.h"
+#include "src/core/SkResourceCache.h"
+#include "src/core/SkYUVPlanesCache.h"
+
+#include <algorithm>
+#include <atomic>
 
 #if SK_SUPPORT_GPU
 #include "include/gpu/GrDirectContext.h"
 #include "include/gpu/GrRecordingContext.h"
-#include "src/core/SkResourceCache.h"
-#include "src/core/SkYUVPlanesCache.h"
 #include "src/gpu/GrCaps.h"
 #include "src/gpu/GrColorSpaceXform.h"
 #include "src/gpu/GrGpuResourcePriv.h"
@@ -127,31 +132,108 @@ SkImage_Lazy::SkImage_Lazy(Validator* validator)
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
+// How many times getROPixels() has decoded, and how many times it found the pixels another thread
+// had just decoded while it waited for the generator, rather than decoding them again.
+static std::atomic<int64_t> gLazyDecodeCount{0};
+static std::atomic<int64_t> gLazyDecodesCoalescedCount{0};
+
+int64_t SkGraphics::GetLazyImageDecodeCount() {
+    return gLazyDecodeCount.load(std::memory_order_relaxed);
+}
+
+int64_t SkGraphics::GetLazyImageDecodesCoalescedCount() {
+    return gLazyDecodesCoalescedCount.load(std::memory_order_relaxed);
+}
+
 bool SkImage_Lazy::getROPixels(GrDirectContext*, SkBitmap* bitmap,
                                SkImage::CachingHint chint) const {
+    return this->decodeToBitmap(SkBitmapCacheDesc::Make(this), this->imageInfo(), bitmap, chint);
+}
+
+bool SkImage_Lazy::getScaledDecodeDimensions(SkSize scale, SkISize* dimensions) const {
+    if (!(std::max(scale.width(), scale.height()) < 1)) {
+        return false;
+    }
+    const SkISize full = this->dimensions();
+    const SkISize needed = {std::max(1, sk_float_floor2int(full.width()  * scale.width())),
+                            std::max(1, sk_float_floor2int(full.height() * scale.height()))};
+
+    // Ask the generator for its smaller sizes only once, so that draws don't have to wait for it.
+    fScaledDecodeDimensionsOnce([this, full] {
+        ScopedGenerator generator(fSharedGenerator);
+        // Generators that decode at smaller sizes support a few fixed scales, e.g. JPEG's eighths.
+        for (int eighths = 1; eighths < 8; ++eighths) {
+            SkISize scaled = generator->getScaledDimensions(eighths / 8.0f);
+            if (scaled.isEmpty() || scaled == full ||
+                scaled.width() > full.width() || scaled.height() > full.height() ||
+                std::count(fScaledDecodeDimensions,
+                           fScaledDecodeDimensions + fScaledDecodeDimensionsCount, scaled)) {
+                continue;
+            }
+            fScaledDecodeDimensions[fScaledDecodeDimensionsCount++] = scaled;
+        }
+    });
+
+    const SkISize* smallest = nullptr;
+    for (int i = 0; i < fScaledDecodeDimensionsCount; ++i) {
+        const SkISize& scaled = fScaledDecodeDimensions[i];
+        if (scaled.width() >= needed.width() && scaled.height() >= needed.height() &&
+            (!smallest || scaled.area() < smallest->area())) {
+            smallest = &scaled;
+        }
+    }
+    if (!smallest) {
+        return false;
+    }
+
+    // Scaling down pixels that are already decoded is cheaper than decoding again.
+    if (SkBitmap bitmap; SkBitmapCache::Find(SkBitmapCacheDesc::Make(this), &bitmap)) {
+        return false;
+    }
+    *dimensions = *smallest;
+    return true;
+}
+
+bool SkImage_Lazy::getScaledROPixels(SkISize dimensions, SkBitmap* bitmap,
+                                     SkImage::CachingHint chint) const {
+    return this->decodeToBitmap(SkBitmapCacheDesc::MakeScaled(this, dimensions),
+                                this->imageInfo().makeDimensions(dimensions), bitmap, chint);
+}
+
+bool SkImage_Lazy::decodeToBitmap(const SkBitmapCacheDesc& desc, const SkImageInfo& info,
+                                  SkBitmap* bitmap, SkImage::CachingHint chint) const {
     auto check_output_bitmap = [bitmap]() {
         SkASSERT(bitmap->isImmutable());
         SkASSERT(bitmap->getPixels());
         (void)bitmap;
     };
 
-    auto desc = SkBitmapCacheDesc::Make(this);
     if (SkBitmapCache::Find(desc, bitmap)) {
         check_output_bitmap();
         return true;
     }
 
+    // Only one thread at a time can decode with the generator. If another thread was decoding
+    // these same pixels while we waited for it, they are in the cache now, so use them instead of
+    // decoding again.
+    ScopedGenerator generator(fSharedGenerator);
+    if (SkBitmapCache::Find(desc, bitmap)) {
+        gLazyDecodesCoalescedCount.fetch_add(1, std::memory_order_relaxed);
+        check_output_bitmap();
+        return true;
+    }
+
+    gLazyDecodeCount.fetch_add(1, std::memory_order_relaxed);
     if (SkImage::kAllow_CachingHint == chint) {
         SkPixmap pmap;
-        SkBitmapCache::RecPtr cacheRec = SkBitmapCache::Alloc(desc, this->imageInfo(), &pmap);
-        if (!cacheRec || !ScopedGenerator(fSharedGenerator)->getPixels(pmap)) {
+        SkBitmapCache::RecPtr cacheRec = SkBitmapCache::Alloc(desc, info, &pmap);
+        if (!cacheRec || !generator->getPixels(pmap)) {
             return false;
         }
         SkBitmapCache::Add(std::move(cacheRec), bitmap);
         this->notifyAddedToRasterCache();
     } else {
-        if (!bitmap->tryAllocPixels(this->imageInfo()) ||
-            !ScopedGenerator(fSharedGenerator)->getPixels(bitmap->pixmap())) {
+        if (!bitmap->tryAllocPixels(info) || !generator->getPixels(bitmap->pixmap())) {
             return false;
         }
         bitmap->setImmutable();
@@ -161,6 +243,69 @@ bool SkImage_Lazy::getROPixels(GrDirectContext*, SkBitmap* bitmap,
     return true;
 }
 
+static std::atomic<bool> gRasterDrawsFromYUVAPlanes{false};
+
+bool SkGraphics::SetRasterDrawsFromYUVAPlanes(bool enabled) {
+    return gRasterDrawsFromYUVAPlanes.exchange(enabled, std::memory_order_relaxed);
+}
+
+sk_sp<SkCachedData> SkImage_Lazy::getROPlanes(SkYUVAPixmaps* pixmaps) const {
+    if (!gRasterDrawsFromYUVAPlanes.load(std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    // The planes are the generator's, so they're not ours if we changed its color type or space.
+    if (fSharedGenerator->fGenerator->uniqueID() != this->uniqueID()) {
+        return nullptr;
+    }
+    // If the RGBA pixels are already decoded, drawing those is cheaper.
+    if (SkBitmap bitmap; SkBitmapCache::Find(SkBitmapCacheDesc::Make(this), &bitmap)) {
+        return nullptr;
+    }
+
+    SkYUVAPixmapInfo::SupportedDataTypes supportedDataTypes;
+    for (int numChannels = 1; numChannels <= 4; ++numChannels) {
+        supportedDataTypes.enableDataType(SkYUVAPixmapInfo::DataType::kUnorm8, numChannels);
+    }
+    sk_sp<SkCachedData> data = this->getPlanes(supportedDataTypes, pixmaps);
+    // The cache may hold planes decoded for the GPU in some other form.
+    if (!data || pixmaps->dataType() != SkYUVAPixmapInfo::DataType::kUnorm8 ||
+        pixmaps->yuvaInfo().origin() != kTopLeft_SkEncodedOrigin) {
+        return nullptr;
+    }
+    return data;
+}
+
+sk_sp<SkCachedData> SkImage_Lazy::getPlanes(
+        const SkYUVAPixmapInfo::SupportedDataTypes& supportedDataTypes,
+        SkYUVAPixmaps* yuvaPixmaps) const {
+    // Planes that are already decoded don't need the generator.
+    sk_sp<SkCachedData> data(SkYUVPlanesCache::FindAndRef(fSharedGenerator->fGenerator->uniqueID(),
+                                                          yuvaPixmaps));
+    if (data) {
+        SkASSERT(yuvaPixmaps->isValid());
+        SkASSERT(yuvaPixmaps->yuvaInfo().dimensions() == this->dimensions());
+        return data;
+    }
+
+    ScopedGenerator generator(fSharedGenerator);
+    SkYUVAPixmapInfo yuvaPixmapInfo;
+    if (!generator->queryYUVAInfo(supportedDataTypes, &yuvaPixmapInfo) ||
+        yuvaPixmapInfo.yuvaInfo().dimensions() != this->dimensions()) {
+        return nullptr;
+    }
+    data.reset(SkResourceCache::NewCachedData(yuvaPixmapInfo.computeTotalBytes()));
+    SkYUVAPixmaps tempPixmaps = SkYUVAPixmaps::FromExternalMemory(yuvaPixmapInfo,
+                                                                  data->writable_data());
+    SkASSERT(tempPixmaps.isValid());
+    if (!generator->getYUVAPlanes(tempPixmaps)) {
+        return nullptr;
+    }
+    // Decoding is done, cache the resulting YUV planes
+    *yuvaPixmaps = tempPixmaps;
+    SkYUVPlanesCache::Add(this->uniqueID(), data.get(), *yuvaPixmaps);
+    return data;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
 bool SkImage_Lazy::onReadPixels(GrDirectContext* dContext,
@@ -372,36 +517,6 @@ GrSurfaceProxyView SkImage_Lazy::textureProxyViewFromPlanes(GrRecordingContext*
     return sfc->readSurfaceView();
 }
 
-sk_sp<SkCachedData> SkImage_Lazy::getPlanes(
-        const SkYUVAPixmapInfo::SupportedDataTypes& supportedDataTypes,
-        SkYUVAPixmaps* yuvaPixmaps) const {
-    ScopedGenerator generator(fSharedGenerator);
-
-    sk_sp<SkCachedData> data(SkYUVPlanesCache::FindAndRef(generator->uniqueID(), yuvaPixmaps));
-
-    if (data) {
-        SkASSERT(yuvaPixmaps->isValid());
-        SkASSERT(yuvaPixmaps->yuvaInfo().dimensions() == this->dimensions());
-        return data;
-    }
-    SkYUVAPixmapInfo yuvaPixmapInfo;
-    if (!generator->queryYUVAInfo(supportedDataTypes, &yuvaPixmapInfo) ||
-        yuvaPixmapInfo.yuvaInfo().dimensions() != this->dimensions()) {
-        return nullptr;
-    }
-    data.reset(SkResourceCache::NewCachedData(yuvaPixmapInfo.computeTotalBytes()));
-    SkYUVAPixmaps tempPixmaps = SkYUVAPixmaps::FromExternalMemory(yuvaPixmapInfo,
-                                                                  data->writable_data());
-    SkASSERT(tempPixmaps.isValid());
-    if (!generator->getYUVAPlanes(tempPixmaps)) {
-        return nullptr;
-    }
-    // Decoding is done, cache the resulting YUV planes
-    *yuvaPixmaps = tempPixmaps;
-    SkYUVPlanesCache::Add(this->uniqueID(), data.get(), *yuvaPixmaps);
-    return data;
-}
-
 /*
  *  We have 4 ways to try to return a texture (in sorted order)
  *
@@ -8,15 +8,14 @@
 #ifndef SkImage_Lazy_DEFINED
 #define SkImage_Lazy_DEFINED
 
+#include "include/core/SkYUVAPixmaps.h"
 #include "include/private/SkIDChangeListener.h"
 #include "include/private/SkMutex.h"
+#include "include/private/SkOnce.h"
 #include "src/image/SkImage_Base.h"
 
-#if SK_SUPPORT_GPU
-#include "include/core/SkYUVAPixmaps.h"
-#endif
-
 class SharedGenerator;
+struct SkBitmapCacheDesc;
 
 class SkImage_Lazy : public SkImage_Base {
 public:
@@ -44,6 +43,9 @@ public:
     sk_sp<SkData> onRefEncoded() const override;
     sk_sp<SkImage> onMakeSubset(const SkIRect&, GrDirectContext*) const override;
     bool getROPixels(GrDirectContext*, SkBitmap*, CachingHint) const override;
+    bool getScaledDecodeDimensions(SkSize scale, SkISize* dimensions) const override;
+    bool getScaledROPixels(SkISize dimensions, SkBitmap*, CachingHint) const override;
+    sk_sp<SkCachedData> getROPlanes(SkYUVAPixmaps*) const override;
     bool onIsLazyGenerated() const override { return true; }
     sk_sp<SkImage> onMakeColorTypeAndColorSpace(SkColorType, sk_sp<SkColorSpace>,
                                                 GrDirectContext*) const override;
@@ -79,9 +81,16 @@ private:
                                                                const SkRect*) const override;
 
     GrSurfaceProxyView textureProxyViewFromPlanes(GrRecordingContext*, SkBudgeted) const;
+#endif
+
+    // Returns the generator's YUVA planes, decoding them if they aren't in SkYUVPlanesCache.
     sk_sp<SkCachedData> getPlanes(const SkYUVAPixmapInfo::SupportedDataTypes& supportedDataTypes,
                                   SkYUVAPixmaps* pixmaps) const;
-#endif
+
+    // Decodes the pixels described by info (this image's, possibly at a smaller size) into bitmap,
+    // and caches them under desc if chint allows.
+    bool decodeToBitmap(const SkBitmapCacheDesc&, const SkImageInfo&, SkBitmap*,
+                        CachingHint) const;
 
     class ScopedGenerator;
 
@@ -95,6 +104,11 @@ private:
     mutable SkMutex             fOnMakeColorTypeAndSpaceMutex;
     mutable sk_sp<SkImage>      fOnMakeColorTypeAndSpaceResult;
 
+    // The smaller sizes the generator can decode to, found the first time they're asked for.
+    mutable SkOnce              fScaledDecodeDimensionsOnce;
+    mutable SkISize             fScaledDecodeDimensions[7];
+    mutable int                 fScaledDecodeDimensionsCount = 0;
+
 #if SK_SUPPORT_GPU
     // When the SkImage_Lazy goes away, we will iterate over all the listeners to inform them
     // of the unique ID's demise. This is used to remove cached textures from GrContext.
@@ -128,7 +128,7 @@ public:
         if (mips) {
             img->fBitmap.fMips = std::move(mips);
         } else {
-            img->fBitmap.fMips.reset(SkMipmap::Build(fBitmap.pixmap(), nullptr));
+            img->fBitmap.fMips.reset(SkMipmap::BuildLazily(fBitmap.pixmap(), nullptr));
         }
         return sk_sp<SkImage>(img);
     }
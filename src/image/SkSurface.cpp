@@ -79,6 +79,19 @@ void SkSurface_Base::onDraw(SkCanvas* canvas, SkScalar x, SkScalar y,
     }
 }
 
+SkImageInfo SkSurface_Base::onImageInfo() {
+    // TODO: do we need to go through canvas for this?
+    return this->getCachedCanvas()->imageInfo();
+}
+
+bool SkSurface_Base::onPeekPixels(SkPixmap* pmap) {
+    return this->getCachedCanvas()->peekPixels(pmap);
+}
+
+bool SkSurface_Base::onReadPixels(const SkPixmap& dst, int srcX, int srcY) {
+    return this->getCachedCanvas()->readPixels(dst, srcX, srcY);
+}
+
 void SkSurface_Base::onAsyncRescaleAndReadPixels(const SkImageInfo& info,
                                                  const SkIRect& origSrcRect,
                                                  SkSurface::RescaleGamma rescaleGamma,
@@ -182,8 +195,7 @@ SkSurface::SkSurface(const SkImageInfo& info, const SkSurfaceProps* props)
 }
 
 SkImageInfo SkSurface::imageInfo() {
-    // TODO: do we need to go through canvas for this?
-    return this->getCanvas()->imageInfo();
+    return asSB(this)->onImageInfo();
 }
 
 uint32_t SkSurface::generationID() {
@@ -197,6 +209,18 @@ void SkSurface::notifyContentWillChange(ContentChangeMode mode) {
     sk_ignore_unused_variable(asSB(this)->aboutToDraw(mode));
 }
 
+bool SkSurface::setDirtyRegionTracking(bool enabled) {
+    return asSB(this)->onSetDirtyRegionTracking(enabled);
+}
+
+SkRegion SkSurface::dirtyRegion() {
+    return asSB(this)->onDirtyRegion();
+}
+
+void SkSurface::resetDirtyRegion() {
+    asSB(this)->onResetDirtyRegion();
+}
+
 SkCanvas* SkSurface::getCanvas() {
     return asSB(this)->getCachedCanvas();
 }
@@ -233,11 +257,11 @@ void SkSurface::draw(SkCanvas* canvas, SkScalar x, SkScalar y, const SkSamplingO
 }
 
 bool SkSurface::peekPixels(SkPixmap* pmap) {
-    return this->getCanvas()->peekPixels(pmap);
+    return asSB(this)->onPeekPixels(pmap);
 }
 
 bool SkSurface::readPixels(const SkPixmap& pm, int srcX, int srcY) {
-    return this->getCanvas()->readPixels(pm, srcX, srcY);
+    return asSB(this)->onReadPixels(pm, srcX, srcY);
 }
 
 bool SkSurface::readPixels(const SkImageInfo& dstInfo, void* dstPixels, size_t dstRowBytes,
@@ -361,11 +385,13 @@ void SkSurface::resolveMSAA() {
 }
 
 GrSemaphoresSubmitted SkSurface::flush(BackendSurfaceAccess access, const GrFlushInfo& flushInfo) {
+    asSB(this)->onFlushDeferredDraws();
     return asSB(this)->onFlush(access, flushInfo, nullptr);
 }
 
 GrSemaphoresSubmitted SkSurface::flush(const GrFlushInfo& info,
                                        const GrBackendSurfaceMutableState* newState) {
+    asSB(this)->onFlushDeferredDraws();
     return asSB(this)->onFlush(BackendSurfaceAccess::kNoAccess, info, newState);
 }
 
@@ -373,9 +399,14 @@ void SkSurface::flush() {
     this->flush({});
 }
 #else
-void SkSurface::flush() {} // Flush is a no-op for CPU surfaces
+void SkSurface::flush() {
+    // Flush is a no-op for CPU surfaces, unless they defer their draws.
+    asSB(this)->onFlushDeferredDraws();
+}
 
-void SkSurface::flushAndSubmit(bool syncCpu) {}
+void SkSurface::flushAndSubmit(bool syncCpu) {
+    this->flush();
+}
 
 // TODO(kjlubick, scroggo) Remove this once Android is updated.
 sk_sp<SkSurface> SkSurface::MakeRenderTarget(GrRecordingContext*, SkBudgeted, const SkImageInfo&,
@@ -10,6 +10,7 @@
 
 #include "include/core/SkCanvas.h"
 #include "include/core/SkDeferredDisplayList.h"
+#include "include/core/SkRegion.h"
 #include "include/core/SkSurface.h"
 #include "src/core/SkImagePriv.h"
 #include "src/core/SkSurfacePriv.h"
@@ -22,6 +23,14 @@ public:
 
     virtual GrRecordingContext* onGetRecordingContext();
 
+    /**
+     *  Only raster surfaces track the pixels that drawing may change; see
+     *  SkSurface::setDirtyRegionTracking().
+     */
+    virtual bool onSetDirtyRegionTracking(bool) { return false; }
+    virtual SkRegion onDirtyRegion() { return SkRegion(); }
+    virtual void onResetDirtyRegion() {}
+
 #if SK_SUPPORT_GPU
     virtual GrBackendTexture onGetBackendTexture(BackendHandleAccess);
     virtual GrBackendRenderTarget onGetBackendRenderTarget(BackendHandleAccess);
@@ -67,6 +76,19 @@ public:
 
     virtual void onWritePixels(const SkPixmap&, int x, int y) = 0;
 
+    /**
+     *  Accessors for the pixels of this surface. The defaults go through the cached canvas,
+     *  which for most surfaces draws directly into those pixels.
+     */
+    virtual SkImageInfo onImageInfo();
+    virtual bool onPeekPixels(SkPixmap*);
+    virtual bool onReadPixels(const SkPixmap& dst, int srcX, int srcY);
+
+    /**
+     *  Called by flush(). Surfaces that defer CPU drawing resolve that work here.
+     */
+    virtual void onFlushDeferredDraws() {}
+
     /**
      * Default implementation does a rescale/read and then calls the callback.
      */
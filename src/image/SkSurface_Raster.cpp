@@ -8,6 +8,7 @@
 #include "include/core/SkCanvas.h"
 #include "include/core/SkMallocPixelRef.h"
 #include "include/private/SkImageInfoPriv.h"
+#include "src/core/SkBitmapDevice.h"
 #include "src/core/SkDevice.h"
 #include "src/core/SkImagePriv.h"
 #include "src/image/SkSurface_Base.h"
@@ -26,8 +27,15 @@ public:
     void onDraw(SkCanvas*, SkScalar, SkScalar, const SkSamplingOptions&, const SkPaint*) override;
     bool onCopyOnWrite(ContentChangeMode) override;
     void onRestoreBackingMutability() override;
+    bool onSetDirtyRegionTracking(bool) override;
+    SkRegion onDirtyRegion() override;
+    void onResetDirtyRegion() override;
 
 private:
+    SkBitmapDevice* device() {
+        return static_cast<SkBitmapDevice*>(this->getCachedCanvas()->baseDevice());
+    }
+
     SkBitmap    fBitmap;
     bool        fWeOwnThePixels;
 
@@ -114,7 +122,12 @@ sk_sp<SkImage> SkSurface_Raster::onNewImageSnapshot(const SkIRect* subset) {
 }
 
 void SkSurface_Raster::onWritePixels(const SkPixmap& src, int x, int y) {
-    fBitmap.writePixels(src, x, y);
+    if (fBitmap.writePixels(src, x, y)) {
+        SkBitmapDevice* device = this->device();
+        if (device->fTracksDirtyRegion) {
+            device->markDirty(SkIRect::MakeXYWH(x, y, src.width(), src.height()));
+        }
+    }
 }
 
 void SkSurface_Raster::onRestoreBackingMutability() {
@@ -124,6 +137,19 @@ void SkSurface_Raster::onRestoreBackingMutability() {
     }
 }
 
+bool SkSurface_Raster::onSetDirtyRegionTracking(bool enabled) {
+    this->device()->setTracksDirtyRegion(enabled);
+    return true;
+}
+
+SkRegion SkSurface_Raster::onDirtyRegion() {
+    return this->device()->dirtyRegion();
+}
+
+void SkSurface_Raster::onResetDirtyRegion() {
+    this->device()->resetDirtyRegion();
+}
+
 bool SkSurface_Raster::onCopyOnWrite(ContentChangeMode mode) {
     // are we sharing pixelrefs with the image?
     sk_sp<SkImage> cached(this->refCachedImage());
@@ -0,0 +1,398 @@
+/*
+ * Copyright 2022 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "include/core/SkBBHFactory.h"
+#include "include/core/SkCanvas.h"
+#include "include/core/SkExecutor.h"
+#include "include/core/SkMallocPixelRef.h"
+#include "include/core/SkPicture.h"
+#include "include/private/SkTDArray.h"
+#include "src/core/SkBigPicture.h"
+#include "src/core/SkBitmapDevice.h"
+#include "src/core/SkImagePriv.h"
+#include "src/core/SkPicturePriv.h"
+#include "src/core/SkRecord.h"
+#include "src/core/SkRecordDraw.h"
+#include "src/core/SkRecorder.h"
+#include "src/core/SkTaskGroup.h"
+#include "src/image/SkSurface_Base.h"
+
+#include <vector>
+
+namespace {
+
+// Without a hint from the caller, we split into this many tiles...
+static constexpr int kDefaultTileCount = 16;
+// ... but never make a tile shorter than this.
+static constexpr int kMinTileSize = 64;
+// Where a blit is cut off at the edge of what a tile may write, the blitter can round the last
+// row it writes differently than it would have uncut.  Tiles write this many rows further than
+// their own, into a scratch copy, so those rows are never the ones kept.
+static constexpr int kTileGuard = 1;
+
+// Draws that read back from pixels they do not write make tiles depend on one another.
+struct TileSafety {
+    bool operator()(const SkRecords::SaveLayer& op) {
+        return !op.backdrop && !(op.saveLayerFlags & SkCanvas::kInitWithPrevious_SaveLayerFlag);
+    }
+    bool operator()(const SkRecords::SaveBehind&) { return false; }
+    bool operator()(const SkRecords::DrawPicture& op);
+
+    template <typename T>
+    bool operator()(const T&) { return true; }
+};
+
+static bool is_tile_safe(const SkRecord& record, int stop) {
+    TileSafety safety;
+    for (int i = 0; i < stop; i++) {
+        if (!record.visit(i, safety)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool is_tile_safe(const SkPicture* pic) {
+    const SkBigPicture* big = SkPicturePriv::AsSkBigPicture(sk_ref_sp(pic));
+    return !big || is_tile_safe(*big->record(), big->record()->count());
+}
+
+bool TileSafety::operator()(const SkRecords::DrawPicture& op) {
+    return is_tile_safe(op.picture.get());
+}
+
+// How an op affects the canvas state left behind for the ops after it.
+enum class OpKind {
+    kSave,       // Opens a save block.
+    kSaveLayer,  // Opens a save block whose contents are drawn when it is restored.
+    kRestore,    // Closes a save block, undoing any state changes inside it.
+    kState,      // Changes the matrix or clip.
+    kOther,      // Draws, or does nothing at all.
+};
+
+struct ClassifyOp {
+    template <typename T>
+    OpKind operator()(const T&) {
+        switch (T::kType) {
+            case SkRecords::Save_Type:       return OpKind::kSave;
+            case SkRecords::SaveLayer_Type:
+            case SkRecords::SaveBehind_Type: return OpKind::kSaveLayer;
+            case SkRecords::Restore_Type:    return OpKind::kRestore;
+            case SkRecords::SetMatrix_Type:
+            case SkRecords::SetM44_Type:
+            case SkRecords::Translate_Type:
+            case SkRecords::Scale_Type:
+            case SkRecords::Concat_Type:
+            case SkRecords::Concat44_Type:
+            case SkRecords::ClipPath_Type:
+            case SkRecords::ClipRRect_Type:
+            case SkRecords::ClipRect_Type:
+            case SkRecords::ClipRegion_Type:
+            case SkRecords::ClipShader_Type:
+            case SkRecords::ResetClip_Type:  return OpKind::kState;
+            default:                         return OpKind::kOther;
+        }
+    }
+};
+
+}  // namespace
+
+// SkSurface_RasterTiled records draws through an SkRecorder canvas and only rasterizes them when
+// the pixels are needed.  Playback splits the surface into bands of rows that run in parallel.
+// A tile is not drawn through a clip, which would change how paths are edged and how big layers
+// are; instead it draws with the same clip as the whole surface into a scratch bitmap, letting
+// the blitters write only its own rows plus a small guard, and copies its own rows back.
+// That way each tile matches what drawing the whole surface at once would have produced.
+class SkSurface_RasterTiled : public SkSurface_Base {
+public:
+    SkSurface_RasterTiled(const SkImageInfo&, sk_sp<SkPixelRef>, SkExecutor*, int tileCount,
+                          const SkSurfaceProps*);
+
+    SkCanvas* onNewCanvas() override;
+    sk_sp<SkSurface> onNewSurface(const SkImageInfo&) override;
+    sk_sp<SkImage> onNewImageSnapshot(const SkIRect* subset) override;
+    void onWritePixels(const SkPixmap&, int x, int y) override;
+    SkImageInfo onImageInfo() override { return fBitmap.info(); }
+    bool onPeekPixels(SkPixmap*) override;
+    bool onReadPixels(const SkPixmap& dst, int srcX, int srcY) override;
+    void onFlushDeferredDraws() override { this->playbackPendingDraws(); }
+    void onDraw(SkCanvas*, SkScalar, SkScalar, const SkSamplingOptions&, const SkPaint*) override;
+    bool onCopyOnWrite(ContentChangeMode) override;
+    void onRestoreBackingMutability() override;
+
+private:
+    // Rasterizes every recorded draw we can into fBitmap, then drops those draws from fRecord,
+    // keeping only what is needed to reproduce the recorder's current matrix, clip and saves.
+    void playbackPendingDraws();
+    void discardPlayedBackOps(int stop);
+
+    SkBitmap        fBitmap;
+    SkExecutor*     fExecutor;
+    const int       fTileCount;
+    sk_sp<SkRecord> fRecord;
+    SkRecorder*     fRecorder = nullptr;  // Owned by SkSurface_Base as our cached canvas.
+
+    using INHERITED = SkSurface_Base;
+};
+
+SkSurface_RasterTiled::SkSurface_RasterTiled(const SkImageInfo& info, sk_sp<SkPixelRef> pr,
+                                             SkExecutor* executor, int tileCount,
+                                             const SkSurfaceProps* props)
+        : INHERITED(pr->width(), pr->height(), props)
+        , fExecutor(executor)
+        , fTileCount(tileCount)
+        , fRecord(sk_make_sp<SkRecord>()) {
+    fBitmap.setInfo(info, pr->rowBytes());
+    fBitmap.setPixelRef(std::move(pr), 0, 0);
+}
+
+SkCanvas* SkSurface_RasterTiled::onNewCanvas() {
+    SkASSERT(!fRecorder);
+    fRecorder = new SkRecorder(fRecord.get(), SkRect::Make(fBitmap.bounds()));
+    return fRecorder;
+}
+
+sk_sp<SkSurface> SkSurface_RasterTiled::onNewSurface(const SkImageInfo& info) {
+    return SkSurface::MakeRasterTiled(info, fExecutor, fTileCount, &this->props());
+}
+
+void SkSurface_RasterTiled::playbackPendingDraws() {
+    if (!fRecorder || fRecord->count() == 0) {
+        return;
+    }
+
+    // Draws inside a layer that is still open can't be rasterized until that layer is restored,
+    // so we stop at the first unbalanced saveLayer.
+    int stop = fRecord->count();
+    {
+        SkTDArray<int> layers;
+        ClassifyOp classify;
+        for (int i = 0; i < fRecord->count(); i++) {
+            switch (fRecord->visit(i, classify)) {
+                case OpKind::kSave:      layers.push_back(-1); break;
+                case OpKind::kSaveLayer: layers.push_back(i);  break;
+                case OpKind::kRestore:   if (!layers.isEmpty()) { layers.pop(); } break;
+                default: break;
+            }
+        }
+        for (int index : layers) {
+            if (index >= 0) {
+                stop = index;
+                break;
+            }
+        }
+    }
+    if (stop == 0) {
+        return;
+    }
+
+    std::unique_ptr<SkBigPicture::SnapshotArray> drawables;
+    if (SkDrawableList* list = fRecorder->getDrawableList()) {
+        drawables.reset(list->newDrawableSnapshot());
+    }
+    const SkPicture* const* drawablePicts = drawables ? drawables->begin() : nullptr;
+    const int drawableCount = drawables ? drawables->count() : 0;
+
+    // Tiles are bands that span the full width of the surface.  Shaders that step from one pixel
+    // to the next (e.g. legacy linear gradients and bitmap shaders) start each row of a draw where
+    // the row starts, so a tile must never cut a row short on the left.
+    const int w = fBitmap.width(),
+              h = fBitmap.height();
+    int tileCount = fTileCount > 0 ? fTileCount : kDefaultTileCount;
+    tileCount = std::min(tileCount, std::max(1, h / kMinTileSize));
+
+    bool tileSafe = is_tile_safe(*fRecord, stop);
+    for (int i = 0; tileSafe && i < drawableCount; i++) {
+        tileSafe = is_tile_safe(drawablePicts[i]);
+    }
+
+    // Tiles next to each other write into each other's guard, so they alternate between two
+    // scratch bitmaps.  Pages of a scratch bitmap that no tile touches are never committed, so
+    // each costs about half of the surface.
+    SkBitmap scratch[2];
+    if (tileCount > 1 && tileSafe) {
+        tileSafe = scratch[0].tryAllocPixels(fBitmap.info()) &&
+                   scratch[1].tryAllocPixels(fBitmap.info());
+    }
+
+    if (tileCount == 1 || !tileSafe) {
+        SkCanvas canvas(fBitmap, this->props());
+        SkRecordPartialDraw(*fRecord, &canvas, drawablePicts, drawableCount, 0, stop, SkM44());
+    } else {
+        SkAutoTMalloc<SkRect> bounds(fRecord->count());
+        SkAutoTMalloc<SkBBoxHierarchy::Metadata> meta(fRecord->count());
+        SkRecordFillBounds(SkRect::Make(fBitmap.bounds()), *fRecord, bounds, meta);
+
+        // Only ops before stop go into the R-tree, so only they are played back.
+        sk_sp<SkBBoxHierarchy> bbh = SkRTreeFactory()();
+        bbh->insert(bounds, meta, stop);
+
+        auto tileBounds = [&](int i) {
+            return SkIRect::MakeLTRB(0, (int)((int64_t)h *  i      / tileCount),
+                                     w, (int)((int64_t)h * (i + 1) / tileCount));
+        };
+        auto guardBounds = [&](const SkIRect& tile) {
+            SkIRect guarded = tile.makeOutset(0, kTileGuard);
+            SkAssertResult(guarded.intersect(fBitmap.bounds()));
+            return guarded;
+        };
+        auto copyRect = [](const SkBitmap& src, const SkBitmap& dst, const SkIRect& rect) {
+            SkPixmap srcRect, dstRect;
+            SkAssertResult(src.pixmap().extractSubset(&srcRect, rect) &&
+                           dst.pixmap().extractSubset(&dstRect, rect));
+            SkAssertResult(srcRect.readPixels(dstRect));
+        };
+
+        SkExecutor& executor = fExecutor ? *fExecutor : SkExecutor::GetDefault();
+        SkTaskGroup tasks(executor);
+        // Every tile reads its guard before any tile writes its pixels back.
+        tasks.batch(tileCount, [&](int i) {
+            copyRect(fBitmap, scratch[i % 2], guardBounds(tileBounds(i)));
+        });
+        tasks.wait();
+        tasks.batch(tileCount, [&](int i) {
+            const SkIRect tile = tileBounds(i);
+            auto device = sk_make_sp<SkBitmapDevice>(scratch[i % 2], this->props());
+            device->setBlitBounds(guardBounds(tile));
+            SkCanvas canvas(device);
+
+            // Just as SkRecordDraw() does with a clipped canvas, only play back the ops that may
+            // draw into the tile.
+            std::vector<int> ops;
+            bbh->search(SkRect::Make(tile.makeOutset(1, 1)), &ops);
+            SkRecords::Draw draw(&canvas, drawablePicts, nullptr, drawableCount);
+            for (int op : ops) {
+                fRecord->visit(op, draw);
+            }
+
+            copyRect(scratch[i % 2], fBitmap, tile);
+        });
+    }
+
+    this->discardPlayedBackOps(stop);
+}
+
+void SkSurface_RasterTiled::discardPlayedBackOps(int stop) {
+    // Walk the played back ops, discarding draws and any save block that was restored.
+    // What's left are the open saves and the matrix and clip changes that are still in effect.
+    SkTDArray<int> saves;
+    ClassifyOp classify;
+    for (int i = 0; i < stop; i++) {
+        switch (fRecord->visit(i, classify)) {
+            case OpKind::kSave:
+            case OpKind::kSaveLayer:
+                saves.push_back(i);
+                break;
+            case OpKind::kRestore: {
+                int save = saves.isEmpty() ? i : saves.back();
+                if (!saves.isEmpty()) {
+                    saves.pop();
+                }
+                for (int j = save; j <= i; j++) {
+                    fRecord->replace<SkRecords::NoOp>(j);
+                }
+                break;
+            }
+            case OpKind::kState:
+                break;
+            case OpKind::kOther:
+                fRecord->replace<SkRecords::NoOp>(i);
+                break;
+        }
+    }
+    fRecord->defrag();
+
+    if (fRecord->count() == 0) {
+        // Nothing is left to carry over, so the recorder's canvas is in its initial state.
+        // Starting over with a fresh SkRecord releases the memory of everything played back.
+        fRecord = sk_make_sp<SkRecord>();
+        fRecorder->reset(fRecord.get(), SkRect::Make(fBitmap.bounds()));
+    }
+}
+
+void SkSurface_RasterTiled::onDraw(SkCanvas* canvas, SkScalar x, SkScalar y,
+                                   const SkSamplingOptions& sampling, const SkPaint* paint) {
+    this->playbackPendingDraws();
+    canvas->drawImage(fBitmap.asImage().get(), x, y, sampling, paint);
+}
+
+sk_sp<SkImage> SkSurface_RasterTiled::onNewImageSnapshot(const SkIRect* subset) {
+    this->playbackPendingDraws();
+
+    if (subset) {
+        SkASSERT(SkIRect::MakeWH(fBitmap.width(), fBitmap.height()).contains(*subset));
+        SkBitmap dst;
+        dst.allocPixels(fBitmap.info().makeDimensions(subset->size()));
+        SkAssertResult(fBitmap.readPixels(dst.pixmap(), subset->left(), subset->top()));
+        dst.setImmutable(); // key, so MakeFromBitmap doesn't make a copy of the buffer
+        return dst.asImage();
+    }
+
+    // SkImage_raster requires these pixels are immutable for its full lifetime.
+    // We'll undo this via onRestoreBackingMutability() if we can avoid the COW.
+    if (SkPixelRef* pr = fBitmap.pixelRef()) {
+        pr->setTemporarilyImmutable();
+    }
+    return SkMakeImageFromRasterBitmap(fBitmap, kIfMutable_SkCopyPixelsMode);
+}
+
+void SkSurface_RasterTiled::onWritePixels(const SkPixmap& src, int x, int y) {
+    this->playbackPendingDraws();
+    fBitmap.writePixels(src, x, y);
+}
+
+bool SkSurface_RasterTiled::onPeekPixels(SkPixmap* pmap) {
+    this->playbackPendingDraws();
+    return fBitmap.peekPixels(pmap);
+}
+
+bool SkSurface_RasterTiled::onReadPixels(const SkPixmap& dst, int srcX, int srcY) {
+    this->playbackPendingDraws();
+    return fBitmap.readPixels(dst, srcX, srcY);
+}
+
+void SkSurface_RasterTiled::onRestoreBackingMutability() {
+    SkASSERT(!this->hasCachedImage());  // Shouldn't be any snapshots out there.
+    if (SkPixelRef* pr = fBitmap.pixelRef()) {
+        pr->restoreMutability();
+    }
+}
+
+bool SkSurface_RasterTiled::onCopyOnWrite(ContentChangeMode mode) {
+    // Every snapshot plays back all pending draws first, so the draw about to be recorded is
+    // the first to touch pixels the snapshot may share.  Unlike SkSurface_Raster, no canvas
+    // holds onto fBitmap, so swapping in a copy is all there is to do.
+    sk_sp<SkImage> cached(this->refCachedImage());
+    SkASSERT(cached);
+    if (SkBitmapImageGetPixelRef(cached.get()) == fBitmap.pixelRef()) {
+        SkBitmap prev(fBitmap);
+        if (!fBitmap.tryAllocPixels()) {
+            return false;
+        }
+        if (kRetain_ContentChangeMode == mode) {
+            SkASSERT(prev.info() == fBitmap.info());
+            SkASSERT(prev.rowBytes() == fBitmap.rowBytes());
+            memcpy(fBitmap.getPixels(), prev.getPixels(), fBitmap.computeByteSize());
+        }
+    }
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+sk_sp<SkSurface> SkSurface::MakeRasterTiled(const SkImageInfo& info, SkExecutor* executor,
+                                            int tileCount, const SkSurfaceProps* props) {
+    if (!SkSurfaceValidateRasterInfo(info)) {
+        return nullptr;
+    }
+
+    sk_sp<SkPixelRef> pr = SkMallocPixelRef::MakeAllocate(info, 0);
+    if (!pr) {
+        return nullptr;
+    }
+    return sk_make_sp<SkSurface_RasterTiled>(info, std::move(pr), executor, tileCount, props);
+}
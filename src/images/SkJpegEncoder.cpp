@@ -9,16 +9,20 @@
 
 #ifdef SK_ENCODE_JPEG
 
+#include "include/core/SkMath.h"
 #include "include/core/SkStream.h"
 #include "include/encode/SkJpegEncoder.h"
 #include "include/private/SkColorData.h"
 #include "include/private/SkImageInfoPriv.h"
 #include "include/private/SkTemplates.h"
+#include "include/private/SkTo.h"
 #include "src/core/SkMSAN.h"
+#include "src/core/SkTaskGroup.h"
 #include "src/images/SkImageEncoderFns.h"
 #include "src/images/SkJPEGWriteUtility.h"
 
 #include <stdio.h>
+#include <vector>
 
 extern "C" {
     #include "jpeglib.h"
@@ -44,6 +48,10 @@ public:
 
     transform_scanline_proc proc() const { return fProc; }
 
+    SkWStream* stream() const { return fDstMgr.fStream; }
+
+    const SkJpegEncoder::Options& options() const { return fOptions; }
+
     ~SkJpegEncoderMgr() {
         jpeg_destroy_compress(&fCInfo);
     }
@@ -64,6 +72,7 @@ private:
     skjpeg_error_mgr        fErrMgr;
     skjpeg_destination_mgr  fDstMgr;
     transform_scanline_proc fProc;
+    SkJpegEncoder::Options  fOptions;
 };
 
 bool SkJpegEncoderMgr::setParams(const SkImageInfo& srcInfo, const SkJpegEncoder::Options& options)
@@ -161,6 +170,12 @@ bool SkJpegEncoderMgr::setParams(const SkImageInfo& srcInfo, const SkJpegEncoder
     // for the image.  This improves compression at the cost of
     // slower encode performance.
     fCInfo.optimize_coding = TRUE;
+
+    if (options.fRestartInterval < 0 || options.fRestartInterval > 65535) {
+        return false;
+    }
+    fCInfo.restart_in_rows = options.fRestartInterval;
+    fOptions = options;
     return true;
 }
 
@@ -209,25 +224,23 @@ SkJpegEncoder::SkJpegEncoder(std::unique_ptr<SkJpegEncoderMgr> encoderMgr, const
 
 SkJpegEncoder::~SkJpegEncoder() {}
 
-bool SkJpegEncoder::onEncodeRows(int numRows) {
-    skjpeg_error_mgr::AutoPushJmpBuf jmp(fEncoderMgr->errorMgr());
-    if (setjmp(jmp)) {
-        return false;
-    }
-
-    const size_t srcBytes = SkColorTypeBytesPerPixel(fSrc.colorType()) * fSrc.width();
-    const size_t jpegSrcBytes = fEncoderMgr->cinfo()->input_components * fSrc.width();
+// Converts |numRows| rows of |src|, starting at |startRow|, and hands them to |mgr|'s compressor.
+// |storage| must hold one converted row if |mgr| has a proc.
+static void write_rows(SkJpegEncoderMgr* mgr, const SkPixmap& src, int startRow, int numRows,
+                       JSAMPLE* storage) {
+    const size_t srcBytes = SkColorTypeBytesPerPixel(src.colorType()) * src.width();
+    const size_t jpegSrcBytes = mgr->cinfo()->input_components * src.width();
 
-    const void* srcRow = fSrc.addr(0, fCurrRow);
+    const void* srcRow = src.addr(0, startRow);
     for (int i = 0; i < numRows; i++) {
         JSAMPLE* jpegSrcRow = (JSAMPLE*) srcRow;
-        if (fEncoderMgr->proc()) {
+        if (mgr->proc()) {
             sk_msan_assert_initialized(srcRow, SkTAddOffset<const void>(srcRow, srcBytes));
-            fEncoderMgr->proc()((char*)fStorage.get(),
-                                (const char*)srcRow,
-                                fSrc.width(),
-                                fEncoderMgr->cinfo()->input_components);
-            jpegSrcRow = fStorage.get();
+            mgr->proc()((char*)storage,
+                        (const char*)srcRow,
+                        src.width(),
+                        mgr->cinfo()->input_components);
+            jpegSrcRow = storage;
             sk_msan_assert_initialized(jpegSrcRow,
                                        SkTAddOffset<const void>(jpegSrcRow, jpegSrcBytes));
         } else {
@@ -237,9 +250,238 @@ bool SkJpegEncoder::onEncodeRows(int numRows) {
                                        SkTAddOffset<const void>(jpegSrcRow, jpegSrcBytes));
         }
 
-        jpeg_write_scanlines(fEncoderMgr->cinfo(), &jpegSrcRow, 1);
-        srcRow = SkTAddOffset<const void>(srcRow, fSrc.rowBytes());
+        jpeg_write_scanlines(mgr->cinfo(), &jpegSrcRow, 1);
+        srcRow = SkTAddOffset<const void>(srcRow, src.rowBytes());
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Parallel encoding
+///////////////////////////////////////////////////////////////////////////////
+
+// Images with at least this many pixels are encoded in strips on an executor.
+static constexpr SkRowBanding kBanding = {1024 * 1024};
+// Roughly how many pixels each strip encodes.
+static constexpr int kStripArea = 512 * 1024;
+// A restart interval is counted in MCUs, in 16 bits.
+static constexpr int kMaxRestartInterval = 65535;
+
+static constexpr uint8_t kSOF0Marker = 0xC0;
+static constexpr uint8_t kRST0Marker = 0xD0;
+static constexpr uint8_t kEOIMarker  = 0xD9;
+static constexpr uint8_t kSOSMarker  = 0xDA;
+
+static int mcu_width(const jpeg_compress_struct* cinfo) {
+    return DCTSIZE * cinfo->max_h_samp_factor;
+}
+
+static int mcu_height(const jpeg_compress_struct* cinfo) {
+    return DCTSIZE * cinfo->max_v_samp_factor;
+}
+
+// Returns how many rows of MCUs each strip should hold, or 0 if the image should not be split.
+// |restartInterval| is SkJpegEncoder::Options::fRestartInterval.
+static int choose_strip_mcu_rows(const jpeg_compress_struct* cinfo, int width,
+                                 int restartInterval) {
+    const int mcusPerRow = (width + mcu_width(cinfo) - 1) / mcu_width(cinfo);
+    const int mcuRows = SkToInt((cinfo->image_height + mcu_height(cinfo) - 1) /
+                                mcu_height(cinfo));
+
+    int stripMCURows = std::max(1, kStripArea / (width * mcu_height(cinfo)));
+    if (restartInterval > 0) {
+        // Strips hold whole restart intervals, which libjpeg would have clamped if too long.
+        if (restartInterval * mcusPerRow > kMaxRestartInterval) {
+            return 0;
+        }
+        stripMCURows = (stripMCURows + restartInterval - 1) / restartInterval * restartInterval;
+    } else {
+        // Each strip is one restart interval.
+        stripMCURows = std::min(stripMCURows, kMaxRestartInterval / mcusPerRow);
+    }
+    return stripMCURows < mcuRows ? stripMCURows : 0;
+}
+
+namespace {
+
+// Rows [fStartRow, fEndRow), encoded as a jpeg of their own.
+struct JpegStrip {
+    int           fStartRow;
+    int           fEndRow;
+    int           fRestartsBefore;  // Restart intervals in the strips above this one.
+    sk_sp<SkData> fData;
+    size_t        fSOFOffset = 0;   // Of the SOF0 marker in fData.
+    size_t        fScanOffset = 0;  // Of the entropy-coded data, which runs up to the EOI marker.
+    bool          fSuccess = false;
+};
+
+}  // namespace
+
+// Finds the frame header and the entropy-coded data in |strip|'s jpeg, and renumbers its
+// restart markers to follow on from the strips above.
+static bool parse_strip(JpegStrip* strip) {
+    uint8_t* data = (uint8_t*)strip->fData->writable_data();
+    const size_t size = strip->fData->size();
+    if (size < 4 || data[size - 2] != 0xFF || data[size - 1] != kEOIMarker) {
+        return false;
+    }
+
+    size_t offset = 2;  // Skip SOI.
+    for (;;) {
+        if (offset + 4 > size || data[offset] != 0xFF) {
+            return false;
+        }
+        const uint8_t marker = data[offset + 1];
+        const size_t length = (data[offset + 2] << 8) | data[offset + 3];
+        if (kSOF0Marker == marker) {
+            strip->fSOFOffset = offset;
+        }
+        offset += 2 + length;
+        if (kSOSMarker == marker) {
+            break;
+        }
+    }
+    if (0 == strip->fSOFOffset || offset > size - 2) {
+        return false;
+    }
+    strip->fScanOffset = offset;
+
+    // Outside of markers, 0xFF is always followed by a zero byte, so this only finds RSTs.
+    const int renumber = strip->fRestartsBefore % 8;
+    if (renumber != 0) {
+        for (size_t i = offset; i + 1 < size - 2; i++) {
+            if (0xFF == data[i] && (data[i + 1] & ~7) == kRST0Marker) {
+                data[i + 1] = kRST0Marker + ((data[i + 1] - kRST0Marker + renumber) & 7);
+                i++;
+            }
+        }
     }
+    return true;
+}
+
+static void encode_strip(const SkPixmap& src, const SkJpegEncoder::Options& options,
+                         unsigned int restartInterval, JpegStrip* strip) {
+    SkPixmap rows;
+    SkAssertResult(src.extractSubset(&rows, SkIRect::MakeLTRB(0, strip->fStartRow, src.width(),
+                                                              strip->fEndRow)));
+    SkDynamicMemoryWStream stream;
+    std::unique_ptr<SkJpegEncoderMgr> mgr = SkJpegEncoderMgr::Make(&stream);
+    SkAutoTMalloc<JSAMPLE> storage;
+
+    skjpeg_error_mgr::AutoPushJmpBuf jmp(mgr->errorMgr());
+    if (setjmp(jmp)) {
+        return;
+    }
+
+    if (!mgr->setParams(rows.info(), options)) {
+        return;
+    }
+    jpeg_compress_struct* cinfo = mgr->cinfo();
+    jpeg_set_quality(cinfo, options.fQuality, TRUE);
+    // Only the frame header of the first strip is kept, so every strip must use the same
+    // Huffman tables: the standard ones.
+    cinfo->optimize_coding = FALSE;
+    cinfo->write_JFIF_header = FALSE;
+    cinfo->restart_in_rows = 0;
+    cinfo->restart_interval = restartInterval;
+    jpeg_start_compress(cinfo, TRUE);
+
+    if (mgr->proc()) {
+        storage.reset(cinfo->input_components * rows.width());
+    }
+    write_rows(mgr.get(), rows, 0, rows.height(), storage.get());
+    jpeg_finish_compress(cinfo);
+
+    strip->fData = stream.detachAsData();
+    strip->fSuccess = parse_strip(strip);
+}
+
+// Encodes all of |src| in strips of |stripMCURows| rows of MCUs, in parallel, and writes them
+// after the markers |mgr| has already written, as one baseline jpeg with restart markers between
+// the strips.
+static bool encode_rows_in_parallel(SkExecutor& executor, const SkPixmap& src, int stripMCURows,
+                                    SkJpegEncoderMgr* mgr) {
+    const SkJpegEncoder::Options& options = mgr->options();
+    jpeg_compress_struct* cinfo = mgr->cinfo();
+    const int mcusPerRow = (src.width() + mcu_width(cinfo) - 1) / mcu_width(cinfo);
+    const int restartRows = options.fRestartInterval > 0 ? options.fRestartInterval
+                                                         : stripMCURows;
+    const int stripRows = stripMCURows * mcu_height(cinfo);
+    const int stripCount = (src.height() + stripRows - 1) / stripRows;
+
+    std::vector<JpegStrip> strips(stripCount);
+    for (int i = 0; i < stripCount; i++) {
+        strips[i].fStartRow = i * stripRows;
+        strips[i].fEndRow = std::min(src.height(), (i + 1) * stripRows);
+        strips[i].fRestartsBefore = i * (stripMCURows / restartRows);
+    }
+
+    SkTaskGroup tg(executor);
+    tg.batch(stripCount, [&](int i) {
+        encode_strip(src, options, SkToUInt(restartRows * mcusPerRow), &strips[i]);
+    });
+    tg.wait();
+
+    for (const JpegStrip& strip : strips) {
+        if (!strip.fSuccess) {
+            return false;
+        }
+    }
+
+    // |mgr|'s compressor has written SOI and any markers (such as the ICC profile), but none
+    // of the frame. Flush those and write the frame ourselves.
+    cinfo->dest->term_destination((j_compress_ptr)cinfo);
+    jpeg_abort_compress(cinfo);
+    SkWStream* stream = mgr->stream();
+
+    // The first strip's frame header (after its SOI), with the height of the whole image.
+    const JpegStrip& first = strips.front();
+    SkAutoTMalloc<uint8_t> header(first.fScanOffset - 2);
+    memcpy(header.get(), first.fData->bytes() + 2, first.fScanOffset - 2);
+    uint8_t* height = header.get() + (first.fSOFOffset - 2) + 5;
+    height[0] = (uint8_t)(src.height() >> 8);
+    height[1] = (uint8_t)src.height();
+    if (!stream->write(header.get(), first.fScanOffset - 2)) {
+        return false;
+    }
+
+    for (const JpegStrip& strip : strips) {
+        if (strip.fRestartsBefore > 0) {
+            const uint8_t restart[] = { 0xFF, (uint8_t)(kRST0Marker +
+                                                        ((strip.fRestartsBefore - 1) & 7)) };
+            if (!stream->write(restart, sizeof(restart))) {
+                return false;
+            }
+        }
+        if (!stream->write(strip.fData->bytes() + strip.fScanOffset,
+                           strip.fData->size() - 2 - strip.fScanOffset)) {
+            return false;
+        }
+    }
+
+    const uint8_t eoi[] = { 0xFF, kEOIMarker };
+    return stream->write(eoi, sizeof(eoi));
+}
+
+bool SkJpegEncoder::onEncodeRows(int numRows) {
+    skjpeg_error_mgr::AutoPushJmpBuf jmp(fEncoderMgr->errorMgr());
+    if (setjmp(jmp)) {
+        return false;
+    }
+
+    // Encoding the whole image at once lets it be split into strips that encode in parallel.
+    const SkJpegEncoder::Options& options = fEncoderMgr->options();
+    if (options.fExecutor && 0 == fCurrRow && numRows == fSrc.height() &&
+        kBanding.worthSplitting(sk_64_mul(fSrc.width(), fSrc.height()))) {
+        const int stripMCURows = choose_strip_mcu_rows(fEncoderMgr->cinfo(), fSrc.width(),
+                                                       options.fRestartInterval);
+        if (stripMCURows > 0) {
+            fCurrRow = numRows;
+            return encode_rows_in_parallel(*options.fExecutor, fSrc, stripMCURows,
+                                           fEncoderMgr.get());
+        }
+    }
+
+    write_rows(fEncoderMgr.get(), fSrc, fCurrRow, numRows, fStorage.get());
 
     fCurrRow += numRows;
     if (fCurrRow == fSrc.height()) {
@@ -9,17 +9,22 @@
 
 #ifdef SK_ENCODE_PNG
 
+#include "include/core/SkMath.h"
 #include "include/core/SkStream.h"
 #include "include/core/SkString.h"
 #include "include/encode/SkPngEncoder.h"
 #include "include/private/SkImageInfoPriv.h"
+#include "include/private/SkTo.h"
+#include "include/private/SkVx.h"
 #include "src/codec/SkColorTable.h"
 #include "src/codec/SkPngPriv.h"
 #include "src/core/SkMSAN.h"
+#include "src/core/SkTaskGroup.h"
 #include "src/images/SkImageEncoderFns.h"
 #include <vector>
 
 #include <png.h>
+#include "zlib.h"
 
 static_assert(PNG_FILTER_NONE  == (int)SkPngEncoder::FilterFlag::kNone,  "Skia libpng filter err.");
 static_assert(PNG_FILTER_SUB   == (int)SkPngEncoder::FilterFlag::kSub,   "Skia libpng filter err.");
@@ -45,6 +50,8 @@ static void sk_write_fn(png_structp png_ptr, png_bytep data, png_size_t len) {
     }
 }
 
+class PngRowWriter;
+
 class SkPngEncoderMgr final : SkNoncopyable {
 public:
 
@@ -63,10 +70,16 @@ public:
     png_infop infoPtr() { return fInfoPtr; }
     int pngBytesPerPixel() const { return fPngBytesPerPixel; }
     transform_scanline_proc proc() const { return fProc; }
+    SkExecutor* executor() const { return fExecutor; }
+    int filters() const { return fFilters; }
+    bool selectFiltersWithSkia() const { return fSelectFiltersWithSkia; }
+    int zlibLevel() const { return fZLibLevel; }
 
-    ~SkPngEncoderMgr() {
-        png_destroy_write_struct(&fPngPtr, &fInfoPtr);
-    }
+    // When set, it filters and compresses the rows instead of libpng.
+    PngRowWriter* rowWriter() const { return fRowWriter.get(); }
+    void setRowWriter(std::unique_ptr<PngRowWriter> writer) { fRowWriter = std::move(writer); }
+
+    ~SkPngEncoderMgr();
 
 private:
 
@@ -75,10 +88,15 @@ private:
         , fInfoPtr(infoPtr)
     {}
 
-    png_structp             fPngPtr;
-    png_infop               fInfoPtr;
-    int                     fPngBytesPerPixel;
-    transform_scanline_proc fProc;
+    png_structp                   fPngPtr;
+    png_infop                     fInfoPtr;
+    int                           fPngBytesPerPixel;
+    transform_scanline_proc       fProc;
+    SkExecutor*                   fExecutor = nullptr;
+    int                           fFilters = 0;
+    bool                          fSelectFiltersWithSkia = false;
+    int                           fZLibLevel = 0;
+    std::unique_ptr<PngRowWriter> fRowWriter;
 };
 
 std::unique_ptr<SkPngEncoderMgr> SkPngEncoderMgr::Make(SkWStream* stream) {
@@ -202,6 +220,11 @@ bool SkPngEncoderMgr::setHeader(const SkImageInfo& srcInfo, const SkPngEncoder::
     SkASSERT(zlibLevel == options.fZLibLevel);
     png_set_compression_level(fPngPtr, zlibLevel);
 
+    fExecutor = options.fExecutor;
+    fFilters = filters;
+    fSelectFiltersWithSkia = options.fSelectFiltersWithSkia;
+    fZLibLevel = zlibLevel;
+
     // Set comments in tEXt chunk
     const sk_sp<SkDataTable>& comments = options.fComments;
     if (comments != nullptr) {
@@ -433,11 +456,484 @@ SkPngEncoder::SkPngEncoder(std::unique_ptr<SkPngEncoderMgr> encoderMgr, const Sk
 
 SkPngEncoder::~SkPngEncoder() {}
 
+///////////////////////////////////////////////////////////////////////////////
+// Row filtering
+///////////////////////////////////////////////////////////////////////////////
+
+// The filter type byte written before each filtered row.
+enum PngFilterType : uint8_t {
+    kNone_PngFilterType  = 0,
+    kSub_PngFilterType   = 1,
+    kUp_PngFilterType    = 2,
+    kAvg_PngFilterType   = 3,
+    kPaeth_PngFilterType = 4,
+};
+
+template <int N> using U8  = skvx::Vec<N, uint8_t>;
+template <int N> using U16 = skvx::Vec<N, uint16_t>;
+
+// Each filter predicts a byte from the byte of the previous pixel (a), the byte above (b) and
+// the byte above the previous pixel (c), and stores the difference from that prediction.
+struct NoneFilter {
+    static constexpr PngFilterType kType = kNone_PngFilterType;
+    template <int N> static U8<N> Predict(const U8<N>&, const U8<N>&, const U8<N>&) {
+        return U8<N>(0);
+    }
+};
+
+struct SubFilter {
+    static constexpr PngFilterType kType = kSub_PngFilterType;
+    template <int N> static U8<N> Predict(const U8<N>& a, const U8<N>&, const U8<N>&) {
+        return a;
+    }
+};
+
+struct UpFilter {
+    static constexpr PngFilterType kType = kUp_PngFilterType;
+    template <int N> static U8<N> Predict(const U8<N>&, const U8<N>& b, const U8<N>&) {
+        return b;
+    }
+};
+
+struct AvgFilter {
+    static constexpr PngFilterType kType = kAvg_PngFilterType;
+    template <int N> static U8<N> Predict(const U8<N>& a, const U8<N>& b, const U8<N>&) {
+        // (a + b) / 2, without overflowing a byte.
+        return (a & b) + ((a ^ b) >> 1);
+    }
+};
+
+struct PaethFilter {
+    static constexpr PngFilterType kType = kPaeth_PngFilterType;
+    template <int N> static U8<N> Predict(const U8<N>& a, const U8<N>& b, const U8<N>& c) {
+        auto absdiff = [](const U8<N>& x, const U8<N>& y) {
+            return skvx::max(x, y) - skvx::min(x, y);
+        };
+        // The distances from p = a + b - c to a, b and c, kept in bytes: |p - c| is pa + pb when
+        // b - c and a - c have the same sign, and |pa - pb| otherwise. It is only compared to pa
+        // and pb, so saturating it changes nothing.
+        const U8<N> pa = absdiff(b, c),
+                    pb = absdiff(a, c),
+                    sum = pa + pb,
+                    pc = skvx::if_then_else(~((b < c) ^ (a < c)), sum | (sum < pa),
+                                            absdiff(pa, pb));
+        // Ties go to a, then b.
+        return skvx::if_then_else((pa <= pb) & (pa <= pc), a,
+                                  skvx::if_then_else(pb <= pc, b, c));
+    }
+};
+
+// The heuristic libpng uses to choose among several filters: the sum of the filtered bytes'
+// magnitudes, taken as signed values. Smaller usually compresses better.
+template <int N> static U8<N> filtered_byte_cost(const U8<N>& filtered) {
+    return skvx::min(filtered, U8<N>(0) - filtered);
+}
+
+// Writes |row| filtered with |Filter| to |out| and returns its cost. |prior| is the unfiltered
+// previous row (zeros for the first row) and |bpp| the number of bytes per complete pixel,
+// rounded up to one.
+template <typename Filter>
+static size_t filter_row(const uint8_t* row, const uint8_t* prior, size_t n, int bpp,
+                         uint8_t* out) {
+    size_t cost = 0;
+    size_t i = 0;
+
+    // The first pixel has no previous pixel, so a and c are zero.
+    for (const size_t first = std::min<size_t>(bpp, n); i < first; i++) {
+        const U8<1> filtered = U8<1>(row[i]) - Filter::template Predict<1>(0, prior[i], 0);
+        out[i] = filtered.val;
+        cost += filtered_byte_cost(filtered).val;
+    }
+
+    // Filtering only ever reads the unfiltered rows, so every byte can be done at once.
+    // The costs are summed in pairs of bytes, and added up before those could overflow.
+    constexpr int kMaxChunksPerSum = 0xFFFF / (2 * 0xFF);
+    U16<8> sums(0);
+    int chunks = 0;
+    for (; i + 16 <= n; i += 16) {
+        const U8<16> filtered = U8<16>::Load(row + i) -
+                                Filter::template Predict<16>(U8<16>::Load(row + i - bpp),
+                                                             U8<16>::Load(prior + i),
+                                                             U8<16>::Load(prior + i - bpp));
+        filtered.store(out + i);
+        const U16<8> costs = skvx::bit_pun<U16<8>>(filtered_byte_cost(filtered));
+        sums += (costs & 0xFF) + (costs >> 8);
+        if (++chunks == kMaxChunksPerSum) {
+            for (int lane = 0; lane < 8; lane++) {
+                cost += sums[lane];
+            }
+            sums = 0;
+            chunks = 0;
+        }
+    }
+    for (int lane = 0; lane < 8; lane++) {
+        cost += sums[lane];
+    }
+
+    for (; i < n; i++) {
+        const U8<1> filtered = U8<1>(row[i]) - Filter::template Predict<1>(row[i - bpp],
+                                                                          prior[i],
+                                                                          prior[i - bpp]);
+        out[i] = filtered.val;
+        cost += filtered_byte_cost(filtered).val;
+    }
+    return cost;
+}
+
+// Writes the filter type byte and the filtered row to |out|, choosing among |filters| (a set of
+// SkPngEncoder::FilterFlags) per row as libpng does. |scratch| must hold one row.
+static void filter_row_adaptive(int filters, const uint8_t* row, const uint8_t* prior, size_t n,
+                                int bpp, uint8_t* out, uint8_t* scratch) {
+    using FilterRowProc = size_t (*)(const uint8_t*, const uint8_t*, size_t, int, uint8_t*);
+    static constexpr struct {
+        SkPngEncoder::FilterFlag flag;
+        PngFilterType            type;
+        FilterRowProc            proc;
+    } kFilters[] = {
+        { SkPngEncoder::FilterFlag::kNone,  NoneFilter::kType,  filter_row<NoneFilter>  },
+        { SkPngEncoder::FilterFlag::kSub,   SubFilter::kType,   filter_row<SubFilter>   },
+        { SkPngEncoder::FilterFlag::kUp,    UpFilter::kType,    filter_row<UpFilter>    },
+        { SkPngEncoder::FilterFlag::kAvg,   AvgFilter::kType,   filter_row<AvgFilter>   },
+        { SkPngEncoder::FilterFlag::kPaeth, PaethFilter::kType, filter_row<PaethFilter> },
+    };
+
+    if (0 == filters) {
+        filters = (int)SkPngEncoder::FilterFlag::kNone;
+    }
+
+    // Candidates alternate between out and scratch, so that the best so far is never copied.
+    uint8_t* candidate = out + 1;
+    const uint8_t* best = nullptr;
+    size_t bestCost = 0;
+    for (const auto& f : kFilters) {
+        if (!(filters & (int)f.flag)) {
+            continue;
+        }
+        const size_t cost = f.proc(row, prior, n, bpp, candidate);
+        if (!best || cost < bestCost) {
+            out[0] = f.type;
+            best = candidate;
+            bestCost = cost;
+            candidate = candidate == scratch ? out + 1 : scratch;
+        }
+    }
+    if (best != out + 1) {
+        memcpy(out + 1, best, n);
+    }
+}
+
+static bool write_u32(SkWStream* stream, uint32_t v) {
+    const uint8_t bytes[] = { (uint8_t)(v >> 24), (uint8_t)(v >> 16), (uint8_t)(v >> 8),
+                              (uint8_t)v };
+    return stream->write(bytes, sizeof(bytes));
+}
+
+static bool write_chunk(SkWStream* stream, const char type[4], const void* data, size_t length) {
+    uLong crc = crc32(0, (const Bytef*)type, 4);
+    if (length > 0) {
+        // crc32() treats a null buffer as a request for the initial value.
+        crc = crc32(crc, (const Bytef*)data, SkToUInt(length));
+    }
+    return write_u32(stream, SkToU32(length)) &&
+           stream->write(type, 4) &&
+           stream->write(data, length) &&
+           write_u32(stream, SkToU32(crc));
+}
+
+// libpng chooses among several filters in scalar code, which can take longer than deflate does
+// at low levels, and it has no way to be handed rows that are already filtered. So when several
+// filters are allowed and the caller asked for fSelectFiltersWithSkia, PngRowWriter filters the
+// rows itself and compresses them into IDAT chunks in place of png_write_rows() and
+// png_write_end().
+class PngRowWriter final : SkNoncopyable {
+public:
+    static std::unique_ptr<PngRowWriter> Make(SkWStream* stream, int filters, int zlibLevel,
+                                              size_t rowBytes, int bpp) {
+        std::unique_ptr<PngRowWriter> writer(
+                new PngRowWriter(stream, filters, rowBytes, bpp));
+        // The same zlib stream libpng would set up.
+        const int strategy = filters == (int)SkPngEncoder::FilterFlag::kNone ? Z_DEFAULT_STRATEGY
+                                                                             : Z_FILTERED;
+        if (Z_OK != deflateInit2(&writer->fZStream, zlibLevel, Z_DEFLATED, 15, 8, strategy)) {
+            return nullptr;
+        }
+        writer->fZStreamInitialized = true;
+        writer->fZStream.next_out = writer->fOutput.get();
+        writer->fZStream.avail_out = kChunkBytes;
+        return writer;
+    }
+
+    ~PngRowWriter() {
+        if (fZStreamInitialized) {
+            deflateEnd(&fZStream);
+        }
+    }
+
+    bool writeRow(const uint8_t* row) {
+        filter_row_adaptive(fFilters, row, fPrior.get(), fRowBytes, fBpp, fFiltered.get(),
+                            fScratch.get());
+        memcpy(fPrior.get(), row, fRowBytes);
+
+        fZStream.next_in = fFiltered.get();
+        fZStream.avail_in = SkToUInt(fRowBytes + 1);
+        while (fZStream.avail_in > 0) {
+            if (Z_OK != deflate(&fZStream, Z_NO_FLUSH)) {
+                return false;
+            }
+            if (0 == fZStream.avail_out && !this->writeOutput()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Ends the zlib stream and writes the last IDAT chunk, then IEND.
+    bool finish() {
+        for (;;) {
+            const int result = deflate(&fZStream, Z_FINISH);
+            if (Z_STREAM_END == result) {
+                break;
+            }
+            if (Z_OK != result || !this->writeOutput()) {
+                return false;
+            }
+        }
+        return this->writeOutput() && write_chunk(fStream, "IEND", nullptr, 0);
+    }
+
+private:
+    // libpng writes 8KB chunks. Larger ones cost fewer headers and CRC setups.
+    static constexpr uInt kChunkBytes = 32 * 1024;
+
+    PngRowWriter(SkWStream* stream, int filters, size_t rowBytes, int bpp)
+        : fStream(stream)
+        , fFilters(filters)
+        , fRowBytes(rowBytes)
+        , fBpp(bpp)
+        , fPrior(rowBytes)
+        , fFiltered(rowBytes + 1)
+        , fScratch(rowBytes)
+        , fOutput(kChunkBytes) {
+        sk_bzero(fPrior.get(), rowBytes);
+        memset(&fZStream, 0, sizeof(fZStream));
+    }
+
+    bool writeOutput() {
+        const size_t length = kChunkBytes - fZStream.avail_out;
+        fZStream.next_out = fOutput.get();
+        fZStream.avail_out = kChunkBytes;
+        return 0 == length || write_chunk(fStream, "IDAT", fOutput.get(), length);
+    }
+
+    SkWStream*             fStream;
+    const int              fFilters;
+    const size_t           fRowBytes;
+    const int              fBpp;
+    SkAutoTMalloc<uint8_t> fPrior;
+    SkAutoTMalloc<uint8_t> fFiltered;
+    SkAutoTMalloc<uint8_t> fScratch;
+    SkAutoTMalloc<uint8_t> fOutput;
+    z_stream               fZStream;
+    bool                   fZStreamInitialized = false;
+};
+
+SkPngEncoderMgr::~SkPngEncoderMgr() {
+    png_destroy_write_struct(&fPngPtr, &fInfoPtr);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Parallel encoding
+///////////////////////////////////////////////////////////////////////////////
+
+// Images with at least this many pixels are compressed in strips on an executor.
+static constexpr SkRowBanding kBanding = {1024 * 1024};
+// Roughly how much filtered data each strip compresses. As in pigz, each strip is primed with
+// the 32KB before it (deflate's whole window), so splitting barely costs any compression.
+static constexpr size_t kStripBytes = 256 * 1024;
+static constexpr size_t kDictionaryBytes = 32 * 1024;
+
+namespace {
+
+// Rows [fStartRow, fEndRow), filtered and compressed into the data of one IDAT chunk.
+struct PngStrip {
+    int                  fStartRow;
+    int                  fEndRow;
+    std::vector<uint8_t> fData;
+    uLong                fAdler = 0;  // Of the filtered rows.
+    uLong                fCrc = 0;    // Of the chunk type and fData.
+    bool                 fSuccess = false;
+};
+
+}  // namespace
+
+static void encode_strip(const SkPixmap& src, transform_scanline_proc proc, int bpp,
+                         size_t pngRowBytes, int filters, int zlibLevel, bool isLastStrip,
+                         PngStrip* strip) {
+    const size_t filteredRowBytes = pngRowBytes + 1;
+
+    // Also filter enough of the rows before this strip to fill deflate's window. Filtering a
+    // row only depends on it and the row before, so these bytes match the previous strip's.
+    const int dictionaryRows = std::min(strip->fStartRow,
+            SkToInt((kDictionaryBytes + filteredRowBytes - 1) / filteredRowBytes));
+    const int firstRow = strip->fStartRow - dictionaryRows;
+
+    SkAutoTMalloc<uint8_t> rows(3 * pngRowBytes);
+    uint8_t* prior = rows.get();
+    uint8_t* curr = prior + pngRowBytes;
+    uint8_t* scratch = curr + pngRowBytes;
+    const int srcBpp = SkColorTypeBytesPerPixel(src.colorType());
+    if (firstRow > 0) {
+        proc((char*)prior, (const char*)src.addr(0, firstRow - 1), src.width(), srcBpp);
+    } else {
+        sk_bzero(prior, pngRowBytes);
+    }
+
+    SkAutoTMalloc<uint8_t> filtered((strip->fEndRow - firstRow) * filteredRowBytes);
+    for (int y = firstRow; y < strip->fEndRow; y++) {
+        proc((char*)curr, (const char*)src.addr(0, y), src.width(), srcBpp);
+        filter_row_adaptive(filters, curr, prior, pngRowBytes, bpp,
+                            filtered.get() + (y - firstRow) * filteredRowBytes, scratch);
+        std::swap(prior, curr);
+    }
+
+    const uint8_t* stripBytes = filtered.get() + dictionaryRows * filteredRowBytes;
+    const size_t stripLength = (strip->fEndRow - strip->fStartRow) * filteredRowBytes;
+    strip->fAdler = adler32(adler32(0, Z_NULL, 0), stripBytes, SkToUInt(stripLength));
+
+    // Raw deflate, set up the way libpng sets up its own stream.
+    z_stream z;
+    memset(&z, 0, sizeof(z));
+    const int strategy = filters == (int)SkPngEncoder::FilterFlag::kNone ? Z_DEFAULT_STRATEGY
+                                                                         : Z_FILTERED;
+    if (Z_OK != deflateInit2(&z, zlibLevel, Z_DEFLATED, -15, 8, strategy)) {
+        return;
+    }
+    if (dictionaryRows > 0) {
+        const size_t dictionaryLength = std::min(kDictionaryBytes,
+                                                 dictionaryRows * filteredRowBytes);
+        deflateSetDictionary(&z, stripBytes - dictionaryLength, SkToUInt(dictionaryLength));
+    }
+
+    size_t written = 0;
+    if (0 == strip->fStartRow) {
+        // The zlib header: deflate with a 32KB window, no preset dictionary, and the level
+        // hint zlib itself would write.
+        const int levelHint = zlibLevel < 2 ? 0 : zlibLevel < 6 ? 1 : zlibLevel == 6 ? 2 : 3;
+        int header = (0x78 << 8) | (levelHint << 6);
+        header += 31 - header % 31;
+        strip->fData.push_back(header >> 8);
+        strip->fData.push_back(header & 0xFF);
+        written = strip->fData.size();
+    }
+
+    // Every strip but the last ends on a byte boundary with a sync flush, so that the next
+    // strip's deflate data can follow it directly.
+    const int flush = isLastStrip ? Z_FINISH : Z_SYNC_FLUSH;
+    z.next_in = const_cast<Bytef*>(stripBytes);
+    z.avail_in = SkToUInt(stripLength);
+    size_t capacity = written + deflateBound(&z, stripLength) + 16;
+    int result;
+    do {
+        strip->fData.resize(capacity);
+        z.next_out = strip->fData.data() + written;
+        z.avail_out = SkToUInt(capacity - written);
+        result = deflate(&z, flush);
+        written = capacity - z.avail_out;
+        capacity *= 2;
+    } while ((Z_OK == result || Z_BUF_ERROR == result) && 0 == z.avail_out);
+    deflateEnd(&z);
+
+    if (result != (isLastStrip ? Z_STREAM_END : Z_OK) || z.avail_in != 0) {
+        return;
+    }
+    strip->fData.resize(written);
+    strip->fCrc = crc32(crc32(0, (const Bytef*)"IDAT", 4), strip->fData.data(),
+                        SkToUInt(written));
+    strip->fSuccess = true;
+}
+
+// Filters and compresses all of |src| in strips, in parallel, then writes them as IDAT chunks
+// followed by IEND. The chunks before IDAT must already have been written.
+static bool encode_rows_in_parallel(SkExecutor& executor, const SkPixmap& src,
+                                    SkPngEncoderMgr* mgr, SkWStream* stream) {
+    const size_t pngRowBytes = png_get_rowbytes(mgr->pngPtr(), mgr->infoPtr());
+    const int rowsPerStrip = SkToInt(std::max<size_t>(1, kStripBytes / (pngRowBytes + 1)));
+    const int stripCount = (src.height() + rowsPerStrip - 1) / rowsPerStrip;
+
+    std::vector<PngStrip> strips(stripCount);
+    for (int i = 0; i < stripCount; i++) {
+        strips[i].fStartRow = i * rowsPerStrip;
+        strips[i].fEndRow = std::min(src.height(), (i + 1) * rowsPerStrip);
+    }
+
+    SkTaskGroup tg(executor);
+    tg.batch(stripCount, [&](int i) {
+        encode_strip(src, mgr->proc(), mgr->pngBytesPerPixel(), pngRowBytes, mgr->filters(),
+                     mgr->zlibLevel(), i == stripCount - 1, &strips[i]);
+    });
+    tg.wait();
+
+    // The zlib stream ends with the Adler-32 of all of the filtered rows, which we can put
+    // together from each strip's.
+    uLong adler = adler32(0, Z_NULL, 0);
+    for (const PngStrip& strip : strips) {
+        if (!strip.fSuccess) {
+            return false;
+        }
+        const size_t length = (strip.fEndRow - strip.fStartRow) * (pngRowBytes + 1);
+        adler = adler32_combine(adler, strip.fAdler, length);
+    }
+    const uint8_t adlerBytes[] = { (uint8_t)(adler >> 24), (uint8_t)(adler >> 16),
+                                   (uint8_t)(adler >> 8), (uint8_t)adler };
+
+    for (const PngStrip& strip : strips) {
+        const bool isLastStrip = &strip == &strips.back();
+        uLong crc = strip.fCrc;
+        size_t length = strip.fData.size();
+        if (isLastStrip) {
+            crc = crc32(crc, adlerBytes, sizeof(adlerBytes));
+            length += sizeof(adlerBytes);
+        }
+        if (!write_u32(stream, SkToU32(length)) ||
+            !stream->write("IDAT", 4) ||
+            !stream->write(strip.fData.data(), strip.fData.size()) ||
+            (isLastStrip && !stream->write(adlerBytes, sizeof(adlerBytes))) ||
+            !write_u32(stream, SkToU32(crc))) {
+            return false;
+        }
+    }
+
+    return write_chunk(stream, "IEND", nullptr, 0);
+}
+
 bool SkPngEncoder::onEncodeRows(int numRows) {
     if (setjmp(png_jmpbuf(fEncoderMgr->pngPtr()))) {
         return false;
     }
 
+    // Filtering the rows ourselves needs every row to be exactly what libpng would filter (no
+    // filler to strip).
+    const size_t pngRowBytes = (size_t)fEncoderMgr->pngBytesPerPixel() * fSrc.width();
+    const bool canFilterRows =
+            png_get_rowbytes(fEncoderMgr->pngPtr(), fEncoderMgr->infoPtr()) == pngRowBytes;
+    SkWStream* stream = (SkWStream*)png_get_io_ptr(fEncoderMgr->pngPtr());
+
+    // Encoding the whole image at once lets it be split into strips that compress in parallel.
+    if (fEncoderMgr->executor() && 0 == fCurrRow && numRows == fSrc.height() &&
+        kBanding.worthSplitting(sk_64_mul(fSrc.width(), fSrc.height())) && canFilterRows) {
+        fCurrRow = numRows;
+        return encode_rows_in_parallel(*fEncoderMgr->executor(), fSrc, fEncoderMgr.get(), stream);
+    }
+
+    const int filters = fEncoderMgr->filters();
+    if (0 == fCurrRow && canFilterRows && fEncoderMgr->selectFiltersWithSkia() &&
+        (filters & (filters - 1))) {
+        fEncoderMgr->setRowWriter(PngRowWriter::Make(stream, filters, fEncoderMgr->zlibLevel(),
+                                                     pngRowBytes,
+                                                     fEncoderMgr->pngBytesPerPixel()));
+    }
+    PngRowWriter* rowWriter = fEncoderMgr->rowWriter();
+
     const void* srcRow = fSrc.addr(0, fCurrRow);
     for (int y = 0; y < numRows; y++) {
         sk_msan_assert_initialized(srcRow,
@@ -448,12 +944,21 @@ bool SkPngEncoder::onEncodeRows(int numRows) {
                             SkColorTypeBytesPerPixel(fSrc.colorType()));
 
         png_bytep rowPtr = (png_bytep) fStorage.get();
-        png_write_rows(fEncoderMgr->pngPtr(), &rowPtr, 1);
+        if (rowWriter) {
+            if (!rowWriter->writeRow(rowPtr)) {
+                return false;
+            }
+        } else {
+            png_write_rows(fEncoderMgr->pngPtr(), &rowPtr, 1);
+        }
         srcRow = SkTAddOffset<const void>(srcRow, fSrc.rowBytes());
     }
 
     fCurrRow += numRows;
     if (fCurrRow == fSrc.height()) {
+        if (rowWriter) {
+            return rowWriter->finish();
+        }
         png_write_end(fEncoderMgr->pngPtr(), fEncoderMgr->infoPtr());
     }
 
@@ -46,6 +46,8 @@ namespace SkOpts {
         start_pipeline_lowp = SK_OPTS_NS::lowp::start_pipeline;
     #undef M
 
-        interpret_skvm = SK_OPTS_NS::interpret_skvm;
+        interpret_skvm          = SK_OPTS_NS::interpret_skvm;
+        decode_skvm_threaded    = SK_OPTS_NS::decode_skvm_threaded;
+        interpret_skvm_threaded = SK_OPTS_NS::interpret_skvm_threaded;
     }
 }  // namespace SkOpts
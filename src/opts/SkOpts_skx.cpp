@@ -12,6 +12,8 @@
 
 namespace SkOpts {
     void Init_skx() {
-        interpret_skvm = SK_OPTS_NS::interpret_skvm;
+        interpret_skvm          = SK_OPTS_NS::interpret_skvm;
+        decode_skvm_threaded    = SK_OPTS_NS::decode_skvm_threaded;
+        interpret_skvm_threaded = SK_OPTS_NS::interpret_skvm_threaded;
     }
 }  // namespace SkOpts
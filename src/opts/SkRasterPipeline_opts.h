@@ -2720,6 +2720,62 @@ STAGE(gauss_a_to_rgba, Ctx::None) {
     b = a;
 }
 
+// The integral of the blur kernel from x to infinity, with x in units of 2*sigma.  This is the
+// piecewise cubic gaussianIntegral() in SkBlurMask.cpp, so it agrees with SkBlurMask::BlurRect.
+SI F blur_integral(F x) {
+    x = min(max(x, -1.5f), 1.5f);
+    F x2 = x*x,
+      x3 = x*x2;
+    F lo  = 0.4375f - (x3*(1/6.0f) + 0.75f*x2 + 1.125f*x),
+      mid = 0.5f    - (0.75f*x - x3*(1/3.0f)),
+      hi  = 0.5625f - (x3*(1/6.0f) - 0.75f*x2 + 1.125f*x);
+    return if_then_else(x > 0.5f, hi, if_then_else(x > -0.5f, mid, lo));
+}
+
+// The blurred coverage at x of the span [lo,hi].
+SI F blur_span(F x, F lo, F hi, float invTwoSigma) {
+    return blur_integral((lo - x) * invTwoSigma) - blur_integral((hi - x) * invTwoSigma);
+}
+
+STAGE(blur_rect_coverage, const SkRasterPipeline_BlurRectCtx* ctx) {
+    const float k = ctx->invTwoSigma;
+    F c = blur_span(r, ctx->l, ctx->r, k)
+        * blur_span(g, ctx->t, ctx->b, k);
+    if (ctx->hasInner) {
+        c = max(0, c - blur_span(r, ctx->innerL, ctx->innerR, k)
+                     * blur_span(g, ctx->innerT, ctx->innerB, k));
+    }
+    r = g = b = a = c;
+}
+
+STAGE(blur_rrect_coverage, const SkRasterPipeline_BlurRectCtx* ctx) {
+    // The rrect isn't separable, so we integrate the kernel vertically over the rows it
+    // covers in slices, each of which sees the rrect as a horizontal span that narrows in
+    // the corners.  Slices are weighted by their exact share of the kernel, so the straight
+    // top and bottom edges come out the same as blur_rect_coverage.
+    const int   slices = ctx->slices;
+    const float k      = ctx->invTwoSigma,
+                reach  = 1.5f / k,                  // The kernel is zero past 3*sigma.
+                radius = ctx->radius;
+    F x = r,
+      y = g;
+    F lo   = max(y - reach, ctx->t),
+      hi   = min(y + reach, ctx->b),
+      step = max(0, hi - lo) * (1.0f / slices);
+
+    F c    = 0,
+      edge = blur_integral((lo - y) * k);
+    for (int i = 0; i < slices; i++) {
+        F next  = blur_integral(mad(step, (float)(i+1), lo - y) * k),
+          sy    = mad(step, i + 0.5f, lo),
+          dy    = max(0, max(ctx->t + radius - sy, sy - (ctx->b - radius))),
+          inset = radius - sqrt_(max(0, radius*radius - dy*dy));
+        c = mad(edge - next, blur_span(x, ctx->l + inset, ctx->r - inset, k), c);
+        edge = next;
+    }
+    r = g = b = a = c;
+}
+
 SI F tile(F v, SkTileMode mode, float limit, float invLimit) {
     // The ix_and_ptr() calls in sample() will clamp tile()'s output, so no need to clamp here.
     switch (mode) {
@@ -2883,6 +2939,46 @@ STAGE(bicubic_clamp_8888, const SkRasterPipeline_GatherCtx* ctx) {
     }
 }
 
+SI F sample_yuva_channel(const SkRasterPipeline_YUVACtx::Channel& c, F x, F y) {
+    if (c.snap) {
+        x = floor_(x) + 0.5f;
+        y = floor_(y) + 0.5f;
+    }
+    x = x * c.scaleX;
+    y = y * c.scaleY;
+
+    auto texel = [&](F tx, F ty) {
+        U32 ix = trunc_(clamp(ty, c.height)) * c.stride + trunc_(clamp(tx, c.width)) * c.bpp;
+        return from_byte(gather(c.pixels, ix));
+    };
+    if (!c.linear) {
+        return texel(x, y);
+    }
+    // Just like bilerp_clamp_8888, from the 4 texels at +/- 0.5 around (x,y).
+    F fx = fract(x + 0.5f),
+      fy = fract(y + 0.5f);
+    x -= 0.5f;
+    y -= 0.5f;
+    return lerp(lerp(texel(x, y  ), texel(x+1, y  ), fx),
+                lerp(texel(x, y+1), texel(x+1, y+1), fx), fy);
+}
+
+// Samples YUVA planes in place at (r,g) and converts to RGBA.  Alpha is unpremul.
+STAGE(sample_yuva, const SkRasterPipeline_YUVACtx* ctx) {
+    F x = r,
+      y = g;
+    F Y = sample_yuva_channel(ctx->channels[0], x, y),
+      U = sample_yuva_channel(ctx->channels[1], x, y),
+      V = sample_yuva_channel(ctx->channels[2], x, y);
+    a = ctx->hasAlpha ? sample_yuva_channel(ctx->channels[3], x, y) : F(1);
+
+    // The conversion never depends on alpha (nor changes it), so we skip those terms.
+    const float* m = ctx->matrix;
+    r = mad(Y,m[ 0], mad(U,m[ 1], mad(V,m[ 2], m[ 4])));
+    g = mad(Y,m[ 5], mad(U,m[ 6], mad(V,m[ 7], m[ 9])));
+    b = mad(Y,m[10], mad(U,m[11], mad(V,m[12], m[14])));
+}
+
 // ~~~~~~ skgpu::Swizzle stage ~~~~~~ //
 
 STAGE(swizzle, void* ctx) {
@@ -4237,6 +4333,69 @@ STAGE_GG(xy_to_radius, Ctx::None) {
     x = sqrt_(x*x + y*y);
 }
 
+// These mirror the highp 2pt conical stages above; t stays a float, so only the final
+// color lookup is done at 16-bit precision.
+
+STAGE_GG(negate_x, Ctx::None) { x = -x; }
+
+STAGE_GG(xy_to_2pt_conical_strip, const SkRasterPipeline_2PtConicalCtx* ctx) {
+    F& t = x;
+    t = x + sqrt_(ctx->fP0 - y*y); // ctx->fP0 = r0 * r0
+}
+
+STAGE_GG(xy_to_2pt_conical_focal_on_circle, Ctx::None) {
+    F& t = x;
+    t = x + y*y / x; // (x^2 + y^2) / x
+}
+
+STAGE_GG(xy_to_2pt_conical_well_behaved, const SkRasterPipeline_2PtConicalCtx* ctx) {
+    F& t = x;
+    t = sqrt_(x*x + y*y) - x * ctx->fP0; // ctx->fP0 = 1/r1
+}
+
+STAGE_GG(xy_to_2pt_conical_greater, const SkRasterPipeline_2PtConicalCtx* ctx) {
+    F& t = x;
+    t = sqrt_(x*x - y*y) - x * ctx->fP0; // ctx->fP0 = 1/r1
+}
+
+STAGE_GG(xy_to_2pt_conical_smaller, const SkRasterPipeline_2PtConicalCtx* ctx) {
+    F& t = x;
+    t = -sqrt_(x*x - y*y) - x * ctx->fP0; // ctx->fP0 = 1/r1
+}
+
+STAGE_GG(alter_2pt_conical_compensate_focal, const SkRasterPipeline_2PtConicalCtx* ctx) {
+    F& t = x;
+    t = t + ctx->fP1; // ctx->fP1 = f
+}
+
+STAGE_GG(alter_2pt_conical_unswap, Ctx::None) {
+    F& t = x;
+    t = 1 - t;
+}
+
+// The mask is written as 32-bit lanes, just like highp, so the two share one context layout.
+STAGE_GG(mask_2pt_conical_nan, SkRasterPipeline_2PtConicalCtx* c) {
+    F& t = x;
+    auto is_degenerate = (t != t); // NaN
+    t = if_then_else(is_degenerate, F(0), t);
+    sk_unaligned_store(&c->fMask, sk_bit_cast<U32>(~is_degenerate));
+}
+
+STAGE_GG(mask_2pt_conical_degenerates, SkRasterPipeline_2PtConicalCtx* c) {
+    F& t = x;
+    auto is_degenerate = (t <= 0) | (t != t);
+    t = if_then_else(is_degenerate, F(0), t);
+    sk_unaligned_store(&c->fMask, sk_bit_cast<U32>(~is_degenerate));
+}
+
+STAGE_PP(apply_vector_mask, const uint32_t* ctx) {
+    const U16 mask = cast<U16>(sk_unaligned_load<U32>(ctx));
+    r = r & mask;
+    g = g & mask;
+    b = b & mask;
+    a = a & mask;
+}
+
 // ~~~~~~ Compound stages ~~~~~~ //
 
 STAGE_PP(srcover_rgba_8888, const SkRasterPipeline_MemoryCtx* ctx) {
@@ -4334,17 +4493,19 @@ STAGE_PP(swizzle, void* ctx) {
     NOT_IMPLEMENTED(rgb_to_hsl)
     NOT_IMPLEMENTED(hsl_to_rgb)
     NOT_IMPLEMENTED(gauss_a_to_rgba)
+    NOT_IMPLEMENTED(blur_rect_coverage)
+    NOT_IMPLEMENTED(blur_rrect_coverage)
     NOT_IMPLEMENTED(mirror_x)
     NOT_IMPLEMENTED(repeat_x)
     NOT_IMPLEMENTED(mirror_y)
     NOT_IMPLEMENTED(repeat_y)
-    NOT_IMPLEMENTED(negate_x)
     NOT_IMPLEMENTED(bilinear)
 #if defined(SK_SUPPORT_LEGACY_BILERP_HIGHP)
     NOT_IMPLEMENTED(bilerp_clamp_8888)
 #endif
     NOT_IMPLEMENTED(bicubic)
     NOT_IMPLEMENTED(bicubic_clamp_8888)
+    NOT_IMPLEMENTED(sample_yuva)
     NOT_IMPLEMENTED(bilinear_nx)
     NOT_IMPLEMENTED(bilinear_ny)
     NOT_IMPLEMENTED(bilinear_px)
@@ -4359,16 +4520,6 @@ STAGE_PP(swizzle, void* ctx) {
     NOT_IMPLEMENTED(bicubic_p3y)
     NOT_IMPLEMENTED(save_xy)
     NOT_IMPLEMENTED(accumulate)
-    NOT_IMPLEMENTED(xy_to_2pt_conical_well_behaved)
-    NOT_IMPLEMENTED(xy_to_2pt_conical_strip)
-    NOT_IMPLEMENTED(xy_to_2pt_conical_focal_on_circle)
-    NOT_IMPLEMENTED(xy_to_2pt_conical_smaller)
-    NOT_IMPLEMENTED(xy_to_2pt_conical_greater)
-    NOT_IMPLEMENTED(alter_2pt_conical_compensate_focal)
-    NOT_IMPLEMENTED(alter_2pt_conical_unswap)
-    NOT_IMPLEMENTED(mask_2pt_conical_nan)
-    NOT_IMPLEMENTED(mask_2pt_conical_degenerates)
-    NOT_IMPLEMENTED(apply_vector_mask)
 #undef NOT_IMPLEMENTED
 
 #endif//defined(JUMPER_IS_SCALAR) controlling whether we build lowp stages
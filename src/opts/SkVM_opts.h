@@ -48,18 +48,39 @@ namespace SkVMInterpreterTypes {
         I16   i16;
         U16   u16;
     };
-}  // namespace SkVMInterpreterTypes
 
-    inline void interpret_skvm(const skvm::InterpreterInstruction insts[], const int ninsts,
-                               const int nregs, const int loop,
-                               const int strides[],
-                               skvm::TraceHook* traceHooks[], const int nTraceHooks,
-                               const int nargs, int n, void* args[]) {
-        using namespace skvm;
+    // Registers for a program, an array of Slots.
+    class Registers {
+    public:
+        explicit Registers(int nregs) {
+            if (nregs > (int)SK_ARRAY_COUNT(fFewRegs)) {
+                // Annoyingly we can't trust that malloc() or new will work with Slot because
+                // the skvx::Vec types may have alignment greater than what they provide.
+                // We'll overallocate one extra register so we can align manually.
+                fManyRegs.reset(new char[ sizeof(Slot) * (nregs + 1) ]);
+
+                uintptr_t addr = (uintptr_t)fManyRegs.get();
+                addr += alignof(Slot) -
+                         (addr & (alignof(Slot) - 1));
+                SkASSERT((addr & (alignof(Slot) - 1)) == 0);
+                fRegs = (Slot*)addr;
+            }
+        }
 
+        Slot* get() { return fRegs; }
+
+    private:
+        Slot                    fFewRegs[16];
+        std::unique_ptr<char[]> fManyRegs;
+        Slot*                   fRegs = fFewRegs;
+    };
+}  // namespace SkVMInterpreterTypes
+
+    // The ops both interpreters run, one handler per op.  Each runs a single instruction, either
+    // an InterpreterInstruction or a ThreadedInstruction, which share the same fields.
+    namespace SkVMInterpreterOps {
         using SkVMInterpreterTypes::K;
         using SkVMInterpreterTypes::I32;
-        using SkVMInterpreterTypes::I16;
         using SkVMInterpreterTypes::F32;
         using SkVMInterpreterTypes::U64;
         using SkVMInterpreterTypes::U32;
@@ -67,37 +88,260 @@ namespace SkVMInterpreterTypes {
         using SkVMInterpreterTypes::U8;
         using SkVMInterpreterTypes::Slot;
 
-        // We'll operate in SIMT style, knocking off K-size chunks from n while possible.
+        struct Context {
+            void**            args;
+            int               n,
+                              stride;
+            skvm::TraceHook** traceHooks;
+            int               nTraceHooks;
+        };
 
-        Slot                     few_regs[16];
-        std::unique_ptr<char[]> many_regs;
+    #define OP(name)                 \
+        template <typename Inst>     \
+        static inline void name(const Inst& inst, Slot* r, const Context& ctx)
+
+        // Ops that interact with memory need to know whether we're stride=1 or K,
+        // so they come in two flavors.  Everything else runs the same at either stride.
+        OP(store8_1 ) { memcpy(ctx.args[inst.immA], &r[inst.x].i32, 1); }
+        OP(store16_1) { memcpy(ctx.args[inst.immA], &r[inst.x].i32, 2); }
+        OP(store32_1) { memcpy(ctx.args[inst.immA], &r[inst.x].i32, 4); }
+        OP(store64_1) {
+            memcpy((char*)ctx.args[inst.immA]+0, &r[inst.x].i32, 4);
+            memcpy((char*)ctx.args[inst.immA]+4, &r[inst.y].i32, 4);
+        }
 
-        Slot* r = few_regs;
+        OP(store8_K ) { skvx::cast<uint8_t> (r[inst.x].i32).store(ctx.args[inst.immA]); }
+        OP(store16_K) { skvx::cast<uint16_t>(r[inst.x].i32).store(ctx.args[inst.immA]); }
+        OP(store32_K) {                     (r[inst.x].i32).store(ctx.args[inst.immA]); }
+        OP(store64_K) {
+            (skvx::cast<uint64_t>(r[inst.x].u32) << 0 |
+             skvx::cast<uint64_t>(r[inst.y].u32) << 32).store(ctx.args[inst.immA]);
+        }
 
-        if (nregs > (int)SK_ARRAY_COUNT(few_regs)) {
-            // Annoyingly we can't trust that malloc() or new will work with Slot because
-            // the skvx::Vec types may have alignment greater than what they provide.
-            // We'll overallocate one extra register so we can align manually.
-            many_regs.reset(new char[ sizeof(Slot) * (nregs + 1) ]);
+        OP(load8_1 ) { r[inst.d].i32 = 0; memcpy(&r[inst.d].i32, ctx.args[inst.immA], 1); }
+        OP(load16_1) { r[inst.d].i32 = 0; memcpy(&r[inst.d].i32, ctx.args[inst.immA], 2); }
+        OP(load32_1) { r[inst.d].i32 = 0; memcpy(&r[inst.d].i32, ctx.args[inst.immA], 4); }
+        OP(load64_1) {
+            r[inst.d].i32 = 0;
+            memcpy(&r[inst.d].i32, (char*)ctx.args[inst.immA] + 4*inst.immB, 4);
+        }
+
+        OP(load8_K ) { r[inst.d].i32 = skvx::cast<int>(U8 ::Load(ctx.args[inst.immA])); }
+        OP(load16_K) { r[inst.d].i32 = skvx::cast<int>(U16::Load(ctx.args[inst.immA])); }
+        OP(load32_K) { r[inst.d].i32 =                 I32::Load(ctx.args[inst.immA]) ; }
+        OP(load64_K) {
+            // Low 32 bits if immB=0, or high 32 bits if immB=1.
+            r[inst.d].i32 = skvx::cast<int>(U64::Load(ctx.args[inst.immA]) >> (32*inst.immB));
+        }
+
+        // The pointer we base our gather on is loaded indirectly from a uniform:
+        //     - args[immA] is the uniform holding our gather base pointer somewhere;
+        //     - (const uint8_t*)args[immA] + immB points to the gather base pointer;
+        //     - memcpy() loads the gather base and into a pointer of the right type.
+        // After all that we have an ordinary (uniform) pointer `ptr` to load from,
+        // and we then gather from it using the varying indices in r[x].
+        template <typename T, typename Inst>
+        static inline const T* gather_base(const Inst& inst, const Context& ctx) {
+            const T* ptr;
+            memcpy(&ptr, (const uint8_t*)ctx.args[inst.immA] + inst.immB, sizeof(ptr));
+            return ptr;
+        }
+
+        OP(gather8_1 ) { r[inst.d].i32 = gather_base<uint8_t >(inst, ctx)[r[inst.x].i32[0]]; }
+        OP(gather16_1) { r[inst.d].i32 = gather_base<uint16_t>(inst, ctx)[r[inst.x].i32[0]]; }
+        OP(gather32_1) { r[inst.d].i32 = gather_base<int     >(inst, ctx)[r[inst.x].i32[0]]; }
+
+        OP(gather8_K) {
+            const uint8_t* ptr = gather_base<uint8_t>(inst, ctx);
+            r[inst.d].i32 = map([&](int ix) { return (int)ptr[ix]; }, r[inst.x].i32);
+        }
+        OP(gather16_K) {
+            const uint16_t* ptr = gather_base<uint16_t>(inst, ctx);
+            r[inst.d].i32 = map([&](int ix) { return (int)ptr[ix]; }, r[inst.x].i32);
+        }
+        OP(gather32_K) { r[inst.d].i32 = gather32(gather_base<int>(inst, ctx), r[inst.x].i32); }
+
+        // These 128-bit ops are implemented serially for simplicity.
+        OP(store128) {
+            U64 lo = (skvx::cast<uint64_t>(r[inst.x].u32) << 0 |
+                      skvx::cast<uint64_t>(r[inst.y].u32) << 32),
+                hi = (skvx::cast<uint64_t>(r[inst.z].u32) << 0 |
+                      skvx::cast<uint64_t>(r[inst.w].u32) << 32);
+            for (int i = 0; i < ctx.stride; i++) {
+                memcpy((char*)ctx.args[inst.immA] + 16*i + 0, &lo[i], 8);
+                memcpy((char*)ctx.args[inst.immA] + 16*i + 8, &hi[i], 8);
+            }
+        }
+        OP(load128) {
+            r[inst.d].i32 = 0;
+            for (int i = 0; i < ctx.stride; i++) {
+                memcpy(&r[inst.d].i32[i], (const char*)ctx.args[inst.immA] + 16*i + 4*inst.immB, 4);
+            }
+        }
 
-            uintptr_t addr = (uintptr_t)many_regs.get();
-            addr += alignof(Slot) -
-                     (addr & (alignof(Slot) - 1));
-            SkASSERT((addr & (alignof(Slot) - 1)) == 0);
-            r = (Slot*)addr;
+        OP(assert_true) {
+        #ifdef SK_DEBUG
+            if (!all(r[inst.x].i32)) {
+                SkDebugf("register %d\n", inst.y);
+                for (int i = 0; i < K; i++) {
+                    SkDebugf("\t%2d: %08x (%g)\n", i, r[inst.y].i32[i], r[inst.y].f32[i]);
+                }
+                SkASSERT(false);
+            }
+        #endif
         }
 
-        const auto should_trace = [&](int stride, int immA, Reg x, Reg y) -> bool {
-            if (immA < 0 || immA >= nTraceHooks) {
+        template <typename Inst>
+        static inline bool should_trace(const Inst& inst, Slot* r, const Context& ctx) {
+            if (inst.immA < 0 || inst.immA >= ctx.nTraceHooks) {
                 return false;
             }
             // When stride == K, all lanes are used.
-            if (stride == K) {
-                return any(r[x].i32 & r[y].i32);
+            if (ctx.stride == K) {
+                return any(r[inst.x].i32 & r[inst.y].i32);
             }
             // When stride == 1, only the first lane is used; the rest are not meaningful.
-            return r[x].i32[0] & r[y].i32[0];
-        };
+            return r[inst.x].i32[0] & r[inst.y].i32[0];
+        }
+
+        OP(trace_line) {
+            if (should_trace(inst, r, ctx)) {
+                ctx.traceHooks[inst.immA]->line(inst.immB);
+            }
+        }
+        OP(trace_var) {
+            if (should_trace(inst, r, ctx)) {
+                for (int i = 0; i < K; ++i) {
+                    if (r[inst.x].i32[i] & r[inst.y].i32[i]) {
+                        ctx.traceHooks[inst.immA]->var(inst.immB, r[inst.z].i32[i]);
+                        break;
+                    }
+                }
+            }
+        }
+        OP(trace_enter) {
+            if (should_trace(inst, r, ctx)) {
+                ctx.traceHooks[inst.immA]->enter(inst.immB);
+            }
+        }
+        OP(trace_exit) {
+            if (should_trace(inst, r, ctx)) {
+                ctx.traceHooks[inst.immA]->exit(inst.immB);
+            }
+        }
+        OP(trace_scope) {
+            if (should_trace(inst, r, ctx)) {
+                ctx.traceHooks[inst.immA]->scope(inst.immB);
+            }
+        }
+
+        OP(index) {
+            const int iota[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,10,11,12,13,14,15,
+                                16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31,
+                                32,33,34,35,36,37,38,39,40,41,42,43,44,45,46,47,
+                                48,49,50,51,52,53,54,55,56,57,58,59,60,61,62,63 };
+            static_assert(K <= SK_ARRAY_COUNT(iota), "");
+
+            r[inst.d].i32 = ctx.n - I32::Load(iota);
+        }
+
+        OP(uniform32) {
+            r[inst.d].i32 = *(const int*)( (const char*)ctx.args[inst.immA] + inst.immB );
+        }
+        OP(array32) {
+            const int* ptr = gather_base<int>(inst, ctx);
+            r[inst.d].i32 = ptr[inst.immC/sizeof(int)];
+        }
+
+        OP(splat) { r[inst.d].i32 = inst.immA; }
+
+        OP(add_f32) { r[inst.d].f32 = r[inst.x].f32 + r[inst.y].f32; }
+        OP(sub_f32) { r[inst.d].f32 = r[inst.x].f32 - r[inst.y].f32; }
+        OP(mul_f32) { r[inst.d].f32 = r[inst.x].f32 * r[inst.y].f32; }
+        OP(div_f32) { r[inst.d].f32 = r[inst.x].f32 / r[inst.y].f32; }
+        OP(min_f32) { r[inst.d].f32 = min(r[inst.x].f32, r[inst.y].f32); }
+        OP(max_f32) { r[inst.d].f32 = max(r[inst.x].f32, r[inst.y].f32); }
+
+        OP(fma_f32)  { r[inst.d].f32 = fma( r[inst.x].f32, r[inst.y].f32,  r[inst.z].f32); }
+        OP(fms_f32)  { r[inst.d].f32 = fma( r[inst.x].f32, r[inst.y].f32, -r[inst.z].f32); }
+        OP(fnma_f32) { r[inst.d].f32 = fma(-r[inst.x].f32, r[inst.y].f32,  r[inst.z].f32); }
+
+        OP(sqrt_f32) { r[inst.d].f32 = sqrt(r[inst.x].f32); }
+
+        OP(add_i32) { r[inst.d].i32 = r[inst.x].i32 + r[inst.y].i32; }
+        OP(sub_i32) { r[inst.d].i32 = r[inst.x].i32 - r[inst.y].i32; }
+        OP(mul_i32) { r[inst.d].i32 = r[inst.x].i32 * r[inst.y].i32; }
+
+        OP(shl_i32) { r[inst.d].i32 = r[inst.x].i32 << inst.immA; }
+        OP(sra_i32) { r[inst.d].i32 = r[inst.x].i32 >> inst.immA; }
+        OP(shr_i32) { r[inst.d].u32 = r[inst.x].u32 >> inst.immA; }
+
+        OP( eq_f32) { r[inst.d].i32 = r[inst.x].f32 == r[inst.y].f32; }
+        OP(neq_f32) { r[inst.d].i32 = r[inst.x].f32 != r[inst.y].f32; }
+        OP( gt_f32) { r[inst.d].i32 = r[inst.x].f32 >  r[inst.y].f32; }
+        OP(gte_f32) { r[inst.d].i32 = r[inst.x].f32 >= r[inst.y].f32; }
+
+        OP( eq_i32) { r[inst.d].i32 = r[inst.x].i32 == r[inst.y].i32; }
+        OP( gt_i32) { r[inst.d].i32 = r[inst.x].i32 >  r[inst.y].i32; }
+
+        OP(bit_and  ) { r[inst.d].i32 = r[inst.x].i32 &  r[inst.y].i32; }
+        OP(bit_or   ) { r[inst.d].i32 = r[inst.x].i32 |  r[inst.y].i32; }
+        OP(bit_xor  ) { r[inst.d].i32 = r[inst.x].i32 ^  r[inst.y].i32; }
+        OP(bit_clear) { r[inst.d].i32 = r[inst.x].i32 & ~r[inst.y].i32; }
+
+        OP(select) {
+            r[inst.d].i32 = skvx::if_then_else(r[inst.x].i32, r[inst.y].i32, r[inst.z].i32);
+        }
+
+        OP(ceil)   { r[inst.d].f32 =                    skvx::ceil(r[inst.x].f32) ; }
+        OP(floor)  { r[inst.d].f32 =                   skvx::floor(r[inst.x].f32) ; }
+        OP(to_f32) { r[inst.d].f32 = skvx::cast<float>(            r[inst.x].i32 ); }
+        OP(trunc)  { r[inst.d].i32 = skvx::cast<int>  (            r[inst.x].f32 ); }
+        OP(round)  { r[inst.d].i32 = skvx::cast<int>  (skvx::lrint(r[inst.x].f32)); }
+
+        OP(to_fp16)   { r[inst.d].i32 = skvx::cast<int>(skvx::to_half(r[inst.x].f32)); }
+        OP(from_fp16) { r[inst.d].f32 = skvx::from_half(skvx::cast<uint16_t>(r[inst.x].i32)); }
+
+    #undef OP
+    }  // namespace SkVMInterpreterOps
+
+    // The handlers above, listed once for both interpreters to dispatch to.  Memory ops come in
+    // op_1 and op_K flavors; the rest run the same at either stride.  Op::duplicate never makes
+    // it into a Program, so it has no handler.
+    #define SKVM_INTERPRETER_STRIDED_OPS(M)                 \
+        M(store8)  M(store16)  M(store32) M(store64)        \
+        M(load8)   M(load16)   M(load32)  M(load64)         \
+        M(gather8) M(gather16) M(gather32)
+    #define SKVM_INTERPRETER_OPS(M)                                              \
+        M(store128) M(load128)                                                   \
+        M(assert_true)                                                           \
+        M(trace_line) M(trace_var) M(trace_enter) M(trace_exit) M(trace_scope)   \
+        M(index) M(uniform32) M(array32) M(splat)                                \
+        M(add_f32) M(sub_f32) M(mul_f32) M(div_f32) M(min_f32) M(max_f32)        \
+        M(fma_f32) M(fms_f32) M(fnma_f32) M(sqrt_f32)                            \
+        M(add_i32) M(sub_i32) M(mul_i32)                                         \
+        M(shl_i32) M(sra_i32) M(shr_i32)                                         \
+        M(eq_f32) M(neq_f32) M(gt_f32) M(gte_f32) M(eq_i32) M(gt_i32)            \
+        M(bit_and) M(bit_or) M(bit_xor) M(bit_clear) M(select)                   \
+        M(ceil) M(floor) M(to_f32) M(trunc) M(round) M(to_fp16) M(from_fp16)
+
+    #define M(op) +1
+    static_assert(0 SKVM_INTERPRETER_STRIDED_OPS(M) SKVM_INTERPRETER_OPS(M) + 1 == 0 SKVM_OPS(M),
+                  "Every op but duplicate needs a handler.");
+    #undef M
+
+    inline void interpret_skvm(const skvm::InterpreterInstruction insts[], const int ninsts,
+                               const int nregs, const int loop,
+                               const int strides[],
+                               skvm::TraceHook* traceHooks[], const int nTraceHooks,
+                               const int nargs, int n, void* args[]) {
+        using namespace skvm;
+        using SkVMInterpreterTypes::K;
+        using SkVMInterpreterOps::Context;
+
+        // We'll operate in SIMT style, knocking off K-size chunks from n while possible.
+        SkVMInterpreterTypes::Registers regs(nregs);
+        SkVMInterpreterTypes::Slot* r = regs.get();
 
         // Step each argument pointer ahead by its stride a number of times.
         auto step_args = [&](int times) {
@@ -106,245 +350,216 @@ namespace SkVMInterpreterTypes {
             }
         };
 
+        Context ctx = {args, n, K, traceHooks, nTraceHooks};
+
         int start = 0,
             stride;
         for ( ; n > 0; start = loop, n -= stride, step_args(stride)) {
             stride = n >= K ? K : 1;
+            ctx.n      = n;
+            ctx.stride = stride;
 
             for (int instIdx = start; instIdx < ninsts; instIdx++) {
-                InterpreterInstruction inst = insts[instIdx];
+                const InterpreterInstruction& inst = insts[instIdx];
 
                 // d = op(x,y,z,w, immA,immB)
-                Reg   d = inst.d,
-                      x = inst.x,
-                      y = inst.y,
-                      z = inst.z,
-                      w = inst.w;
-                int immA = inst.immA,
-                    immB = inst.immB,
-                    immC = inst.immC;
-
                 // Ops that interact with memory need to know whether we're stride=1 or K,
                 // but all non-memory ops can run the same code no matter the stride.
                 switch (2*(int)inst.op + (stride == K ? 1 : 0)) {
                     default: SkUNREACHABLE;
 
-                #define STRIDE_1(op) case 2*(int)op
-                #define STRIDE_K(op) case 2*(int)op + 1
-                    STRIDE_1(Op::store8 ): memcpy(args[immA], &r[x].i32, 1); break;
-                    STRIDE_1(Op::store16): memcpy(args[immA], &r[x].i32, 2); break;
-                    STRIDE_1(Op::store32): memcpy(args[immA], &r[x].i32, 4); break;
-                    STRIDE_1(Op::store64): memcpy((char*)args[immA]+0, &r[x].i32, 4);
-                                           memcpy((char*)args[immA]+4, &r[y].i32, 4); break;
-
-                    STRIDE_K(Op::store8 ): skvx::cast<uint8_t> (r[x].i32).store(args[immA]); break;
-                    STRIDE_K(Op::store16): skvx::cast<uint16_t>(r[x].i32).store(args[immA]); break;
-                    STRIDE_K(Op::store32):                     (r[x].i32).store(args[immA]); break;
-                    STRIDE_K(Op::store64): (skvx::cast<uint64_t>(r[x].u32) << 0 |
-                                            skvx::cast<uint64_t>(r[y].u32) << 32).store(args[immA]);
-                                           break;
-
-                    STRIDE_1(Op::load8 ): r[d].i32 = 0; memcpy(&r[d].i32, args[immA], 1); break;
-                    STRIDE_1(Op::load16): r[d].i32 = 0; memcpy(&r[d].i32, args[immA], 2); break;
-                    STRIDE_1(Op::load32): r[d].i32 = 0; memcpy(&r[d].i32, args[immA], 4); break;
-                    STRIDE_1(Op::load64):
-                        r[d].i32 = 0; memcpy(&r[d].i32, (char*)args[immA] + 4*immB, 4); break;
-
-                    STRIDE_K(Op::load8 ): r[d].i32= skvx::cast<int>(U8 ::Load(args[immA])); break;
-                    STRIDE_K(Op::load16): r[d].i32= skvx::cast<int>(U16::Load(args[immA])); break;
-                    STRIDE_K(Op::load32): r[d].i32=                 I32::Load(args[immA]) ; break;
-                    STRIDE_K(Op::load64):
-                        // Low 32 bits if immB=0, or high 32 bits if immB=1.
-                        r[d].i32 = skvx::cast<int>(U64::Load(args[immA]) >> (32*immB)); break;
-
-                    // The pointer we base our gather on is loaded indirectly from a uniform:
-                    //     - args[immA] is the uniform holding our gather base pointer somewhere;
-                    //     - (const uint8_t*)args[immA] + immB points to the gather base pointer;
-                    //     - memcpy() loads the gather base and into a pointer of the right type.
-                    // After all that we have an ordinary (uniform) pointer `ptr` to load from,
-                    // and we then gather from it using the varying indices in r[x].
-                    STRIDE_1(Op::gather8): {
-                        const uint8_t* ptr;
-                        memcpy(&ptr, (const uint8_t*)args[immA] + immB, sizeof(ptr));
-                        r[d].i32 = ptr[ r[x].i32[0] ];
-                    } break;
-                    STRIDE_1(Op::gather16): {
-                        const uint16_t* ptr;
-                        memcpy(&ptr, (const uint8_t*)args[immA] + immB, sizeof(ptr));
-                        r[d].i32 = ptr[ r[x].i32[0] ];
-                    } break;
-                    STRIDE_1(Op::gather32): {
-                        const int* ptr;
-                        memcpy(&ptr, (const uint8_t*)args[immA] + immB, sizeof(ptr));
-                        r[d].i32 = ptr[ r[x].i32[0] ];
-                    } break;
-
-                    STRIDE_K(Op::gather8): {
-                        const uint8_t* ptr;
-                        memcpy(&ptr, (const uint8_t*)args[immA] + immB, sizeof(ptr));
-                        r[d].i32 = map([&](int ix) { return (int)ptr[ix]; }, r[x].i32);
-                    } break;
-                    STRIDE_K(Op::gather16): {
-                        const uint16_t* ptr;
-                        memcpy(&ptr, (const uint8_t*)args[immA] + immB, sizeof(ptr));
-                        r[d].i32 = map([&](int ix) { return (int)ptr[ix]; }, r[x].i32);
-                    } break;
-                    STRIDE_K(Op::gather32): {
-                        const int* ptr;
-                        memcpy(&ptr, (const uint8_t*)args[immA] + immB, sizeof(ptr));
-                        r[d].i32 = gather32(ptr, r[x].i32);
-                    } break;
-
-                #undef STRIDE_1
-                #undef STRIDE_K
-
-                    // Ops that don't interact with memory should never care about the stride.
-                #define CASE(op) case 2*(int)op: /*fallthrough*/ case 2*(int)op+1
-
-                    // These 128-bit ops are implemented serially for simplicity.
-                    CASE(Op::store128): {
-                        U64 lo = (skvx::cast<uint64_t>(r[x].u32) << 0 |
-                                  skvx::cast<uint64_t>(r[y].u32) << 32),
-                            hi = (skvx::cast<uint64_t>(r[z].u32) << 0 |
-                                  skvx::cast<uint64_t>(r[w].u32) << 32);
-                        for (int i = 0; i < stride; i++) {
-                            memcpy((char*)args[immA] + 16*i + 0, &lo[i], 8);
-                            memcpy((char*)args[immA] + 16*i + 8, &hi[i], 8);
-                        }
-                    } break;
-
-                    CASE(Op::load128):
-                        r[d].i32 = 0;
-                        for (int i = 0; i < stride; i++) {
-                            memcpy(&r[d].i32[i], (const char*)args[immA] + 16*i+ 4*immB, 4);
-                        } break;
-
-                    CASE(Op::assert_true):
-                    #ifdef SK_DEBUG
-                        if (!all(r[x].i32)) {
-                            SkDebugf("inst %d, register %d\n", instIdx, y);
-                            for (int i = 0; i < K; i++) {
-                                SkDebugf("\t%2d: %08x (%g)\n",
-                                         instIdx, r[y].i32[instIdx], r[y].f32[instIdx]);
-                            }
-                            SkASSERT(false);
-                        }
-                    #endif
-                    break;
-
-                    CASE(Op::trace_line):
-                        if (should_trace(stride, immA, x, y)) {
-                            traceHooks[immA]->line(immB);
-                        }
-                        break;
-
-                    CASE(Op::trace_var):
-                        if (should_trace(stride, immA, x, y)) {
-                            for (int i = 0; i < K; ++i) {
-                                if (r[x].i32[i] & r[y].i32[i]) {
-                                    traceHooks[immA]->var(immB, r[z].i32[i]);
-                                    break;
-                                }
-                            }
-                        }
-                        break;
-
-                    CASE(Op::trace_enter):
-                        if (should_trace(stride, immA, x, y)) {
-                            traceHooks[immA]->enter(immB);
-                        }
-                        break;
-
-                    CASE(Op::trace_exit):
-                        if (should_trace(stride, immA, x, y)) {
-                            traceHooks[immA]->exit(immB);
-                        }
-                        break;
-
-                    CASE(Op::trace_scope):
-                        if (should_trace(stride, immA, x, y)) {
-                            traceHooks[immA]->scope(immB);
-                        }
-                        break;
-
-                    CASE(Op::index): {
-                        const int iota[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,10,11,12,13,14,15,
-                                            16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31,
-                                            32,33,34,35,36,37,38,39,40,41,42,43,44,45,46,47,
-                                            48,49,50,51,52,53,54,55,56,57,58,59,60,61,62,63 };
-                        static_assert(K <= SK_ARRAY_COUNT(iota), "");
-
-                        r[d].i32 = n - I32::Load(iota);
-                    } break;
-
-                    CASE(Op::uniform32):
-                        r[d].i32 = *(const int*)( (const char*)args[immA] + immB );
-                        break;
-
-                    CASE(Op::array32):
-                        const int* ptr;
-                        memcpy(&ptr, (const uint8_t*)args[immA] + immB, sizeof(ptr));
-                        r[d].i32 = ptr[immC/sizeof(int)];
-                        break;
-
-                    CASE(Op::splat): r[d].i32 = immA; break;
-
-                    CASE(Op::add_f32): r[d].f32 = r[x].f32 + r[y].f32; break;
-                    CASE(Op::sub_f32): r[d].f32 = r[x].f32 - r[y].f32; break;
-                    CASE(Op::mul_f32): r[d].f32 = r[x].f32 * r[y].f32; break;
-                    CASE(Op::div_f32): r[d].f32 = r[x].f32 / r[y].f32; break;
-                    CASE(Op::min_f32): r[d].f32 = min(r[x].f32, r[y].f32); break;
-                    CASE(Op::max_f32): r[d].f32 = max(r[x].f32, r[y].f32); break;
+                #define M(op)                                                                  \
+                    case 2*(int)Op::op:   SkVMInterpreterOps::op##_1(inst, r, ctx); break;    \
+                    case 2*(int)Op::op+1: SkVMInterpreterOps::op##_K(inst, r, ctx); break;
+                    SKVM_INTERPRETER_STRIDED_OPS(M)
+                #undef M
+                #define M(op)                                                                  \
+                    case 2*(int)Op::op:                                                        \
+                    case 2*(int)Op::op+1: SkVMInterpreterOps::op(inst, r, ctx); break;
+                    SKVM_INTERPRETER_OPS(M)
+                #undef M
+                }
+            }
+        }
+    }
 
-                    CASE(Op::fma_f32):  r[d].f32 = fma( r[x].f32, r[y].f32,  r[z].f32); break;
-                    CASE(Op::fms_f32):  r[d].f32 = fma( r[x].f32, r[y].f32, -r[z].f32); break;
-                    CASE(Op::fnma_f32): r[d].f32 = fma(-r[x].f32, r[y].f32,  r[z].f32); break;
+    // The threaded interpreter runs the same programs as interpret_skvm(), but first
+    // decode_skvm_threaded() resolves each instruction to the handler that runs it, so the
+    // inner loop never switches on an Op.  Each handler ends by dispatching straight to the
+    // next instruction's handler, as a guaranteed tail call when the compiler can promise one,
+    // or otherwise by returning it to a trampoline loop.  Either way every handler gets its own
+    // indirect branch to predict, rather than all of them sharing the one at the top of a switch.
+    //
+    // Common runs of ops, e.g. unpacking or packing channels around loads and stores, are fused
+    // into single handlers so we don't dispatch between them at all.
+    namespace SkVMThreadedInterpreter {
+        using namespace SkVMInterpreterOps;
+        using SkVMInterpreterTypes::Slot;
+        using skvm::Op;
+        using skvm::ThreadedInstruction;
+
+        using Handler = const ThreadedInstruction* (*)(const ThreadedInstruction*, Slot*,
+                                                       const Context*);
+        using OpFn = void (*)(const ThreadedInstruction&, Slot*, const Context&);
+
+    #if defined(__has_cpp_attribute)
+        #if __has_cpp_attribute(clang::musttail)
+            #define SKVM_THREADED_MUSTTAIL
+        #endif
+    #endif
+
+    #if defined(SKVM_THREADED_MUSTTAIL)
+        #define SKVM_THREADED_NEXT(next) \
+            [[clang::musttail]] return ((Handler)(next)->fn)(next, r, ctx)
+    #else
+        #define SKVM_THREADED_NEXT(next) return next
+    #endif
+
+        // Run ops over the next sizeof...(ops) instructions, then move on to the one after that.
+        template <OpFn... ops>
+        static const ThreadedInstruction* run(const ThreadedInstruction* ip, Slot* r,
+                                              const Context* ctx) {
+            int i = 0;
+            (ops(ip[i++], r, *ctx), ...);
+            const ThreadedInstruction* next = ip + sizeof...(ops);
+            SKVM_THREADED_NEXT(next);
+        }
 
-                    CASE(Op::sqrt_f32): r[d].f32 = sqrt(r[x].f32); break;
+        // Each decoded program ends with a call to done(), which stops the trampoline loop.
+        static const ThreadedInstruction* done(const ThreadedInstruction*, Slot*, const Context*) {
+            return nullptr;
+        }
 
-                    CASE(Op::add_i32): r[d].i32 = r[x].i32 + r[y].i32; break;
-                    CASE(Op::sub_i32): r[d].i32 = r[x].i32 - r[y].i32; break;
-                    CASE(Op::mul_i32): r[d].i32 = r[x].i32 * r[y].i32; break;
+        static inline Handler handler(Op op, bool strideK) {
+            switch (op) {
+            #define M(op) case Op::op: return strideK ? run<op##_K> : run<op##_1>;
+                SKVM_INTERPRETER_STRIDED_OPS(M)
+            #undef M
+            #define M(op) case Op::op: return run<op>;
+                SKVM_INTERPRETER_OPS(M)
+            #undef M
+                case Op::duplicate: break;
+            }
+            SkUNREACHABLE;
+        }
 
-                    CASE(Op::shl_i32): r[d].i32 = r[x].i32 << immA; break;
-                    CASE(Op::sra_i32): r[d].i32 = r[x].i32 >> immA; break;
-                    CASE(Op::shr_i32): r[d].u32 = r[x].u32 >> immA; break;
+        // Runs of ops we fuse into one handler, found by counting adjacent ops in the raster
+        // blitters' programs.  Longer runs come first so we prefer them when runs overlap.
+        struct Fusion {
+            Op      ops[3];
+            int     len;
+            Handler fn;
+        };
+        static constexpr Fusion kFusions[] = {
+            // Unpacking a channel, (x >> shift) & mask, and normalizing it to float.  The top
+            // channel needs no mask.
+            {{Op::shr_i32, Op::bit_and, Op::to_f32 }, 3, run<shr_i32, bit_and, to_f32 >},
+            {{Op::bit_and, Op::to_f32,  Op::mul_f32}, 3, run<bit_and, to_f32,  mul_f32>},
+            {{Op::shr_i32, Op::to_f32,  Op::mul_f32}, 3, run<shr_i32, to_f32,  mul_f32>},
+            // Packing a channel, round(x * scale) << shift, or'd into the others.
+            {{Op::mul_f32, Op::round,   Op::shl_i32}, 3, run<mul_f32, round,   shl_i32>},
+            {{Op::round,   Op::shl_i32, Op::bit_or }, 3, run<round,   shl_i32, bit_or >},
+            // Blending and premultiplying, e.g. lerp() and srcover without FMA.
+            {{Op::mul_f32, Op::add_f32, Op::mul_f32}, 3, run<mul_f32, add_f32, mul_f32>},
+            {{Op::sub_f32, Op::mul_f32, Op::add_f32}, 3, run<sub_f32, mul_f32, add_f32>},
+            {{Op::mul_f32, Op::mul_f32, Op::mul_f32}, 3, run<mul_f32, mul_f32, mul_f32>},
+            {{Op::fma_f32, Op::fma_f32, Op::fma_f32}, 3, run<fma_f32, fma_f32, fma_f32>},
+
+            {{Op::load32,  Op::bit_and}, 2, run<load32_K, bit_and  >},
+            {{Op::load32,  Op::shr_i32}, 2, run<load32_K, shr_i32  >},
+            {{Op::bit_or,  Op::store32}, 2, run<bit_or,   store32_K>},
+            {{Op::shr_i32, Op::bit_and}, 2, run<shr_i32,  bit_and  >},
+            {{Op::bit_and, Op::to_f32 }, 2, run<bit_and,  to_f32   >},
+            {{Op::to_f32,  Op::mul_f32}, 2, run<to_f32,   mul_f32  >},
+            {{Op::mul_f32, Op::round  }, 2, run<mul_f32,  round    >},
+            {{Op::shl_i32, Op::bit_or }, 2, run<shl_i32,  bit_or   >},
+            {{Op::mul_f32, Op::add_f32}, 2, run<mul_f32,  add_f32  >},
+            {{Op::add_f32, Op::mul_f32}, 2, run<add_f32,  mul_f32  >},
+            {{Op::sub_f32, Op::mul_f32}, 2, run<sub_f32,  mul_f32  >},
+            {{Op::mul_f32, Op::mul_f32}, 2, run<mul_f32,  mul_f32  >},
+            {{Op::fma_f32, Op::fma_f32}, 2, run<fma_f32,  fma_f32  >},
+        };
+    }  // namespace SkVMThreadedInterpreter
+
+    // Decode ninsts instructions into out[0..ninsts], the last being a sentinel to stop at.
+    inline void decode_skvm_threaded(const skvm::InterpreterInstruction insts[], const int ninsts,
+                                     const int loop, const bool strideK,
+                                     skvm::ThreadedInstruction out[]) {
+        using namespace SkVMThreadedInterpreter;
+
+        for (int i = 0; i < ninsts; i++) {
+            const skvm::InterpreterInstruction& inst = insts[i];
+            out[i] = {(void(*)())handler(inst.op, strideK),
+                      inst.d, inst.x, inst.y, inst.z, inst.w,
+                      inst.immA, inst.immB, inst.immC};
+        }
+        out[ninsts] = {(void(*)())done, 0,0,0,0,0, 0,0,0};
 
-                    CASE(Op:: eq_f32): r[d].i32 = r[x].f32 == r[y].f32; break;
-                    CASE(Op::neq_f32): r[d].i32 = r[x].f32 != r[y].f32; break;
-                    CASE(Op:: gt_f32): r[d].i32 = r[x].f32 >  r[y].f32; break;
-                    CASE(Op::gte_f32): r[d].i32 = r[x].f32 >= r[y].f32; break;
+        // Fusions all use the stride=K flavor of memory ops, and anyway the stride=1 tail only
+        // ever runs a few times per call, so we only bother fusing when decoding for stride=K.
+        if (!strideK) {
+            return;
+        }
+        for (int i = 0; i < ninsts;) {
+            int len = 1;
+            for (const Fusion& fusion : kFusions) {
+                // A fused run can't straddle the start of the loop, where we jump in later.
+                if (i + fusion.len > ninsts || (i < loop && i + fusion.len > loop)) {
+                    continue;
+                }
+                bool match = true;
+                for (int j = 0; j < fusion.len; j++) {
+                    match = match && insts[i+j].op == fusion.ops[j];
+                }
+                if (match) {
+                    out[i].fn = (void(*)())fusion.fn;
+                    len = fusion.len;
+                    break;
+                }
+            }
+            i += len;
+        }
+    }
 
-                    CASE(Op:: eq_i32): r[d].i32 = r[x].i32 == r[y].i32; break;
-                    CASE(Op:: gt_i32): r[d].i32 = r[x].i32 >  r[y].i32; break;
+    inline void interpret_skvm_threaded(const skvm::ThreadedInstruction strideK[],
+                                        const skvm::ThreadedInstruction stride1[],
+                                        const int nregs, const int loop,
+                                        const int strides[],
+                                        skvm::TraceHook* traceHooks[], const int nTraceHooks,
+                                        const int nargs, int n, void* args[]) {
+        using namespace SkVMThreadedInterpreter;
 
-                    CASE(Op::bit_and  ): r[d].i32 = r[x].i32 &  r[y].i32; break;
-                    CASE(Op::bit_or   ): r[d].i32 = r[x].i32 |  r[y].i32; break;
-                    CASE(Op::bit_xor  ): r[d].i32 = r[x].i32 ^  r[y].i32; break;
-                    CASE(Op::bit_clear): r[d].i32 = r[x].i32 & ~r[y].i32; break;
+        SkVMInterpreterTypes::Registers regs(nregs);
+        Slot* r = regs.get();
 
-                    CASE(Op::select): r[d].i32 = skvx::if_then_else(r[x].i32, r[y].i32, r[z].i32);
-                                      break;
+        // Step each argument pointer ahead by its stride a number of times.
+        auto step_args = [&](int times) {
+            for (int i = 0; i < nargs; i++) {
+                args[i] = (void*)( (char*)args[i] + times * strides[i] );
+            }
+        };
 
-                    CASE(Op::ceil):   r[d].f32 =                    skvx::ceil(r[x].f32) ; break;
-                    CASE(Op::floor):  r[d].f32 =                   skvx::floor(r[x].f32) ; break;
-                    CASE(Op::to_f32): r[d].f32 = skvx::cast<float>(            r[x].i32 ); break;
-                    CASE(Op::trunc):  r[d].i32 = skvx::cast<int>  (            r[x].f32 ); break;
-                    CASE(Op::round):  r[d].i32 = skvx::cast<int>  (skvx::lrint(r[x].f32)); break;
+        Context ctx = {args, n, K, traceHooks, nTraceHooks};
 
-                    CASE(Op::to_fp16):
-                        r[d].i32 = skvx::cast<int>(skvx::to_half(r[x].f32));
-                        break;
-                    CASE(Op::from_fp16):
-                        r[d].f32 = skvx::from_half(skvx::cast<uint16_t>(r[x].i32));
-                        break;
+        int start = 0,
+            stride;
+        for ( ; n > 0; start = loop, n -= stride, step_args(stride)) {
+            stride = n >= K ? K : 1;
+            ctx.n      = n;
+            ctx.stride = stride;
 
-                #undef CASE
-                }
+            const ThreadedInstruction* ip = (stride == K ? strideK : stride1) + start;
+            while (ip) {
+                ip = ((Handler)ip->fn)(ip, r, &ctx);
             }
         }
     }
 
+#undef SKVM_THREADED_NEXT
+#undef SKVM_THREADED_MUSTTAIL
+#undef SKVM_INTERPRETER_STRIDED_OPS
+#undef SKVM_INTERPRETER_OPS
+
 }  // namespace SK_OPTS_NS
 
 #endif//SkVM_opts_DEFINED
@@ -7,6 +7,7 @@
 
 #include "src/shaders/SkImageShader.h"
 
+#include "include/core/SkYUVAPixmaps.h"
 #include "include/private/SkImageInfoPriv.h"
 #include "src/core/SkArenaAlloc.h"
 #include "src/core/SkColorSpacePriv.h"
@@ -22,6 +23,8 @@
 #include "src/core/SkScopeExit.h"
 #include "src/core/SkVM.h"
 #include "src/core/SkWriteBuffer.h"
+#include "src/core/SkYUVAInfoLocation.h"
+#include "src/core/SkYUVMath.h"
 #include "src/image/SkImage_Base.h"
 #include "src/shaders/SkBitmapProcShader.h"
 #include "src/shaders/SkEmptyShader.h"
@@ -204,9 +207,38 @@ static bool legacy_shader_can_handle(const SkMatrix& inv) {
     return true;
 }
 
+// Images backed by 8-bit YUVA planes can be sampled from those planes in place (see
+// append_yuva_stages()), as long as they're clamped and need neither mipmaps nor bicubic filtering.
+static bool can_sample_yuva(SkTileMode tileModeX, SkTileMode tileModeY,
+                            const SkSamplingOptions& sampling, bool raw) {
+    return !raw &&
+           tileModeX == SkTileMode::kClamp && tileModeY == SkTileMode::kClamp &&
+           !sampling.useCubic && sampling.mipmap == SkMipmapMode::kNone;
+}
+
+// Scaled down far enough, a smaller RGBA decode is cheaper still than the YUVA planes (see
+// SkMipmapAccessor), so those shouldn't even be fetched.
+static bool prefers_scaled_decode(const SkImage_Base* image, const SkMatrix& inv) {
+    SkSize invScale;
+    SkISize scaledDimensions;
+    return inv.decomposeScale(&invScale, nullptr) &&
+           image->getScaledDecodeDimensions({1/invScale.width(), 1/invScale.height()},
+                                            &scaledDimensions);
+}
+
 SkShaderBase::Context* SkImageShader::onMakeContext(const ContextRec& rec,
                                                     SkArenaAlloc* alloc) const {
     SkASSERT(!needs_subset(fImage.get(), fSubset)); // TODO(skbug.com/12784)
+    // Leave images we can draw from their YUVA planes to SkRasterPipeline.
+    if (can_sample_yuva(fTileModeX, fTileModeY, fSampling, fRaw)) {
+        SkMatrix inv;
+        SkYUVAPixmaps pixmaps;
+        if (fPlanes ||
+            (this->computeTotalInverse(*rec.fMatrix, rec.fLocalMatrix, &inv) &&
+             !prefers_scaled_decode(as_IB(fImage), inv) && as_IB(fImage)->getROPlanes(&pixmaps))) {
+            return nullptr;
+        }
+    }
     if (fImage->alphaType() == kUnpremul_SkAlphaType) {
         return nullptr;
     }
@@ -302,6 +334,20 @@ sk_sp<SkShader> SkImageShader::MakeRaw(sk_sp<SkImage> image,
             /*raw=*/true, /*clampAsIfUnpremul=*/false)};
 }
 
+sk_sp<SkShader> SkImageShader::MakeFromPlanes(sk_sp<SkImage> image,
+                                              sk_sp<SkCachedData> planes,
+                                              const SkYUVAPixmaps& pixmaps,
+                                              const SkSamplingOptions& options,
+                                              const SkMatrix* localMatrix) {
+    SkASSERT(image && planes);
+    sk_sp<SkImageShader> shader{new SkImageShader(
+            image, SkRect::Make(image->dimensions()), SkTileMode::kClamp, SkTileMode::kClamp,
+            options, localMatrix, /*raw=*/false, /*clampAsIfUnpremul=*/false)};
+    shader->fPlanes = std::move(planes);
+    shader->fPlanePixmaps = pixmaps;
+    return shader;
+}
+
 sk_sp<SkShader> SkImageShader::MakeSubset(sk_sp<SkImage> image,
                                           const SkRect& subset,
                                           SkTileMode tmx, SkTileMode tmy,
@@ -451,6 +497,73 @@ static SkMatrix tweak_inv_matrix(SkFilterMode filter, SkMatrix matrix) {
     return matrix;
 }
 
+// Samples the image's YUVA planes in place and converts them to RGBA as it goes, so the image
+// is never decoded to RGBA, which is both a full extra pass and up to 2.7x the memory. If the
+// planes haven't been fetched yet, this fetches them.
+static bool append_yuva_stages(const SkImage_Base* image, sk_sp<SkCachedData> planes,
+                               SkYUVAPixmaps pixmaps, const SkStageRec& rec, SkMatrix matrix,
+                               SkSamplingOptions sampling) {
+    if (!planes) {
+        if (prefers_scaled_decode(image, matrix)) {
+            return false;
+        }
+        planes = image->getROPlanes(&pixmaps);
+        if (!planes) {
+            return false;
+        }
+    }
+
+    SkRasterPipeline* p = rec.fPipeline;
+    SkArenaAlloc* alloc = rec.fAlloc;
+    // The planes must outlive the pipeline.
+    alloc->make<sk_sp<SkCachedData>>(std::move(planes));
+
+    if (rec.fMatrixProvider.localToDeviceHitsPixelCenters()) {
+        sampling = tweak_sampling(sampling, matrix);
+    }
+    matrix = tweak_inv_matrix(sampling.filter, matrix);
+    p->append(SkRasterPipeline::seed_shader);
+    p->append_matrix(alloc, matrix);
+
+    const SkYUVAInfo& yuvaInfo = pixmaps.yuvaInfo();
+    const SkYUVAInfo::YUVALocations locations = pixmaps.toYUVALocations();
+    auto ctx = alloc->make<SkRasterPipeline_YUVACtx>();
+    for (int i = 0; i < SkYUVAInfo::kYUVAChannelCount; ++i) {
+        const auto [plane, channel] = locations[i];
+        if (plane < 0) {
+            SkASSERT(i == SkYUVAInfo::kA);
+            continue;
+        }
+        const SkPixmap& pm = pixmaps.plane(plane);
+        const auto [ssx, ssy] = yuvaInfo.planeSubsamplingFactors(plane);
+        const bool subsampled = ssx > 1 || ssy > 1;
+        // Only SkYUVAInfo::Siting::kCentered exists, which needs no offset.
+        auto& c = ctx->channels[i];
+        c.pixels = static_cast<const uint8_t*>(pm.addr()) +
+                   (pm.colorType() == kAlpha_8_SkColorType ? 0 : static_cast<int>(channel));
+        c.stride = SkToInt(pm.rowBytes());
+        c.bpp    = pm.info().bytesPerPixel();
+        c.width  = pm.width();
+        c.height = pm.height();
+        c.scaleX = 1.0f / ssx;
+        c.scaleY = 1.0f / ssy;
+        c.linear = subsampled || sampling.filter == SkFilterMode::kLinear;
+        c.snap   = subsampled && sampling.filter == SkFilterMode::kNearest;
+    }
+    ctx->hasAlpha = locations[SkYUVAInfo::kA].fPlane >= 0;
+    SkColorMatrix_YUV2RGB(yuvaInfo.yuvColorSpace(), ctx->matrix);
+    p->append(SkRasterPipeline::sample_yuva, ctx);
+
+    // The conversion can land a little outside of [0,1].
+    p->append(SkRasterPipeline::clamp_0);
+    p->append(SkRasterPipeline::clamp_1);
+    alloc->make<SkColorSpaceXformSteps>(image->colorSpace(),
+                                        ctx->hasAlpha ? kUnpremul_SkAlphaType
+                                                      : kOpaque_SkAlphaType,
+                                        rec.fDstCS, kPremul_SkAlphaType)->apply(p);
+    return true;
+}
+
 bool SkImageShader::doStages(const SkStageRec& rec, TransformShader* updater) const {
     SkASSERT(!needs_subset(fImage.get(), fSubset)); // TODO(skbug.com/12784)
     // We only support certain sampling options in stages so far
@@ -478,6 +591,11 @@ bool SkImageShader::doStages(const SkStageRec& rec, TransformShader* updater) co
     }
     matrix.normalizePerspective();
 
+    if (!updater && can_sample_yuva(fTileModeX, fTileModeY, sampling, fRaw) &&
+        append_yuva_stages(as_IB(fImage), fPlanes, fPlanePixmaps, rec, matrix, sampling)) {
+        return true;
+    }
+
     SkASSERT(!sampling.useCubic || sampling.mipmap == SkMipmapMode::kNone);
     auto* access = SkMipmapAccessor::Make(alloc, fImage.get(), matrix, sampling.mipmap);
     if (!access) {
@@ -10,6 +10,8 @@
 
 #include "include/core/SkImage.h"
 #include "include/core/SkM44.h"
+#include "include/core/SkYUVAPixmaps.h"
+#include "src/core/SkCachedData.h"
 #include "src/shaders/SkBitmapProcShader.h"
 #include "src/shaders/SkShaderBase.h"
 
@@ -38,6 +40,14 @@ public:
                                       const SkMatrix* localMatrix,
                                       bool clampAsIfUnpremul = false);
 
+    // Like Make() with clamped tiling, for an image whose YUVA planes the caller has already
+    // fetched with SkImage_Base::getROPlanes(). The shader samples those planes where it can.
+    static sk_sp<SkShader> MakeFromPlanes(sk_sp<SkImage>,
+                                          sk_sp<SkCachedData> planes,
+                                          const SkYUVAPixmaps&,
+                                          const SkSamplingOptions&,
+                                          const SkMatrix* localMatrix);
+
     bool isOpaque() const override;
 
 #if SK_SUPPORT_GPU
@@ -98,6 +108,10 @@ private:
     const bool              fRaw;
     const bool              fClampAsIfUnpremul;
 
+    // Set by MakeFromPlanes(). Otherwise the planes are fetched when the shader is drawn.
+    sk_sp<SkCachedData>     fPlanes;
+    SkYUVAPixmaps           fPlanePixmaps;
+
     friend class SkShaderBase;
     using INHERITED = SkShaderBase;
 };
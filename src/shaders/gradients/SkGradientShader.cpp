@@ -6,15 +6,18 @@
  */
 
 #include <algorithm>
+#include "include/core/SkData.h"
 #include "include/core/SkMallocPixelRef.h"
 #include "include/private/SkFloatBits.h"
 #include "include/private/SkHalf.h"
 #include "include/private/SkTPin.h"
 #include "include/private/SkVx.h"
+#include "src/core/SkAutoMalloc.h"
 #include "src/core/SkColorSpacePriv.h"
 #include "src/core/SkConvertPixels.h"
 #include "src/core/SkMatrixProvider.h"
 #include "src/core/SkReadBuffer.h"
+#include "src/core/SkResourceCache.h"
 #include "src/core/SkVM.h"
 #include "src/core/SkWriteBuffer.h"
 #include "src/shaders/gradients/Sk4fLinearGradient.h"
@@ -275,6 +278,105 @@ static void init_stop_pos(
     add_stop_color(ctx, stop, Fs, Bs);
 }
 
+namespace {
+static unsigned gGradientLUTKeyNamespaceLabel;
+
+// A color table is keyed on everything that goes into it: the table's size and format,
+// the premul flag, both color spaces, and every stop's color and position.
+class GradientLUTKey {
+public:
+    GradientLUTKey(const SkColor4f* colors, const float* pos, int count, bool premulGrad,
+                   SkColorSpace* srcCS, SkColorSpace* dstCS, int lutSize, SkColorType lutCT) {
+        const size_t dataBytes = sizeof(uint32_t) * (kHeader32s + 5*count);
+        fStorage.reset(sizeof(SkResourceCache::Key) + dataBytes);
+        fKey = new (fStorage.get()) SkResourceCache::Key();
+
+        uint32_t* data = reinterpret_cast<uint32_t*>(
+                static_cast<char*>(fStorage.get()) + sizeof(SkResourceCache::Key));
+        data[0] = srcCS->toXYZD50Hash();
+        data[1] = srcCS->transferFnHash();
+        data[2] = dstCS ? dstCS->toXYZD50Hash()    : 0;
+        data[3] = dstCS ? dstCS->transferFnHash()  : 0;
+        data[4] = (uint32_t)premulGrad | (uint32_t)lutCT << 8;
+        data[5] = (uint32_t)lutSize;
+        data[6] = (uint32_t)count;
+        memcpy(data + kHeader32s,           colors, sizeof(SkColor4f) * count);
+        memcpy(data + kHeader32s + 4*count, pos,    sizeof(float)     * count);
+
+        fKey->init(&gGradientLUTKeyNamespaceLabel, 0, dataBytes);
+    }
+
+    const SkResourceCache::Key& key() const { return *fKey; }
+
+private:
+    static constexpr int kHeader32s = 7;
+
+    SkAutoSMalloc<1024>   fStorage;
+    SkResourceCache::Key* fKey;
+};
+
+struct GradientLUTRec : public SkResourceCache::Rec {
+    GradientLUTRec(const SkResourceCache::Key& key, sk_sp<SkData> lut)
+        : fKey(new uint8_t[key.size()])
+        , fLUT(std::move(lut)) {
+        memcpy(fKey.get(), &key, key.size());
+    }
+
+    std::unique_ptr<uint8_t[]> fKey;
+    sk_sp<SkData>              fLUT;
+
+    const Key& getKey() const override {
+        return *reinterpret_cast<const SkResourceCache::Key*>(fKey.get());
+    }
+    size_t bytesUsed() const override {
+        return sizeof(*this) + this->getKey().size() + fLUT->size();
+    }
+    const char* getCategory() const override { return "gradient-lut"; }
+
+    static bool Visitor(const SkResourceCache::Rec& baseRec, void* context) {
+        const GradientLUTRec& rec = static_cast<const GradientLUTRec&>(baseRec);
+        *static_cast<sk_sp<SkData>*>(context) = rec.fLUT;
+        return true;
+    }
+};
+}  // namespace
+
+// Samples the gradient at lutSize evenly spaced t in [0,1], premultiplies, and stores the
+// result as lutCT. Like the gradient stage, a t right on a hard stop takes the color after it.
+static sk_sp<SkData> make_gradient_lut(const SkPMColor4f* colors, const float* pos, int count,
+                                       bool premulGrad, int lutSize, SkColorType lutCT) {
+    SkAutoTMalloc<SkPMColor4f> row(lutSize);
+
+    int i = 0;
+    for (int x = 0; x < lutSize; x++) {
+        const float t = x / (float)(lutSize - 1);
+        while (i + 2 < count && pos[i + 1] <= t) {
+            i++;
+        }
+
+        Sk4f c_l = Sk4f::Load(colors[i  ].vec()),
+             c_r = Sk4f::Load(colors[i+1].vec()),
+             c;
+        if (pos[i] < pos[i + 1]) {
+            c = c_l + (c_r - c_l) * SkTPin((t - pos[i]) / (pos[i + 1] - pos[i]), 0.0f, 1.0f);
+        } else {
+            c = c_r;
+        }
+        if (!premulGrad) {
+            c = c * Sk4f(c[3], c[3], c[3], 1.0f);
+        }
+        c.store(row[x].vec());
+    }
+
+    const SkImageInfo src = SkImageInfo::Make(lutSize, 1, kRGBA_F32_SkColorType,
+                                              kPremul_SkAlphaType),
+                      dst = src.makeColorType(lutCT);
+    sk_sp<SkData> lut = SkData::MakeUninitialized(dst.computeMinByteSize());
+    SkAssertResult(SkConvertPixels(dst, lut->writable_data(), dst.minRowBytes(),
+                                   src, row.get(),            src.minRowBytes()));
+    return lut;
+}
+
 bool SkGradientShaderBase::onAppendStages(const SkStageRec& rec) const {
     SkRasterPipeline* p = rec.fPipeline;
     SkArenaAlloc* alloc = rec.fAlloc;
@@ -292,6 +394,10 @@ bool SkGradientShaderBase::onAppendStages(const SkStageRec& rec) const {
     p->append_matrix(alloc, matrix);
     this->appendGradientStages(alloc, p, &postPipeline);
 
+    // A 2-stop evenly spaced gradient is already a single mad per pixel.
+    const bool useLUT = (fGradFlags & SkGradientShader::kCacheColorLUT_Flag)
+                     && (fColorCount > 2 || fOrigPos);
+
     switch(fTileMode) {
         case SkTileMode::kMirror: p->append(SkRasterPipeline::mirror_x_1); break;
         case SkTileMode::kRepeat: p->append(SkRasterPipeline::repeat_x_1); break;
@@ -303,11 +409,12 @@ bool SkGradientShaderBase::onAppendStages(const SkStageRec& rec) const {
             [[fallthrough]];
 
         case SkTileMode::kClamp:
-            if (!fOrigPos) {
+            if (!fOrigPos || useLUT) {
                 // We clamp only when the stops are evenly spaced.
                 // If not, there may be hard stops, and clamping ruins hard stops at 0 and/or 1.
                 // In that case, we must make sure we're using the general "gradient" stage,
                 // which is the only stage that will correctly handle unclamped t.
+                // (A color table has already baked any hard stops in, so it always clamps.)
                 p->append(SkRasterPipeline::clamp_x_1);
             }
             break;
@@ -324,6 +431,54 @@ bool SkGradientShaderBase::onAppendStages(const SkStageRec& rec) const {
                           : SkPMColor4f{ c.fR, c.fG, c.fB, c.fA };
     };
 
+    if (useLUT) {
+        // Bake the gradient into a premul table, shared through SkResourceCache, and look up
+        // the nearest entry. We keep 8-bit tables for 8888 destinations, where they lose
+        // nothing we'd store, unless we're dithering. Everything else gets a half-float table.
+        const int lutSize = fColorCount > 64 ? 1024 : 256;
+        const SkColorType lutCT = (rec.fDstColorType == kRGBA_8888_SkColorType ||
+                                   rec.fDstColorType == kBGRA_8888_SkColorType) &&
+                                  !rec.fPaint.isDither() ? kRGBA_8888_SkColorType
+                                                         : kRGBA_F16_SkColorType;
+
+        SkAutoSTMalloc<16, float> pos(fColorCount);
+        for (int i = 0; i < fColorCount; i++) {
+            pos[i] = this->getPos(i);
+        }
+
+        GradientLUTKey key(fOrigColors4f, pos.get(), fColorCount, premulGrad,
+                           fColorSpace.get(), rec.fDstCS, lutSize, lutCT);
+
+        // Keep the table alive at least as long as the pipeline that reads it.
+        auto& lut = *alloc->make<sk_sp<SkData>>();
+        if (!SkResourceCache::Find(key.key(), GradientLUTRec::Visitor, &lut)) {
+            SkAutoSTMalloc<16, SkPMColor4f> colors(fColorCount);
+            for (int i = 0; i < fColorCount; i++) {
+                colors[i] = prepareColor(i);
+            }
+            lut = make_gradient_lut(colors.get(), pos.get(), fColorCount, premulGrad,
+                                    lutSize, lutCT);
+            SkResourceCache::Add(new GradientLUTRec(key.key(), lut));
+        }
+
+        auto* ctx = alloc->make<SkRasterPipeline_GatherCtx>();
+        ctx->pixels = lut->data();
+        ctx->stride = lutSize;
+        ctx->width  = lutSize;
+        ctx->height = 1;
+
+        // Map t in [0,1] to the center of its nearest entry.
+        p->append_matrix(alloc, SkMatrix::Translate(0.5f, 0) * SkMatrix::Scale(lutSize - 1, 1));
+        p->append(lutCT == kRGBA_8888_SkColorType ? SkRasterPipeline::gather_8888
+                                                  : SkRasterPipeline::gather_f16, ctx);
+
+        if (decal_ctx) {
+            p->append(SkRasterPipeline::check_decal_mask, decal_ctx);
+        }
+        p->extend(postPipeline);
+        return true;
+    }
+
     // The two-stop case with stops at 0 and 1.
     if (fColorCount == 2 && fOrigPos == nullptr) {
         const SkPMColor4f c_l = prepareColor(0),
@@ -64,6 +64,10 @@ SkShaderBase::Context* SkLinearGradient::onMakeContext(
     if (!this->colorsCanConvertToSkColor()) {
         return nullptr;
     }
+    // Color tables are only baked for the raster pipeline.
+    if (fGradFlags & SkGradientShader::kCacheColorLUT_Flag) {
+        return nullptr;
+    }
 
     return fTileMode != SkTileMode::kDecal
         ? CheckedMakeContext<LinearGradient4fContext>(alloc, *this, rec)
@@ -46,6 +46,9 @@ void SkDebugf(const char format[], ...) {
 namespace SkOpts {
     decltype(hash_fn) hash_fn = skslc_standalone::hash_fn;
     decltype(interpret_skvm) interpret_skvm = skslc_standalone::interpret_skvm;
+    decltype(decode_skvm_threaded) decode_skvm_threaded = skslc_standalone::decode_skvm_threaded;
+    decltype(interpret_skvm_threaded) interpret_skvm_threaded =
+            skslc_standalone::interpret_skvm_threaded;
 }
 
 enum class ResultCode {
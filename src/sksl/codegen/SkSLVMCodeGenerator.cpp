@@ -2098,31 +2098,9 @@ bool ProgramToSkVM(const Program& program,
                    skvm::Builder* b,
                    SkVMDebugTrace* debugTrace,
                    SkSpan<skvm::Val> uniforms,
-                   SkVMSignature* outSignature) {
-    SkVMSignature ignored,
-                  *signature = outSignature ? outSignature : &ignored;
-
-    std::vector<skvm::Ptr> argPtrs;
-    std::vector<skvm::Val> argVals;
-
-    for (const Variable* p : function.declaration().parameters()) {
-        size_t slots = p->type().slotCount();
-        signature->fParameterSlots += slots;
-        for (size_t i = 0; i < slots; ++i) {
-            argPtrs.push_back(b->varying<float>());
-            argVals.push_back(b->loadF(argPtrs.back()).id);
-        }
-    }
-
-    std::vector<skvm::Ptr> returnPtrs;
-    std::vector<skvm::Val> returnVals;
-
-    signature->fReturnSlots = function.declaration().returnType().slotCount();
-    for (size_t i = 0; i < signature->fReturnSlots; ++i) {
-        returnPtrs.push_back(b->varying<float>());
-        returnVals.push_back(b->splat(0.0f).id);
-    }
-
+                   skvm::Coord device,
+                   SkSpan<skvm::Val> arguments,
+                   SkSpan<skvm::Val> outReturn) {
     class Callbacks : public SkVMCallbacks {
     public:
         Callbacks(skvm::Color color) : fColor(color) {}
@@ -2153,22 +2131,56 @@ bool ProgramToSkVM(const Program& program,
         const skvm::Color fColor;
     };
 
-    // Set up device coordinates so that the rightmost evaluated pixel will be centered on (0, 0).
-    // (If the coordinates aren't used, dead-code elimination will optimize this away.)
-    skvm::F32 pixelCenter = b->splat(0.5f);
-    skvm::Coord device = {pixelCenter, pixelCenter};
-    device.x += to_F32(b->splat(1) - b->index());
-
     skvm::F32 zero = b->splat(0.0f);
     skvm::Color sampledColor{zero, zero, zero, zero};
     Callbacks callbacks(sampledColor);
 
     SkVMGenerator generator(program, b, debugTrace, &callbacks);
-    generator.writeProgram(uniforms, device, function, SkMakeSpan(argVals), SkMakeSpan(returnVals));
+    generator.writeProgram(uniforms, device, function, arguments, outReturn);
 
     // If the SkSL tried to use any shader, colorFilter, or blender objects - we don't have a
     // mechanism (yet) for binding to those.
-    if (callbacks.fUsedUnsupportedFeatures) {
+    return !callbacks.fUsedUnsupportedFeatures;
+}
+
+bool ProgramToSkVM(const Program& program,
+                   const FunctionDefinition& function,
+                   skvm::Builder* b,
+                   SkVMDebugTrace* debugTrace,
+                   SkSpan<skvm::Val> uniforms,
+                   SkVMSignature* outSignature) {
+    SkVMSignature ignored,
+                  *signature = outSignature ? outSignature : &ignored;
+
+    std::vector<skvm::Ptr> argPtrs;
+    std::vector<skvm::Val> argVals;
+
+    for (const Variable* p : function.declaration().parameters()) {
+        size_t slots = p->type().slotCount();
+        signature->fParameterSlots += slots;
+        for (size_t i = 0; i < slots; ++i) {
+            argPtrs.push_back(b->varying<float>());
+            argVals.push_back(b->loadF(argPtrs.back()).id);
+        }
+    }
+
+    std::vector<skvm::Ptr> returnPtrs;
+    std::vector<skvm::Val> returnVals;
+
+    signature->fReturnSlots = function.declaration().returnType().slotCount();
+    for (size_t i = 0; i < signature->fReturnSlots; ++i) {
+        returnPtrs.push_back(b->varying<float>());
+        returnVals.push_back(b->splat(0.0f).id);
+    }
+
+    // Set up device coordinates so that the rightmost evaluated pixel will be centered on (0, 0).
+    // (If the coordinates aren't used, dead-code elimination will optimize this away.)
+    skvm::F32 pixelCenter = b->splat(0.5f);
+    skvm::Coord device = {pixelCenter, pixelCenter};
+    device.x += to_F32(b->splat(1) - b->index());
+
+    if (!ProgramToSkVM(program, function, b, debugTrace, uniforms, device,
+                       SkMakeSpan(argVals), SkMakeSpan(returnVals))) {
         return false;
     }
 
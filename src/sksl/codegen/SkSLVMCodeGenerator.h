@@ -71,6 +71,22 @@ bool ProgramToSkVM(const Program& program,
                    SkSpan<skvm::Val> uniforms,
                    SkVMSignature* outSignature = nullptr);
 
+/*
+ * Converts 'function' to skvm instructions in 'builder', passing it the values in 'arguments' (one
+ * per slot of each parameter, in order). On return, the slots of any 'out' or 'inout' parameters
+ * in 'arguments' hold their final values, and 'outReturn' holds the return value (one per slot).
+ * Returns false if the program sampled a child or used a color transform intrinsic, neither of
+ * which can be bound here.
+ */
+bool ProgramToSkVM(const Program& program,
+                   const FunctionDefinition& function,
+                   skvm::Builder* builder,
+                   SkVMDebugTrace* debugTrace,
+                   SkSpan<skvm::Val> uniforms,
+                   skvm::Coord device,
+                   SkSpan<skvm::Val> arguments,
+                   SkSpan<skvm::Val> outReturn);
+
 const FunctionDefinition* Program_GetFunction(const Program& program, const char* function);
 
 struct UniformInfo {
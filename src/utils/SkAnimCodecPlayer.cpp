@@ -9,15 +9,24 @@
 #include "include/core/SkCanvas.h"
 #include "include/core/SkData.h"
 #include "include/core/SkImage.h"
+#include "include/private/SkTo.h"
 #include "include/utils/SkAnimCodecPlayer.h"
 #include "src/codec/SkCodecImageGenerator.h"
 #include "src/core/SkPixmapPriv.h"
+#include "src/core/SkTaskGroup.h"
 #include <algorithm>
+#include <tuple>
 
-SkAnimCodecPlayer::SkAnimCodecPlayer(std::unique_ptr<SkCodec> codec) : fCodec(std::move(codec)) {
+SkAnimCodecPlayer::SkAnimCodecPlayer(std::unique_ptr<SkCodec> codec)
+    : SkAnimCodecPlayer(std::move(codec), Options()) {}
+
+SkAnimCodecPlayer::SkAnimCodecPlayer(std::unique_ptr<SkCodec> codec, const Options& options)
+    : fOptions(options)
+    , fCodec(std::move(codec)) {
     fImageInfo = fCodec->getInfo();
     fFrameInfos = fCodec->getFrameInfo();
     fImages.resize(fFrameInfos.size());
+    fLastUse.resize(fFrameInfos.size());
 
     // change the interpretation of fDuration to a end-time for that frame
     size_t dur = 0;
@@ -31,12 +40,39 @@ SkAnimCodecPlayer::SkAnimCodecPlayer(std::unique_ptr<SkCodec> codec) : fCodec(st
         // Static image -- may or may not have returned a single frame info.
         fFrameInfos.clear();
         fImages.clear();
+        fLastUse.clear();
         fImages.push_back(SkImage::MakeFromGenerator(
                               SkCodecImageGenerator::MakeFromCodec(std::move(fCodec))));
+        return;
+    }
+
+    // Every frame is the same size once decoded, whatever its origin or alpha type.
+    fFrameBytes = fImageInfo.computeMinByteSize();
+
+    // Count how many decodes each frame needs, starting from the nearest independent frame or
+    // snapshot, and make a snapshot of each frame that reaches the interval. Required frames
+    // always come first, so one pass will do.
+    const int interval = std::max(1, fOptions.fSnapshotInterval);
+    std::vector<int> decodes(fFrameInfos.size());
+    fIsSnapshot.resize(fFrameInfos.size());
+    for (size_t i = 0; i < fFrameInfos.size(); i++) {
+        const int required = fFrameInfos[i].fRequiredFrame;
+        decodes[i] = required == SkCodec::kNoFrame || fIsSnapshot[required]
+                ? 1
+                : decodes[required] + 1;
+        fIsSnapshot[i] = decodes[i] >= interval;
+    }
+
+    if (fOptions.fExecutor && fOptions.fPrefetchCount > 0) {
+        fPrefetchTasks = std::make_unique<SkTaskGroup>(*fOptions.fExecutor);
     }
 }
 
-SkAnimCodecPlayer::~SkAnimCodecPlayer() {}
+SkAnimCodecPlayer::~SkAnimCodecPlayer() {
+    if (fPrefetchTasks) {
+        fPrefetchTasks->wait();
+    }
+}
 
 SkISize SkAnimCodecPlayer::dimensions() const {
     if (!fCodec) {
@@ -51,11 +87,39 @@ SkISize SkAnimCodecPlayer::dimensions() const {
 
 sk_sp<SkImage> SkAnimCodecPlayer::getFrameAt(int index) {
     SkASSERT((unsigned)index < fFrameInfos.size());
+    fMutex.assertHeld();
 
-    if (fImages[index]) {
-        return fImages[index];
+    // Walk back along the required frames until we find one already decoded, or one that does
+    // not need a prior frame at all.
+    std::vector<int> chain;
+    sk_sp<SkImage> prior;
+    int priorIndex = SkCodec::kNoFrame;
+    for (int i = index; i != SkCodec::kNoFrame; i = fFrameInfos[i].fRequiredFrame) {
+        if (fImages[i]) {
+            prior = fImages[i];
+            priorIndex = i;
+            break;
+        }
+        chain.push_back(i);
+    }
+
+    // Then decode forward. Caching the frames along the way means the next seek nearby (or
+    // simply playing on) can start from them.
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        prior = this->decodeFrame(*it, priorIndex, prior);
+        if (!prior) {
+            return nullptr;
+        }
+        priorIndex = *it;
+        this->cacheFrame(priorIndex, prior);
     }
 
+    fLastUse[index] = ++fUseCount;
+    return prior;
+}
+
+sk_sp<SkImage> SkAnimCodecPlayer::decodeFrame(int index, int priorIndex,
+                                              const sk_sp<SkImage>& prior) {
     size_t rb = fImageInfo.minRowBytes();
     size_t size = fImageInfo.computeByteSize(rb);
     auto data = SkData::MakeUninitialized(size);
@@ -75,9 +139,8 @@ sk_sp<SkImage> SkAnimCodecPlayer::getFrameAt(int index) {
     if (fFrameInfos[index].fAlphaType != kOpaque_SkAlphaType && imageInfo.isOpaque()) {
         imageInfo = imageInfo.makeAlphaType(kPremul_SkAlphaType);
     }
-    const int requiredFrame = fFrameInfos[index].fRequiredFrame;
-    if (requiredFrame != SkCodec::kNoFrame && fImages[requiredFrame]) {
-        auto requiredImage = fImages[requiredFrame];
+    if (prior) {
+        SkASSERT(priorIndex == fFrameInfos[index].fRequiredFrame);
         auto canvas = SkCanvas::MakeRasterDirect(imageInfo, data->writable_data(), rb);
         if (origin != kDefault_SkEncodedOrigin) {
             // The required frame is stored after applying the origin. Undo that,
@@ -91,8 +154,8 @@ sk_sp<SkImage> SkAnimCodecPlayer::getFrameAt(int index) {
             SkAssertResult(originMatrix.invert(&inverse));
             canvas->concat(inverse);
         }
-        canvas->drawImage(requiredImage, 0, 0, SkSamplingOptions(), &paint);
-        opts.fPriorFrame = requiredFrame;
+        canvas->drawImage(prior, 0, 0, SkSamplingOptions(), &paint);
+        opts.fPriorFrame = priorIndex;
     }
 
     if (SkCodec::kSuccess != fCodec->getPixels(imageInfo, data->writable_data(), rb, &opts)) {
@@ -110,15 +173,77 @@ sk_sp<SkImage> SkAnimCodecPlayer::getFrameAt(int index) {
         canvas->drawImage(image, 0, 0, SkSamplingOptions(), &paint);
         image = SkImage::MakeRasterData(imageInfo, std::move(data), rb);
     }
-    return fImages[index] = image;
+    return image;
+}
+
+void SkAnimCodecPlayer::cacheFrame(int index, sk_sp<SkImage> image) {
+    SkASSERT(!fImages[index]);
+    fImages[index] = std::move(image);
+    fLastUse[index] = ++fUseCount;
+    fCacheBytes += fFrameBytes;
+
+    if (!fOptions.fCacheBudget) {
+        return;
+    }
+    // Drop the least recently used frames until we are back under budget, keeping snapshots
+    // as long as there is anything else to drop. Neither the frame we just decoded nor the
+    // current one are dropped, so that getFrame() keeps returning the same image.
+    while (fCacheBytes > fOptions.fCacheBudget) {
+        int victim = -1;
+        for (int i = 0; i < SkToInt(fImages.size()); i++) {
+            if (!fImages[i] || i == index || i == fCurrIndex) {
+                continue;
+            }
+            if (victim < 0 ||
+                std::make_tuple(fIsSnapshot[i], fLastUse[i]) <
+                std::make_tuple(fIsSnapshot[victim], fLastUse[victim])) {
+                victim = i;
+            }
+        }
+        if (victim < 0) {
+            break;
+        }
+        fImages[victim] = nullptr;
+        fCacheBytes -= fFrameBytes;
+    }
+}
+
+void SkAnimCodecPlayer::prefetch() {
+    // Decode one frame at a time, letting go of the lock in between so that getFrame() never
+    // waits on more than one decode, and starting over whenever the current frame changes.
+    // Each frame ahead is visited once, so that a budget too small to hold them all cannot
+    // keep us evicting and decoding the same frames forever.
+    const int frameCount = SkToInt(fFrameInfos.size());
+    const int count = std::min(fOptions.fPrefetchCount, frameCount - 1);
+    int start = -1;
+    int ahead = 0;
+    for (;;) {
+        SkAutoMutexExclusive lock(fMutex);
+        if (start != fCurrIndex) {
+            start = fCurrIndex;
+            ahead = 0;
+        }
+        if (++ahead > count || !this->getFrameAt((start + ahead) % frameCount)) {
+            fPrefetchPending = false;
+            return;
+        }
+    }
 }
 
 sk_sp<SkImage> SkAnimCodecPlayer::getFrame() {
     SkASSERT(fTotalDuration > 0 || fImages.size() == 1);
 
-    return fTotalDuration > 0
-        ? this->getFrameAt(fCurrIndex)
-        : fImages.front();
+    if (!fTotalDuration) {
+        return fImages.front();
+    }
+
+    SkAutoMutexExclusive lock(fMutex);
+    auto image = this->getFrameAt(fCurrIndex);
+    if (fPrefetchTasks && !fPrefetchPending) {
+        fPrefetchPending = true;
+        fPrefetchTasks->add([this] { this->prefetch(); });
+    }
+    return image;
 }
 
 bool SkAnimCodecPlayer::seek(uint32_t msec) {
@@ -132,6 +257,7 @@ bool SkAnimCodecPlayer::seek(uint32_t msec) {
                                   [](const SkCodec::FrameInfo& info, uint32_t msec) {
                                       return (uint32_t)info.fDuration <= msec;
                                   });
+    SkAutoMutexExclusive lock(fMutex);
     int prevIndex = fCurrIndex;
     fCurrIndex = lower - fFrameInfos.begin();
     return fCurrIndex != prevIndex;
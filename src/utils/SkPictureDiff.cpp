@@ -0,0 +1,686 @@
+/*
+ * Copyright 2022 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "include/utils/SkPictureDiff.h"
+
+#include "include/core/SkData.h"
+#include "include/core/SkDrawable.h"
+#include "include/core/SkImage.h"
+#include "include/core/SkImageFilter.h"
+#include "include/core/SkPicture.h"
+#include "include/core/SkTypeface.h"
+#include "include/private/SkTemplates.h"
+#include "include/private/SkTHash.h"
+#include "include/private/SkTo.h"
+#include "include/utils/SkNWayCanvas.h"
+#include "src/core/SkCanvasPriv.h"
+#include "src/core/SkOpts.h"
+#include "src/core/SkRRectPriv.h"
+#include "src/core/SkRecord.h"
+#include "src/core/SkRecordDraw.h"
+#include "src/core/SkRecorder.h"
+#include "src/core/SkTextBlobPriv.h"
+#include "src/core/SkVerticesPriv.h"
+#include "src/core/SkWriteBuffer.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+// Plays pictures back into an SkRecorder, replacing nested pictures and drawables with their ops,
+// so that ops can be compared no matter how the pictures were put together.
+class UnrollingCanvas final : public SkNWayCanvas {
+public:
+    UnrollingCanvas(SkRecorder* recorder, int width, int height) : SkNWayCanvas(width, height) {
+        this->addCanvas(recorder);
+    }
+
+protected:
+    void onDrawPicture(const SkPicture* picture, const SkMatrix* matrix,
+                       const SkPaint* paint) override {
+        SkAutoCanvasMatrixPaint acmp(this, matrix, paint, picture->cullRect());
+        picture->playback(this);
+    }
+
+    void onDrawDrawable(SkDrawable* drawable, const SkMatrix* matrix) override {
+        drawable->draw(this, matrix);
+    }
+};
+
+uint64_t hash64(const void* data, size_t bytes) {
+    return (uint64_t)SkOpts::hash_fn(data, bytes, 0) << 32 | SkOpts::hash_fn(data, bytes, 1);
+}
+
+// An op that draws, or a whole layer, with the device space bounds of everything it may touch.
+struct Op {
+    uint64_t key;
+    SkIRect  bounds;
+    int      layer;  // Index into Ops::fLayers if this is a layer, or -1.
+};
+
+struct Layer {
+    uint64_t        header;      // The SaveLayer itself, and the matrix and clip it was made with.
+    bool            comparable;  // Can we compare the ops in this layer one by one?
+    std::vector<Op> ops;
+};
+
+// Lists the ops of an unrolled record by layer, each with a key that is the same for any two ops
+// that draw the same pixels: their content, matrix and clip.
+class Ops {
+public:
+    Ops(const SkRecord& record, const SkRect bounds[], int width, int height, int side)
+            : fBounds(bounds)
+            , fDevice(SkIRect::MakeWH(width, height))
+            , fSide(side) {
+        fProcs.fImageProc = [](SkImage* image, void*) {
+            const uint32_t id = image->uniqueID();
+            return SkData::MakeWithCopy(&id, sizeof(id));
+        };
+        fProcs.fTypefaceProc = [](SkTypeface* typeface, void*) {
+            const SkTypefaceID id = typeface->uniqueID();
+            return SkData::MakeWithCopy(&id, sizeof(id));
+        };
+        fProcs.fPictureProc = [](SkPicture* picture, void*) {
+            const uint32_t id = picture->uniqueID();
+            return SkData::MakeWithCopy(&id, sizeof(id));
+        };
+
+        fLayers.push_back({0, true, {}});
+        fSaves.push_back({fDevice, 0, 0, false, false, SkIRect::MakeEmpty()});
+        for (fCurrentOp = 0; fCurrentOp < record.count(); fCurrentOp++) {
+            record.visit(fCurrentOp, *this);
+        }
+        // Unrolling keeps saves and restores balanced, but just in case.
+        while (fSaves.size() > 1) {
+            this->restore(fDevice);
+        }
+    }
+
+    const std::vector<Layer>&   layers()    const { return fLayers; }
+    const std::vector<SkIRect>& backdrops() const { return fBackdrops; }
+
+    template <typename T>
+    std::enable_if_t<T::kTags & SkRecords::kDraw_Tag> operator()(const T& op) {
+        // Ops that draw nothing we can see still have to be listed, as a layer with an image
+        // filter could move what they draw into view.
+        SkIRect bounds = this->deviceBounds(fBounds[fCurrentOp]);
+        if (!bounds.intersect(fSaves.back().clip)) {
+            bounds.setEmpty();
+        }
+        Key key(fProcs);
+        this->write(key.buffer(), op);
+        this->writeState(key.buffer());
+        fLayers[fSaves.back().layer].ops.push_back({key.hash(), bounds, -1});
+    }
+
+    // Ops that neither draw nor change the matrix or clip.
+    void operator()(const SkRecords::NoOp&)           {}
+    void operator()(const SkRecords::Flush&)          {}
+    void operator()(const SkRecords::DrawAnnotation&) {}
+
+    void operator()(const SkRecords::Save&) {
+        fSaves.push_back(fSaves.back());
+        fSaves.back().opensLayer = false;
+    }
+
+    void operator()(const SkRecords::SaveLayer& op) {
+        Key key(fProcs);
+        SkWriteBuffer& buffer = key.buffer();
+        buffer.writeBool(op.bounds);
+        if (op.bounds) {
+            buffer.writeRect(*op.bounds);
+        }
+        this->writePaint(buffer, op.paint);
+        buffer.writeFlattenable(op.backdrop.get());
+        buffer.writeUInt(op.saveLayerFlags);
+        buffer.writeScalar(op.backdropScale);
+        this->writeState(buffer);
+
+        // Layers that start with the pixels under them draw all of their bounds, not just where
+        // their ops draw.  SkCanvas sizes layers with a backdrop to the whole clip.
+        SkIRect fills = SkIRect::MakeEmpty();
+        if (op.backdrop) {
+            fills = fSaves.back().clip;
+        } else if (op.saveLayerFlags & SkCanvas::kInitWithPrevious_SaveLayerFlag) {
+            fills = op.bounds ? this->deviceBounds(fCTM.mapRect(*op.bounds)) : fDevice;
+            if (!fills.intersect(fSaves.back().clip)) {
+                fills.setEmpty();
+            }
+        }
+
+        // Without an image filter, each pixel of the layer only depends on the ops drawn there.
+        const bool comparable = !op.backdrop && !(op.paint && op.paint->getImageFilter());
+        this->saveLayer(key.hash(), comparable, op.backdrop != nullptr, fills);
+    }
+
+    void operator()(const SkRecords::SaveBehind& op) {
+        Key key(fProcs);
+        key.buffer().writeBool(op.subset);
+        if (op.subset) {
+            key.buffer().writeRect(*op.subset);
+        }
+        this->writeState(key.buffer());
+        this->saveLayer(key.hash(), false, false, SkIRect::MakeEmpty());
+    }
+
+    void operator()(const SkRecords::Restore& op) {
+        fCTM = op.matrix;
+        this->restore(this->deviceBounds(fBounds[fCurrentOp]));
+    }
+
+    void operator()(const SkRecords::SetMatrix& op) { fCTM = op.matrix; }
+    void operator()(const SkRecords::SetM44& op)    { fCTM = op.matrix.asM33(); }
+    void operator()(const SkRecords::Concat& op)    { fCTM.preConcat(op.matrix); }
+    void operator()(const SkRecords::Concat44& op)  { fCTM.preConcat(op.matrix.asM33()); }
+    void operator()(const SkRecords::Scale& op)     { fCTM.preScale(op.sx, op.sy); }
+    void operator()(const SkRecords::Translate& op) { fCTM.preTranslate(op.dx, op.dy); }
+
+    void operator()(const SkRecords::ClipRect& op) {
+        Key key(fProcs);
+        key.buffer().writeRect(op.rect);
+        this->clip(key, op.opAA.op(), op.opAA.aa(), op.rect);
+    }
+    void operator()(const SkRecords::ClipRRect& op) {
+        Key key(fProcs);
+        WriteRRect(key.buffer(), op.rrect);
+        this->clip(key, op.opAA.op(), op.opAA.aa(), op.rrect.rect());
+    }
+    void operator()(const SkRecords::ClipPath& op) {
+        Key key(fProcs);
+        key.buffer().writePath(op.path);
+        this->clip(key, op.opAA.op(), op.opAA.aa(),
+                   op.path.isInverseFillType() ? SkRect::MakeEmpty() : op.path.getBounds());
+    }
+    void operator()(const SkRecords::ClipRegion& op) {
+        // Regions are in device space, so they don't tighten our bounds.
+        Key key(fProcs);
+        key.buffer().writeRegion(op.region);
+        this->clip(key, op.op, false, SkRect::MakeEmpty());
+    }
+    void operator()(const SkRecords::ClipShader& op) {
+        Key key(fProcs);
+        key.buffer().writeFlattenable(op.shader.get());
+        this->clip(key, op.op, false, SkRect::MakeEmpty());
+    }
+    void operator()(const SkRecords::ResetClip&) {
+        fSaves.back().clip = fDevice;
+        fSaves.back().clipKey = 0;
+    }
+
+private:
+    // Each op is written to its own buffer, so flattenables are always written the same way.
+    class Key {
+    public:
+        explicit Key(const SkSerialProcs& procs) : fBuffer(fStorage, sizeof(fStorage)) {
+            fBuffer.setSerialProcs(procs);
+        }
+
+        SkWriteBuffer& buffer() { return fBuffer; }
+
+        uint64_t hash() {
+            if (fBuffer.usingInitialStorage()) {
+                return hash64(fStorage, fBuffer.bytesWritten());
+            }
+            sk_sp<SkData> data = fBuffer.snapshotAsData();
+            return hash64(data->data(), data->size());
+        }
+
+    private:
+        char                fStorage[512];
+        SkBinaryWriteBuffer fBuffer;
+    };
+
+    struct SaveState {
+        SkIRect  clip;     // Conservative device space bounds of the clip.
+        uint64_t clipKey;  // Identifies the clip ops that made the clip.
+        int      layer;       // The layer that ops are drawn into.
+        bool     opensLayer;  // Did this save start that layer?
+        bool     backdrop;    // Does that layer have a backdrop?
+        SkIRect  fills;       // The bounds that layer draws no matter what's drawn into it.
+    };
+
+    SkIRect deviceBounds(const SkRect& bounds) const {
+        if (bounds.isEmpty()) {
+            return SkIRect::MakeEmpty();
+        }
+        // Anti-aliasing can touch the pixels just outside of the bounds.
+        SkIRect device = bounds.makeOutset(1, 1).roundOut();
+        return device.intersect(fDevice) ? device : SkIRect::MakeEmpty();
+    }
+
+    void writeState(SkWriteBuffer& buffer) const {
+        buffer.writeMatrix(fCTM);
+        buffer.writeByteArray(&fSaves.back().clipKey, sizeof(uint64_t));
+    }
+
+    void clip(Key& key, SkClipOp op, bool aa, const SkRect& localBounds) {
+        SkWriteBuffer& buffer = key.buffer();
+        buffer.writeInt((int)op);
+        buffer.writeBool(aa);
+        buffer.writeMatrix(fCTM);
+        buffer.writeByteArray(&fSaves.back().clipKey, sizeof(uint64_t));
+
+        SaveState& state = fSaves.back();
+        state.clipKey = key.hash();
+        if (op == SkClipOp::kIntersect && !localBounds.isEmpty() &&
+            !state.clip.intersect(fCTM.mapRect(localBounds).roundOut())) {
+            state.clip.setEmpty();
+        }
+    }
+
+    void saveLayer(uint64_t header, bool comparable, bool hasBackdrop, const SkIRect& fills) {
+        fSaves.push_back(fSaves.back());
+        fSaves.back().layer      = SkToInt(fLayers.size());
+        fSaves.back().opensLayer = true;
+        fSaves.back().backdrop   = hasBackdrop;
+        fSaves.back().fills      = fills;
+        fLayers.push_back({header, comparable, {}});
+    }
+
+    void restore(SkIRect bounds) {
+        const SaveState state = fSaves.back();
+        fSaves.pop_back();
+        if (!state.opensLayer) {
+            return;
+        }
+        // The layer is drawn with the clip it was saved with, which we've just restored.
+        const Layer& layer = fLayers[state.layer];
+        if (!bounds.intersect(fSaves.back().clip)) {
+            bounds.setEmpty();
+        }
+        bounds.join(state.fills);
+        std::vector<uint64_t> keys;
+        keys.reserve(layer.ops.size() + 1);
+        keys.push_back(layer.header);
+        for (const Op& op : layer.ops) {
+            keys.push_back(op.key);
+        }
+        const uint64_t key = hash64(keys.data(), keys.size() * sizeof(uint64_t));
+        fLayers[fSaves.back().layer].ops.push_back({key, bounds, state.layer});
+        if (state.backdrop && !bounds.isEmpty()) {
+            fBackdrops.push_back(bounds);
+        }
+    }
+
+    void writePaint(SkWriteBuffer& buffer, const SkPaint* paint) const {
+        buffer.writeBool(paint);
+        if (paint) {
+            buffer.writePaint(*paint);
+        }
+    }
+
+    static void WriteRRect(SkWriteBuffer& buffer, const SkRRect& rrect) {
+        buffer.writeRect(rrect.rect());
+        buffer.writePointArray(SkRRectPriv::GetRadiiArray(rrect), 4);
+    }
+
+    static void WriteSampling(SkWriteBuffer& buffer, const SkSamplingOptions& sampling) {
+        buffer.writeBool(sampling.useCubic);
+        buffer.writeScalar(sampling.cubic.B);
+        buffer.writeScalar(sampling.cubic.C);
+        buffer.writeInt((int)sampling.filter);
+        buffer.writeInt((int)sampling.mipmap);
+    }
+
+    static void WriteImage(SkWriteBuffer& buffer, const SkImage* image) {
+        buffer.writeUInt(image ? image->uniqueID() : 0);
+    }
+
+    template <typename T>
+    static void WriteArray(SkWriteBuffer& buffer, const T* array, int count) {
+        buffer.writeBool(array);
+        if (array) {
+            buffer.writeByteArray(array, count * sizeof(T));
+        }
+    }
+
+    // These never match anything: pictures and drawables have already been unrolled.
+    void write(SkWriteBuffer& buffer, const SkRecords::DrawPicture&) const {
+        buffer.writeInt(fSide);
+        buffer.writeInt(fCurrentOp);
+    }
+    void write(SkWriteBuffer& buffer, const SkRecords::DrawDrawable&) const {
+        buffer.writeInt(fSide);
+        buffer.writeInt(fCurrentOp);
+    }
+
+    void write(SkWriteBuffer& buffer, const SkRecords::DrawArc& op) const {
+        this->writePaint(buffer, &op.paint);
+        buffer.writeRect(op.oval);
+        buffer.writeScalar(op.startAngle);
+        buffer.writeScalar(op.sweepAngle);
+        buffer.writeBool(op.useCenter);
+    }
+    void write(SkWriteBuffer& buffer, const SkRecords::DrawDRRect& op) const {
+        this->writePaint(buffer, &op.paint);
+        WriteRRect(buffer, op.outer);
+        WriteRRect(buffer, op.inner);
+    }
+    void write(SkWriteBuffer& buffer, const SkRecords::DrawImage& op) const {
+        this->writePaint(buffer, op.paint);
+        WriteImage(buffer, op.image.get());
+        buffer.writeScalar(op.left);
+        buffer.writeScalar(op.top);
+        WriteSampling(buffer, op.sampling);
+    }
+    void write(SkWriteBuffer& buffer, const SkRecords::DrawImageLattice& op) const {
+        this->writePaint(buffer, op.paint);
+        WriteImage(buffer, op.image.get());
+        WriteArray<int>(buffer, op.xDivs, op.xCount);
+        WriteArray<int>(buffer, op.yDivs, op.yCount);
+        WriteArray<SkCanvas::Lattice::RectType>(buffer, op.flags, op.flagCount);
+        WriteArray<SkColor>(buffer, op.colors, op.flagCount);
+        buffer.writeIRect(op.src);
+        buffer.writeRect(op.dst);
+        buffer.writeInt((int)op.filter);
+    }
+    void write(SkWriteBuffer& buffer, const SkRecords::DrawImageRect& op) const {
+        this->writePaint(buffer, op.paint);
+        WriteImage(buffer, op.image.get());
+        buffer.writeRect(op.src);
+        buffer.writeRect(op.dst);
+        WriteSampling(buffer, op.sampling);
+        buffer.writeInt(op.constraint);
+    }
+    void write(SkWriteBuffer& buffer, const SkRecords::DrawOval& op) const {
+        this->writePaint(buffer, &op.paint);
+        buffer.writeRect(op.oval);
+    }
+    void write(SkWriteBuffer& buffer, const SkRecords::DrawPaint& op) const {
+        this->writePaint(buffer, &op.paint);
+    }
+    void write(SkWriteBuffer& buffer, const SkRecords::DrawBehind& op) const {
+        this->writePaint(buffer, &op.paint);
+    }
+    void write(SkWriteBuffer& buffer, const SkRecords::DrawPath& op) const {
+        this->writePaint(buffer, &op.paint);
+        buffer.writePath(op.path);
+    }
+    void write(SkWriteBuffer& buffer, const SkRecords::DrawPoints& op) const {
+        this->writePaint(buffer, &op.paint);
+        buffer.writeInt(op.mode);
+        buffer.writePointArray(op.pts, op.count);
+    }
+    void write(SkWriteBuffer& buffer, const SkRecords::DrawRRect& op) const {
+        this->writePaint(buffer, &op.paint);
+        WriteRRect(buffer, op.rrect);
+    }
+    void write(SkWriteBuffer& buffer, const SkRecords::DrawRect& op) const {
+        this->writePaint(buffer, &op.paint);
+        buffer.writeRect(op.rect);
+    }
+    void write(SkWriteBuffer& buffer, const SkRecords::DrawRegion& op) const {
+        this->writePaint(buffer, &op.paint);
+        buffer.writeRegion(op.region);
+    }
+    void write(SkWriteBuffer& buffer, const SkRecords::DrawTextBlob& op) const {
+        this->writePaint(buffer, &op.paint);
+        SkTextBlobPriv::Flatten(*op.blob, buffer);
+        buffer.writeScalar(op.x);
+        buffer.writeScalar(op.y);
+    }
+    void write(SkWriteBuffer& buffer, const SkRecords::DrawPatch& op) const {
+        this->writePaint(buffer, &op.paint);
+        WriteArray<SkPoint>(buffer, op.cubics, 12);
+        WriteArray<SkColor>(buffer, op.colors, 4);
+        WriteArray<SkPoint>(buffer, op.texCoords, 4);
+        buffer.writeInt((int)op.bmode);
+    }
+    void write(SkWriteBuffer& buffer, const SkRecords::DrawAtlas& op) const {
+        this->writePaint(buffer, op.paint);
+        WriteImage(buffer, op.atlas.get());
+        WriteArray<SkRSXform>(buffer, op.xforms, op.count);
+        WriteArray<SkRect>(buffer, op.texs, op.count);
+        WriteArray<SkColor>(buffer, op.colors, op.count);
+        buffer.writeInt((int)op.mode);
+        WriteSampling(buffer, op.sampling);
+        WriteArray<SkRect>(buffer, op.cull, 1);
+    }
+    void write(SkWriteBuffer& buffer, const SkRecords::DrawVertices& op) const {
+        this->writePaint(buffer, &op.paint);
+        op.vertices->priv().encode(buffer);
+        buffer.writeInt((int)op.bmode);
+    }
+    void write(SkWriteBuffer& buffer, const SkRecords::DrawShadowRec& op) const {
+        buffer.writePath(op.path);
+        buffer.writePoint3(op.rec.fZPlaneParams);
+        buffer.writePoint3(op.rec.fLightPos);
+        buffer.writeScalar(op.rec.fLightRadius);
+        buffer.writeColor(op.rec.fAmbientColor);
+        buffer.writeColor(op.rec.fSpotColor);
+        buffer.writeUInt(op.rec.fFlags);
+    }
+    void write(SkWriteBuffer& buffer, const SkRecords::DrawEdgeAAQuad& op) const {
+        buffer.writeRect(op.rect);
+        WriteArray<SkPoint>(buffer, op.clip, 4);
+        buffer.writeInt(op.aa);
+        buffer.writeColor4f(op.color);
+        buffer.writeInt((int)op.mode);
+    }
+    void write(SkWriteBuffer& buffer, const SkRecords::DrawEdgeAAImageSet& op) const {
+        this->writePaint(buffer, op.paint);
+        int clipCount = 0,
+            matrixCount = 0;
+        for (int i = 0; i < op.count; i++) {
+            const SkCanvas::ImageSetEntry& entry = op.set[i];
+            WriteImage(buffer, entry.fImage.get());
+            buffer.writeRect(entry.fSrcRect);
+            buffer.writeRect(entry.fDstRect);
+            buffer.writeInt(entry.fMatrixIndex);
+            buffer.writeScalar(entry.fAlpha);
+            buffer.writeUInt(entry.fAAFlags);
+            buffer.writeBool(entry.fHasClip);
+            clipCount += entry.fHasClip ? 4 : 0;
+            matrixCount = std::max(matrixCount, entry.fMatrixIndex + 1);
+        }
+        WriteArray<SkPoint>(buffer, op.dstClips, clipCount);
+        for (int i = 0; i < matrixCount; i++) {
+            buffer.writeMatrix(op.preViewMatrices[i]);
+        }
+        WriteSampling(buffer, op.sampling);
+        buffer.writeInt(op.constraint);
+    }
+
+    const SkRect*          fBounds;
+    const SkIRect          fDevice;
+    const int              fSide;
+    SkSerialProcs          fProcs;
+    int                    fCurrentOp = 0;
+    SkMatrix               fCTM = SkMatrix::I();
+    std::vector<SaveState> fSaves;
+    std::vector<Layer>     fLayers;
+    std::vector<SkIRect>   fBackdrops;
+};
+
+// Unrolls the picture as drawn with the matrix into a device of the given size, and lists its ops.
+std::unique_ptr<Ops> make_ops(const SkPicture* picture, const SkMatrix& matrix,
+                              int width, int height, int side) {
+    SkRecord record;
+    if (picture) {
+        SkRecorder recorder(&record, SkRect::MakeIWH(width, height));
+        UnrollingCanvas canvas(&recorder, width, height);
+        canvas.concat(matrix);
+        picture->playback(&canvas);
+        canvas.restoreToCount(1);
+    }
+
+    SkAutoTMalloc<SkRect> bounds(record.count());
+    SkAutoTMalloc<SkBBoxHierarchy::Metadata> meta(record.count());
+    SkRecordFillBounds(SkRect::MakeIWH(width, height), record, bounds, meta);
+    return std::make_unique<Ops>(record, bounds, width, height, side);
+}
+
+// Matches the ops of two layers like a patience diff: first the ops at the start and end that are
+// the same, then the longest increasing run of ops that appear exactly once in each of them, and
+// then the same again between those.  The ops left over are damaged.
+class Matcher {
+public:
+    Matcher(const Ops& before, const Ops& after) : fBefore(before), fAfter(after) {}
+
+    void match(int beforeLayer, int afterLayer) {
+        const std::vector<Op>& a = fBefore.layers()[beforeLayer].ops;
+        const std::vector<Op>& b = fAfter .layers()[afterLayer ].ops;
+        fWork.push_back({a.data(), SkToInt(a.size()), b.data(), SkToInt(b.size())});
+
+        while (!fWork.empty()) {
+            Range r = fWork.back();
+            fWork.pop_back();
+            this->matchRange(r);
+        }
+    }
+
+    std::vector<SkIRect>& damage() { return fDamage; }
+
+private:
+    struct Range {
+        const Op* a;
+        int       aCount;
+        const Op* b;
+        int       bCount;
+    };
+
+    void damage(const Op* ops, int count) {
+        for (int i = 0; i < count; i++) {
+            if (!ops[i].bounds.isEmpty()) {
+                fDamage.push_back(ops[i].bounds);
+            }
+        }
+    }
+
+    void matchRange(Range r) {
+        while (r.aCount > 0 && r.bCount > 0 && r.a[0].key == r.b[0].key) {
+            r.a++; r.aCount--;
+            r.b++; r.bCount--;
+        }
+        while (r.aCount > 0 && r.bCount > 0 && r.a[r.aCount-1].key == r.b[r.bCount-1].key) {
+            r.aCount--;
+            r.bCount--;
+        }
+        if (r.aCount == 0 || r.bCount == 0) {
+            this->damage(r.a, r.aCount);
+            this->damage(r.b, r.bCount);
+            return;
+        }
+
+        // A layer that changed in place: compare what's in it.
+        if (r.aCount == 1 && r.bCount == 1 && r.a[0].layer >= 0 && r.b[0].layer >= 0) {
+            const Layer& a = fBefore.layers()[r.a[0].layer];
+            const Layer& b = fAfter .layers()[r.b[0].layer];
+            if (a.header == b.header && a.comparable && b.comparable) {
+                fWork.push_back({a.ops.data(), SkToInt(a.ops.size()),
+                                 b.ops.data(), SkToInt(b.ops.size())});
+                return;
+            }
+        }
+
+        struct Count {
+            int aCount = 0, aIndex = 0,
+                bCount = 0, bIndex = 0;
+        };
+        SkTHashMap<uint64_t, Count> counts;
+        for (int i = 0; i < r.aCount; i++) {
+            Count* count = counts.find(r.a[i].key);
+            if (!count) {
+                count = counts.set(r.a[i].key, Count());
+            }
+            count->aCount++;
+            count->aIndex = i;
+        }
+        for (int i = 0; i < r.bCount; i++) {
+            if (Count* count = counts.find(r.b[i].key)) {
+                count->bCount++;
+                count->bIndex = i;
+            }
+        }
+
+        // The unique ops in b's order, by their index in a, and then the longest run of them that
+        // is in a's order too.
+        std::vector<int> unique;
+        for (int i = 0; i < r.bCount; i++) {
+            const Count* count = counts.find(r.b[i].key);
+            if (count && count->aCount == 1 && count->bCount == 1) {
+                unique.push_back(count->aIndex);
+            }
+        }
+        std::vector<int> anchors = LongestIncreasing(unique);
+        if (anchors.empty()) {
+            this->damage(r.a, r.aCount);
+            this->damage(r.b, r.bCount);
+            return;
+        }
+
+        int aStart = 0,
+            bStart = 0;
+        for (int aIndex : anchors) {
+            const int bIndex = counts.find(r.a[aIndex].key)->bIndex;
+            fWork.push_back({r.a + aStart, aIndex - aStart, r.b + bStart, bIndex - bStart});
+            aStart = aIndex + 1;
+            bStart = bIndex + 1;
+        }
+        fWork.push_back({r.a + aStart, r.aCount - aStart, r.b + bStart, r.bCount - bStart});
+    }
+
+    // Returns the longest strictly increasing subsequence of values.
+    static std::vector<int> LongestIncreasing(const std::vector<int>& values) {
+        std::vector<int> tails,     // Index of the smallest last value of a run of each length.
+                         previous(values.size());
+        for (int i = 0; i < SkToInt(values.size()); i++) {
+            auto it = std::lower_bound(tails.begin(), tails.end(), values[i],
+                                       [&](int tail, int value) { return values[tail] < value; });
+            previous[i] = it == tails.begin() ? -1 : *(it - 1);
+            if (it == tails.end()) {
+                tails.push_back(i);
+            } else {
+                *it = i;
+            }
+        }
+        std::vector<int> run(tails.size());
+        for (int i = tails.empty() ? -1 : tails.back(), n = SkToInt(run.size()); i >= 0;
+             i = previous[i]) {
+            run[--n] = values[i];
+        }
+        return run;
+    }
+
+    const Ops&           fBefore;
+    const Ops&           fAfter;
+    std::vector<Range>   fWork;
+    std::vector<SkIRect> fDamage;
+};
+
+}  // namespace
+
+SkRegion SkPictureDiff::Damage(const SkPicture* before, const SkPicture* after,
+                               const SkIRect& deviceBounds, const SkMatrix& matrix) {
+    SkRegion region;
+    if (deviceBounds.isEmpty() || before == after) {
+        return region;
+    }
+
+    // Record in a device that starts at the origin, and move the damage back at the end.
+    const SkMatrix toDevice = SkMatrix::Translate(-deviceBounds.left(), -deviceBounds.top())
+                            * matrix;
+    const int width  = deviceBounds.width(),
+              height = deviceBounds.height();
+    std::unique_ptr<Ops> a = make_ops(before, toDevice, width, height, 0),
+                         b = make_ops(after,  toDevice, width, height, 1);
+
+    Matcher matcher(*a, *b);
+    matcher.match(0, 0);
+    std::vector<SkIRect>& damage = matcher.damage();
+
+    // Layers with a backdrop read the pixels around them, so anything could change them.
+    if (!damage.empty()) {
+        damage.insert(damage.end(), a->backdrops().begin(), a->backdrops().end());
+        damage.insert(damage.end(), b->backdrops().begin(), b->backdrops().end());
+    }
+
+    region.setRects(damage.data(), SkToInt(damage.size()));
+    region.translate(deviceBounds.left(), deviceBounds.top());
+    return region;
+}
@@ -11,6 +11,7 @@
 #include "include/core/SkCanvas.h"
 #include "include/core/SkColor.h"
 #include "include/core/SkColorPriv.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkImageInfo.h"
 #include "include/core/SkMaskFilter.h"
 #include "include/core/SkMath.h"
@@ -30,9 +31,11 @@
 #include "include/gpu/GrDirectContext.h"
 #include "include/private/SkFloatBits.h"
 #include "include/private/SkTPin.h"
+#include "include/utils/SkRandom.h"
 #include "src/core/SkBlurMask.h"
 #include "src/core/SkGpuBlurUtils.h"
 #include "src/core/SkMask.h"
+#include "src/core/SkMaskBlurFilter.h"
 #include "src/core/SkMaskFilterBase.h"
 #include "src/core/SkMathPriv.h"
 #include "src/effects/SkEmbossMaskFilter.h"
@@ -42,6 +45,7 @@
 
 #include <math.h>
 #include <string.h>
+#include <functional>
 #include <initializer_list>
 #include <utility>
 
@@ -580,3 +584,220 @@ DEF_TEST(zero_blur, reporter) {
     SkIPoint offset;
     bitmap.extractAlpha(&alpha, &paint, nullptr, &offset);
 }
+
+// Given an executor, large masks are blurred in bands of rows on it. The result must not depend on
+// how the rows were split up, or on whether the bands ran on other threads.
+DEF_TEST(MaskBlurFilter_Bands, reporter) {
+    std::unique_ptr<SkExecutor> threadPool = SkExecutor::MakeFIFOThreadPool(4);
+
+    const struct {
+        SkMask::Format format;
+        int            bytesPerPixel;  // 0 for 1-bit kBW_Format.
+    } formats[] = {
+        {SkMask::kBW_Format,     0},
+        {SkMask::kA8_Format,     1},
+        {SkMask::kARGB32_Format, 4},
+        {SkMask::kLCD16_Format,  2},
+    };
+
+    SkRandom rand;
+    for (auto [format, bytesPerPixel] : formats) {
+        // Odd sizes leave rows over after the SIMD groups of rows, and after each band.
+        for (SkISize size : {SkISize{301, 259}, SkISize{517, 130}, SkISize{37, 1023}}) {
+            SkMask src;
+            src.fFormat   = format;
+            src.fBounds   = SkIRect::MakeXYWH(7, 3, size.width(), size.height());
+            src.fRowBytes = bytesPerPixel ? size.width() * bytesPerPixel
+                                          : SkAlign4((size.width() + 7) / 8);
+            SkAutoMaskFreeImage srcImage(src.fImage = SkMask::AllocImage(src.computeImageSize()));
+            for (size_t i = 0; i < src.computeImageSize(); i++) {
+                src.fImage[i] = rand.nextBool() ? 0xFF : rand.nextU();
+            }
+
+            for (double sigma : {2.5, 20.0, 100.0}) {
+                SkMaskBlurFilter filter{sigma, sigma * 0.5};
+                SkMask serial, threaded;
+                SkIPoint serialMargin   = filter.blur(src, &serial),
+                         threadedMargin = filter.blur(src, &threaded, threadPool.get());
+                SkAutoMaskFreeImage serialImage(serial.fImage),
+                                    threadedImage(threaded.fImage);
+
+                REPORTER_ASSERT(reporter, serialMargin == threadedMargin);
+                REPORTER_ASSERT(reporter, serial.fBounds == threaded.fBounds);
+                REPORTER_ASSERT(reporter, !memcmp(serial.fImage, threaded.fImage,
+                                                  serial.computeImageSize()),
+                                "format %d, %dx%d, sigma %g", format, size.width(), size.height(),
+                                sigma);
+            }
+        }
+    }
+}
+
+// Rows are blurred a few at a time with SIMD, and any rows left over one at a time. Padding the
+// mask with a row and column of zeros moves every row to a different lane, or out of the SIMD
+// groups altogether, but must not change the blurred pixels.
+DEF_TEST(MaskBlurFilter_RowGroups, reporter) {
+    SkRandom rand;
+    for (int height : {5, 8, 63, 130}) {
+        SkMask src;
+        src.fFormat   = SkMask::kA8_Format;
+        src.fBounds   = SkIRect::MakeXYWH(1, 1, 97, height);
+        src.fRowBytes = src.fBounds.width();
+        SkAutoMaskFreeImage srcImage(src.fImage = SkMask::AllocImage(src.computeImageSize()));
+        for (size_t i = 0; i < src.computeImageSize(); i++) {
+            src.fImage[i] = rand.nextU();
+        }
+
+        SkMask padded = src;
+        padded.fBounds.fLeft -= 1;
+        padded.fBounds.fTop  -= 1;
+        padded.fRowBytes = padded.fBounds.width();
+        padded.fImage = SkMask::AllocImage(padded.computeImageSize(), SkMask::kZeroInit_Alloc);
+        SkAutoMaskFreeImage paddedImage(padded.fImage);
+        for (int y = src.fBounds.top(); y < src.fBounds.bottom(); y++) {
+            memcpy(padded.getAddr8(src.fBounds.left(), y), src.getAddr8(src.fBounds.left(), y),
+                   src.fBounds.width());
+        }
+
+        for (double sigma : {2.0, 7.5, 30.0}) {
+            SkMaskBlurFilter filter{sigma, sigma};
+            SkMask dst, paddedDst;
+            filter.blur(src, &dst);
+            filter.blur(padded, &paddedDst);
+            SkAutoMaskFreeImage dstImage(dst.fImage),
+                                paddedDstImage(paddedDst.fImage);
+
+            REPORTER_ASSERT(reporter, paddedDst.fBounds.contains(dst.fBounds));
+            int mismatches = 0;
+            for (int y = dst.fBounds.top(); y < dst.fBounds.bottom(); y++) {
+                for (int x = dst.fBounds.left(); x < dst.fBounds.right(); x++) {
+                    mismatches += *dst.getAddr8(x, y) != *paddedDst.getAddr8(x, y);
+                }
+            }
+            REPORTER_ASSERT(reporter, mismatches == 0, "height %d, sigma %g: %d mismatches",
+                            height, sigma, mismatches);
+        }
+    }
+}
+
+// A round rect with circular corners (or a rect, with no radius) blurred by a true Gaussian,
+// integrated numerically over rows.
+static float gaussian_blurred_rrect(float x, float y, const SkRect& r, float radius, float sigma) {
+    auto cdf = [sigma](float v) { return 0.5f * erfcf(-v / (sigma * SK_FloatSqrt2)); };
+
+    const float lo = std::max(y - 4 * sigma, r.fTop),
+                hi = std::min(y + 4 * sigma, r.fBottom);
+    const int kSlices = 64;
+    float coverage = 0;
+    for (int i = 0; i < kSlices && lo < hi; i++) {
+        float y0 = lo + (hi - lo) * i / kSlices,
+              y1 = lo + (hi - lo) * (i + 1) / kSlices,
+              sy = (y0 + y1) / 2;
+        float dy = std::max({0.0f, r.fTop + radius - sy, sy - (r.fBottom - radius)}),
+              inset = radius - sqrtf(std::max(0.0f, radius * radius - dy * dy));
+        coverage += (cdf(y1 - y) - cdf(y0 - y)) *
+                    (cdf(x - r.fLeft - inset) - cdf(x - r.fRight + inset));
+    }
+    return coverage;
+}
+
+// Blurred rects, nested rects and round rects with small circular corners are drawn on the
+// raster backend from closed-form coverage stages instead of a mask. Check them against a
+// Gaussian blur of the exact geometry, with and without a clip that cuts through the blur, and
+// against the mask blur they replace.
+DEF_TEST(BlurAnalyticRaster, reporter) {
+    const SkRect outer = SkRect::MakeLTRB(50, 60.5f, 200.25f, 180),
+                 inner = SkRect::MakeLTRB(90, 100, 150, 150.5f);
+    const SkIRect clipR = SkIRect::MakeLTRB(40, 30, 200, 180),
+                  holeR = SkIRect::MakeLTRB(90, 90, 120, 120);
+
+    // Round rects are only drawn this way while their corners are small next to the blur.
+    const struct {
+        const char*                  name;
+        SkRect                       rect;
+        float                        radius;
+        bool                         nested;
+        std::initializer_list<float> sigmas;
+    } shapes[] = {
+        {"rect",         outer,                             0, false, {0.75f, 2.5f, 9, 25}},
+        {"nested rects", outer,                             0, true,  {0.75f, 2.5f, 9, 25}},
+        {"rrect",        outer,                             6, false, {0.75f, 2.5f, 4}},
+        {"small radius", outer,                             2, false, {0.75f, 2.5f, 4.5f}},
+        {"circle",       SkRect::MakeXYWH(100, 90, 24, 24), 12, false, {0.75f, 2.5f, 3}},
+    };
+
+    for (const auto& shape : shapes) {
+        const SkRect& rect = shape.rect;
+        for (float sigma : shape.sigmas) {
+            for (bool clip : {false, true}) {
+                SkBitmap bitmap;
+                bitmap.allocPixels(SkImageInfo::MakeA8(256, 256));
+                bitmap.eraseColor(SK_ColorTRANSPARENT);
+                SkCanvas canvas(bitmap);
+                if (clip) {
+                    canvas.clipIRect(clipR);
+                    canvas.clipIRect(holeR, SkClipOp::kDifference);
+                }
+                SkPaint paint;
+                paint.setMaskFilter(SkMaskFilter::MakeBlur(kNormal_SkBlurStyle, sigma));
+
+                SkPath path;
+                if (shape.nested) {
+                    path.addRect(rect);
+                    path.addRect(inner, SkPathDirection::kCCW);
+                    canvas.drawPath(path, paint);
+                } else if (shape.radius == rect.width() / 2) {
+                    path.addOval(rect);
+                    canvas.drawOval(rect, paint);
+                } else {
+                    path.addRRect(SkRRect::MakeRectXY(rect, shape.radius, shape.radius));
+                    canvas.drawRRect(SkRRect::MakeRectXY(rect, shape.radius, shape.radius), paint);
+                }
+
+                // An extra, empty contour keeps the same geometry from being recognized as a rect
+                // or round rect, so it is blurred as a mask.
+                SkBitmap masked;
+                masked.allocPixels(bitmap.info());
+                masked.eraseColor(SK_ColorTRANSPARENT);
+                SkCanvas maskedCanvas(masked);
+                if (clip) {
+                    maskedCanvas.clipIRect(clipR);
+                    maskedCanvas.clipIRect(holeR, SkClipOp::kDifference);
+                }
+                path.moveTo(0, 0);
+                path.lineTo(1, 0);
+                maskedCanvas.drawPath(path, paint);
+
+                float maxDiff = 0,
+                      maxMaskDiff = 0;
+                for (int y = 0; y < 256; y += 3) {
+                    for (int x = 0; x < 256; x += 3) {
+                        float expected = 0;
+                        if (!clip || (clipR.contains(x, y) && !holeR.contains(x, y))) {
+                            expected = gaussian_blurred_rrect(x + 0.5f, y + 0.5f, rect,
+                                                              shape.radius, sigma);
+                            if (shape.nested) {
+                                expected -= gaussian_blurred_rrect(x + 0.5f, y + 0.5f, inner,
+                                                                   0, sigma);
+                            }
+                        }
+                        maxDiff = std::max(maxDiff,
+                                           std::abs(*bitmap.getAddr8(x, y) - 255 * expected));
+                        maxMaskDiff = std::max(maxMaskDiff,
+                                               std::abs(*masked.getAddr8(x, y) - 255 * expected));
+                    }
+                }
+                // The blur kernel only approximates a Gaussian. Nested rects subtract two blurs,
+                // so their error can double. The mask blur rasterizes the geometry first, so it
+                // strays further at small sigmas; drawing analytically must not do much worse.
+                const float tolerance = shape.nested ? 9 : 5;
+                REPORTER_ASSERT(reporter, maxDiff <= tolerance,
+                                "%s, sigma %g%s: max difference %g",
+                                shape.name, sigma, clip ? ", clipped" : "", maxDiff);
+                REPORTER_ASSERT(reporter, maxDiff <= maxMaskDiff + tolerance / 2,
+                                "%s, sigma %g%s: max difference %g, %g with a mask",
+                                shape.name, sigma, clip ? ", clipped" : "", maxDiff, maxMaskDiff);
+            }
+        }
+    }
+}
@@ -10,6 +10,7 @@
 #include "include/codec/SkCodecAnimation.h"
 #include "include/core/SkBitmap.h"
 #include "include/core/SkData.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkImage.h"
 #include "include/core/SkImageInfo.h"
 #include "include/core/SkRect.h"
@@ -17,7 +18,9 @@
 #include "include/core/SkSize.h"
 #include "include/core/SkString.h"
 #include "include/core/SkTypes.h"
+#include "include/private/SkTo.h"
 #include "include/utils/SkAnimCodecPlayer.h"
+#include "include/utils/SkRandom.h"
 #include "tests/CodecPriv.h"
 #include "tests/Test.h"
 #include "tools/Resources.h"
@@ -609,3 +612,59 @@ DEF_TEST(AnimCodecPlayer, r) {
                         "Mismatched size for frame at 500 ms of %s", test.fFile);
     }
 }
+
+DEF_TEST(AnimCodecPlayer_Cache, r) {
+    auto executor = SkExecutor::MakeFIFOThreadPool(4);
+
+    for (const char* file : { "images/alphabetAnim.gif",
+                              "images/required.gif",
+                              "images/required.webp",
+                              "images/stoplight.webp" }) {
+        auto data = GetResourceAsData(file);
+        if (!data) {
+            continue;
+        }
+        auto codec = SkCodec::MakeFromData(data);
+        REPORTER_ASSERT(r, codec);
+        std::vector<uint32_t> startTimes;
+        uint32_t time = 0;
+        for (const auto& info : codec->getFrameInfo()) {
+            startTimes.push_back(time);
+            time += info.fDuration;
+        }
+
+        // Every frame, decoded (and cached) in order.
+        SkAnimCodecPlayer reference(std::move(codec));
+        std::vector<sk_sp<SkImage>> expected;
+        for (uint32_t start : startTimes) {
+            reference.seek(start);
+            expected.push_back(reference.getFrame());
+            REPORTER_ASSERT(r, expected.back());
+        }
+        const int frameCount = SkToInt(expected.size());
+        const size_t frameBytes = expected[0]->imageInfo().computeMinByteSize();
+
+        // A budget too small to keep every frame forces frames to be dropped and decoded again,
+        // starting from snapshots and from whatever is left in the cache.
+        for (SkExecutor* prefetchExecutor : { (SkExecutor*)nullptr, executor.get() }) {
+            SkAnimCodecPlayer::Options options;
+            options.fCacheBudget = 2 * frameBytes;
+            options.fSnapshotInterval = 2;
+            options.fExecutor = prefetchExecutor;
+            SkAnimCodecPlayer player(SkCodec::MakeFromData(data), options);
+
+            SkRandom rand;
+            for (int i = 0; i < 4 * frameCount; i++) {
+                // Play forward, then seek around at random.
+                const int index = i < frameCount ? i : rand.nextULessThan(frameCount);
+                player.seek(startTimes[index]);
+                auto frame = player.getFrame();
+                REPORTER_ASSERT(r, frame && ToolUtils::equal_pixels(frame.get(),
+                                                                    expected[index].get()),
+                                "Mismatched frame %d of %s (prefetch: %d)",
+                                index, file, prefetchExecutor != nullptr);
+                REPORTER_ASSERT(r, player.getFrame() == frame);
+            }
+        }
+    }
+}
@@ -19,6 +19,7 @@
 #include "include/core/SkColorSpace.h"
 #include "include/core/SkData.h"
 #include "include/core/SkEncodedImageFormat.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkImage.h"
 #include "include/core/SkImageEncoder.h"
 #include "include/core/SkImageGenerator.h"
@@ -1921,3 +1922,120 @@ DEF_TEST(Codec_noConversion, r) {
         REPORTER_ASSERT(r, bm.getColor(0, 0) == rec.color);
     }
 }
+
+#if defined(SK_CODEC_DECODES_JPEG) && defined(SK_ENCODE_JPEG)
+// Large jpegs with restart markers are decoded in bands on SkCodec::Options::fExecutor. That must
+// give exactly the pixels decoding them top to bottom does.
+DEF_TEST(Codec_jpeg_restartIntervals, r) {
+    SkBitmap src;
+    src.allocN32Pixels(1500, 1001);
+    SkRandom random;
+    for (int y = 0; y < src.height(); y++) {
+        for (int x = 0; x < src.width(); x++) {
+            *src.getAddr32(x, y) = SkPreMultiplyARGB(0xFF, x * 255 / src.width(),
+                                                     y * 255 / src.height(), random.nextU() & 0xFF);
+        }
+    }
+
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(4);
+
+    auto decode = [](SkCodec* codec, const SkImageInfo& info, SkExecutor* executor, SkBitmap* bm) {
+        SkCodec::Options options;
+        options.fExecutor = executor;
+        bm->allocPixels(info);
+        return SkCodec::kSuccess == codec->getPixels(info, bm->getPixels(), bm->rowBytes(),
+                                                     &options);
+    };
+
+    for (auto downsample : { SkJpegEncoder::Downsample::k420, SkJpegEncoder::Downsample::k444 }) {
+        for (int restartInterval : { 1, 3, 5 }) {
+            SkJpegEncoder::Options options;
+            options.fDownsample = downsample;
+            options.fRestartInterval = restartInterval;
+            SkDynamicMemoryWStream stream;
+            REPORTER_ASSERT(r, SkJpegEncoder::Encode(&stream, src.pixmap(), options));
+
+            auto codec = SkCodec::MakeFromData(stream.detachAsData());
+            REPORTER_ASSERT(r, codec);
+            if (!codec) {
+                continue;
+            }
+
+            // No color xform, a color xform in place, and one from a row of storage.
+            auto rec2020 = SkColorSpace::MakeRGB(SkNamedTransferFn::kSRGB, SkNamedGamut::kRec2020);
+            for (SkImageInfo info : { codec->getInfo(),
+                                      codec->getInfo().makeColorType(kRGB_565_SkColorType),
+                                      codec->getInfo().makeColorSpace(rec2020),
+                                      codec->getInfo().makeColorType(kRGBA_F16_SkColorType) }) {
+                SkBitmap serial, parallel;
+                REPORTER_ASSERT(r, decode(codec.get(), info, nullptr, &serial));
+                REPORTER_ASSERT(r, decode(codec.get(), info, executor.get(), &parallel));
+                REPORTER_ASSERT(r, ToolUtils::equal_pixels(serial.pixmap(), parallel.pixmap()));
+            }
+        }
+    }
+}
+#endif
+
+// With Options::fExecutor, PNG and WebP color transform decoded rows on other threads while the
+// calling thread decodes the rest. That must give exactly the pixels a serial decode does.
+DEF_TEST(Codec_pipelinedRows, r) {
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(3);
+
+    auto decode = [](sk_sp<SkData> data, const SkImageInfo& info, SkExecutor* executor,
+                     bool incremental, SkBitmap* bm) {
+        auto codec = SkCodec::MakeFromData(std::move(data));
+        if (!codec) {
+            return SkCodec::kInvalidInput;
+        }
+        bm->allocPixels(info);
+        bm->eraseColor(SK_ColorTRANSPARENT);
+        SkCodec::Options options;
+        options.fExecutor = executor;
+        if (!incremental) {
+            return codec->getPixels(info, bm->getPixels(), bm->rowBytes(), &options);
+        }
+        auto result = codec->startIncrementalDecode(info, bm->getPixels(), bm->rowBytes(),
+                                                    &options);
+        return SkCodec::kSuccess == result ? codec->incrementalDecode() : result;
+    };
+
+    auto rec2020 = SkColorSpace::MakeRGB(SkNamedTransferFn::kSRGB, SkNamedGamut::kRec2020);
+    for (const char* path : { "images/mandrill_512.png",
+                              "images/plane_interlaced.png",
+                              "images/color_wheel_with_profile.png",
+                              "images/yellow_rose.webp",
+                              "images/webp-color-profile-lossless.webp",
+                              "images/webp-color-profile-lossy-alpha.webp" }) {
+        sk_sp<SkData> full = GetResourceAsData(path);
+        if (!full) {
+            continue;
+        }
+        auto codec = SkCodec::MakeFromData(full);
+        REPORTER_ASSERT(r, codec);
+        if (!codec) {
+            continue;
+        }
+        const bool isPng = SkEncodedImageFormat::kPNG == codec->getEncodedFormat();
+
+        // Whole and truncated images, transformed in place and from a row of storage.
+        for (sk_sp<SkData> data : { full, SkData::MakeSubset(full.get(), 0, full->size() * 3 / 5) }) {
+            for (SkImageInfo info : { codec->getInfo().makeColorSpace(rec2020),
+                                      codec->getInfo().makeColorType(kRGBA_F16_SkColorType)
+                                                      .makeColorSpace(rec2020) }) {
+                for (bool incremental : { false, true }) {
+                    if (incremental && !isPng) {
+                        continue;
+                    }
+                    SkBitmap serial, pipelined;
+                    auto serialResult = decode(data, info, nullptr, incremental, &serial);
+                    auto pipelinedResult = decode(data, info, executor.get(), incremental,
+                                                  &pipelined);
+                    REPORTER_ASSERT(r, serialResult == pipelinedResult, "%s", path);
+                    REPORTER_ASSERT(r, ToolUtils::equal_pixels(serial.pixmap(),
+                                                               pipelined.pixmap()), "%s", path);
+                }
+            }
+        }
+    }
+}
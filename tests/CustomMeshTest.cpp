@@ -5,8 +5,14 @@
  * found in the LICENSE file.
  */
 
+#include "include/core/SkBlender.h"
 #include "include/core/SkCanvas.h"
 #include "include/core/SkCustomMesh.h"
+#include "include/core/SkM44.h"
+#include "include/core/SkSurface.h"
+#include "include/core/SkVertices.h"
+#include "include/effects/SkGradientShader.h"
+#include "src/core/SkCanvasPriv.h"
 #include "tests/Test.h"
 
 using Attribute = SkCustomMeshSpecification::Attribute;
@@ -536,3 +542,144 @@ DEF_TEST(CustomMeshSpec, reporter) {
     test_empty_attribute_name(reporter);
     test_empty_varying_name(reporter);
 }
+
+// Draws a grid of triangles as a custom mesh and as SkVertices on raster surfaces, checking that
+// the two agree for per-vertex colors, local coordinates from the fragment program, and both.
+DEF_TEST(CustomMesh_RasterMatchesVertices, r) {
+    static constexpr int kSize = 64;
+    static constexpr int kGrid = 5;
+
+    struct Vertex {
+        SkPoint  pos;
+        SkPoint  uv;
+        uint32_t color;
+    };
+    std::vector<Vertex>   vertices;
+    std::vector<SkPoint>  positions, texs;
+    std::vector<SkColor>  colors;
+    std::vector<uint16_t> indices;
+    for (int y = 0; y < kGrid; ++y)
+    for (int x = 0; x < kGrid; ++x) {
+        SkPoint pos = {4 + x*14.f, 4 + y*14.f + (x & 1)*3};
+        SkColor color = SkColorSetARGB(0xFF, 60*x, 60*y, 255 - 50*(x + y)/2);
+        // The mesh takes bytes in RGBA order.
+        uint32_t rgba = SkColorGetR(color) <<  0 | SkColorGetG(color) <<  8 |
+                        SkColorGetB(color) << 16 | SkColorGetA(color) << 24;
+        vertices.push_back({pos, pos*0.5f, rgba});
+        positions.push_back(pos);
+        texs.push_back(pos*0.5f);
+        colors.push_back(color);
+        if (x > 0 && y > 0) {
+            uint16_t i = y*kGrid + x;
+            indices.insert(indices.end(), {(uint16_t)(i - kGrid - 1), (uint16_t)(i - kGrid),
+                                           (uint16_t)(i - 1),
+                                           (uint16_t)(i - kGrid),     i,
+                                           (uint16_t)(i - 1)});
+        }
+    }
+
+    static const Attribute kAttributes[]{
+            {Attribute::Type::kFloat2,       0, SkString{"pos"}  },
+            {Attribute::Type::kFloat2,       8, SkString{"uv"}   },
+            {Attribute::Type::kUByte4_unorm, 16, SkString{"color"}},
+    };
+    static const Varying kVaryings[]{
+            {Varying::Type::kHalf4,  SkString{"color"}},
+            {Varying::Type::kFloat2, SkString{"uv"}   },
+    };
+    static constexpr char kVS[] = R"(
+            float2 main(in Attributes a, out Varyings v) {
+                v.color = a.color;
+                v.uv    = a.uv;
+                return a.pos;
+            }
+    )";
+    static constexpr const char* kFSes[] = {
+            R"(void   main(in Varyings v, out half4 color) { color = v.color;              })",
+            R"(float2 main(in Varyings v)                  { return v.uv;                   })",
+            R"(float2 main(in Varyings v, out half4 color) { color = v.color; return v.uv; })",
+    };
+
+    SkPoint pts[] = {{0, 0}, {kSize/2, kSize/2}};
+    SkColor gradient[] = {SK_ColorRED, SK_ColorCYAN};
+    sk_sp<SkShader> shader = SkGradientShader::MakeLinear(pts, gradient, nullptr, 2,
+                                                          SkTileMode::kMirror);
+
+    SkM44 persp = SkM44::Perspective(0.1f, 10, SK_ScalarPI/2);
+
+    for (int fs = 0; fs < (int)SK_ARRAY_COUNT(kFSes); ++fs)
+    for (bool usePersp : {false, true}) {
+        auto [spec, error] = SkCustomMeshSpecification::Make(
+                SkMakeSpan(kAttributes, SK_ARRAY_COUNT(kAttributes)),
+                sizeof(Vertex),
+                SkMakeSpan(kVaryings, SK_ARRAY_COUNT(kVaryings)),
+                SkString(kVS),
+                SkString(kFSes[fs]));
+        REPORTER_ASSERT(r, spec, "%s", error.c_str());
+        if (!spec) {
+            continue;
+        }
+        const bool hasColors = fs != 1,
+                   hasCoords = fs != 0;
+
+        SkPaint paint;
+        paint.setColor(SK_ColorGREEN);
+        paint.setShader(hasCoords ? shader : nullptr);
+
+        auto setup = [&](SkCanvas* canvas) {
+            canvas->clear(SK_ColorWHITE);
+            if (usePersp) {
+                canvas->translate(kSize/2, kSize/2);
+                canvas->concat(SkM44::Scale(kSize/2, kSize/2) * persp *
+                               SkM44::Translate(0, 0, -1.2f) * SkM44::Rotate({1, 0, 0}, 0.3f) *
+                               SkM44::Scale(2.f/kSize, 2.f/kSize) *
+                               SkM44::Translate(-kSize/2, -kSize/2));
+            }
+        };
+
+        auto expected = SkSurface::MakeRasterN32Premul(kSize, kSize);
+        setup(expected->getCanvas());
+        expected->getCanvas()->drawVertices(
+                SkVertices::MakeCopy(SkVertices::kTriangles_VertexMode,
+                                     (int)positions.size(),
+                                     positions.data(),
+                                     hasCoords ? texs.data()   : nullptr,
+                                     hasColors ? colors.data() : nullptr,
+                                     (int)indices.size(),
+                                     indices.data()),
+                SkBlendMode::kModulate,
+                paint);
+
+        auto actual = SkSurface::MakeRasterN32Premul(kSize, kSize);
+        setup(actual->getCanvas());
+        SkCustomMesh cm;
+        cm.spec    = std::move(spec);
+        cm.mode    = SkCustomMesh::Mode::kTriangles;
+        cm.bounds  = SkRect::MakeWH(kSize, kSize);
+        cm.vb      = vertices.data();
+        cm.vcount  = (int)vertices.size();
+        cm.indices = indices.data();
+        cm.icount  = (int)indices.size();
+        SkCanvasPriv::DrawCustomMesh(actual->getCanvas(), std::move(cm),
+                                     SkBlender::Mode(SkBlendMode::kModulate), paint);
+
+        SkPixmap want, got;
+        SkAssertResult(expected->peekPixels(&want));
+        SkAssertResult(actual  ->peekPixels(&got));
+        REPORTER_ASSERT(r, got.getColor(kSize/2, kSize/2) != SK_ColorWHITE);
+        int mismatches = 0;
+        for (int y = 0; y < kSize; ++y)
+        for (int x = 0; x < kSize; ++x) {
+            SkColor w = want.getColor(x, y),
+                    g = got .getColor(x, y);
+            for (int shift : {0, 8, 16, 24}) {
+                if (abs((int)((w >> shift) & 0xFF) - (int)((g >> shift) & 0xFF)) > 2) {
+                    ++mismatches;
+                    break;
+                }
+            }
+        }
+        REPORTER_ASSERT(r, mismatches == 0, "fs %d, persp %d: %d mismatched pixels",
+                        fs, usePersp, mismatches);
+    }
+}
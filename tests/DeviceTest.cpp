@@ -6,6 +6,7 @@
  */
 
 #include "include/core/SkBitmap.h"
+#include "include/core/SkCanvas.h"
 #include "include/core/SkImage.h"
 #include "include/core/SkImageInfo.h"
 #include "include/core/SkRect.h"
@@ -13,6 +14,8 @@
 #include "include/core/SkTypes.h"
 #include "include/gpu/GrDirectContext.h"
 #include "include/gpu/GrTypes.h"
+#include "include/utils/SkRandom.h"
+#include "src/core/SkBitmapDevice.h"
 #include "src/core/SkDevice.h"
 #include "src/core/SkSpecialImage.h"
 #include "src/gpu/GrDirectContextPriv.h"
@@ -36,6 +39,38 @@ public:
     }
 };
 
+// Blit bounds keep every draw, including aliased points written straight into the pixels, from
+// touching anything outside of them.
+DEF_TEST(BitmapDevice_BlitBounds, reporter) {
+    SkBitmap bitmap;
+    bitmap.allocN32Pixels(64, 64);
+    bitmap.eraseColor(SK_ColorWHITE);
+    const SkIRect blitBounds = SkIRect::MakeLTRB(0, 16, 64, 40);
+
+    auto device = sk_make_sp<SkBitmapDevice>(bitmap);
+    device->setBlitBounds(blitBounds);
+    SkCanvas canvas(device);
+    SkRandom rand;
+    SkPoint pts[400];
+    for (SkPoint& pt : pts) {
+        pt = {rand.nextRangeF(0, 64), rand.nextRangeF(0, 64)};
+    }
+    canvas.drawPoints(SkCanvas::kPoints_PointMode, SK_ARRAY_COUNT(pts), pts,
+                      SkPaint(SkColors::kRed));
+    canvas.drawRect({8, 8, 56, 56}, SkPaint(SkColors::kBlue));
+
+    int inside = 0,
+        outside = 0;
+    for (int y = 0; y < 64; y++) {
+        for (int x = 0; x < 64; x++) {
+            bool drawn = bitmap.getColor(x, y) != SK_ColorWHITE;
+            (blitBounds.contains(x, y) ? inside : outside) += drawn;
+        }
+    }
+    REPORTER_ASSERT(reporter, inside > 0);
+    REPORTER_ASSERT(reporter, outside == 0, "%d pixels drawn outside", outside);
+}
+
 // TODO: re-enable this when Raster methods are implemented
 #if 0
 DEF_TEST(SpecialImage_BitmapDevice, reporter) {
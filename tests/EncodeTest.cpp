@@ -12,6 +12,7 @@
 #include "include/core/SkCanvas.h"
 #include "include/core/SkColorPriv.h"
 #include "include/core/SkEncodedImageFormat.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkImage.h"
 #include "include/core/SkStream.h"
 #include "include/core/SkSurface.h"
@@ -19,6 +20,7 @@
 #include "include/encode/SkPngEncoder.h"
 #include "include/encode/SkWebpEncoder.h"
 #include "include/private/SkImageInfoPriv.h"
+#include "include/utils/SkRandom.h"
 
 #include <png.h>
 
@@ -218,6 +220,48 @@ DEF_TEST(Encode_JpegDownsample, r) {
     REPORTER_ASSERT(r, almost_equals(bm1, bm2, 60));
 }
 
+DEF_TEST(Encode_JpegParallel, r) {
+    // Large enough to be split into strips, and not a whole number of MCUs in either direction.
+    SkBitmap bitmap;
+    bitmap.allocN32Pixels(1203, 1001);
+    SkRandom random;
+    for (int y = 0; y < bitmap.height(); y++) {
+        for (int x = 0; x < bitmap.width(); x++) {
+            *bitmap.getAddr32(x, y) = SkPackARGB32(0xFF, x * 0xFF / bitmap.width(),
+                                                   y * 0xFF / bitmap.height(),
+                                                   random.nextU() & 0x3F);
+        }
+    }
+
+    auto executor = SkExecutor::MakeFIFOThreadPool(4);
+    for (auto downsample : { SkJpegEncoder::Downsample::k420, SkJpegEncoder::Downsample::k444 }) {
+        // Restart markers between the strips only, or also every 3 rows of MCUs.
+        for (int restartInterval : { 0, 3 }) {
+            SkJpegEncoder::Options options;
+            options.fDownsample = downsample;
+            options.fRestartInterval = restartInterval;
+
+            SkDynamicMemoryWStream serial, parallel;
+            REPORTER_ASSERT(r, SkJpegEncoder::Encode(&serial, bitmap.pixmap(), options));
+            options.fExecutor = executor.get();
+            REPORTER_ASSERT(r, SkJpegEncoder::Encode(&parallel, bitmap.pixmap(), options));
+
+            // Only the Huffman tables differ, so the pixels must match exactly.
+            auto image0 = SkImage::MakeFromEncoded(serial.detachAsData());
+            auto image1 = SkImage::MakeFromEncoded(parallel.detachAsData());
+            if (!image0 || !image1) {
+                ERRORF(r, "Failed to decode jpeg (downsample %d, restart interval %d)",
+                       (int)downsample, restartInterval);
+                continue;
+            }
+            SkBitmap bm0, bm1;
+            image0->asLegacyBitmap(&bm0);
+            image1->asLegacyBitmap(&bm1);
+            REPORTER_ASSERT(r, almost_equals(bm0, bm1, 0));
+        }
+    }
+}
+
 static inline void pushComment(
         std::vector<std::string>& comments, const char* keyword, const char* text) {
     comments.push_back(keyword);
@@ -332,6 +376,100 @@ DEF_TEST(Encode_PngOptions, r) {
     REPORTER_ASSERT(r, almost_equals(bm0, bm2, 0));
 }
 
+DEF_TEST(Encode_PngFilters, r) {
+    // With fSelectFiltersWithSkia, Skia picks among several filters itself, with SIMD. Cover
+    // every pixel size, and widths that leave a partial vector at the end of each row.
+    const SkColorType colorTypes[] = {
+        kGray_8_SkColorType, kRGB_888x_SkColorType, kRGBA_8888_SkColorType,
+        kRGBA_1010102_SkColorType, kRGBA_F16_SkColorType,
+    };
+    for (SkColorType colorType : colorTypes) {
+        for (int width : { 1, 5, 16, 37 }) {
+            SkBitmap bitmap;
+            bitmap.allocPixels(SkImageInfo::Make(width, 23, colorType,
+                                                 SkColorTypeIsAlwaysOpaque(colorType)
+                                                         ? kOpaque_SkAlphaType
+                                                         : kUnpremul_SkAlphaType));
+            SkBitmap n32;
+            n32.allocPixels(bitmap.info().makeColorType(kN32_SkColorType));
+            // Gradients with some noise, so that every filter wins some rows.
+            SkRandom random;
+            for (int y = 0; y < n32.height(); y++) {
+                for (int x = 0; x < n32.width(); x++) {
+                    const U8CPU noise = random.nextULessThan(y % 4 ? 0x10 : 0x100);
+                    *n32.getAddr32(x, y) = SkPackARGB32NoCheck(0xFF - noise / 2,
+                                                               (11 * x + noise) & 0xFF,
+                                                               (13 * y + noise) & 0xFF, noise);
+                }
+            }
+            REPORTER_ASSERT(r, n32.readPixels(bitmap.pixmap()));
+
+            SkPngEncoder::Options options;
+            options.fFilterFlags = SkPngEncoder::FilterFlag::kNone;
+            SkDynamicMemoryWStream unfiltered;
+            REPORTER_ASSERT(r, SkPngEncoder::Encode(&unfiltered, bitmap.pixmap(), options));
+            SkBitmap expected;
+            SkImage::MakeFromEncoded(unfiltered.detachAsData())->asLegacyBitmap(&expected);
+
+            options.fSelectFiltersWithSkia = true;
+            using Flag = SkPngEncoder::FilterFlag;
+            for (auto filters : { Flag::kAll, Flag::kSub | Flag::kUp, Flag::kAvg | Flag::kPaeth,
+                                  Flag::kNone | Flag::kPaeth }) {
+                options.fFilterFlags = filters;
+                SkDynamicMemoryWStream dst;
+                REPORTER_ASSERT(r, SkPngEncoder::Encode(&dst, bitmap.pixmap(), options));
+                auto image = SkImage::MakeFromEncoded(dst.detachAsData());
+                if (!image) {
+                    ERRORF(r, "Failed to decode PNG (color type %d, width %d, filters %d)",
+                           colorType, width, (int)filters);
+                    continue;
+                }
+                SkBitmap actual;
+                image->asLegacyBitmap(&actual);
+                REPORTER_ASSERT(r, almost_equals(expected, actual, 0));
+            }
+        }
+    }
+}
+
+DEF_TEST(Encode_PngParallel, r) {
+    // Large enough to be split into strips.
+    SkBitmap bitmap;
+    bitmap.allocN32Pixels(1200, 1000);
+    for (int y = 0; y < bitmap.height(); y++) {
+        for (int x = 0; x < bitmap.width(); x++) {
+            *bitmap.getAddr32(x, y) = SkPreMultiplyARGB(0x80 + (x & 0x7F), x & 0xFF, y & 0xFF,
+                                                        (x ^ y) & 0xFF);
+        }
+    }
+
+    auto executor = SkExecutor::MakeFIFOThreadPool(4);
+    for (auto filters : { SkPngEncoder::FilterFlag::kAll, SkPngEncoder::FilterFlag::kNone,
+                          SkPngEncoder::FilterFlag::kPaeth }) {
+        for (int zlibLevel : { 0, 6 }) {
+            SkPngEncoder::Options options;
+            options.fFilterFlags = filters;
+            options.fZLibLevel = zlibLevel;
+
+            SkDynamicMemoryWStream serial, parallel;
+            REPORTER_ASSERT(r, SkPngEncoder::Encode(&serial, bitmap.pixmap(), options));
+            options.fExecutor = executor.get();
+            REPORTER_ASSERT(r, SkPngEncoder::Encode(&parallel, bitmap.pixmap(), options));
+
+            SkBitmap bm0, bm1;
+            auto image0 = SkImage::MakeFromEncoded(serial.detachAsData());
+            auto image1 = SkImage::MakeFromEncoded(parallel.detachAsData());
+            if (!image0 || !image1) {
+                ERRORF(r, "Failed to decode PNG (filters %d, level %d)", (int)filters, zlibLevel);
+                continue;
+            }
+            image0->asLegacyBitmap(&bm0);
+            image1->asLegacyBitmap(&bm1);
+            REPORTER_ASSERT(r, almost_equals(bm0, bm1, 0));
+        }
+    }
+}
+
 #ifndef SK_BUILD_FOR_GOOGLE3
 DEF_TEST(Encode_WebpQuality, r) {
     SkBitmap bm;
@@ -585,3 +585,47 @@ DEF_TEST(Gradient, reporter) {
     test_sweep_fuzzer(reporter);
     test_unsorted_degenerate(reporter);
 }
+
+// Drawing through a cached color table should match the exact gradient to within a
+// table entry, for both 8-bit and half-float destinations.
+DEF_TEST(Gradient_ColorLUT, r) {
+    constexpr int kStops = 64,
+                  kWidth = 256;
+
+    SkColor  colors[kStops];
+    SkScalar pos[kStops];
+    for (int i = 0; i < kStops; i++) {
+        colors[i] = SkColorSetARGB(255 - 2*i, 4*i, 255 - 4*i, 128);
+        pos[i] = i < kStops - 1 ? (i + 0.25f * (i & 1)) / (kStops - 1) : 1.0f;
+    }
+    const SkPoint pts[] = {{0, 0}, {kWidth, 0}};
+
+    for (SkColorType ct : {kN32_SkColorType, kRGBA_F16_SkColorType}) {
+        for (uint32_t flags : {0u, (uint32_t)SkGradientShader::kInterpolateColorsInPremul_Flag}) {
+            SkBitmap results[2];
+            for (int lut = 0; lut < 2; lut++) {
+                auto surface = SkSurface::MakeRaster(
+                        SkImageInfo::Make(kWidth, 1, ct, kPremul_SkAlphaType,
+                                          SkColorSpace::MakeSRGB()));
+                SkPaint paint;
+                paint.setShader(SkGradientShader::MakeLinear(
+                        pts, colors, pos, kStops, SkTileMode::kClamp,
+                        flags | (lut ? SkGradientShader::kCacheColorLUT_Flag : 0), nullptr));
+                surface->getCanvas()->drawPaint(paint);
+
+                results[lut].allocPixels(SkImageInfo::MakeN32Premul(kWidth, 1));
+                REPORTER_ASSERT(r, surface->readPixels(results[lut], 0, 0));
+            }
+
+            for (int x = 0; x < kWidth; x++) {
+                SkPMColor want = *results[0].getAddr32(x, 0),
+                          got  = *results[1].getAddr32(x, 0);
+                for (int shift = 0; shift < 32; shift += 8) {
+                    int diff = std::abs((int)((want >> shift) & 0xff) -
+                                        (int)((got  >> shift) & 0xff));
+                    REPORTER_ASSERT(r, diff <= 2, "x=%d want %08x got %08x", x, want, got);
+                }
+            }
+        }
+    }
+}
@@ -7,12 +7,19 @@
 
 #include "include/core/SkCanvas.h"
 #include "include/core/SkData.h"
-
+#include "include/core/SkExecutor.h"
 #include "include/core/SkGraphics.h"
 #include "include/core/SkImageGenerator.h"
+#include "include/core/SkPictureRecorder.h"
 #include "include/private/SkImageInfoPriv.h"
+#include "src/core/SkAutoMalloc.h"
+#include "src/core/SkTaskGroup.h"
 #include "tests/Test.h"
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+
 #if defined(SK_BUILD_FOR_MAC) || defined(SK_BUILD_FOR_IOS)
     #include "include/ports/SkImageGeneratorCG.h"
 #elif defined(SK_BUILD_FOR_WIN)
@@ -81,9 +88,6 @@ DEF_TEST(ImageGenerator, reporter) {
     }
 }
 
-#include "include/core/SkPictureRecorder.h"
-#include "src/core/SkAutoMalloc.h"
-
 static sk_sp<SkPicture> make_picture() {
     SkPictureRecorder recorder;
     recorder.beginRecording(100, 100)->drawColor(SK_ColorRED);
@@ -122,3 +126,67 @@ DEF_TEST(PictureImageGenerator, reporter) {
     }
 }
 
+// Counts its decodes, and doesn't finish one until every thread has asked for the pixels and had
+// a moment to start waiting for the generator, so the others ask while it is still decoding.
+class LatchedImageGenerator : public SkImageGenerator {
+public:
+    LatchedImageGenerator(std::atomic<int>* decodeCount, const std::atomic<int>* arrivals,
+                          int threads)
+            : SkImageGenerator(SkImageInfo::MakeN32Premul(64, 64))
+            , fDecodeCount(decodeCount)
+            , fArrivals(arrivals)
+            , fThreads(threads) {}
+
+protected:
+    bool onGetPixels(const SkImageInfo& info, void* pixels, size_t rowBytes,
+                     const Options&) override {
+        fDecodeCount->fetch_add(1);
+        while (fArrivals->load() < fThreads) {
+            std::this_thread::yield();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        SkPixmap(info, pixels, rowBytes).erase(SK_ColorBLUE);
+        return true;
+    }
+
+private:
+    std::atomic<int>*       fDecodeCount;
+    const std::atomic<int>* fArrivals;
+    const int               fThreads;
+};
+
+// Threads that want a lazy image's pixels at the same time should share one decode.
+DEF_TEST(ImageGenerator_CoalescedDecodes, reporter) {
+    // Every thread must be able to ask at once, so there is one task per thread in the pool.
+    constexpr int kThreads = 4;
+    std::atomic<int> decodeCount{0},
+                     arrivals{0};
+    sk_sp<SkImage> image = SkImage::MakeFromGenerator(
+            std::make_unique<LatchedImageGenerator>(&decodeCount, &arrivals, kThreads));
+    REPORTER_ASSERT(reporter, image && image->isLazyGenerated());
+
+    const int64_t lazyDecodes = SkGraphics::GetLazyImageDecodeCount(),
+                  coalesced   = SkGraphics::GetLazyImageDecodesCoalescedCount();
+
+    std::unique_ptr<SkExecutor> threadPool = SkExecutor::MakeFIFOThreadPool(kThreads);
+    SkTaskGroup taskGroup(*threadPool);
+    std::atomic<int> failures{0};
+    taskGroup.batch(kThreads, [&](int) {
+        SkBitmap bm;
+        bm.allocPixels(image->imageInfo());
+        arrivals.fetch_add(1);
+        if (!image->readPixels(nullptr, bm.pixmap(), 0, 0) ||
+            *bm.getAddr32(31, 31) != SkPreMultiplyColor(SK_ColorBLUE)) {
+            failures.fetch_add(1);
+        }
+    });
+    taskGroup.wait();
+
+    REPORTER_ASSERT(reporter, failures.load() == 0);
+    REPORTER_ASSERT(reporter, decodeCount.load() == 1, "%d decodes", decodeCount.load());
+    REPORTER_ASSERT(reporter, SkGraphics::GetLazyImageDecodeCount() > lazyDecodes);
+    // Every other thread found the pixels once it got the generator.
+    const int64_t coalescedNow = SkGraphics::GetLazyImageDecodesCoalescedCount();
+    REPORTER_ASSERT(reporter, coalescedNow - coalesced == kThreads - 1, "%d coalesced",
+                    (int)(coalescedNow - coalesced));
+}
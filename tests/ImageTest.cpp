@@ -1546,3 +1546,163 @@ DEF_TEST(image_subset_encode_skbug_7752, reporter) {
     check_roundtrip(image->makeSubset({W/2, H/2, W, H}));
     check_roundtrip(image->makeColorSpace(SkColorSpace::MakeSRGBLinear()));
 }
+
+#include "include/core/SkExecutor.h"
+#include "include/private/SkSemaphore.h"
+#include "src/core/SkMipmap.h"
+
+// prefetchRaster() should leave what a raster draw of the image needs in the caches.
+DEF_TEST(Image_PrefetchRaster, reporter) {
+    sk_sp<SkPicture> picture;
+    {
+        SkPictureRecorder recorder;
+        recorder.beginRecording(128, 128)->drawColor(SK_ColorGREEN);
+        picture = recorder.finishRecordingAsPicture();
+    }
+    sk_sp<SkImage> images[] = {
+        SkImage::MakeFromEncoded(GetResourceAsData("images/mandrill_128.png")),
+        SkImage::MakeFromPicture(picture, {128, 128}, nullptr, nullptr,
+                                 SkImage::BitDepth::kU8, SkColorSpace::MakeSRGB()),
+    };
+
+    struct Prefetch {
+        SkSemaphore done;
+        bool        success = false;
+    };
+    auto callback = [](SkImage::PrefetchContext context, bool success) {
+        auto prefetch = static_cast<Prefetch*>(context);
+        prefetch->success = success;
+        prefetch->done.signal();
+    };
+
+    std::unique_ptr<SkExecutor> threadPool = SkExecutor::MakeFIFOThreadPool(2);
+    for (const sk_sp<SkImage>& image : images) {
+        REPORTER_ASSERT(reporter, image && image->isLazyGenerated());
+        const auto desc = SkBitmapCacheDesc::Make(image.get());
+
+        // At full size only the decoded pixels are needed...
+        Prefetch prefetch;
+        image->prefetchRaster(*threadPool, SkSamplingOptions(SkFilterMode::kLinear),
+                              image->dimensions(), callback, &prefetch);
+        prefetch.done.wait();
+        REPORTER_ASSERT(reporter, prefetch.success);
+        SkBitmap cachedBitmap;
+        if (!SkBitmapCache::Find(desc, &cachedBitmap)) {
+            // The cache is global and other threads compete for its budget.
+            SkDebugf("Image_PrefetchRaster : cachedBitmap was already purged\n");
+        }
+        REPORTER_ASSERT(reporter, !SkMipmapCache::FindAndRef(desc));
+
+        // ...but a quarter size draw with mipmaps will sample a mipmap level.
+        image->prefetchRaster(*threadPool,
+                              SkSamplingOptions(SkFilterMode::kLinear, SkMipmapMode::kNearest),
+                              {32, 32}, callback, &prefetch);
+        prefetch.done.wait();
+        REPORTER_ASSERT(reporter, prefetch.success);
+        if (const SkMipmap* mips = SkMipmapCache::FindAndRef(desc)) {
+            mips->unref();
+        } else {
+            SkDebugf("Image_PrefetchRaster : mipmap was already purged\n");
+        }
+    }
+
+    // There's nothing to prefetch for an empty draw.
+    Prefetch prefetch;
+    images[0]->prefetchRaster(*threadPool, SkSamplingOptions(), {0, 0}, callback, &prefetch);
+    REPORTER_ASSERT(reporter, prefetch.done.try_wait());
+    REPORTER_ASSERT(reporter, !prefetch.success);
+}
+
+// A JPEG drawn much smaller than it is should be decoded at a smaller size, and cached at it.
+DEF_TEST(Image_ScaledLazyDecode, reporter) {
+    auto draw = [](sk_sp<SkImage> image, int size, const SkSamplingOptions& sampling) {
+        auto surface = SkSurface::MakeRasterN32Premul(size, size);
+        surface->getCanvas()->drawImageRect(image, SkRect::MakeIWH(size, size), sampling);
+        return surface->makeImageSnapshot();
+    };
+    auto cached = [](const sk_sp<SkImage>& image, SkISize scaledDimensions) {
+        SkBitmap bitmap;
+        return SkBitmapCache::Find(scaledDimensions.isEmpty()
+                                           ? SkBitmapCacheDesc::Make(image.get())
+                                           : SkBitmapCacheDesc::MakeScaled(image.get(),
+                                                                           scaledDimensions),
+                                   &bitmap);
+    };
+    auto total_diff = [](const sk_sp<SkImage>& imageA, const sk_sp<SkImage>& imageB) {
+        SkPixmap a, b;
+        SkAssertResult(imageA->peekPixels(&a) && imageB->peekPixels(&b));
+        int totalDiff = 0;
+        for (int y = 0; y < a.height(); ++y) {
+            for (int x = 0; x < a.width(); ++x) {
+                SkColor ca = a.getColor(x, y), cb = b.getColor(x, y);
+                totalDiff += std::abs((int)SkColorGetR(ca) - (int)SkColorGetR(cb)) +
+                             std::abs((int)SkColorGetG(ca) - (int)SkColorGetG(cb)) +
+                             std::abs((int)SkColorGetB(ca) - (int)SkColorGetB(cb));
+            }
+        }
+        return totalDiff;
+    };
+
+    sk_sp<SkData> data = GetResourceAsData("images/mandrill_512_q075.jpg");
+    if (!data) {
+        return;
+    }
+    const SkSamplingOptions linear(SkFilterMode::kLinear),
+                            mipmapped(SkFilterMode::kLinear, SkMipmapMode::kLinear);
+
+    // At 1/4 size, the 1/4 scale decode is all the draw needs, with or without mipmaps.
+    for (const SkSamplingOptions& sampling : {linear, mipmapped}) {
+        sk_sp<SkImage> image = SkImage::MakeFromEncoded(data);
+        sk_sp<SkImage> scaledDraw = draw(image, 128, sampling);
+        REPORTER_ASSERT(reporter, !cached(image, {}));
+        if (!cached(image, {128, 128})) {
+            // The cache is global and other threads compete for its budget.
+            SkDebugf("Image_ScaledLazyDecode : scaled decode was already purged\n");
+        }
+
+        // It should look about like drawing from the full size decode.
+        sk_sp<SkImage> fullDraw = draw(SkImage::MakeFromEncoded(data)->makeRasterImage(), 128,
+                                       sampling);
+        int totalDiff = total_diff(scaledDraw, fullDraw);
+        // Unscaled linear sampling aliases, so allow an average difference of 16 per channel.
+        REPORTER_ASSERT(reporter, totalDiff <= 128 * 128 * 3 * 16, "%d", totalDiff);
+    }
+
+    // At 1/32 size, even the smallest (1/8) decode needs mipmaps. They are built from it rather
+    // than from a full size decode, whether the image is drawn directly or by its shader.
+    sk_sp<SkImage> fullDraw = draw(SkImage::MakeFromEncoded(data)->makeRasterImage(), 16,
+                                   mipmapped);
+    for (bool shader : {false, true}) {
+        sk_sp<SkImage> image = SkImage::MakeFromEncoded(data);
+        sk_sp<SkImage> scaledDraw;
+        if (shader) {
+            auto surface = SkSurface::MakeRasterN32Premul(16, 16);
+            SkPaint paint;
+            const SkMatrix localMatrix = SkMatrix::Scale(1/32.0f, 1/32.0f);
+            paint.setShader(image->makeShader(SkTileMode::kClamp, SkTileMode::kClamp, mipmapped,
+                                              &localMatrix));
+            surface->getCanvas()->drawPaint(paint);
+            scaledDraw = surface->makeImageSnapshot();
+        } else {
+            scaledDraw = draw(image, 16, mipmapped);
+        }
+        REPORTER_ASSERT(reporter, !cached(image, {}));
+        int totalDiff = total_diff(scaledDraw, fullDraw);
+        REPORTER_ASSERT(reporter, totalDiff <= 16 * 16 * 3 * 16, "%d", totalDiff);
+    }
+    // Without mipmaps, the 1/8 decode is still better than sampling the full size.
+    {
+        sk_sp<SkImage> image = SkImage::MakeFromEncoded(data);
+        draw(image, 16, linear);
+        REPORTER_ASSERT(reporter, !cached(image, {}));
+    }
+
+    // Once the full size is decoded, smaller draws scale that down rather than decode again.
+    {
+        sk_sp<SkImage> image = SkImage::MakeFromEncoded(data);
+        SkBitmap full;
+        REPORTER_ASSERT(reporter, as_IB(image)->getROPixels(nullptr, &full));
+        draw(image, 128, linear);
+        REPORTER_ASSERT(reporter, !cached(image, {128, 128}));
+    }
+}
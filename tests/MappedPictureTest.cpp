@@ -0,0 +1,206 @@
+/*
+ * Copyright 2022 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "include/core/SkBitmap.h"
+#include "include/core/SkCanvas.h"
+#include "include/core/SkData.h"
+#include "include/core/SkImage.h"
+#include "include/core/SkPaint.h"
+#include "include/core/SkPath.h"
+#include "include/core/SkPicture.h"
+#include "include/core/SkPictureRecorder.h"
+#include "include/private/SkTo.h"
+#include "include/utils/SkRandom.h"
+#include "src/core/SkMappedPicture.h"
+#include "src/core/SkRTree.h"
+#include "tests/Test.h"
+#include "tools/Resources.h"
+
+#include <cstring>
+#include <vector>
+
+static sk_sp<SkPicture> make_picture(const sk_sp<SkImage>& image) {
+    const SkRect bounds = SkRect::MakeWH(256, 256);
+
+    SkPictureRecorder nestedRecorder;
+    SkCanvas* nested = nestedRecorder.beginRecording(SkRect::MakeWH(64, 64));
+    nested->drawImageRect(image, SkRect::MakeWH(64, 64), SkSamplingOptions());
+    nested->drawCircle(32, 32, 16, SkPaint());
+    sk_sp<SkPicture> nestedPicture = nestedRecorder.finishRecordingAsPicture();
+
+    SkPictureRecorder recorder;
+    SkCanvas* canvas = recorder.beginRecording(bounds);
+    SkRandom rand;
+    SkPaint paint;
+    for (int y = 0; y < 256; y += 16) {
+        for (int x = 0; x < 256; x += 16) {
+            paint.setColor(rand.nextU() | 0xFF000000);
+            canvas->drawRect(SkRect::MakeXYWH(x, y, 12, 12), paint);
+        }
+    }
+
+    canvas->save();
+    canvas->clipRect(SkRect::MakeLTRB(20, 20, 120, 100));
+    canvas->rotate(15);
+    SkPath path;
+    path.moveTo(10, 10).lineTo(200, 40).quadTo(100, 150, 30, 90).close();
+    paint.setColor(SK_ColorBLUE);
+    canvas->drawPath(path, paint);
+    canvas->restore();
+
+    // The same image twice, which should only be stored once.
+    canvas->drawImage(image, 140, 10);
+    canvas->drawImageRect(image, SkRect::MakeXYWH(10, 150, 60, 90), SkSamplingOptions());
+
+    paint.setAlpha(0x80);
+    canvas->saveLayer(SkRect::MakeLTRB(100, 100, 220, 220), &paint);
+    canvas->drawPicture(nestedPicture);
+    canvas->translate(120, 120);
+    canvas->drawPicture(nestedPicture);
+    canvas->restore();
+
+    // A block that changes the clip nested in one that changes the matrix.  Playback clipped to
+    // miss the inner block must skip its save and restore together, or the outer restore would
+    // pop the wrong save and leave the translate on the last draw.
+    canvas->save();
+    canvas->translate(8, 8);
+    canvas->save();
+    canvas->clipRect(SkRect::MakeLTRB(200, 200, 240, 240));
+    paint.setColor(SK_ColorGREEN);
+    canvas->drawRect(SkRect::MakeLTRB(190, 190, 250, 250), paint);
+    canvas->restore();
+    canvas->drawRect(SkRect::MakeXYWH(20, 184, 30, 30), paint);
+    canvas->restore();
+    canvas->drawRect(SkRect::MakeXYWH(20, 184, 30, 30), paint);
+
+    return recorder.finishRecordingAsPicture();
+}
+
+static SkBitmap draw(const SkPicture* picture, const SkRect& clip) {
+    SkBitmap bm;
+    bm.allocN32Pixels(256, 256);
+    bm.eraseColor(SK_ColorWHITE);
+    SkCanvas canvas(bm);
+    canvas.clipRect(clip);
+    picture->playback(&canvas);
+    return bm;
+}
+
+static bool equal_pixels(const SkBitmap& a, const SkBitmap& b) {
+    for (int y = 0; y < a.height(); y++) {
+        if (0 != memcmp(a.getAddr32(0, y), b.getAddr32(0, y), a.width() * sizeof(uint32_t))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+DEF_TEST(MappedPicture_RoundTrip, r) {
+    sk_sp<SkImage> image = GetResourceAsImage("images/mandrill_128.png");
+    if (!image) {
+        return;
+    }
+    sk_sp<SkPicture> picture = make_picture(image);
+
+    sk_sp<SkData> data = SkMappedPicture::Serialize(picture.get());
+    REPORTER_ASSERT(r, data);
+    REPORTER_ASSERT(r, SkMappedPicture::IsMappedPicture(data->data(), data->size()));
+
+    // SkPicture::MakeFromData() recognizes the format too.
+    sk_sp<SkPicture> mapped = SkPicture::MakeFromData(data.get());
+    REPORTER_ASSERT(r, mapped);
+    if (!mapped) {
+        return;
+    }
+    REPORTER_ASSERT(r, mapped->cullRect() == picture->cullRect());
+    REPORTER_ASSERT(r, mapped->approximateOpCount(true) == picture->approximateOpCount(true));
+
+    // Clips that do and don't cover the whole picture, so playback both does and doesn't search
+    // the R-tree for the ops to draw.
+    const SkRect clips[] = {
+        SkRect::MakeWH(256, 256),
+        SkRect::MakeLTRB(10, 10, 50, 50),
+        SkRect::MakeLTRB(100, 30, 200, 120),
+        SkRect::MakeLTRB(0, 200, 256, 256),
+        SkRect::MakeLTRB(130, 130, 140, 140),
+        SkRect::MakeLTRB(0, 170, 100, 256),
+    };
+    for (const SkRect& clip : clips) {
+        REPORTER_ASSERT(r, equal_pixels(draw(picture.get(), clip), draw(mapped.get(), clip)),
+                        "clip %g %g %g %g", clip.fLeft, clip.fTop, clip.fRight, clip.fBottom);
+    }
+
+    // Unaligned data is copied, and plays back the same.
+    sk_sp<SkData> unaligned = SkData::MakeUninitialized(data->size() + 4);
+    memcpy((char*)unaligned->writable_data() + 4, data->data(), data->size());
+    mapped = SkMappedPicture::Make(SkData::MakeSubset(unaligned.get(), 4, data->size()));
+    REPORTER_ASSERT(r, mapped);
+    if (mapped) {
+        REPORTER_ASSERT(r, equal_pixels(draw(picture.get(), clips[2]),
+                                        draw(mapped.get(), clips[2])));
+    }
+
+    // And a regular serialized picture still works.
+    sk_sp<SkPicture> copy = SkPicture::MakeFromData(mapped->serialize().get());
+    REPORTER_ASSERT(r, copy);
+    if (copy) {
+        REPORTER_ASSERT(r, equal_pixels(draw(picture.get(), clips[0]),
+                                        draw(copy.get(), clips[0])));
+    }
+}
+
+DEF_TEST(MappedPicture_Invalid, r) {
+    sk_sp<SkImage> image = GetResourceAsImage("images/mandrill_128.png");
+    if (!image) {
+        return;
+    }
+    sk_sp<SkData> data = SkMappedPicture::Serialize(make_picture(image).get());
+    REPORTER_ASSERT(r, data);
+
+    // Each section ends before the next starts, so a truncated picture can't be valid.
+    for (size_t size = 0; size < data->size(); size += 7) {
+        REPORTER_ASSERT(r, !SkMappedPicture::Make(SkData::MakeWithCopy(data->data(), size)));
+    }
+
+    // Corrupt data may or may not load, but must not crash when drawn.
+    SkRandom rand;
+    for (int i = 0; i < 100; i++) {
+        sk_sp<SkData> corrupt = SkData::MakeWithCopy(data->data(), data->size());
+        auto bytes = static_cast<uint8_t*>(corrupt->writable_data());
+        for (int j = 0; j < 4; j++) {
+            bytes[rand.nextULessThan(SkToU32(corrupt->size()))] ^= 1 << rand.nextULessThan(8);
+        }
+        if (sk_sp<SkPicture> picture = SkMappedPicture::Make(corrupt)) {
+            draw(picture.get(), SkRect::MakeLTRB(30, 30, 90, 200));
+        }
+    }
+
+    // An R-tree whose branches share nodes has levels that all check out, but searching it
+    // would visit the shared nodes exponentially many times, so it must be rejected.
+    static constexpr int kNodes = 33;
+    std::vector<SkRTree::FlatNode> nodes(kNodes);
+    for (int i = 0; i < kNodes; i++) {
+        nodes[i].fNumChildren = SkRTree::kMaxChildren;
+        nodes[i].fLevel = SkToU16(i);
+        for (SkRTree::FlatBranch& child : nodes[i].fChildren) {
+            child = {SkToU32(i > 0 ? i - 1 : 0), SkRect::MakeWH(256, 256)};
+        }
+    }
+    const SkRTree::FlatBranch root = {kNodes - 1, SkRect::MakeWH(256, 256)};
+    REPORTER_ASSERT(r, !SkRTree::ValidateFlat(nodes.data(), kNodes, root, /*opCount=*/1));
+
+    // As is one with a node that the search never reaches.
+    SkRTree rtree;
+    const SkRect bounds[] = {SkRect::MakeWH(10, 10), SkRect::MakeXYWH(20, 20, 10, 10)};
+    rtree.insert(bounds, SK_ARRAY_COUNT(bounds));
+    nodes.resize(rtree.flatNodeCount() + 1);
+    const SkRTree::FlatBranch rtreeRoot = rtree.flatten(nodes.data());
+    REPORTER_ASSERT(r, SkRTree::ValidateFlat(nodes.data(), rtree.flatNodeCount(), rtreeRoot, 2));
+    nodes.back() = nodes[rtreeRoot.fIndex];
+    REPORTER_ASSERT(r, !SkRTree::ValidateFlat(nodes.data(), rtree.flatNodeCount() + 1,
+                                              rtreeRoot, 2));
+}
@@ -6,11 +6,16 @@
  */
 
 #include "include/core/SkBitmap.h"
+#include "include/core/SkExecutor.h"
+#include "include/core/SkPixelRef.h"
 #include "include/utils/SkRandom.h"
 #include "src/core/SkMipmap.h"
 #include "tests/Test.h"
 #include "tools/Resources.h"
 
+#include <deque>
+#include <functional>
+
 static void make_bitmap(SkBitmap* bm, int width, int height) {
     bm->allocN32Pixels(width, height);
     bm->eraseColor(SK_ColorWHITE);
@@ -211,6 +216,105 @@ DEF_TEST(MipMap_F16, reporter) {
     sk_sp<SkMipmap> mipmap(SkMipmap::Build(bmp, nullptr));
 }
 
+// Levels computed on demand, in any order, must match the ones Build() computes up front. They
+// must not depend on the base pixels once the mipmap has been built, nor keep them alive.
+DEF_TEST(MipMap_Lazy, reporter) {
+    SkRandom rand;
+    // The last size is large enough that the first level is downsampled in bands.
+    for (SkISize size : {SkISize{37, 21}, SkISize{64, 64}, SkISize{1027, 600}}) {
+        SkBitmap noise;
+        noise.allocN32Pixels(size.width(), size.height());
+        for (int y = 0; y < noise.height(); ++y) {
+            for (int x = 0; x < noise.width(); ++x) {
+                *noise.getAddr32(x, y) = SkPreMultiplyColor(rand.nextU());
+            }
+        }
+
+        for (SkColorType ct : {kN32_SkColorType, kRGBA_F16_SkColorType}) {
+            SkBitmap bm;
+            bm.allocPixels(noise.info().makeColorType(ct));
+            REPORTER_ASSERT(reporter, noise.readPixels(bm.pixmap()));
+
+            sk_sp<SkMipmap> eager(SkMipmap::Build(bm, nullptr));
+            sk_sp<SkMipmap> lazy(SkMipmap::BuildLazily(bm.pixmap(), nullptr));
+            REPORTER_ASSERT(reporter, eager && lazy);
+            REPORTER_ASSERT(reporter, eager->countLevels() == lazy->countLevels());
+            REPORTER_ASSERT(reporter, bm.pixelRef()->unique());
+            bm.eraseColor(SK_ColorTRANSPARENT);
+
+            // Ask for a level in the middle first, then the rest, last to first.
+            int count = lazy->countLevels();
+            SkMipmap::Level level;
+            REPORTER_ASSERT(reporter, lazy->getLevel(count / 2, &level));
+            for (int i = count - 1; i >= 0; --i) {
+                SkMipmap::Level expected, actual;
+                REPORTER_ASSERT(reporter, eager->getLevel(i, &expected));
+                REPORTER_ASSERT(reporter, lazy->getLevel(i, &actual));
+                const SkPixmap& e = expected.fPixmap;
+                const SkPixmap& a = actual.fPixmap;
+                REPORTER_ASSERT(reporter, e.info() == a.info());
+                for (int y = 0; y < e.height(); ++y) {
+                    REPORTER_ASSERT(reporter, !memcmp(e.addr(0, y), a.addr(0, y),
+                                                      e.info().minRowBytes()));
+                }
+            }
+        }
+    }
+}
+
+namespace {
+// Runs work only when borrowed, oldest first, as another thread's work might get run by an
+// SkTaskGroup waiting on a real pool.
+class QueueExecutor final : public SkExecutor {
+public:
+    void add(std::function<void(void)> work) override { fWork.push_back(std::move(work)); }
+    void borrow() override {
+        if (!fWork.empty()) {
+            std::function<void(void)> work = std::move(fWork.front());
+            fWork.pop_front();
+            work();
+        }
+    }
+
+private:
+    std::deque<std::function<void(void)>> fWork;
+};
+}  // namespace
+
+DEF_TEST(MipMap_LazyReentrant, reporter) {
+    // Large enough that the second level is downsampled in bands.
+    SkBitmap bm;
+    make_bitmap(&bm, 1024, 1024);
+    sk_sp<SkMipmap> lazy(SkMipmap::BuildLazily(bm.pixmap(), nullptr));
+    REPORTER_ASSERT(reporter, lazy);
+    if (!lazy) {
+        return;
+    }
+    const int count = lazy->countLevels();
+
+    QueueExecutor executor;
+    SkExecutor* defaultExecutor = &SkExecutor::GetDefault();
+    SkExecutor::SetDefault(&executor);
+
+    // While computing the second level waits for its bands, it runs this work first, which needs
+    // the same mipmap's levels. That must not deadlock.
+    bool reentered = false;
+    executor.add([&] {
+        SkMipmap::Level level;
+        reentered = lazy->getLevel(count - 1, &level);
+    });
+    SkMipmap::Level level;
+    REPORTER_ASSERT(reporter, lazy->getLevel(1, &level));
+    REPORTER_ASSERT(reporter, reentered);
+
+    SkExecutor::SetDefault(defaultExecutor);
+
+    for (int i = 0; i < count; ++i) {
+        REPORTER_ASSERT(reporter, lazy->getLevel(i, &level));
+        REPORTER_ASSERT(reporter, *level.fPixmap.addr32(0, 0) == SK_ColorWHITE);
+    }
+}
+
 #include "include/core/SkCanvas.h"
 #include "include/core/SkSurface.h"
 #include "src/core/SkMipmapBuilder.h"
@@ -0,0 +1,185 @@
+/*
+ * Copyright 2022 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "include/core/SkBitmap.h"
+#include "include/core/SkCanvas.h"
+#include "include/core/SkPaint.h"
+#include "include/core/SkPicture.h"
+#include "include/core/SkPictureRecorder.h"
+#include "include/core/SkRRect.h"
+#include "include/core/SkSurface.h"
+#include "include/effects/SkImageFilters.h"
+#include "include/utils/SkPictureDiff.h"
+#include "include/utils/SkRandom.h"
+#include "tests/Test.h"
+
+#include <vector>
+
+namespace {
+
+// A screen of cards, each with a few things drawn on it, that tests animate between frames.
+struct Card {
+    SkRect  rect;
+    SkColor color;
+    int     layer;  // 0: none, 1: alpha, 2: blur
+    bool    nested;
+};
+
+sk_sp<SkPicture> record(const std::vector<Card>& cards, const sk_sp<SkImage>& image) {
+    SkPictureRecorder recorder;
+    SkCanvas* canvas = recorder.beginRecording(SkRect::MakeWH(200, 200));
+    canvas->drawColor(SK_ColorWHITE);
+    for (const Card& card : cards) {
+        SkAutoCanvasRestore acr(canvas, true);
+        SkPaint layerPaint;
+        if (card.layer == 1) {
+            layerPaint.setAlphaf(0.5f);
+            canvas->saveLayer(card.rect, &layerPaint);
+        } else if (card.layer == 2) {
+            layerPaint.setImageFilter(SkImageFilters::Blur(3, 3, nullptr));
+            canvas->saveLayer(nullptr, &layerPaint);
+        }
+        canvas->clipRect(card.rect.makeOutset(4, 4));
+
+        SkPaint paint;
+        paint.setAntiAlias(true);
+        paint.setColor(card.color);
+        canvas->drawRRect(SkRRect::MakeRectXY(card.rect, 4, 4), paint);
+
+        SkPictureRecorder nestedRecorder;
+        SkCanvas* nested = card.nested ? nestedRecorder.beginRecording(card.rect) : canvas;
+        nested->drawImageRect(image, SkRect::MakeXYWH(card.rect.x() + 2, card.rect.y() + 2, 8, 8),
+                              SkSamplingOptions());
+        paint.setColor(SK_ColorBLACK);
+        paint.setStyle(SkPaint::kStroke_Style);
+        nested->drawLine(card.rect.x() + 12, card.rect.centerY(),
+                         card.rect.right() - 2, card.rect.centerY(), paint);
+        if (card.nested) {
+            canvas->drawPicture(nestedRecorder.finishRecordingAsPicture());
+        }
+    }
+    return recorder.finishRecordingAsPicture();
+}
+
+SkBitmap draw(const SkPicture* picture, const SkMatrix& matrix) {
+    SkBitmap bm;
+    bm.allocN32Pixels(160, 120);
+    bm.eraseColor(SK_ColorWHITE);
+    SkCanvas canvas(bm);
+    canvas.concat(matrix);
+    canvas.drawPicture(picture);
+    return bm;
+}
+
+// Checks that every pixel that changes is damaged.
+void check(skiatest::Reporter* r, const SkPicture* before, const SkPicture* after,
+           const SkMatrix& matrix) {
+    const SkRegion damage = SkPictureDiff::Damage(before, after, SkIRect::MakeWH(160, 120), matrix);
+    REPORTER_ASSERT(r, damage.isEmpty() ||
+                       SkIRect::MakeWH(160, 120).contains(damage.getBounds()));
+
+    SkBitmap a = draw(before, matrix),
+             b = draw(after,  matrix);
+    int missed = 0;
+    for (int y = 0; y < 120; y++) {
+        for (int x = 0; x < 160; x++) {
+            missed += *a.getAddr32(x, y) != *b.getAddr32(x, y) && !damage.contains(x, y);
+        }
+    }
+    REPORTER_ASSERT(r, missed == 0, "%d changed pixels not damaged", missed);
+}
+
+}  // namespace
+
+DEF_TEST(PictureDiff_Damage, r) {
+    sk_sp<SkSurface> surface = SkSurface::MakeRasterN32Premul(8, 8);
+    surface->getCanvas()->clear(SK_ColorBLUE);
+    sk_sp<SkImage> image = surface->makeImageSnapshot();
+
+    std::vector<Card> cards;
+    for (int i = 0; i < 10; i++) {
+        cards.push_back({SkRect::MakeXYWH(10, 10 + 18 * i, 120, 14), SK_ColorLTGRAY, 0, false});
+    }
+    sk_sp<SkPicture> before = record(cards, image);
+
+    // Recording the same thing again damages nothing, and neither does drawing a picture nested
+    // instead of inline.
+    REPORTER_ASSERT(r, SkPictureDiff::Damage(before.get(), record(cards, image).get(),
+                                             SkIRect::MakeWH(160, 120)).isEmpty());
+    std::vector<Card> nested = cards;
+    nested[3].nested = true;
+    REPORTER_ASSERT(r, SkPictureDiff::Damage(before.get(), record(nested, image).get(),
+                                             SkIRect::MakeWH(160, 120)).isEmpty());
+
+    // Changing one card damages only that card.
+    std::vector<Card> changed = cards;
+    changed[2].color = SK_ColorRED;
+    sk_sp<SkPicture> after = record(changed, image);
+    SkRegion damage = SkPictureDiff::Damage(before.get(), after.get(), SkIRect::MakeWH(160, 120));
+    REPORTER_ASSERT(r, !damage.isEmpty());
+    REPORTER_ASSERT(r, SkIRect::MakeLTRB(5, 41, 135, 65).contains(damage.getBounds()));
+
+    // And only the card's pixels when it's drawn in a layer that hasn't changed.
+    for (Card& card : cards) {
+        card.layer = 1;
+    }
+    changed = cards;
+    changed[2].color = SK_ColorRED;
+    damage = SkPictureDiff::Damage(record(cards, image).get(), record(changed, image).get(),
+                                   SkIRect::MakeWH(160, 120));
+    REPORTER_ASSERT(r, SkIRect::MakeLTRB(5, 41, 135, 65).contains(damage.getBounds()));
+
+    // Damage is in device space, and only within the device.
+    damage = SkPictureDiff::Damage(before.get(), after.get(), SkIRect::MakeLTRB(20, 20, 100, 100),
+                                   SkMatrix::Scale(2, 2));
+    REPORTER_ASSERT(r, !damage.isEmpty());
+    REPORTER_ASSERT(r, SkIRect::MakeLTRB(20, 89, 100, 100).contains(damage.getBounds()));
+
+    // No picture is like an empty one.
+    damage = SkPictureDiff::Damage(nullptr, before.get(), SkIRect::MakeWH(160, 120));
+    REPORTER_ASSERT(r, damage == SkRegion(SkIRect::MakeWH(160, 120)));
+}
+
+DEF_TEST(PictureDiff_Random, r) {
+    sk_sp<SkSurface> surface = SkSurface::MakeRasterN32Premul(8, 8);
+    surface->getCanvas()->clear(SK_ColorBLUE);
+    sk_sp<SkImage> image = surface->makeImageSnapshot();
+
+    const SkMatrix matrices[] = {
+        SkMatrix::I(),
+        SkMatrix::Translate(-20.5f, 10.25f),
+        SkMatrix::Scale(0.6f, 0.75f),
+        SkMatrix::RotateDeg(10, {80, 60}),
+    };
+
+    SkRandom rand;
+    for (int frame = 0; frame < 50; frame++) {
+        std::vector<Card> cards;
+        for (int i = 0; i < 12; i++) {
+            cards.push_back({SkRect::MakeXYWH(rand.nextRangeF(0, 150), rand.nextRangeF(0, 150),
+                                              rand.nextRangeF(10, 60), rand.nextRangeF(8, 30)),
+                             rand.nextU() | 0xFF000000, (int)rand.nextULessThan(3),
+                             rand.nextBool()});
+        }
+        std::vector<Card> next = cards;
+        for (int change = 0; change < 3; change++) {
+            const int i = rand.nextULessThan(SkToU32(next.size()));
+            switch (rand.nextULessThan(5)) {
+                case 0: next[i].color = rand.nextU() | 0xFF000000;        break;
+                case 1: next[i].rect.offset(rand.nextRangeF(-10, 10), 0); break;
+                case 2: next[i].layer = (next[i].layer + 1) % 3;          break;
+                case 3: next.erase(next.begin() + i);                     break;
+                case 4: next.insert(next.begin() + i, Card(next[i]));     break;
+            }
+        }
+        sk_sp<SkPicture> before = record(cards, image),
+                         after  = record(next,  image);
+        for (const SkMatrix& matrix : matrices) {
+            check(r, before.get(), after.get(), matrix);
+        }
+    }
+}
@@ -8,16 +8,23 @@
 #include "tests/RecordTestUtils.h"
 #include "tests/Test.h"
 
+#include "include/core/SkPictureRecorder.h"
 #include "include/core/SkSurface.h"
 #include "include/effects/SkImageFilters.h"
+#include "src/core/SkBigPicture.h"
+#include "src/core/SkCanvasPriv.h"
 #include "src/core/SkImagePriv.h"
+#include "src/core/SkPicturePriv.h"
 #include "src/core/SkRecord.h"
 #include "src/core/SkRecordDraw.h"
 #include "src/core/SkRecordOpts.h"
 #include "src/core/SkRecorder.h"
 #include "src/core/SkRecords.h"
+#include "src/utils/SkBitSet.h"
 #include "tools/debugger/DebugCanvas.h"
 
+#include <functional>
+
 static const int W = 1920, H = 1080;
 
 class JustOneDraw : public SkPicture::AbortCallback {
@@ -288,3 +295,202 @@ DEF_TEST(RecordDraw_drawImage, r){
 
     SkCanvasMock canvas(10, 10);
 }
+
+static int count_occluded(const SkRecord& record, int* first) {
+    SkAutoTMalloc<SkRect> bounds(record.count());
+    SkAutoTMalloc<SkBBoxHierarchy::Metadata> meta(record.count());
+    SkRecordFillBounds(SkRect::MakeWH(W, H), record, bounds, meta);
+
+    SkBitSet occluded(record.count());
+    const int count = SkRecordComputeOccluded(record, bounds, &occluded);
+    *first = occluded.findFirst() ? (int)*occluded.findFirst() : -1;
+    return count;
+}
+
+DEF_TEST(RecordDraw_Occluded, r) {
+    const SkRect cover = SkRect::MakeLTRB(10, 10, 100, 100);
+    SkPaint translucent;
+    translucent.setAlpha(0x80);
+    int first;
+
+    {
+        // Any draw, opaque or not, is hidden by a later opaque draw that covers it.
+        SkRecord record;
+        SkRecorder recorder(&record, W, H);
+        recorder.drawRect(SkRect::MakeLTRB(200, 200, 300, 300), SkPaint());
+        recorder.drawOval(SkRect::MakeLTRB(20, 20, 90, 90), translucent);
+        recorder.drawRect(cover, SkPaint());
+        REPORTER_ASSERT(r, 1 == count_occluded(record, &first));
+        REPORTER_ASSERT(r, 1 == first);
+    }
+    {
+        // The covering draw's edges may be anti-aliased, so it's inset by a unit.
+        SkRecord record;
+        SkRecorder recorder(&record, W, H);
+        recorder.drawRect(SkRect::MakeLTRB(10.5f, 20, 90, 90), SkPaint());
+        recorder.drawRect(cover, SkPaint());
+        REPORTER_ASSERT(r, 0 == count_occluded(record, &first));
+    }
+    {
+        // A translucent draw hides nothing.
+        SkRecord record;
+        SkRecorder recorder(&record, W, H);
+        recorder.drawRect(SkRect::MakeLTRB(20, 20, 90, 90), SkPaint());
+        recorder.drawRect(cover, translucent);
+        REPORTER_ASSERT(r, 0 == count_occluded(record, &first));
+    }
+    {
+        // Nor does a draw into a layer.
+        SkRecord record;
+        SkRecorder recorder(&record, W, H);
+        recorder.drawRect(SkRect::MakeLTRB(20, 20, 90, 90), SkPaint());
+        recorder.saveLayer(nullptr, nullptr);
+        recorder.drawRect(cover, SkPaint());
+        recorder.restore();
+        REPORTER_ASSERT(r, 0 == count_occluded(record, &first));
+    }
+    {
+        // A layer may read what's under it, so nothing after it hides draws before it.
+        SkRecord record;
+        SkRecorder recorder(&record, W, H);
+        recorder.drawRect(SkRect::MakeLTRB(20, 20, 90, 90), SkPaint());
+        recorder.saveLayer(nullptr, nullptr);
+        recorder.restore();
+        recorder.drawRect(cover, SkPaint());
+        REPORTER_ASSERT(r, 0 == count_occluded(record, &first));
+    }
+    {
+        // The same goes for SaveBehind.
+        SkRecord record;
+        SkRecorder recorder(&record, W, H);
+        recorder.drawRect(SkRect::MakeLTRB(20, 20, 90, 90), SkPaint());
+        SkCanvasPriv::SaveBehind(&recorder, nullptr);
+        recorder.restore();
+        recorder.drawRect(cover, SkPaint());
+        REPORTER_ASSERT(r, 0 == count_occluded(record, &first));
+    }
+    {
+        // A draw under a clip is hidden by one without a clip, or with the same clip...
+        SkRecord record;
+        SkRecorder recorder(&record, W, H);
+        recorder.save();
+        recorder.clipRect(SkRect::MakeLTRB(0, 0, 50, 50), true);
+        recorder.drawRect(SkRect::MakeLTRB(20, 20, 90, 90), SkPaint());
+        recorder.drawRect(cover, SkPaint());
+        recorder.restore();
+        recorder.drawRect(cover, SkPaint());
+        REPORTER_ASSERT(r, 1 == count_occluded(record, &first));
+        assert_type<SkRecords::DrawRect>(r, record, first);
+        REPORTER_ASSERT(r, 2 == first);
+    }
+    {
+        // ... but not by one with a different clip.
+        SkRecord record;
+        SkRecorder recorder(&record, W, H);
+        recorder.save();
+        recorder.clipRect(SkRect::MakeLTRB(0, 0, 50, 50));
+        recorder.drawRect(SkRect::MakeLTRB(20, 20, 90, 90), SkPaint());
+        recorder.restore();
+        recorder.save();
+        recorder.clipRect(SkRect::MakeLTRB(0, 0, 60, 60));
+        recorder.drawRect(cover, SkPaint());
+        recorder.restore();
+        REPORTER_ASSERT(r, 0 == count_occluded(record, &first));
+    }
+}
+
+// Records the same picture with and without kSkipOccludedDraws_RecordFlag, and checks that they
+// draw the same pixels under a few transforms and clips.
+static void check_occluded_playback(skiatest::Reporter* r,
+                                    const std::function<void(SkCanvas*)>& record,
+                                    bool expectOccluded) {
+    sk_sp<SkPicture> pictures[2];
+    for (bool skip : {false, true}) {
+        SkPictureRecorder recorder;
+        SkRTreeFactory factory;
+        record(recorder.beginRecording(SkRect::MakeWH(200, 200), &factory,
+                                       skip ? SkPictureRecorder::kSkipOccludedDraws_RecordFlag
+                                            : 0));
+        pictures[skip] = recorder.finishRecordingAsPicture();
+    }
+    const SkBigPicture* big = SkPicturePriv::AsSkBigPicture(pictures[1]);
+    REPORTER_ASSERT(r, big && expectOccluded == (big->occluded() != nullptr));
+    REPORTER_ASSERT(r, !SkPicturePriv::AsSkBigPicture(pictures[0])->occluded());
+
+    auto draw = [&](const SkPicture* picture, const SkMatrix& matrix, const SkRect& clip) {
+        SkBitmap bm;
+        bm.allocN32Pixels(300, 300);
+        bm.eraseColor(SK_ColorTRANSPARENT);
+        SkCanvas canvas(bm);
+        canvas.clipRect(clip);
+        canvas.concat(matrix);
+        picture->playback(&canvas);
+        return bm;
+    };
+
+    const SkMatrix matrices[] = {
+        SkMatrix::I(),
+        SkMatrix::Translate(0.25f, 0.75f),
+        SkMatrix::Scale(1.4f, 1.1f),
+        SkMatrix::Scale(0.6f, 0.6f),
+        SkMatrix::RotateDeg(3),
+    };
+    const SkRect clips[] = {
+        SkRect::MakeWH(300, 300),
+        SkRect::MakeLTRB(40, 50, 130, 140),
+    };
+    for (const SkMatrix& matrix : matrices) {
+        for (const SkRect& clip : clips) {
+            SkBitmap expected = draw(pictures[0].get(), matrix, clip);
+            SkBitmap actual   = draw(pictures[1].get(), matrix, clip);
+            for (int y = 0; y < expected.height(); y++) {
+                REPORTER_ASSERT(r, 0 == memcmp(expected.getAddr32(0, y), actual.getAddr32(0, y),
+                                               expected.rowBytes()));
+            }
+        }
+    }
+}
+
+DEF_TEST(RecordDraw_OccludedPlayback, r) {
+    // Cards stacked over a background, some partly hidden, some with clipped or rotated content.
+    check_occluded_playback(r, [](SkCanvas* canvas) {
+        SkPaint paint;
+        paint.setAntiAlias(true);
+        canvas->drawColor(SK_ColorWHITE);
+        for (int i = 0; i < 6; i++) {
+            const SkRect card = SkRect::MakeXYWH(10 + 7.25f * i, 15 + 9.5f * i, 120, 90);
+            canvas->save();
+            canvas->clipRect(card.makeInset(2, 2), i & 1);
+            paint.setColor(SK_ColorBLUE ^ (i * 0x1F3F5F));
+            canvas->drawRect(card, paint);
+            canvas->rotate(10 * i);
+            paint.setColor(SK_ColorRED);
+            canvas->drawCircle(card.centerX(), card.centerY(), 20, paint);
+            canvas->restore();
+            paint.setColor(SK_ColorGRAY ^ (i * 0x102030));
+            canvas->drawRect(card.makeOffset(0.5f, 0.5f), paint);
+        }
+    }, true);
+}
+
+DEF_TEST(RecordDraw_OccludedPlaybackBackdrop, r) {
+    // A backdrop blur reads the pixels around a sheet drawn over it after the layer, so the
+    // content under the sheet must still be drawn.
+    check_occluded_playback(r, [](SkCanvas* canvas) {
+        SkPaint paint;
+        canvas->drawColor(SK_ColorWHITE);
+        const SkRect sheet = SkRect::MakeLTRB(60, 60, 140, 140);
+        for (int i = 0; i < 4; i++) {
+            paint.setColor(SK_ColorRED ^ (i * 0x1F3F5F));
+            canvas->drawRect(SkRect::MakeXYWH(64 + 18 * i, 64, 10, 72), paint);
+        }
+        auto blur = SkImageFilters::Blur(8, 8, nullptr);
+        canvas->save();
+        canvas->clipRect(sheet.makeOutset(20, 20));
+        canvas->saveLayer(SkCanvas::SaveLayerRec(nullptr, nullptr, blur.get(), 0));
+        canvas->restore();
+        canvas->restore();
+        paint.setColor(SK_ColorBLUE);
+        canvas->drawRect(sheet, paint);
+    }, false);
+}
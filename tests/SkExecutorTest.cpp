@@ -0,0 +1,125 @@
+/*
+ * Copyright 2022 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "include/core/SkExecutor.h"
+#include "src/core/SkTaskGroup.h"
+#include "src/core/SkWorkStealingDeque.h"
+#include "tests/Test.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+DEF_TEST(SkWorkStealingDeque, r) {
+    int items[200];
+    SkWorkStealingDeque<int> deque(4);  // Small, so pushing 200 makes it grow a few times.
+
+    REPORTER_ASSERT(r, !deque.pop());
+    REPORTER_ASSERT(r, !deque.steal());
+
+    for (int& item : items) {
+        deque.push(&item);
+    }
+    // steal() takes the oldest, pop() the newest.
+    REPORTER_ASSERT(r, deque.steal() == &items[0]);
+    REPORTER_ASSERT(r, deque.steal() == &items[1]);
+    REPORTER_ASSERT(r, deque.pop()   == &items[199]);
+    REPORTER_ASSERT(r, deque.pop()   == &items[198]);
+
+    for (int i = 197; i >= 2; i--) {
+        REPORTER_ASSERT(r, deque.pop() == &items[i]);
+    }
+    REPORTER_ASSERT(r, deque.looksEmpty());
+    REPORTER_ASSERT(r, !deque.pop());
+    REPORTER_ASSERT(r, !deque.steal());
+}
+
+static void test_batch(skiatest::Reporter* r, SkExecutor& executor, int N) {
+    std::vector<std::atomic<int>> counts(N);
+    for (auto& count : counts) {
+        count.store(0);
+    }
+    SkTaskGroup(executor).batch(N, [&](int i) { counts[i]++; });
+
+    for (int i = 0; i < N; i++) {
+        if (counts[i].load() != 1) {
+            ERRORF(r, "batch(%d) ran index %d %d times", N, i, counts[i].load());
+            return;
+        }
+    }
+}
+
+DEF_TEST(SkExecutor_Batch, r) {
+    std::unique_ptr<SkExecutor> executors[] = {
+        SkExecutor::MakeFIFOThreadPool(4),
+        SkExecutor::MakeLIFOThreadPool(4),
+        SkExecutor::MakeWorkStealingPool(4),
+        SkExecutor::MakeWorkStealingPool(4, /*allowBorrowing=*/false),
+    };
+    for (auto& executor : executors) {
+        for (int N : {0, 1, 7, 256, 257, 1000, 100000}) {
+            test_batch(r, *executor, N);
+        }
+    }
+}
+
+DEF_TEST(SkExecutor_BatchInlineOrder, r) {
+    // An executor that runs work as soon as it's added should see batch() visit indices in
+    // order, just as N separate add()s would.
+    struct InlineExecutor final : public SkExecutor {
+        void add(std::function<void(void)> work) override { work(); }
+    } executor;
+
+    for (int N : {1, 7, 256, 257, 1000}) {
+        std::vector<int> order;
+        SkTaskGroup(executor).batch(N, [&](int i) { order.push_back(i); });
+
+        REPORTER_ASSERT(r, (int)order.size() == N);
+        for (int i = 0; i < (int)order.size(); i++) {
+            if (order[i] != i) {
+                ERRORF(r, "batch(%d) ran index %d at position %d", N, order[i], i);
+                break;
+            }
+        }
+    }
+}
+
+DEF_TEST(SkExecutor_WorkStealingDestroy, r) {
+    // Work still queued when the pool is destroyed must run, including the work it adds.
+    std::atomic<int> ran{0};
+    {
+        std::unique_ptr<SkExecutor> executor = SkExecutor::MakeWorkStealingPool(2);
+        SkExecutor* e = executor.get();
+        for (int i = 0; i < 100; i++) {
+            e->add([&ran, e] {
+                for (int j = 0; j < 10; j++) {
+                    e->add([&ran] { ran++; });
+                }
+                ran++;
+            });
+        }
+    }
+    REPORTER_ASSERT(r, ran.load() == 100 * 11, "%d", ran.load());
+}
+
+DEF_TEST(SkExecutor_WorkStealingNested, r) {
+    auto executor = SkExecutor::MakeWorkStealingPool(3);
+
+    // Task groups waited on from inside the pool's own threads must not deadlock,
+    // and work added from inside the pool must all run.
+    std::atomic<int> sum{0};
+    SkTaskGroup outer(*executor);
+    for (int i = 0; i < 16; i++) {
+        outer.add([&] {
+            SkTaskGroup inner(*executor);
+            inner.batch(100, [&](int j) { sum += j; });
+            inner.wait();
+        });
+    }
+    outer.wait();
+    REPORTER_ASSERT(r, sum.load() == 16 * (99 * 100 / 2));
+}
@@ -5,12 +5,20 @@
  * found in the LICENSE file.
  */
 
+#include "include/core/SkPaint.h"
+#include "include/effects/SkGradientShader.h"
 #include "include/private/SkHalf.h"
 #include "include/private/SkTo.h"
+#include "src/core/SkArenaAlloc.h"
+#include "src/core/SkEffectPriv.h"
+#include "src/core/SkMatrixProvider.h"
 #include "src/core/SkRasterPipeline.h"
 #include "src/gpu/Swizzle.h"
+#include "src/shaders/SkShaderBase.h"
 #include "tests/Test.h"
 
+extern bool gForceHighPrecisionRasterPipeline;
+
 DEF_TEST(SkRasterPipeline, r) {
     // Build and run a simple pipeline to exercise SkRasterPipeline,
     // drawing 50% transparent blue over opaque red in half-floats.
@@ -568,3 +576,73 @@ DEF_TEST(SkRasterPipeline_lowp_clamp01, r) {
     p.append(SkRasterPipeline::store_8888, &ptr);
     p.run(0,0,1,1);
 }
+
+DEF_TEST(SkRasterPipeline_lowp_2pt_conical, r) {
+    // Each kind of 2pt conical gradient should stay in lowp when storing to 8888,
+    // and draw the same as it does when we force highp.
+    static constexpr int kSize = 64;
+
+    const struct {
+        SkPoint c0;
+        float   r0;
+        SkPoint c1;
+        float   r1;
+    } kConicals[] = {
+        {{32, 32},  4, {32, 32}, 28},  // radial
+        {{16, 32},  8, {48, 32},  8},  // strip
+        {{20, 32},  0, {32, 32}, 24},  // focal, well behaved
+        {{ 8, 32},  0, {32, 32}, 24},  // focal on circle
+        {{ 4, 32},  0, {40, 32}, 16},  // focal outside the end circle
+        {{24, 32}, 20, {40, 32},  4},  // swapped
+    };
+    const SkColor colors[] = { 0xff0000ff, 0x8000ff00, 0xffff0000 };
+
+    uint32_t baseline = 0;
+    SkRasterPipeline_MemoryCtx baselineCtx = { &baseline, 0 };
+    SkRasterPipeline_<256> baselineP;
+    baselineP.append(SkRasterPipeline::load_8888,  &baselineCtx);
+    baselineP.append(SkRasterPipeline::store_8888, &baselineCtx);
+    const bool haveLowp = baselineP.isLowp();
+
+    for (auto tm : {SkTileMode::kClamp, SkTileMode::kDecal}) {
+        for (const auto& c : kConicals) {
+            sk_sp<SkShader> shader = SkGradientShader::MakeTwoPointConical(
+                    c.c0, c.r0, c.c1, c.r1, colors, nullptr, SK_ARRAY_COUNT(colors), tm);
+
+            uint32_t pixels[2][kSize * kSize];
+            for (int highp = 0; highp < 2; highp++) {
+                SkRasterPipeline_MemoryCtx ctx = { pixels[highp], kSize };
+
+                SkSTArenaAlloc<1024> alloc;
+                SkRasterPipeline p(&alloc);
+                SkPaint paint;
+                SkMatrixProvider matrixProvider(SkMatrix::I());
+                SkStageRec rec = {&p, &alloc, kRGBA_8888_SkColorType, nullptr, paint, nullptr,
+                                  matrixProvider};
+                REPORTER_ASSERT(r, as_SB(shader)->appendStages(rec));
+                p.append(SkRasterPipeline::store_8888, &ctx);
+
+                const bool wasForced = gForceHighPrecisionRasterPipeline;
+                gForceHighPrecisionRasterPipeline = highp;
+                REPORTER_ASSERT(r, p.isLowp() == (haveLowp && !highp));
+                p.run(0,0,kSize,kSize);
+                gForceHighPrecisionRasterPipeline = wasForced;
+            }
+
+            // lowp rounds once, straight from float to 8-bit, so should be off by at most 1.
+            // A pixel right on the edge of a degenerate region may land on either side of it.
+            int mismatches = 0;
+            for (int i = 0; i < kSize * kSize; i++) {
+                for (int shift = 0; shift < 32; shift += 8) {
+                    int lo = (pixels[0][i] >> shift) & 0xff,
+                        hi = (pixels[1][i] >> shift) & 0xff;
+                    if (std::abs(lo - hi) > 1) {
+                        mismatches++;
+                        break;
+                    }
+                }
+            }
+            REPORTER_ASSERT(r, mismatches <= kSize, "%d pixels differ", mismatches);
+        }
+    }
+}
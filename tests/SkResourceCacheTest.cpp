@@ -13,6 +13,7 @@
 #include "src/core/SkBitmapCache.h"
 #include "src/core/SkMipmap.h"
 #include "src/core/SkResourceCache.h"
+#include "src/core/SkTaskGroup.h"
 #include "src/image/SkImage_Base.h"
 #include "src/lazy/SkDiscardableMemoryPool.h"
 #include "tests/Test.h"
@@ -289,3 +290,102 @@ DEF_TEST(ResourceCache_purge, reporter) {
         }
     }
 }
+
+/*
+ *  Test the global cache from several threads at once.  It's split into shards internally,
+ *  and every shard needs to see purge messages for a shared ID.
+ */
+DEF_TEST(ResourceCache_global, reporter) {
+    constexpr int kSharedID = 0x5eed;  // Not used by any other test.
+    constexpr int kCount    = 256;
+
+    int flags[kCount] = {};
+    SkTaskGroup().batch(kCount, [&](int i) {
+        auto rec = new TestRec(kSharedID, i, &flags[i]);
+        rec->fCanBePurged = true;
+        SkResourceCache::Add(rec);
+    });
+    for (int i = 0; i < kCount; i++) {
+        REPORTER_ASSERT(reporter, flags[i] & TestRec::kDidInstall);
+    }
+
+    auto count = [] {
+        int n = 0;
+        SkResourceCache::VisitAll([](const SkResourceCache::Rec& rec, void* n) {
+            if (rec.getKey().getNamespace() == &gTestNamespace &&
+                rec.getKey().getSharedID() == kSharedID) {
+                *(int*)n += 1;
+            }
+        }, &n);
+        return n;
+    };
+
+    // Other tests may be using the global cache too, so some of ours may have been purged,
+    // but whatever we do find must be what we added under that key.
+    std::atomic<int> wrong{0};
+    SkTaskGroup().batch(kCount, [&](int i) {
+        int data = i;
+        bool hit = SkResourceCache::Find(TestKey(kSharedID, i),
+                                         [](const SkResourceCache::Rec& rec, void* data) {
+            *(int*)data -= static_cast<const TestRec&>(rec).fKey.fData;
+            return true;
+        }, &data);
+        wrong += (hit && data != 0) ? 1 : 0;
+    });
+    REPORTER_ASSERT(reporter, wrong.load() == 0);
+
+    SkResourceCache::PostPurgeSharedID(kSharedID);
+    SkResourceCache::CheckMessages();
+    REPORTER_ASSERT(reporter, count() == 0);
+}
+
+/*
+ *  Test that the shards of the global cache purge against their shared budget in least recently
+ *  used order across all of them, as one unsharded cache would.
+ */
+DEF_TEST(ResourceCache_globalBudget, reporter) {
+    if (SkResourceCache::GetDiscardableFactory()) {
+        return;  // Then the cache is limited by count rather than by bytes.
+    }
+    constexpr int kSharedID = 0xb0d9e7;  // Not used by any other test.
+    constexpr int kCount    = 64;
+    constexpr int kKeep     = 16;
+
+    const size_t prevLimit = SkResourceCache::SetTotalByteLimit(kKeep * 1024);
+    SkResourceCache::PurgeAll();
+
+    // Our Recs hash to all the different shards.  Finding the first one after each add keeps it
+    // among the most recently used, so it should never be purged.
+    int flags[kCount] = {};
+    for (int i = 0; i < kCount; i++) {
+        auto rec = new TestRec(kSharedID, i, &flags[i]);
+        rec->fCanBePurged = true;
+        SkResourceCache::Add(rec);
+        SkResourceCache::Find(TestKey(kSharedID, 0),
+                              [](const SkResourceCache::Rec&, void*) { return true; }, nullptr);
+    }
+
+    bool present[kCount] = {};
+    SkResourceCache::VisitAll([](const SkResourceCache::Rec& rec, void* present) {
+        if (rec.getKey().getNamespace() == &gTestNamespace &&
+            rec.getKey().getSharedID() == kSharedID) {
+            static_cast<bool*>(present)[static_cast<const TestRec&>(rec).fKey.fData] = true;
+        }
+    }, present);
+
+    // Other tests may be adding to the global cache too, which can only purge more of ours, but
+    // what's left of the rest must always be the most recently added.
+    int kept = 0;
+    for (int i = 1; i < kCount; i++) {
+        kept += present[i] ? 1 : 0;
+        REPORTER_ASSERT(reporter, !present[i - 1] || present[i] || i == 1,
+                        "Rec %d was purged before Rec %d", i, i - 1);
+    }
+    REPORTER_ASSERT(reporter, present[0]);
+    REPORTER_ASSERT(reporter, present[kCount - 1]);
+    REPORTER_ASSERT(reporter, kept < kKeep);
+
+    SkResourceCache::PostPurgeSharedID(kSharedID);
+    SkResourceCache::CheckMessages();
+    SkResourceCache::SetTotalByteLimit(prevLimit);
+}
@@ -5,12 +5,18 @@
  * found in the LICENSE file.
  */
 
+#include "include/core/SkBitmap.h"
 #include "include/core/SkColorPriv.h"
 #include "include/private/SkColorData.h"
+#include "src/core/SkArenaAlloc.h"
 #include "src/core/SkCpu.h"
 #include "src/core/SkMSAN.h"
+#include "src/core/SkMatrixProvider.h"
+#include "src/core/SkOSFile.h"
 #include "src/core/SkVM.h"
+#include "src/core/SkVMBlitter.h"
 #include "src/gpu/GrShaderCaps.h"
+#include "src/utils/SkOSPath.h"
 #include "src/sksl/SkSLCompiler.h"
 #include "src/sksl/codegen/SkSLVMCodeGenerator.h"
 #include "src/sksl/tracing/SkVMDebugTrace.h"
@@ -24,6 +30,9 @@ static void test_jit_and_interpreter(const skvm::Builder& b, Fn&& test) {
     if (p.hasJIT()) {
         test(b.done(/*debug_name=*/nullptr, /*allow_jit=*/false));
     }
+
+    // Programs that don't JIT run on the threaded interpreter, so try the switch-based one too.
+    test(b.done(/*debug_name=*/nullptr, /*allow_jit=*/false, /*allow_threaded=*/false));
 }
 
 DEF_TEST(SkVM_eliminate_dead_code, r) {
@@ -2895,3 +2904,135 @@ DEF_TEST(SkVM_Visualizer, r) {
                        "<tr class='source'><td class='mask'>&#8617;v9</td>"
                        "<td colspan=2>int main(int x, int y)</td></tr>"));
 }
+
+DEF_TEST(SkVMBlitter_ProgramCache, r) {
+    // An unusual destination and blend mode, so no one else is likely to share our program.
+    SkBitmap bm;
+    bm.allocPixels(SkImageInfo::Make(16, 1, kRGBA_F16_SkColorType, kPremul_SkAlphaType));
+
+    auto blit = [&] {
+        bm.eraseColor(SK_ColorRED);
+        SkPaint paint;
+        paint.setColor(SK_ColorBLUE);
+        paint.setBlendMode(SkBlendMode::kHue);
+        SkSTArenaAlloc<512> alloc;
+        SkMatrixProvider matrices{SkMatrix::I()};
+        SkBlitter* blitter = SkVMBlitter::Make(bm.pixmap(), paint, matrices, &alloc, nullptr);
+        REPORTER_ASSERT(r, blitter);
+        if (blitter) {
+            blitter->blitH(0, 0, bm.width());
+        }
+        return *bm.pixmap().addr64(7, 0);
+    };
+
+    SkVMBlitter::PurgeProgramCache();
+    auto before = SkVMBlitter::GetProgramCacheStats();
+    const uint64_t want = blit();
+    auto after = SkVMBlitter::GetProgramCacheStats();
+    REPORTER_ASSERT(r, after.misses > before.misses);
+
+    // A second blitter with the same key finds the first one's program in the cache.
+    before = after;
+    REPORTER_ASSERT(r, blit() == want);
+    after = SkVMBlitter::GetProgramCacheStats();
+    REPORTER_ASSERT(r, after.hits > before.hits);
+
+    // With a cache directory set, programs built once can be loaded later instead of rebuilt.
+    SkString tmpDir = skiatest::GetTmpDir();
+    if (tmpDir.isEmpty()) {
+        return;
+    }
+    const SkString dir = SkOSPath::Join(tmpDir.c_str(), "SkVMBlitter_ProgramCache");
+    if (!sk_exists(dir.c_str()) && !sk_mkdir(dir.c_str())) {
+        ERRORF(r, "Could not create %s", dir.c_str());
+        return;
+    }
+    auto removePrograms = [&] {
+        SkOSFile::Iter iter(dir.c_str(), ".skvm");
+        for (SkString name; iter.next(&name);) {
+            remove(SkOSPath::Join(dir.c_str(), name.c_str()).c_str());
+        }
+    };
+    removePrograms();
+    SkVMBlitter::SetProgramCacheDirectory(dir.c_str());
+
+    SkVMBlitter::PurgeProgramCache();
+    before = SkVMBlitter::GetProgramCacheStats();
+    REPORTER_ASSERT(r, blit() == want);
+    after = SkVMBlitter::GetProgramCacheStats();
+    REPORTER_ASSERT(r, after.misses > before.misses);
+
+    before = after;
+    SkVMBlitter::PurgeProgramCache();
+    REPORTER_ASSERT(r, blit() == want);
+    after = SkVMBlitter::GetProgramCacheStats();
+    REPORTER_ASSERT(r, after.diskHits > before.diskHits);
+
+    SkVMBlitter::SetProgramCacheDirectory(nullptr);
+    removePrograms();
+}
+
+DEF_TEST(SkVM_ThreadedInterpreter, r) {
+    // The threaded interpreter fuses runs of ops like these into single handlers.
+    // Make sure it gets the same results as the switch-based interpreter for every length,
+    // including tails shorter than a full stride that run unfused.
+    const skvm::PixelFormat rgba_8888 = skvm::SkColorType_to_PixelFormat(kRGBA_8888_SkColorType);
+    for (bool blend : {false, true})
+    for (SkColorType dstCT : {kRGBA_8888_SkColorType, kRGB_565_SkColorType}) {
+        const skvm::PixelFormat dstFormat = skvm::SkColorType_to_PixelFormat(dstCT);
+
+        skvm::Builder b;
+        skvm::Ptr src = b.varying<int>(),
+                  dst = b.varying(SkColorTypeBytesPerPixel(dstCT));
+        skvm::Color c = b.premul(b.load(rgba_8888, src));
+        if (blend) {
+            c = b.blend(SkBlendMode::kSrcOver, c, b.load(dstFormat, dst));
+        }
+        b.store(dstFormat, dst, c);
+        skvm::Program switched = b.done(/*debug_name=*/nullptr, skvm::Engine::kSwitch),
+                      threaded = b.done(/*debug_name=*/nullptr, skvm::Engine::kThreaded);
+
+        uint32_t srcPixels[67];
+        for (int i = 0; i < 67; i++) {
+            srcPixels[i] = 0x01030507 * (uint32_t)(i+1);
+        }
+
+        for (int N = 0; N <= 67; N++) {
+            uint32_t expected[67], actual[67];
+            for (int i = 0; i < 67; i++) {
+                expected[i] = actual[i] = 0x12345678 + (uint32_t)i;
+            }
+
+            switched.eval(N, srcPixels, expected);
+            threaded.eval(N, srcPixels, actual);
+
+            REPORTER_ASSERT(r, 0 == memcmp(expected, actual, sizeof(expected)),
+                            "blend=%d N=%d", blend, N);
+        }
+    }
+}
+
+DEF_TEST(SkVM_Engine, r) {
+    // A Program built for an explicit engine runs on it whatever gSkVMAllowJIT says.
+    skvm::Builder b;
+    skvm::Ptr ptr = b.varying<int>();
+    b.store32(ptr, b.add(b.load32(ptr), b.splat(1)));
+
+    for (skvm::Engine engine : {skvm::Engine::kSwitch,
+                                skvm::Engine::kThreaded,
+                                skvm::Engine::kJIT}) {
+        skvm::Program program = b.done(/*debug_name=*/nullptr, engine);
+        if (engine != skvm::Engine::kJIT) {
+            REPORTER_ASSERT(r, !program.hasJIT());
+        }
+
+        int buf[17];
+        for (int i = 0; i < 17; i++) {
+            buf[i] = i;
+        }
+        program.eval(17, buf);
+        for (int i = 0; i < 17; i++) {
+            REPORTER_ASSERT(r, buf[i] == i + 1);
+        }
+    }
+}
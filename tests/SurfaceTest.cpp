@@ -7,13 +7,17 @@
 
 #include "include/core/SkCanvas.h"
 #include "include/core/SkData.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkOverdrawCanvas.h"
 #include "include/core/SkPath.h"
 #include "include/core/SkRRect.h"
 #include "include/core/SkRegion.h"
 #include "include/core/SkSurface.h"
+#include "include/effects/SkGradientShader.h"
+#include "include/effects/SkImageFilters.h"
 #include "include/gpu/GrBackendSurface.h"
 #include "include/gpu/GrDirectContext.h"
+#include "include/utils/SkRandom.h"
 #include "src/core/SkAutoPixmapStorage.h"
 #include "src/core/SkCanvasPriv.h"
 #include "src/core/SkDevice.h"
@@ -1143,6 +1147,201 @@ DEF_TEST(Surface_null, r) {
     REPORTER_ASSERT(r, surf->makeImageSnapshot() == nullptr);
 }
 
+DEF_TEST(SurfaceRasterTiled, r) {
+    const SkImageInfo info = SkImageInfo::MakeN32Premul(320, 240);
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(4);
+
+    sk_sp<SkSurface> serial = SkSurface::MakeRaster(info),
+                     tiled  = SkSurface::MakeRasterTiled(info, executor.get(), 9);
+    REPORTER_ASSERT(r, tiled);
+    REPORTER_ASSERT(r, tiled->imageInfo() == info);
+
+    auto check = [&](const char* when) {
+        sk_sp<SkImage> expected = serial->makeImageSnapshot(),
+                       actual   = tiled ->makeImageSnapshot();
+        if (!ToolUtils::equal_pixels(expected.get(), actual.get())) {
+            ERRORF(r, "Tiled surface does not match serial surface %s.", when);
+        }
+    };
+
+    // Antialiased geometry, a gradient and a blurred layer all straddle tile boundaries.
+    auto drawFrame = [](SkCanvas* canvas) {
+        canvas->clear(SK_ColorWHITE);
+
+        SkPaint paint;
+        paint.setAntiAlias(true);
+        const SkPoint pts[] = {{0, 0}, {320, 240}};
+        const SkColor colors[] = {SK_ColorRED, SK_ColorBLUE};
+        paint.setShader(SkGradientShader::MakeLinear(pts, colors, nullptr, 2, SkTileMode::kClamp));
+        paint.setDither(true);
+        canvas->drawCircle(160, 120, 100, paint);
+
+        SkPaint layerPaint;
+        layerPaint.setImageFilter(SkImageFilters::Blur(4, 4, nullptr));
+        canvas->saveLayer(nullptr, &layerPaint);
+            canvas->rotate(15, 160, 120);
+            canvas->drawRect({100, 80, 220, 160}, SkPaint(SkColors::kGreen));
+        canvas->restore();
+    };
+    drawFrame(serial->getCanvas());
+    drawFrame(tiled ->getCanvas());
+    check("after the first frame");
+
+    // Matrix, clip and saves left open at a snapshot must still apply to the draws after it,
+    // and drawing must not disturb the snapshot we already took.
+    sk_sp<SkImage> firstFrame = tiled->makeImageSnapshot();
+    for (SkSurface* surface : {serial.get(), tiled.get()}) {
+        SkCanvas* canvas = surface->getCanvas();
+        canvas->save();
+        canvas->translate(40, 30);
+        canvas->clipRect({0, 0, 150, 100});
+    }
+    check("after changing the matrix and clip");
+    for (SkSurface* surface : {serial.get(), tiled.get()}) {
+        SkCanvas* canvas = surface->getCanvas();
+        SkPaint paint(SkColors::kBlack);
+        paint.setAntiAlias(true);
+        canvas->drawOval({-20, -20, 200, 140}, paint);
+        canvas->saveLayerAlpha(nullptr, 0x80);
+        canvas->drawRect({0, 0, 60, 60}, SkPaint(SkColors::kYellow));
+    }
+    check("with a layer still open");
+    for (SkSurface* surface : {serial.get(), tiled.get()}) {
+        surface->getCanvas()->restoreToCount(1);
+    }
+    check("after restoring");
+
+    SkPixmap pm;
+    REPORTER_ASSERT(r, tiled->peekPixels(&pm));
+    REPORTER_ASSERT(r, !ToolUtils::equal_pixels(firstFrame.get(), tiled->makeImageSnapshot().get()));
+
+    // Restoring a plain save changes no pixels, so it must not count as a draw.
+    uint32_t genID = tiled->generationID();
+    tiled->getCanvas()->save();
+    tiled->getCanvas()->clipRect({0, 0, 10, 10});
+    tiled->getCanvas()->restore();
+    REPORTER_ASSERT(r, genID == tiled->generationID());
+
+    // Resetting the clip must not let a tile draw over its neighbors.
+    for (SkSurface* surface : {serial.get(), tiled.get()}) {
+        SkCanvas* canvas = surface->getCanvas();
+        SkPaint paint(SkColors::kMagenta);
+        paint.setAntiAlias(true);
+        canvas->save();
+        canvas->clipRect({10, 10, 50, 50});
+        SkCanvasPriv::ResetClip(canvas);
+        canvas->drawCircle(200, 100, 90, paint);
+        canvas->restore();
+    }
+    check("after resetting the clip");
+
+    // Aliased hairline points are written straight into the pixels, but still only within a tile.
+    for (SkSurface* surface : {serial.get(), tiled.get()}) {
+        SkRandom rand;
+        SkPoint pts[500];
+        for (SkPoint& pt : pts) {
+            pt = {rand.nextRangeF(-10, 330), rand.nextRangeF(-10, 250)};
+        }
+        surface->getCanvas()->drawPoints(SkCanvas::kPoints_PointMode, SK_ARRAY_COUNT(pts), pts,
+                                         SkPaint(SkColors::kRed));
+    }
+    check("after drawing points");
+
+    // A backdrop filter reads pixels from neighboring tiles, so it must play back serially.
+    for (SkSurface* surface : {serial.get(), tiled.get()}) {
+        sk_sp<SkImageFilter> blur = SkImageFilters::Blur(6, 6, nullptr);
+        surface->getCanvas()->saveLayer({nullptr, nullptr, blur.get(), 0});
+        surface->getCanvas()->restore();
+    }
+    check("after a backdrop filter");
+}
+
+DEF_TEST(SurfaceDirtyRegion, r) {
+    const SkImageInfo info = SkImageInfo::MakeN32Premul(200, 150);
+    sk_sp<SkSurface> surface = SkSurface::MakeRaster(info);
+    SkCanvas* canvas = surface->getCanvas();
+
+    // Only raster surfaces track, and only once asked to.
+    REPORTER_ASSERT(r, !SkSurface::MakeNull(200, 150)->setDirtyRegionTracking(true));
+    canvas->drawPaint(SkPaint(SkColors::kBlue));
+    REPORTER_ASSERT(r, surface->dirtyRegion().isEmpty());
+    REPORTER_ASSERT(r, surface->setDirtyRegionTracking(true));
+    REPORTER_ASSERT(r, surface->dirtyRegion().isEmpty());
+
+    // Draws are dirty within their clipped bounds, and writes within what they wrote.
+    canvas->save();
+    canvas->clipRect({0, 0, 100, 150});
+    canvas->drawRect({90, 10, 120, 20}, SkPaint(SkColors::kRed));
+    canvas->restore();
+    REPORTER_ASSERT(r, SkIRect::MakeLTRB(89, 9, 100, 21).contains(
+                               surface->dirtyRegion().getBounds()));
+    REPORTER_ASSERT(r, surface->dirtyRegion().contains(SkIRect::MakeLTRB(90, 10, 100, 20)));
+    SkAutoPixmapStorage pixels;
+    pixels.alloc(info.makeWH(10, 10));
+    pixels.erase(SK_ColorGREEN);
+    surface->writePixels(pixels, 195, 145);
+    REPORTER_ASSERT(r, surface->dirtyRegion().contains(SkIRect::MakeLTRB(195, 145, 200, 150)));
+    surface->resetDirtyRegion();
+    REPORTER_ASSERT(r, surface->dirtyRegion().isEmpty());
+
+    // Every pixel a frame changes is in the dirty region.
+    SkRandom rand;
+    for (int frame = 0; frame < 20; frame++) {
+        SkBitmap before;
+        before.allocPixels(info);
+        SkAssertResult(surface->readPixels(before, 0, 0));
+        surface->resetDirtyRegion();
+
+        for (int i = 0; i < 8; i++) {
+            const SkRect rect = SkRect::MakeXYWH(rand.nextRangeF(-20, 200),
+                                                 rand.nextRangeF(-20, 150),
+                                                 rand.nextRangeF(1, 40),
+                                                 rand.nextRangeF(1, 40));
+            SkPaint paint(SkColor4f::FromColor(rand.nextU() | 0xFF000000));
+            paint.setAntiAlias(rand.nextBool());
+            if (rand.nextBool()) {
+                paint.setStyle(SkPaint::kStroke_Style);
+                paint.setStrokeWidth(rand.nextRangeF(0, 6));
+            }
+            SkAutoCanvasRestore acr(canvas, true);
+            canvas->rotate(rand.nextRangeF(-10, 10), rect.centerX(), rect.centerY());
+            if (rand.nextBool()) {
+                canvas->clipRect(rect.makeOffset(10, 5), rand.nextBool());
+            }
+            switch (rand.nextULessThan(5)) {
+                case 0: canvas->drawRect(rect, paint);                            break;
+                case 1: canvas->drawRRect(SkRRect::MakeRectXY(rect, 4, 4), paint); break;
+                case 2: canvas->drawOval(rect, paint);                            break;
+                case 3: {
+                    const SkPoint pts[] = {{rect.fLeft, rect.fTop}, {rect.fRight, rect.fBottom}};
+                    canvas->drawPoints(SkCanvas::kLines_PointMode, 2, pts, paint);
+                } break;
+                case 4: {
+                    SkPaint layerPaint;
+                    layerPaint.setImageFilter(SkImageFilters::Blur(3, 3, nullptr));
+                    canvas->saveLayer(nullptr, &layerPaint);
+                    canvas->drawRect(rect, paint);
+                    canvas->restore();
+                } break;
+            }
+        }
+
+        SkPixmap after;
+        SkAssertResult(surface->peekPixels(&after));
+        const SkRegion dirty = surface->dirtyRegion();
+        int missed = 0;
+        for (int y = 0; y < info.height(); y++)
+        for (int x = 0; x < info.width();  x++) {
+            missed += *before.getAddr32(x, y) != *after.addr32(x, y) && !dirty.contains(x, y);
+        }
+        REPORTER_ASSERT(r, missed == 0, "frame %d: %d changed pixels not dirty", frame, missed);
+    }
+
+    REPORTER_ASSERT(r, surface->setDirtyRegionTracking(false));
+    canvas->drawPaint(SkPaint(SkColors::kBlue));
+    REPORTER_ASSERT(r, surface->dirtyRegion().isEmpty());
+}
+
 // assert: if a given imageinfo is valid for a surface, then it must be valid for an image
 //         (so the snapshot can succeed)
 DEF_TEST(surface_image_unity, reporter) {
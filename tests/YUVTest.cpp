@@ -160,3 +160,91 @@ DEF_TEST(YUVMath, reporter) {
         }
     }
 }
+
+#include "include/core/SkCanvas.h"
+#include "include/core/SkGraphics.h"
+#include "include/core/SkImage.h"
+#include "include/core/SkSurface.h"
+#include "src/core/SkResourceCache.h"
+#include "src/core/SkYUVPlanesCache.h"
+#include "src/image/SkImage_Base.h"
+
+// Lazy jpegs are drawn to raster by sampling their Y, U and V planes in place. That should look
+// like drawing the RGBA pixels the codec would have decoded.
+DEF_TEST(YUV_RasterDrawLazyImage, r) {
+    sk_sp<SkData> data = GetResourceAsData("images/mandrill_512_q075.jpg");
+    if (!data || !SkImage::MakeFromEncoded(data)) {
+        return;
+    }
+    const bool yuvaPlanes = SkGraphics::SetRasterDrawsFromYUVAPlanes(false);
+
+    auto draw = [&](bool usePlanes, int test, SkBitmap* bm) {
+        SkGraphics::SetRasterDrawsFromYUVAPlanes(usePlanes);
+        // Decode from scratch, so that neither draw can reuse the other's planes or pixels.
+        SkResourceCache::PurgeAll();
+        sk_sp<SkImage> image = SkImage::MakeFromEncoded(data);
+
+        SkYUVAPixmaps pixmaps;
+        REPORTER_ASSERT(r, usePlanes == SkToBool(as_IB(image)->getROPlanes(&pixmaps)));
+
+        auto surface = SkSurface::MakeRasterN32Premul(300, 300);
+        SkCanvas* canvas = surface->getCanvas();
+        canvas->clear(SK_ColorWHITE);
+        switch (test) {
+            case 0:
+                canvas->drawImage(image, -100, -50);
+                break;
+            case 1:
+                canvas->drawImageRect(image, SkRect::MakeXYWH(100, 100, 200, 200),
+                                      SkRect::MakeXYWH(50, 50, 200, 200), SkSamplingOptions(),
+                                      nullptr, SkCanvas::kFast_SrcRectConstraint);
+                break;
+            case 2: {
+                SkPaint paint;
+                paint.setShader(image->makeShader(SkSamplingOptions(),
+                                                  SkMatrix::Translate(-7, -3)));
+                canvas->drawRect(SkRect::MakeXYWH(20, 20, 260, 260), paint);
+            } break;
+        }
+        bm->allocN32Pixels(300, 300);
+        surface->readPixels(*bm, 0, 0);
+    };
+
+    for (int test = 0; test < 3; test++) {
+        SkBitmap planes, rgba;
+        draw(true, test, &planes);
+        draw(false, test, &rgba);
+
+        // The codec's upsampling of the chroma planes differs a little from the stage's.
+        int maxDiff = 0;
+        for (int y = 0; y < 300; y++) {
+            for (int x = 0; x < 300; x++) {
+                SkColor a = planes.getColor(x, y),
+                        b = rgba.getColor(x, y);
+                for (int shift : { 0, 8, 16, 24 }) {
+                    maxDiff = std::max(maxDiff, abs((int)((a >> shift) & 0xFF) -
+                                                    (int)((b >> shift) & 0xFF)));
+                }
+            }
+        }
+        REPORTER_ASSERT(r, maxDiff <= 2, "test %d: max diff %d", test, maxDiff);
+    }
+
+    // Drawn far enough down, a smaller RGBA decode is cheaper, so the planes aren't even decoded.
+    {
+        SkGraphics::SetRasterDrawsFromYUVAPlanes(true);
+        SkResourceCache::PurgeAll();
+        sk_sp<SkImage> image = SkImage::MakeFromEncoded(data);
+        auto surface = SkSurface::MakeRasterN32Premul(64, 64);
+        SkPaint paint;
+        paint.setShader(image->makeShader(SkSamplingOptions(SkFilterMode::kLinear),
+                                          SkMatrix::Scale(0.125f, 0.125f)));
+        surface->getCanvas()->drawPaint(paint);
+        SkYUVAPixmaps pixmaps;
+        sk_sp<SkCachedData> planes(SkYUVPlanesCache::FindAndRef(image->uniqueID(), &pixmaps));
+        REPORTER_ASSERT(r, !planes);
+    }
+
+    SkGraphics::SetRasterDrawsFromYUVAPlanes(yuvaPlanes);
+    SkResourceCache::PurgeAll();
+}
@@ -64,6 +64,7 @@
 
 #include <cstdlib>
 #include <map>
+#include <utility>
 
 #include "imgui.h"
 #include "misc/cpp/imgui_stdlib.h"  // For ImGui support of std::string
@@ -2685,30 +2686,30 @@ void Viewer::drawImGui() {
             }
 
             if (ImGui::CollapsingHeader("SkVM")) {
-                auto* cache = SkVMBlitter::TryAcquireProgramCache();
-                SkASSERT(cache);
-
                 if (ImGui::Button("Clear")) {
-                    cache->reset();
+                    SkVMBlitter::PurgeProgramCache();
                     fDisassemblyCache.reset();
                 }
 
-                // First, go through the cache and restore the original program if we were hovering
-                if (!fHoveredProgram.empty()) {
-                    auto restoreHoveredProgram = [this](const SkVMBlitter::Key* key,
-                                                        skvm::Program* program) {
-                        if (*key == fHoveredKey) {
-                            *program = std::move(fHoveredProgram);
-                            fHoveredProgram = {};
+                // First, go through the cache and restore the original program if we were hovering.
+                // Blitters share cached programs, so we only ever swap which one the cache holds.
+                if (fHoveredProgram) {
+                    auto restoreHoveredProgram = [this](const SkVMBlitter::Key& key,
+                                                        std::shared_ptr<skvm::Program>* cached) {
+                        if (key == fHoveredKey) {
+                            *cached = std::move(fHoveredProgram);
                         }
                     };
-                    cache->foreach(restoreHoveredProgram);
+                    SkVMBlitter::ForEachCachedProgram(restoreHoveredProgram);
+                    fHoveredProgram = nullptr;
                 }
 
                 // Now iterate again, and dump any expanded program. If any program is hovered,
                 // patch it, and remember the original (so it can be restored next frame).
-                auto showVMEntry = [this](const SkVMBlitter::Key* key, skvm::Program* program) {
-                    SkString keyString = SkVMBlitter::DebugName(*key);
+                auto showVMEntry = [this](const SkVMBlitter::Key& key,
+                                          std::shared_ptr<skvm::Program>* cached) {
+                    skvm::Program* program = cached->get();
+                    SkString keyString = SkVMBlitter::DebugName(key);
                     bool inTreeNode = ImGui::TreeNode(keyString.c_str());
                     bool hovered = ImGui::IsItemHovered();
 
@@ -2726,12 +2727,12 @@ void Viewer::drawImGui() {
                         stringBox("##VM", &dumpString);
 
 #if defined(SKVM_JIT)
-                        std::string* asmString = fDisassemblyCache.find(*key);
+                        std::string* asmString = fDisassemblyCache.find(key);
                         if (!asmString) {
                             program->disassemble(&stream);
                             auto asmData = stream.detachAsData();
                             asmString = fDisassemblyCache.set(
-                                    *key,
+                                    key,
                                     std::string((const char*)asmData->data(), asmData->size()));
                         }
                         stringBox("##ASM", asmString);
@@ -2741,17 +2742,15 @@ void Viewer::drawImGui() {
                     }
                     if (hovered) {
                         // Generate a new blitter that just draws magenta
-                        skvm::Program highlightProgram = build_skvm_highlight_program(
-                                static_cast<SkColorType>(key->colorType), program->nargs());
+                        auto highlightProgram = std::make_shared<skvm::Program>(
+                                build_skvm_highlight_program(
+                                        static_cast<SkColorType>(key.colorType), program->nargs()));
 
-                        fHoveredKey = *key;
-                        fHoveredProgram = std::move(*program);
-                        *program = std::move(highlightProgram);
+                        fHoveredKey = key;
+                        fHoveredProgram = std::exchange(*cached, std::move(highlightProgram));
                     }
                 };
-                cache->foreach(showVMEntry);
-
-                SkVMBlitter::ReleaseProgramCache();
+                SkVMBlitter::ForEachCachedProgram(showVMEntry);
             }
         }
         if (displayParamsChanged || uiParamsChanged) {
@@ -274,8 +274,8 @@ private:
     };
     ShaderOptLevel fOptLevel = kShaderOptLevel_Source;
 
-    SkVMBlitter::Key fHoveredKey;
-    skvm::Program    fHoveredProgram;
+    SkVMBlitter::Key               fHoveredKey;
+    std::shared_ptr<skvm::Program> fHoveredProgram;
 
     SkTHashMap<SkVMBlitter::Key, std::string> fDisassemblyCache;
 };